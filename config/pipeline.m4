@@ -31,10 +31,13 @@ AM_COND_IF([PIPELINE_SUPPORT],[
 
 	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/Makefile
 	test/rofl/datapath/pipeline/monitoring/Makefile
+	test/rofl/datapath/pipeline/threading/Makefile
+	test/rofl/datapath/pipeline/util/Makefile
 	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/bufs/Makefile
 	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/ma/Makefile
 	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/ma/loop/Makefile
 	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/static/Makefile
+	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/stats/Makefile
 	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/reset_pipeline/Makefile
 ])])
 #	test/rofl/datapath/pipeline/openflow/openflow1x/pipeline/dynamic/Makefile
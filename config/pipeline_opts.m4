@@ -30,28 +30,17 @@ enable_inline="no"
 
 	#Pipeline thread IDs
 	AC_MSG_CHECKING(the maximum number of threads/cpus for ROFL-pipeline packet processing API) 
-	AC_ARG_WITH([pipeline-max-tids], AS_HELP_STRING([--with-pipeline-max-tids=num], [maximum number of threads/cpus that ROFL-pipeline packet processing API supports concurrently without locking. Supported values {2,4,8,16,32,64} [default=16]]), with_pipeline_max_tids=yes, [])
+	AC_ARG_WITH([pipeline-max-tids], AS_HELP_STRING([--with-pipeline-max-tids=num], [maximum number of threads/cpus that ROFL-pipeline packet processing API supports concurrently without locking. Supported values [2-1024]; the number actually in use can be lowered at runtime (tid_set_num_of_tids()) [default=16]]), with_pipeline_max_tids=yes, [])
 
 	#Default value	
 	MAX_TIDS=16
 
-	#TODO: There is probably a better way to do this and that is still portable
 	if test "$with_pipeline_max_tids" = "yes"; then
-		if test "$withval" = "2"; then
-			MAX_TIDS=$withval
-		elif test "$withval" = "4"; then
-			MAX_TIDS=$withval
-		elif test "$withval" = "8"; then
-			MAX_TIDS=$withval
-		elif test "$withval" = "16"; then
-			MAX_TIDS=$withval
-		elif test "$withval" = "32"; then
-			MAX_TIDS=$withval
-		elif test "$withval" = "64"; then
+		if expr "x$withval" : 'x[[0-9]][[0-9]]*$' >/dev/null && test "$withval" -ge 2 && test "$withval" -le 1024; then
 			MAX_TIDS=$withval
 		else
 			AC_MSG_RESULT(ERROR)
-		  	AC_ERROR([Invalid value for --with-pipeline-max-tids of '$withval'; supported values {2,4,8,16,32,64}])
+		  	AC_ERROR([Invalid value for --with-pipeline-max-tids of '$withval'; supported values [[2-1024]]])
 		fi	
 	fi
 	AC_MSG_RESULT($MAX_TIDS)
@@ -62,7 +51,7 @@ enable_inline="no"
 	
 	#Pipeline lockless
 	AC_MSG_CHECKING(whether to compile ROFL-pipeline packet processing API without locking) 
-	AC_ARG_WITH([pipeline-lockless], AS_HELP_STRING([--with-pipeline-lockless], [compiles ROFL-pipeline packet processing API without locking [default=no]]), with_pipeline_lockless="yes", [])
+	AC_ARG_WITH([pipeline-lockless], AS_HELP_STRING([--with-pipeline-lockless], [compiles ROFL-pipeline packet processing API without locking; flow lookup is lock-free (RCU) regardless [default=no]]), with_pipeline_lockless="yes", [])
 
 		
 	if test "$with_pipeline_lockless" = "yes"; then
@@ -72,4 +61,40 @@ enable_inline="no"
 		AC_SUBST([ROFL_PIPELINE_LOCKLESS], [""])
 		AC_MSG_RESULT(no)
 	fi
+
+	#Pipeline object pools backed by hugepages
+	AC_MSG_CHECKING(whether to back ROFL-pipeline object pools with hugepages) 
+	AC_ARG_WITH([pipeline-hugepages], AS_HELP_STRING([--with-pipeline-hugepages], [requests hugepage-backed chunks for the ROFL-pipeline object pools (flow entries, matches, actions...) [default=no]]), with_pipeline_hugepages="yes", [])
+
+	if test "$with_pipeline_hugepages" = "yes"; then
+		AC_SUBST([ROFL_PIPELINE_HUGEPAGES], ["#define ROFL_PIPELINE_HUGEPAGES 1"])
+		AC_MSG_RESULT(yes)
+	else
+		AC_SUBST([ROFL_PIPELINE_HUGEPAGES], [""])
+		AC_MSG_RESULT(no)
+	fi
+
+	#Pipeline latency histograms
+	AC_MSG_CHECKING(whether to compile ROFL-pipeline latency histograms instrumentation) 
+	AC_ARG_WITH([pipeline-latency-histograms], AS_HELP_STRING([--with-pipeline-latency-histograms], [compiles the per stage latency (cycles) instrumentation points in ROFL-pipeline packet processing API; histograms are then enabled at runtime (of1x_enable_latency_histograms()) [default=no]]), with_pipeline_latency_histograms="yes", [])
+
+	if test "$with_pipeline_latency_histograms" = "yes"; then
+		AC_SUBST([ROFL_PIPELINE_LATENCY_HISTOGRAMS], ["#define ROFL_PIPELINE_LATENCY_HISTOGRAMS 1"])
+		AC_MSG_RESULT(yes)
+	else
+		AC_SUBST([ROFL_PIPELINE_LATENCY_HISTOGRAMS], [""])
+		AC_MSG_RESULT(no)
+	fi
+
+	#Pipeline batched flow removed notifications
+	AC_MSG_CHECKING(whether ROFL-pipeline notifies batches of removed flows at once) 
+	AC_ARG_WITH([pipeline-batch-flow-removed], AS_HELP_STRING([--with-pipeline-batch-flow-removed], [notifies batches of removed flows (e.g. expired at once) through platform_of1x_notify_flows_removed(), which the platform must then implement; otherwise platform_of1x_notify_flow_removed() is called per entry [default=no]]), with_pipeline_batch_flow_removed="yes", [])
+
+	if test "$with_pipeline_batch_flow_removed" = "yes"; then
+		AC_SUBST([ROFL_PIPELINE_BATCH_FLOW_REMOVED], ["#define ROFL_PIPELINE_BATCH_FLOW_REMOVED 1"])
+		AC_MSG_RESULT(yes)
+	else
+		AC_SUBST([ROFL_PIPELINE_BATCH_FLOW_REMOVED], [""])
+		AC_MSG_RESULT(no)
+	fi
 ])
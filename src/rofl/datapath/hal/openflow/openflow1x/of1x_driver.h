@@ -9,6 +9,7 @@
 #include <rofl/datapath/pipeline/openflow/openflow1x/of1x_switch.h>
 #include <rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_entry.h>
 #include <rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_action.h>
+#include <rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_stats_export.h>
 #include "../../hal.h"
 #include "../../hal_utils.h"
 
@@ -131,7 +132,26 @@ hal_result_t hal_driver_of1x_process_packet_out(uint64_t dpid, uint32_t buffer_i
  * @param check_overlap	Check OVERLAP flag
  * @param check_counts	Check RESET_COUNTS flag
  */
-hal_result_t hal_driver_of1x_process_flow_mod_add(uint64_t dpid, uint8_t table_id, of1x_flow_entry_t** flow_entry, uint32_t buffer_id, bool check_overlap, bool reset_counts); 
+hal_result_t hal_driver_of1x_process_flow_mod_add(uint64_t dpid, uint8_t table_id, of1x_flow_entry_t** flow_entry, uint32_t buffer_id, bool check_overlap, bool reset_counts);
+
+/**
+ * @brief   Instructs driver to process a bundle of FLOW_MOD add events, atomically
+ * @ingroup hal_driver_of1x
+ *
+ * Either all the flow entries are installed or none of them (e.g. controller resyncs).
+ * Drivers using the pipeline shall use of1x_add_flow_entries_table().
+ *
+ * If (and only if) the bundle is successfully installed, the contents of the pointers
+ * in flow_entries are set to NULL.
+ *
+ * @param dpid 		Datapath ID of the switch to install the FLOW_MODs
+ * @param table_id 	Table id to install the flowmods
+ * @param flow_entries	Flow entries to be installed
+ * @param num_of_entries	Number of flow entries
+ * @param check_overlap	Check OVERLAP flag
+ * @param check_counts	Check RESET_COUNTS flag
+ */
+hal_result_t hal_driver_of1x_process_flow_mod_add_bundle(uint64_t dpid, uint8_t table_id, of1x_flow_entry_t** flow_entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts);
 
 /**
  * @brief   Instructs driver to process a FLOW_MOD modify event
@@ -188,6 +208,11 @@ hal_result_t hal_driver_of1x_process_flow_mod_delete(uint64_t dpid, uint8_t tabl
  * @param out_group 	Out group that entry must include	
  * @param matches	Matches
  * 
+ * Large tables should be exported in chunks (of1x_init_flow_stats_cursor() and
+ * of1x_export_flow_stats()) rather than via of1x_get_flow_stats(), which allocates
+ * and copies every flow while the table is locked. The records of each chunk can be
+ * serialized directly into the (multipart) reply.
+ *
  * @return A pointer to an of1x_flow_msg_t struct or NULL on error. This pointer can be safely accessed and
  * modified, and MUST be destroyed via of1x_destroy_stats_flow_msg() once used.
  */
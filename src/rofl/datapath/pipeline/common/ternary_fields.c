@@ -3,72 +3,65 @@
 #include <assert.h>
 
 #include "../platform/memory.h"
+#include "../physical_switch.h"
 #include <rofl/datapath/pipeline/common/ternary_fields.h>
 
+static const slab_desc_t utern_slab_desc = { "utern", SLAB_POOL_UTERN, sizeof(utern_t), NULL, NULL };
+
 /*
 * Initializers
 */
 inline utern_t* __init_utern8(uint8_t value, uint8_t mask){
-	utern_t* tern = (utern_t*)platform_malloc_shared(sizeof(utern_t));
+	utern_t* tern = (utern_t*)__physical_switch_alloc(&utern_slab_desc);
 
 	if(!tern)
 		return NULL;
 
-	tern->type = UTERN8_T;
-	tern->value.u8 = value;
-	tern->mask.u8 = mask;
-	return (utern_t*)tern;
+	__set_utern8(tern, value, mask);
+	return tern;
 }
 inline utern_t* __init_utern16(uint16_t value, uint16_t mask){
-	utern_t* tern = (utern_t*)platform_malloc_shared(sizeof(utern_t));
+	utern_t* tern = (utern_t*)__physical_switch_alloc(&utern_slab_desc);
 
 	if(!tern)
 		return NULL;
 
-	tern->type = UTERN16_T;
-	tern->value.u16 = value;
-	tern->mask.u16 = mask;
-	return (utern_t*)tern;
+	__set_utern16(tern, value, mask);
+	return tern;
 }
 inline utern_t* __init_utern32(uint32_t value, uint32_t mask){
-	utern_t* tern = (utern_t*)platform_malloc_shared(sizeof(utern_t));
+	utern_t* tern = (utern_t*)__physical_switch_alloc(&utern_slab_desc);
 
 	if(!tern)
 		return NULL;
 	
-	tern->type = UTERN32_T;
-	tern->value.u32 = value;
-	tern->mask.u32 = mask;
-	return (utern_t*)tern;
+	__set_utern32(tern, value, mask);
+	return tern;
 }
 inline utern_t* __init_utern64(uint64_t value, uint64_t mask){
-	utern_t* tern = (utern_t*)platform_malloc_shared(sizeof(utern_t));
+	utern_t* tern = (utern_t*)__physical_switch_alloc(&utern_slab_desc);
 
 	if(!tern)
 		return NULL;
 	
-	tern->type = UTERN64_T;
-	tern->value.u64 = value;
-	tern->mask.u64 = mask;
-	return (utern_t*)tern;
+	__set_utern64(tern, value, mask);
+	return tern;
 }
 inline utern_t* __init_utern128(uint128__t value, uint128__t mask){ //uint128_t funny!
-	utern_t* tern = (utern_t*)platform_malloc_shared(sizeof(utern_t));
+	utern_t* tern = (utern_t*)__physical_switch_alloc(&utern_slab_desc);
 	
 	if(!tern)
 		return NULL;
 	
-	tern->type = UTERN128_T;
-	tern->value.u128 = value;
-	tern->mask.u128 = mask;
-	return (utern_t*)tern;
+	__set_utern128(tern, value, mask);
+	return tern;
 }
 
 /*
 * Single destructor
 */
 rofl_result_t __destroy_utern(utern_t* utern){
-	platform_free_shared(utern);
+	__slab_free(utern);
 	//FIXME: maybe check returning value
 	return ROFL_SUCCESS; 
 }	
@@ -155,81 +148,87 @@ inline bool __utern_equals(const utern_t* tern1, const utern_t* tern2){
 }
 
 //Ternary alike functions. Tern2 MUST always have more restrictive mask
-inline utern_t* __utern_get_alike(const utern_t tern1, const utern_t tern2){
+bool __utern_set_alike(utern_t* alike, const utern_t* tern1, const utern_t* tern2){
 	//TODO: there might be more efficient impl. maybe erasing 1s in diff... but dunno
 	
 	wrap_uint_t diff, new_mask;
 	
-	switch(tern1.type){
+	switch(tern1->type){
 		case UTERN8_T:
 
 			diff.u8 = ~( 
-					(tern1.value.u8 & tern1.mask.u8)	
+					(tern1->value.u8 & tern1->mask.u8)	
 					^
-					(tern2.value.u8 & tern2.mask.u8)
+					(tern2->value.u8 & tern2->mask.u8)
 					);
 			//erase right 1.
 			for(new_mask.u8=0xFF;new_mask.u8;new_mask.u8=new_mask.u8<<1)
 				if((diff.u8&new_mask.u8) == new_mask.u8) break; 
 
-			if(tern1.mask.u8 < new_mask.u8 || tern2.mask.u8 < new_mask.u8 )
-				return NULL;
+			if(tern1->mask.u8 < new_mask.u8 || tern2->mask.u8 < new_mask.u8 )
+				return false;
 			
-			if(new_mask.u8)
-				return __init_utern8(tern1.value.u8,new_mask.u8);
+			if(new_mask.u8){
+				__set_utern8(alike, tern1->value.u8,new_mask.u8);
+				return true;
+			}
 
-			return NULL;
+			return false;
 			
 			break;
 			
 		case UTERN16_T:
 	
 			diff.u16 = ~( 
-					(tern1.value.u16 & tern1.mask.u16)	
+					(tern1->value.u16 & tern1->mask.u16)	
 					^
-					(tern2.value.u16 & tern2.mask.u16)
+					(tern2->value.u16 & tern2->mask.u16)
 					);
 			//erase right 1.
 			for(new_mask.u16=0xFFFF;new_mask.u16;new_mask.u16=new_mask.u16<<1)
 				if((diff.u16&new_mask.u16) == new_mask.u16) break; 
 			
-			if(tern1.mask.u16 < new_mask.u16 || tern2.mask.u16 < new_mask.u16 )
-				return NULL;
+			if(tern1->mask.u16 < new_mask.u16 || tern2->mask.u16 < new_mask.u16 )
+				return false;
 			
-			if(new_mask.u16)
-				return __init_utern16(tern1.value.u16,new_mask.u16);
+			if(new_mask.u16){
+				__set_utern16(alike, tern1->value.u16,new_mask.u16);
+				return true;
+			}
 			
-			return NULL;
+			return false;
 			
 			break;
 			
 		case UTERN32_T:
 
 			diff.u32 = ~( 
-					(tern1.value.u32 & tern1.mask.u32)	
+					(tern1->value.u32 & tern1->mask.u32)	
 					^
-					(tern2.value.u32 & tern2.mask.u32)
+					(tern2->value.u32 & tern2->mask.u32)
 					);
 			//erase right 1.
 			for(new_mask.u32=0xFFFFFFFF;new_mask.u32;new_mask.u32=new_mask.u32<<1)
 				if((diff.u32&new_mask.u32) == new_mask.u32) break; 
 			
-			if(tern1.mask.u32 < new_mask.u32 || tern2.mask.u32 < new_mask.u32 )
-				return NULL;
+			if(tern1->mask.u32 < new_mask.u32 || tern2->mask.u32 < new_mask.u32 )
+				return false;
 			
-			if(new_mask.u32)
-				return __init_utern32(tern1.value.u32,new_mask.u32);
+			if(new_mask.u32){
+				__set_utern32(alike, tern1->value.u32,new_mask.u32);
+				return true;
+			}
 			
-			return NULL;
+			return false;
 			
 			break;
 		
 		case UTERN64_T:
 
 			diff.u64 = ~( 
-					(tern1.value.u64 & tern1.mask.u64)	
+					(tern1->value.u64 & tern1->mask.u64)	
 					^
-					(tern2.value.u64 & tern2.mask.u64)
+					(tern2->value.u64 & tern2->mask.u64)
 					);
 			//erase right 1.
 			for(new_mask.u64=0xFFFFFFFFFFFFFFFFULL;new_mask.u64;new_mask.u64=new_mask.u64<<1)
@@ -238,52 +237,70 @@ inline utern_t* __utern_get_alike(const utern_t tern1, const utern_t tern2){
 			//FIXME assert unlikely
 			//FIXME this condition happens also when two values are different in the non masked part.
 				//in this case we sould return the utern as it is now.
-			if(tern1.mask.u64 < new_mask.u64 || tern2.mask.u64 < new_mask.u64 )
-				return NULL;
+			if(tern1->mask.u64 < new_mask.u64 || tern2->mask.u64 < new_mask.u64 )
+				return false;
 			
-			if(new_mask.u64)
-				return __init_utern64(tern1.value.u64,new_mask.u64);
+			if(new_mask.u64){
+				__set_utern64(alike, tern1->value.u64,new_mask.u64);
+				return true;
+			}
 			
-			return NULL;
+			return false;
 			
 			break;
 			
 		case UTERN128_T:
 
-			UINT128__T_LO(diff.u128) = ~(	(UINT128__T_LO(tern1.value.u128) & UINT128__T_LO(tern1.mask.u128))	^	(UINT128__T_LO(tern2.value.u128) & UINT128__T_LO(tern2.mask.u128))	);
-			UINT128__T_HI(diff.u128) = ~(	(UINT128__T_HI(tern1.value.u128) & UINT128__T_HI(tern1.mask.u128))	^	(UINT128__T_HI(tern2.value.u128) & UINT128__T_HI(tern2.mask.u128))	);
+			UINT128__T_LO(diff.u128) = ~(	(UINT128__T_LO(tern1->value.u128) & UINT128__T_LO(tern1->mask.u128))	^	(UINT128__T_LO(tern2->value.u128) & UINT128__T_LO(tern2->mask.u128))	);
+			UINT128__T_HI(diff.u128) = ~(	(UINT128__T_HI(tern1->value.u128) & UINT128__T_HI(tern1->mask.u128))	^	(UINT128__T_HI(tern2->value.u128) & UINT128__T_HI(tern2->mask.u128))	);
 			
 			//We first look for the common mask in the lower part
 			for(UINT128__T_LO(new_mask.u128)=0xFFFFFFFFFFFFFFFFULL;UINT128__T_LO(new_mask.u128);UINT128__T_LO(new_mask.u128)=UINT128__T_LO(new_mask.u128)<<1)
 				if((UINT128__T_LO(diff.u128)&UINT128__T_LO(new_mask.u128)) == UINT128__T_LO(new_mask.u128)) break; 
 			
-			if( (UINT128__T_LO(tern1.mask.u128) < UINT128__T_LO(new_mask.u128) || UINT128__T_LO(tern2.mask.u128) < UINT128__T_LO(new_mask.u128)) && UINT128__T_HI(diff.u128) == 0xffffffffffffffffULL )
-				return NULL;
+			if( (UINT128__T_LO(tern1->mask.u128) < UINT128__T_LO(new_mask.u128) || UINT128__T_LO(tern2->mask.u128) < UINT128__T_LO(new_mask.u128)) && UINT128__T_HI(diff.u128) == 0xffffffffffffffffULL )
+				return false;
 				
 			if( UINT128__T_LO(new_mask.u128) && UINT128__T_HI(diff.u128) == 0xffffffffffffffffULL ){
 				UINT128__T_HI(new_mask.u128) = 0xffffffffffffffffULL;
-				return __init_utern128(tern1.value.u128,new_mask.u128);
+				__set_utern128(alike, tern1->value.u128,new_mask.u128);
+				return true;
 			}
 			
 			//Now we look for it in the higher part
 			for(UINT128__T_HI(new_mask.u128)=0xFFFFFFFFFFFFFFFFULL;UINT128__T_HI(new_mask.u128);UINT128__T_HI(new_mask.u128)=UINT128__T_HI(new_mask.u128)<<1)
 				if((UINT128__T_HI(diff.u128)&UINT128__T_HI(new_mask.u128)) == UINT128__T_HI(new_mask.u128)) break;
 				
-			if(UINT128__T_HI(tern1.mask.u128)<UINT128__T_HI(new_mask.u128) || UINT128__T_HI(tern2.mask.u128) < UINT128__T_HI(new_mask.u128) )
-				return NULL;
+			if(UINT128__T_HI(tern1->mask.u128)<UINT128__T_HI(new_mask.u128) || UINT128__T_HI(tern2->mask.u128) < UINT128__T_HI(new_mask.u128) )
+				return false;
 			
 			if(UINT128__T_HI(new_mask.u128)){
 				UINT128__T_LO(new_mask.u128)=0x0000000000000000;
-				return __init_utern128(tern1.value.u128,new_mask.u128);
+				__set_utern128(alike, tern1->value.u128,new_mask.u128);
+				return true;
 			}
 			
-			return NULL;
+			return false;
 			
 			break;
 		
 		default:
 			assert(0); // we should never reach this point
-			return NULL;
+			return false;
 	}
-	return NULL;
+	return false;
+}
+
+utern_t* __utern_get_alike(const utern_t tern1, const utern_t tern2){
+
+	utern_t alike;
+	utern_t* tern;
+
+	if(!__utern_set_alike(&alike, &tern1, &tern2))
+		return NULL;
+
+	tern = (utern_t*)__physical_switch_alloc(&utern_slab_desc);
+	if(tern)
+		*tern = alike;
+	return tern;
 }
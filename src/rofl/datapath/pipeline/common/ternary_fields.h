@@ -42,7 +42,34 @@ typedef struct utern{
 //C++ extern C
 ROFL_BEGIN_DECLS
 
-//Initializers
+//In-place initializers (e.g. ternary values embedded in other structures)
+static inline void __set_utern8(utern_t* tern, uint8_t value, uint8_t mask){
+	tern->type = UTERN8_T;
+	tern->value.u8 = value;
+	tern->mask.u8 = mask;
+}
+static inline void __set_utern16(utern_t* tern, uint16_t value, uint16_t mask){
+	tern->type = UTERN16_T;
+	tern->value.u16 = value;
+	tern->mask.u16 = mask;
+}
+static inline void __set_utern32(utern_t* tern, uint32_t value, uint32_t mask){
+	tern->type = UTERN32_T;
+	tern->value.u32 = value;
+	tern->mask.u32 = mask;
+}
+static inline void __set_utern64(utern_t* tern, uint64_t value, uint64_t mask){
+	tern->type = UTERN64_T;
+	tern->value.u64 = value;
+	tern->mask.u64 = mask;
+}
+static inline void __set_utern128(utern_t* tern, uint128__t value, uint128__t mask){
+	tern->type = UTERN128_T;
+	tern->value.u128 = value;
+	tern->mask.u128 = mask;
+}
+
+//Initializers (heap)
 utern_t* __init_utern8(uint8_t value, uint8_t mask);
 utern_t* __init_utern16(uint16_t value, uint16_t mask);
 utern_t* __init_utern32(uint32_t value, uint32_t mask);
@@ -85,7 +112,8 @@ bool __utern_equals(const utern_t* tern1, const utern_t* tern2);
 //Check if a ternary value is a subset of another 
 bool __utern_is_contained(const utern_t* extensive_tern, const utern_t* tern);
 
-//Ternary alike functions
+//Ternary alike functions. The in-place version returns false if there is no common value
+bool __utern_set_alike(utern_t* alike, const utern_t* tern1, const utern_t* tern2);
 utern_t* __utern_get_alike(const utern_t tern1, const utern_t tern2);
 
 //C++ extern C
@@ -37,21 +37,37 @@ rofl_result_t of_reconfigure_switch(of_switch_t* sw, of_version_t version){
 
 
 //Wrapping of timers processing
-void of_process_pipeline_tables_timeout_expirations(const of_switch_t* sw){
+bool of_process_pipeline_tables_timeout_expirations(const of_switch_t* sw){
 	
 	switch(sw->of_ver){
 		case OF_VERSION_10: 
 		case OF_VERSION_12: 
 		case OF_VERSION_13: 
-			__of1x_process_pipeline_tables_timeout_expirations(&((of1x_switch_t*)sw)->pipeline);
-			break;
+			return __of1x_process_pipeline_tables_timeout_expirations(&((of1x_switch_t*)sw)->pipeline);
 		default: 
 			//return ROFL_FAILURE;
 			break;
 	}
+
+	return false;
 }	
 
 
+//Wrapping of flow rate sampling
+void of_sample_pipeline_flow_rates(const of_switch_t* sw){
+
+	switch(sw->of_ver){
+		case OF_VERSION_10: 
+		case OF_VERSION_12: 
+		case OF_VERSION_13: 
+			of1x_sample_flow_rates(&((of1x_switch_t*)sw)->pipeline);
+			break;
+		default: 
+			break;
+	}
+}
+
+
 rofl_result_t __of_attach_port_to_switch_at_port_num(of_switch_t* sw, unsigned int port_num, switch_port_t* port){
 	switch(sw->of_ver){
 		case OF_VERSION_10: 
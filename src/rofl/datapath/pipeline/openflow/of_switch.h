@@ -125,10 +125,26 @@ rofl_result_t of_reconfigure_switch(of_switch_t* sw, of_version_t version);
 * The platform has to periodically call of_process_pipeline_tables_timeout_expirations() 
 * (usually via some background thread). The optimal period is around 500ms. 
 *
+* If a budget is set (of1x_set_timeout_expiration_budget()), the call
+* processes a bounded number of expirations per table; the rest are kept for
+* the next calls.
+*
 * @param sw The switch which has to check flow entry expirations 
-* 
+* @retval true if there are expirations pending (the platform should call it again soon) 
+*/
+bool of_process_pipeline_tables_timeout_expirations(const of_switch_t* sw);
+
+/**
+* @brief Samples the flow counters of the switch and updates the flow rate estimations
+* @ingroup core
+*
+* The platform has to periodically call of_sample_pipeline_flow_rates() (usually
+* via some background thread), from a single thread. The optimal period is around 1s.
+* See of1x_sample_flow_rates().
+*
+* @param sw The switch whose flow rates have to be sampled
 */
-void of_process_pipeline_tables_timeout_expirations(const of_switch_t* sw);
+void of_sample_pipeline_flow_rates(const of_switch_t* sw);
 
 //Wrapping port management
 rofl_result_t __of_attach_port_to_switch_at_port_num(of_switch_t* sw, unsigned int port_num, switch_port_t* port);
@@ -36,8 +36,10 @@ ROFL_BEGIN_DECLS
 * which is used to process packets lockless. It is up to the rofl-pipeline user to prevent two threads
 * (or processes/bare metal CPUs sharing memory) to use the same TID.
 *
-* The special ROFL_PIPELINE_LOCKED_TID is a special ID, which allow at the expense of memory barriers and
-* locking.
+* The special ROFL_PIPELINE_LOCKED_TID is a special ID, which can be shared by several threads, at the expense
+* of atomic operations (statistics and grace period accounting).
+*
+* Flow lookup is lock-free in all builds (RCU, see threading.h); tables are never locked for reading.
 * 
 * @param tid Thread ID. 
 * @param sw The switch which has to process the packet 
@@ -48,8 +50,8 @@ ROFL_BEGIN_DECLS
 static inline rofl_result_t of_process_packet_pipeline(const unsigned int tid, const of_switch_t* sw, struct datapacket *const pkt){
 
 #ifdef DEBUG
-	if(unlikely(tid >= ROFL_PIPELINE_MAX_TIDS)){
-		ROFL_PIPELINE_ERR("Invalid tid: %ui. ROFL_PIPELINE_MAX_TIDS is %u\n", tid, ROFL_PIPELINE_MAX_TIDS);
+	if(unlikely(tid >= tid_get_num_of_tids())){
+		ROFL_PIPELINE_ERR("Invalid tid: %u. Number of TIDs in use is %u\n", tid, tid_get_num_of_tids());
 		assert(0);
 	}
 #endif
@@ -82,6 +82,25 @@ void platform_of1x_notify_flow_removed(const of1x_switch_t* sw,
 						of1x_flow_remove_reason_t reason, 
 						of1x_flow_entry_t* removed_flow_entry);
 
+#ifdef ROFL_PIPELINE_BATCH_FLOW_REMOVED
+/**
+* @brief Flow removed event notification of a batch of entries (e.g. expired at once)
+* @ingroup async_events_hooks_of1x 
+*
+* Only used (and required) if the library is configured with
+* --with-pipeline-batch-flow-removed; otherwise batches are notified through
+* platform_of1x_notify_flow_removed(), once per entry.
+*
+* @param removed_flow_entries The entries (of the same table) shall ONLY be used for reading,
+* and shall NEVER be removed (of1x_remove_flow_entry). This is done by the library itself
+* @param reasons Reason of the removal of each entry
+*/
+void platform_of1x_notify_flows_removed(const of1x_switch_t* sw, 	
+						of1x_flow_entry_t** removed_flow_entries,
+						of1x_flow_remove_reason_t* reasons,
+						unsigned int num_of_entries);
+#endif
+
 /**
 * @brief It can be used by hardware or other software (non rofl-pipeline) pipelines, to install the new entry. The entry has been already validated and added the state management
 * @param new_entry		flow entry to add
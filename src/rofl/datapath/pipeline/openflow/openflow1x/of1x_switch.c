@@ -250,6 +250,9 @@ void of1x_dump_switch(of1x_switch_t* sw, bool nbo){
 	ROFL_PIPELINE_INFO("Name: %s\n",sw->name);
 	ROFL_PIPELINE_INFO("OpenFlow version: %s\n", of_version_str[sw->of_ver]);
 	ROFL_PIPELINE_INFO("OpenFlow datapathid: 0x%" PRIx64 "\n",sw->dpid);
+
+	//Latency histograms (if enabled)
+	__of1x_dump_latency(&sw->pipeline);
 }
 
 void of1x_full_dump_switch(of1x_switch_t* sw, bool nbo){
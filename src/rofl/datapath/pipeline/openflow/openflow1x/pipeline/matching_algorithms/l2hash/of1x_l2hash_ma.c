@@ -28,6 +28,13 @@ rofl_result_t of1x_init_l2hash(struct of1x_flow_table *const table){
 	//Cleanup everything
 	memset(table->matching_aux[0], 0, sizeof(l2hash_state_t));	
 
+	//Loop state (priority index), since loop routines are reused
+	if(of1x_init_loop(table) != ROFL_SUCCESS){
+		platform_free_shared(table->matching_aux[0]);
+		table->matching_aux[0] = NULL;
+		return ROFL_FAILURE;
+	}
+
 	//Matches and wildcards support
 	bitmap128_clean(&table->config.match);
 	bitmap128_set(&table->config.match, OF1X_MATCH_ETH_DST);
@@ -125,6 +132,9 @@ rofl_result_t of1x_destroy_l2hash(struct of1x_flow_table *const table){
 	l2hash_destroy_ht(&((struct l2hash_state*)table->matching_aux[0])->vlan);
 	l2hash_destroy_ht(&((struct l2hash_state*)table->matching_aux[0])->no_vlan);
 	platform_free_shared(table->matching_aux[0]);
+
+	//Loop state
+	__of1x_destroy_loop_state(table);
 	
 	return ROFL_FAILURE; 
 }
@@ -176,8 +186,8 @@ void of1x_add_hook_l2hash(of1x_flow_entry_t *const entry){
 	if(vlan){
 		//VLAN
 		l2hash_vlan_key_t key;
-		key.vid = vlan->__tern->value.u16 & vlan->__tern->mask.u16;	
-		key.eth_dst = eth_dst->__tern->value.u64 & eth_dst->__tern->mask.u64;
+		key.vid = vlan->__tern.value.u16 & vlan->__tern.mask.u16;	
+		key.eth_dst = eth_dst->__tern.value.u64 & eth_dst->__tern.mask.u64;
 		//calculate hash	
 		hash = l2hash_ht_hash96((const char*)&key, sizeof(l2hash_vlan_key_t)); 		
 		//Fill in ps
@@ -195,7 +205,7 @@ void of1x_add_hook_l2hash(of1x_flow_entry_t *const entry){
 	}else{
 		//NO-VLAN
 		l2hash_novlan_key_t key;
-		key.eth_dst = eth_dst->__tern->value.u64 & eth_dst->__tern->mask.u64;
+		key.eth_dst = eth_dst->__tern.value.u64 & eth_dst->__tern.mask.u64;
 		//calculate hash	
 		hash = l2hash_ht_hash64((const char*)&key, sizeof(l2hash_novlan_key_t));
 
@@ -219,6 +229,13 @@ void of1x_add_hook_l2hash(of1x_flow_entry_t *const entry){
 void of1x_modify_hook_l2hash(of1x_flow_entry_t *const entry){
 	//We don't care
 }
+
+//Releases the entry state and its (unlinked) hash table bucket
+static void l2hash_release_entry_ps(void* ps){
+	platform_free_shared(((l2hash_entry_ps_t*)ps)->bucket);
+	platform_free_shared(ps);
+}
+
 void of1x_remove_hook_l2hash(of1x_flow_entry_t *const entry){
 	
 	l2hash_state_t* state = (l2hash_state_t*)entry->table->matching_aux[0];
@@ -239,11 +256,9 @@ void of1x_remove_hook_l2hash(of1x_flow_entry_t *const entry){
 		state->no_vlan.num_of_entries--;
 	}
 
-#ifdef ROFL_PIPELINE_LOCKLESS
-	tid_wait_all_not_present(&entry->table->tid_presence_mask);
-#endif
-
-	platform_free_shared(entry->platform_state);
+	//Lookups may still be walking the bucket; release it (deferred) without
+	//waiting, so that batches of removals only need a single grace period
+	tid_defer_release(ps, l2hash_release_entry_ps);
 	entry->platform_state = NULL;
 }
 
@@ -258,6 +273,11 @@ rofl_of1x_fm_result_t of1x_add_flow_entry_l2hash(of1x_flow_table_t *const table,
 	return __of1x_add_flow_entry_loop(table, entry, check_overlap, reset_counts, of1x_add_hook_l2hash);
 }
 
+rofl_of1x_fm_result_t of1x_add_flow_entries_l2hash(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts){
+	//Call loop with the right hooks
+	return __of1x_add_flow_entries_loop(table, entries, num_of_entries, check_overlap, reset_counts, of1x_add_hook_l2hash, of1x_remove_hook_l2hash);
+}
+
 rofl_result_t of1x_modify_flow_entry_l2hash(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, const enum of1x_flow_removal_strictness strict, bool reset_counts){
 	//Call loop with the right hooks
 	return __of1x_modify_flow_entry_loop(table, entry, strict, reset_counts, of1x_add_hook_l2hash, of1x_modify_hook_l2hash);
@@ -268,6 +288,11 @@ rofl_result_t of1x_remove_flow_entry_l2hash(of1x_flow_table_t *const table , of1
 	return __of1x_remove_flow_entry_loop(table, entry, specific_entry, strict, out_port, out_group, reason, mutex_acquired, of1x_remove_hook_l2hash);
 }
 
+rofl_result_t of1x_remove_flow_entries_l2hash(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries){
+	//Call loop with the right hooks
+	return __of1x_remove_flow_entries_loop(table, entries, reasons, num_of_entries, of1x_remove_hook_l2hash);
+}
+
 //Define the matching algorithm struct
 OF1X_REGISTER_MATCHING_ALGORITHM(l2hash) = {
 	//Init and destroy hooks
@@ -276,8 +301,10 @@ OF1X_REGISTER_MATCHING_ALGORITHM(l2hash) = {
 
 	//Flow mods
 	.add_flow_entry_hook = of1x_add_flow_entry_l2hash,
+	.add_flow_entries_hook = of1x_add_flow_entries_l2hash,
 	.modify_flow_entry_hook = of1x_modify_flow_entry_l2hash,
 	.remove_flow_entry_hook = of1x_remove_flow_entry_l2hash,
+	.remove_flow_entries_hook = of1x_remove_flow_entries_l2hash,
 
 	//Stats
 	.get_flow_stats_hook = of1x_get_flow_stats_loop,
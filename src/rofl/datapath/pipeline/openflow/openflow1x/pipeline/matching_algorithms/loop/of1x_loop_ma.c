@@ -8,6 +8,7 @@
 #include "../../of1x_match.h"
 #include "../../of1x_group_table.h"
 #include "../../of1x_instruction.h"
+#include "../../of1x_flow_iterator.h"
 #include "../../../of1x_async_events_hooks.h"
 #include "../../../../../platform/lock.h"
 #include "../../../../../platform/likely.h"
@@ -52,42 +53,446 @@ void of1x_remove_flow_entry_table_trace( of1x_flow_entry_t *const entry, of1x_fl
 
 }
 
-/**
-* Looks for an overlapping entry from the entry pointer by start_entry. This is an EXPENSIVE call
+/*
+*
+* Priority index
+*
+*/
+#define LOOP_PRIO_INDEX_SEED 0x2545F491
+
+static unsigned int loop_prio_index_random_level(loop_state_t* state){
+	unsigned int level = 1;
+	uint32_t x = state->seed;
+
+	//xorshift32
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	state->seed = x;
+
+	//p=1/4
+	while( (x & 0x3) == 0 && level < LOOP_PRIO_INDEX_MAX_LEVEL ){
+		level++;
+		x >>= 2;
+	}
+	return level;
+}
+
+/*
+* Looks for the bucket of priority. If update is not NULL, it is filled with the
+* last node (per level) with a higher priority
 */
-static of1x_flow_entry_t* of1x_flow_table_loop_check_overlapping(of1x_flow_entry_t *const start_entry, of1x_flow_entry_t* entry, bool check_cookie, uint32_t out_port, uint32_t out_group){
+static loop_prio_bucket_t* loop_prio_index_find(loop_state_t* state, uint32_t priority, loop_prio_bucket_t** update){
 
-	of1x_flow_entry_t* it; //Just for code clarity
+	int i;
+	loop_prio_bucket_t* it = &state->head;
 
-	//Empty table
-	if( !start_entry )
-		return NULL;
+	for(i=state->level-1;i>=0;i--){
+		while(it->next[i] && it->next[i]->priority > priority)
+			it = it->next[i];
+		if(update)
+			update[i] = it;
+	}
 
-	for(it=start_entry; it != NULL; it=it->next){
-		if( __of1x_flow_entry_check_overlap(it, entry, true, check_cookie, out_port, out_group) )
-			return it;
-	}	
+	it = it->next[0];
+	if(it && it->priority == priority)
+		return it;
 	return NULL;
 }
 
-/**
-* Looks for a previously added entry from the entry pointer by start_entry. This is an EXPENSIVE call
+/*
+* Returns the bucket of priority, creating it if necessary
 */
-static of1x_flow_entry_t* of1x_flow_table_loop_check_identical(of1x_flow_entry_t *const start_entry, of1x_flow_entry_t* entry, uint32_t out_port, uint32_t out_group, bool check_cookie){
+static loop_prio_bucket_t* loop_prio_index_get(loop_state_t* state, uint32_t priority){
+
+	unsigned int i, level;
+	loop_prio_bucket_t* update[LOOP_PRIO_INDEX_MAX_LEVEL];
+	loop_prio_bucket_t* bucket;
 
-	of1x_flow_entry_t* it; //Just for code clarity
+	bucket = loop_prio_index_find(state, priority, update);
+	if(bucket)
+		return bucket;
 
-	//Empty table
-	if(!start_entry)
+	bucket = (loop_prio_bucket_t*)platform_malloc_shared(sizeof(loop_prio_bucket_t));
+	if(unlikely(bucket == NULL))
 		return NULL;
+	platform_memset(bucket, 0, sizeof(loop_prio_bucket_t));
 
-	for(it=start_entry; it != NULL; it=it->next){
-		if( __of1x_flow_entry_check_equal(it, entry, out_port, out_group, check_cookie) )
-			return it;
-	}	
-	return NULL;
+	level = loop_prio_index_random_level(state);
+	if(level > state->level){
+		for(i=state->level;i<level;i++)
+			update[i] = &state->head;
+		state->level = level;
+	}
+
+	bucket->priority = priority;
+	bucket->level = level;
+	for(i=0;i<level;i++){
+		bucket->next[i] = update[i]->next[i];
+		update[i]->next[i] = bucket;
+	}
+	state->num_of_buckets++;
+
+	return bucket;
+}
+
+static void loop_prio_index_remove_bucket(loop_state_t* state, loop_prio_bucket_t* bucket){
+
+	unsigned int i;
+	loop_prio_bucket_t* update[LOOP_PRIO_INDEX_MAX_LEVEL];
+
+	if(unlikely(loop_prio_index_find(state, bucket->priority, update) != bucket)){
+		assert(0);
+		return;
+	}
+
+	for(i=0;i<bucket->level;i++){
+		if(update[i]->next[i] != bucket)
+			break;
+		update[i]->next[i] = bucket->next[i];
+	}
+
+	while(state->level > 1 && state->head.next[state->level-1] == NULL)
+		state->level--;
+
+	state->num_of_buckets--;
+	if(bucket->runs)
+		platform_free_shared(bucket->runs);
+	platform_free_shared(bucket);
+}
+
+/*
+* Returns the position of the first run with num_of_matches or less matches
+* (bucket->num_of_runs if none)
+*/
+static unsigned int loop_prio_run_position(loop_prio_bucket_t* bucket, unsigned int num_of_matches){
+
+	unsigned int low = 0, high = bucket->num_of_runs, mid;
+
+	while(low < high){
+		mid = (low+high)/2;
+		if(bucket->runs[mid].num_of_matches > num_of_matches)
+			low = mid+1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+//Makes room for num_of_runs new runs
+static rofl_result_t loop_prio_run_reserve(loop_prio_bucket_t* bucket, unsigned int num_of_runs){
+
+	unsigned int i, capacity;
+	loop_prio_run_t* runs;
+
+	if(bucket->num_of_runs + num_of_runs <= bucket->runs_capacity)
+		return ROFL_SUCCESS;
+
+	capacity = (bucket->runs_capacity)? bucket->runs_capacity : LOOP_PRIO_RUNS_MIN_CAPACITY;
+	while(capacity < bucket->num_of_runs + num_of_runs)
+		capacity *= 2;
+	runs = (loop_prio_run_t*)platform_malloc_shared(sizeof(loop_prio_run_t)*capacity);
+	if(unlikely(runs == NULL))
+		return ROFL_FAILURE;
+
+	if(bucket->runs){
+		for(i=0;i<bucket->num_of_runs;i++)
+			runs[i] = bucket->runs[i];
+		platform_free_shared(bucket->runs);
+	}
+	bucket->runs = runs;
+	bucket->runs_capacity = capacity;
+
+	return ROFL_SUCCESS;
+}
+
+//Returns true if an entry with num_of_matches, inserted at pos, opens a new run
+static inline bool loop_prio_run_is_new(loop_prio_bucket_t* bucket, unsigned int pos, unsigned int num_of_matches){
+	return pos == bucket->num_of_runs || bucket->runs[pos].num_of_matches != num_of_matches;
+}
+
+//Accounts an entry inserted at the head of the run at pos (creating it if necessary, capacity reserved)
+static void loop_prio_run_add_entry(loop_prio_bucket_t* bucket, unsigned int pos, of1x_flow_entry_t* entry){
+
+	unsigned int i;
+
+	if(!loop_prio_run_is_new(bucket, pos, entry->matches.num_elements))
+		return;
+
+	for(i=bucket->num_of_runs;i>pos;i--)
+		bucket->runs[i] = bucket->runs[i-1];
+	bucket->runs[pos].num_of_matches = entry->matches.num_elements;
+	bucket->runs[pos].last = entry;
+	bucket->num_of_runs++;
+}
+
+//Accounts the removal of an entry (MUST be called before bucket->first is updated)
+static void loop_prio_run_remove_entry(loop_prio_bucket_t* bucket, of1x_flow_entry_t* entry){
+
+	unsigned int i, pos = loop_prio_run_position(bucket, entry->matches.num_elements);
+
+	if(unlikely(pos == bucket->num_of_runs || bucket->runs[pos].num_of_matches != entry->matches.num_elements)){
+		assert(0);
+		return;
+	}
+
+	if(bucket->runs[pos].last != entry)
+		return;
+
+	//Runs are contiguous
+	if(entry != bucket->first && entry->prev->matches.num_elements == entry->matches.num_elements){
+		bucket->runs[pos].last = entry->prev;
+		return;
+	}
+
+	bucket->num_of_runs--;
+	for(i=pos;i<bucket->num_of_runs;i++)
+		bucket->runs[i] = bucket->runs[i+1];
+}
+
+/*
+* Returns the last entry (list order) with a priority higher than bucket's, or NULL
+*/
+static of1x_flow_entry_t* loop_prio_index_prev_entry(loop_state_t* state, loop_prio_bucket_t* bucket){
+
+	loop_prio_bucket_t* update[LOOP_PRIO_INDEX_MAX_LEVEL];
+
+	loop_prio_index_find(state, bucket->priority, update);
+
+	//Skip empty buckets (reserved by bundles)
+	while(update[0] != &state->head && update[0]->num_of_entries == 0)
+		loop_prio_index_find(state, update[0]->priority, update);
+
+	if(update[0] == &state->head)
+		return NULL;
+	return update[0]->last;
+}
+
+//Releases the reservations of bundles and batches: empty buckets and run room
+static void loop_prio_index_release_empty(loop_state_t* state){
+
+	loop_prio_bucket_t *bucket, *next;
+
+	for(bucket = state->head.next[0]; bucket; bucket = next){
+		next = bucket->next[0];
+		bucket->runs_reserved = 0;
+		if(bucket->num_of_entries == 0)
+			loop_prio_index_remove_bucket(state, bucket);
+	}
+}
+
+/*
+*
+* Entry array
+*
+*/
+
+//Fills slot with entry and its compact key
+static void loop_array_set_slot(loop_array_slot_t* slot, of1x_flow_entry_t *const entry){
+
+	of1x_match_t* match = entry->matches.head;
+
+	if(match){
+		slot->type = match->type;
+		slot->vlan_present = match->vlan_present;
+		slot->tern = match->__tern;
+	}else{
+		slot->type = OF1X_MATCH_MAX;
+	}
+
+	//Key before the entry (lockless readers)
+	tid_memory_barrier();
+	slot->entry = entry;
+}
+
+//Builds an array out of the table->entries list. Requires table->mutex
+static loop_array_t* loop_array_build(of1x_flow_table_t *const table){
+
+	unsigned int i, n, capacity;
+	of1x_flow_entry_t* entry;
+	loop_array_t* array;
+
+	capacity = table->num_of_entries + table->num_of_entries/LOOP_ARRAY_GAP_INTERVAL + LOOP_ARRAY_MIN_SLACK;
+
+	array = (loop_array_t*)platform_malloc_shared(sizeof(loop_array_t) + sizeof(loop_array_slot_t)*capacity);
+	if(unlikely(array == NULL))
+		return NULL;
+
+	array->slots = (loop_array_slot_t*)(array+1);
+	array->capacity = capacity;
+	array->num_of_gaps = 0;
+
+	for(i=0, n=0, entry=table->entries; entry; entry=entry->next, n++){
+		//Leave a gap every LOOP_ARRAY_GAP_INTERVAL entries
+		if(n > 0 && (n % LOOP_ARRAY_GAP_INTERVAL) == 0){
+			array->slots[i++].entry = NULL;
+			array->num_of_gaps++;
+		}
+
+		assert(i < capacity);
+		loop_array_set_slot(&array->slots[i], entry);
+		entry->cold->ma_slot = i++;
+	}
+	array->num_of_slots = i;
+
+	return array;
+}
+
+/*
+* Publishes array (NULL disables it) and releases the previous one. Requires
+* table->mutex and table->rwlock (write)
+*/
+static void loop_array_publish(of1x_flow_table_t *const table, loop_state_t* state, loop_array_t* array){
+
+	loop_array_t* old = state->array;
+
+	//Array contents before the pointer
+	tid_memory_barrier();
+	state->array = array;
+
+	if(old){
+		//Wait for the readers of the old array
+		tid_synchronize();
+		platform_free_shared(old);
+	}
+}
+
+static void loop_array_rebuild(of1x_flow_table_t *const table, loop_state_t* state){
+
+	loop_array_t* array = loop_array_build(table);
+
+	if(unlikely(array == NULL)){
+		//The array would no longer mirror the list
+		ROFL_PIPELINE_ERR("%s: unable to allocate memory. Disabling entry array of table %u\n", __func__, table->number);
+	}else{
+		state->num_of_array_builds++;
+	}
+
+	loop_array_publish(table, state, array);
+}
+
+/*
+* Accounting of entries, once linked into (unlinked from) the table->entries
+* list. Require table->mutex and table->rwlock (write)
+*/
+static void loop_array_add_entry(of1x_flow_table_t *const table, loop_state_t* state, of1x_flow_entry_t *const entry){
+
+	unsigned int lo, hi;
+	loop_array_t* array = state->array;
+
+	if(!array)
+		return;
+
+	//Slots between the list neighbours are gaps
+	lo = (entry->prev)? entry->prev->cold->ma_slot+1 : 0;
+	hi = (entry->next)? entry->next->cold->ma_slot : array->num_of_slots;
+
+	if(lo < hi){
+		loop_array_set_slot(&array->slots[lo], entry);
+		entry->cold->ma_slot = lo;
+		array->num_of_gaps--;
+		return;
+	}
+
+	//Tail
+	if(!entry->next && array->num_of_slots < array->capacity){
+		loop_array_set_slot(&array->slots[array->num_of_slots], entry);
+		entry->cold->ma_slot = array->num_of_slots;
+		tid_memory_barrier();
+		array->num_of_slots++;
+		return;
+	}
+
+	loop_array_rebuild(table, state);
+}
+
+static void loop_array_remove_entry(of1x_flow_table_t *const table, loop_state_t* state, of1x_flow_entry_t *const entry){
+
+	loop_array_t* array = state->array;
+
+	if(!array)
+		return;
+
+	assert(array->slots[entry->cold->ma_slot].entry == entry);
+	array->slots[entry->cold->ma_slot].entry = NULL;
+	array->num_of_gaps++;
+
+	//Compact
+	if(array->num_of_gaps > LOOP_ARRAY_MIN_SLACK && array->num_of_gaps > table->num_of_entries)
+		loop_array_rebuild(table, state);
+}
+
+rofl_result_t of1x_init_loop(struct of1x_flow_table *const table){
+
+	loop_state_t* state;
+
+	state = (loop_state_t*)platform_malloc_shared(sizeof(loop_state_t));
+	if(unlikely(state == NULL))
+		return ROFL_FAILURE;
+
+	platform_memset(state, 0, sizeof(loop_state_t));
+	state->level = 1;
+	state->seed = LOOP_PRIO_INDEX_SEED;
+
+	table->matching_aux[1] = (void*)state;
+
+	return ROFL_SUCCESS;
 }
 
+void __of1x_destroy_loop_state(struct of1x_flow_table *const table){
+
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	loop_prio_bucket_t *bucket, *next;
+
+	if(!state)
+		return;
+
+	for(bucket = state->head.next[0]; bucket; bucket = next){
+		next = bucket->next[0];
+		if(bucket->runs)
+			platform_free_shared(bucket->runs);
+		platform_free_shared(bucket);
+	}
+
+	if(state->array)
+		platform_free_shared(state->array);
+	platform_free_shared(state);
+	table->matching_aux[1] = NULL;
+}
+
+/**
+* Looks for an overlapping entry within the (same) priority range of entry. Note that
+* in OF1.0 the overlap check ignores the non-wildcarded flag of the priority.
+*/
+static of1x_flow_entry_t* of1x_flow_table_loop_check_overlapping(of1x_flow_table_t *const table, of1x_flow_entry_t* entry, bool check_cookie, uint32_t out_port, uint32_t out_group){
+
+	unsigned int i;
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	of1x_flow_entry_t* it;
+	loop_prio_bucket_t* bucket;
+	uint32_t priorities[2];
+
+	//Use the overlap index, unless it could not be maintained
+	if(likely(table->overlap_index.enabled))
+		return __of1x_overlap_index_find(table, entry, check_cookie, out_port, out_group);
+
+	priorities[0] = entry->priority & OF1X_2_BYTE_MASK;
+	priorities[1] = priorities[0] | OF10_NON_WILDCARDED_PRIORITY_FLAG;
+
+	for(i=0;i<2;i++){
+		bucket = loop_prio_index_find(state, priorities[i], NULL);
+		if(!bucket)
+			continue;
+
+		for(it=bucket->first; it; it=it->next){
+			if( __of1x_flow_entry_check_overlap(it, entry, true, check_cookie, out_port, out_group) )
+				return it;
+			if(it == bucket->last)
+				break;
+		}
+	}
+	return NULL;
+}
 
 /*
 *
@@ -96,8 +501,11 @@ static of1x_flow_entry_t* of1x_flow_table_loop_check_identical(of1x_flow_entry_t
 * and table pointer, but no further checkings are done (including lookup in the table linked list)
 *
 */
-static rofl_result_t of1x_remove_flow_entry_table_specific_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const specific_entry, of1x_flow_remove_reason_t reason, void (*ma_hook_ptr)(of1x_flow_entry_t*)){
+static rofl_result_t of1x_detach_flow_entry_table_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const specific_entry, of1x_flow_remove_reason_t reason, void (*ma_hook_ptr)(of1x_flow_entry_t*), bool wrlocked){
 	
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	loop_prio_bucket_t* bucket;
+
 	if( unlikely(table->num_of_entries == 0) ) 
 		return ROFL_FAILURE; 
 
@@ -109,8 +517,13 @@ static rofl_result_t of1x_remove_flow_entry_table_specific_imp(of1x_flow_table_t
 	if(specific_entry->next && unlikely(specific_entry->next->prev != specific_entry))
 		return ROFL_FAILURE; 
 
+	bucket = loop_prio_index_find(state, specific_entry->priority, NULL);
+	if(unlikely(bucket == NULL))
+		return ROFL_FAILURE;
+
 	//Prevent readers to jump in
-	platform_rwlock_wrlock(table->rwlock);
+	if(!wrlocked)
+		platform_rwlock_wrlock(table->rwlock);
 
 #ifdef DEBUG
 	of1x_remove_flow_entry_table_trace(NULL, specific_entry, reason);
@@ -128,58 +541,83 @@ static rofl_result_t of1x_remove_flow_entry_table_specific_imp(of1x_flow_table_t
 			specific_entry->next->prev = specific_entry->prev;
 	}
 	table->num_of_entries--;
+
+	loop_array_remove_entry(table, state, specific_entry);
 	
 	//Green light to readers and other writers			
-	platform_rwlock_wrunlock(table->rwlock);
+	if(!wrlocked)
+		platform_rwlock_wrunlock(table->rwlock);
+
+	//Update the priority index (batches keep the empty buckets, so that a
+	//rollback can reinstate entries without allocating)
+	loop_prio_run_remove_entry(bucket, specific_entry);
+	if(--bucket->num_of_entries == 0){
+		if(!wrlocked)
+			loop_prio_index_remove_bucket(state, bucket);
+	}else{
+		if(bucket->first == specific_entry)
+			bucket->first = specific_entry->next;
+		if(bucket->last == specific_entry)
+			bucket->last = specific_entry->prev;
+	}
 
 	// let the platform do the necessary cleanup
 	if(ma_hook_ptr)
 		(*ma_hook_ptr)(specific_entry);
+	__of1x_miss_filter_remove_entry(table, specific_entry);
+	__of1x_strict_index_remove_entry(table, specific_entry);
+	__of1x_cookie_index_remove_entry(table, specific_entry);
+	__of1x_reverse_index_remove_entry(table, specific_entry);
+	__of1x_overlap_index_remove_entry(table, specific_entry);
+	__of1x_flow_iterators_remove_entry(table, specific_entry);
 	platform_of1x_remove_entry_hook(specific_entry);
 
-	//Destroy entry
-#ifdef ROFL_PIPELINE_LOCKLESS
-	tid_wait_all_not_present(&table->tid_presence_mask);	
-#endif
-	return __of1x_destroy_flow_entry_with_reason(specific_entry, reason);
+	return ROFL_SUCCESS;
+}
+
+static rofl_result_t of1x_remove_flow_entry_table_specific_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const specific_entry, of1x_flow_remove_reason_t reason, void (*ma_hook_ptr)(of1x_flow_entry_t*)){
+
+	if(of1x_detach_flow_entry_table_imp(table, specific_entry, reason, ma_hook_ptr, false) != ROFL_SUCCESS)
+		return ROFL_FAILURE;
+
+	//Notify now, but release the entry once no packet processing thread can be using it
+	__of1x_retire_flow_entry_with_reason(specific_entry, reason);
+	tid_defer_release(specific_entry, __of1x_release_flow_entry);
+	return ROFL_SUCCESS;
 }
 
+/*
+* Bundle (__of1x_add_flow_entries_loop()) state. The table->rwlock is held
+* during the whole bundle, and the replaced entries are only detached, to be
+* destroyed on commit after a single quiescence wait, or reinstated on rollback
+*/
+typedef struct loop_bundle{
+	of1x_flow_entry_t** detached;
+	unsigned int num_of_detached;
+	void (*ma_remove_hook_ptr)(of1x_flow_entry_t*);
+}loop_bundle_t;
+
 /* 
 * Adds flow_entry to the main table. This function is NOT thread safe, and mutual exclusion should be 
 * acquired BEFORE this function being called, using table->mutex var. 
 */
-rofl_of1x_fm_result_t of1x_add_flow_entry_table_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_overlap, bool reset_counts, void (*ma_hook_ptr)(of1x_flow_entry_t*)){
-	of1x_flow_entry_t *it, *prev, *existing=NULL;
+static rofl_of1x_fm_result_t of1x_add_flow_entry_table_bundle_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_overlap, bool reset_counts, void (*ma_hook_ptr)(of1x_flow_entry_t*), loop_bundle_t* bundle){
+	of1x_flow_entry_t *prev, *existing=NULL;
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	loop_prio_bucket_t* bucket;
+	unsigned int run;
 	
 	if(unlikely(table->num_of_entries == OF1X_MAX_NUMBER_OF_TABLE_ENTRIES)){
 		return ROFL_OF1X_FM_FAILURE; 
 	}
 
-	if(!table->entries){
-		//No rule yet
-		entry->prev = NULL;
-		entry->next = NULL;
-		table->entries = entry;
-		//Point entry table to us
-		entry->table = table;
-
-		table->num_of_entries++;
-
-		// let the platform do the necessary add operations
-		if(ma_hook_ptr)
-			(*ma_hook_ptr)(entry);
-		plaftorm_of1x_add_entry_hook(entry);
-
-		return ROFL_OF1X_FM_SUCCESS;
-	}
-
 	//Check overlapping
-	if(check_overlap && of1x_flow_table_loop_check_overlapping(table->entries, entry, false, OF1X_PORT_ANY, OF1X_GROUP_ANY)) //Why spec is saying not to match cookie only in flow_mod add??
+	if(check_overlap && of1x_flow_table_loop_check_overlapping(table, entry, false, OF1X_PORT_ANY, OF1X_GROUP_ANY)) //Why spec is saying not to match cookie only in flow_mod add??
 		return ROFL_OF1X_FM_OVERLAP;
 
 	//Look for existing entries (only if check_overlap is false)
 	if(!check_overlap)
-		existing = of1x_flow_table_loop_check_identical(table->entries, entry, OF1X_PORT_ANY, OF1X_GROUP_ANY, false); //According to spec do NOT check cookie
+		existing = __of1x_strict_index_find(table, entry, OF1X_PORT_ANY, OF1X_GROUP_ANY, false); //According to spec do NOT check cookie
 
 	if(existing){
 		ROFL_PIPELINE_DEBUG("[flowmod-add(%p)] Existing entry(%p) will be replaced by (%p)\n", entry, existing, entry);
@@ -192,104 +630,102 @@ rofl_of1x_fm_result_t of1x_add_flow_entry_table_imp(of1x_flow_table_t *const tab
 		
 		//Let it add normally...
 	}
-	
-	//Look for appropiate position in the table
-	for(it=table->entries,prev=NULL; it!=NULL;prev=it,it=it->next){
-//		if(it->num_of_matches<= entry->num_of_matches || ( it->num_of_matches<= entry->num_of_matches && it->priority<entry->priority ) ){ //HITS|PRIORITY
-		if(it->priority < entry->priority || (it->priority == entry->priority && it->matches.num_elements <= entry->matches.num_elements) ){ //PRIORITY|HITS
-			//Insert
-			if(prev == NULL){
-				//Set current entry
-				entry->prev = NULL; 
-				entry->next = it; 
-
-				//Prevent readers to jump in
-				platform_rwlock_wrlock(table->rwlock);
-					
-				//Place in the head
-				it->prev = entry;
-				table->entries = entry;	
-			}else{
-				//Set current entry
-				entry->prev = prev;
-				entry->next = prev->next;
-				
-				//Prevent readers to jump in
-				platform_rwlock_wrlock(table->rwlock);
-				
-				//Add to n+1 if not tail
-				if(prev->next)
-					prev->next->prev = entry;
-				//Fix prev
-				prev->next = entry;
-				
-			}
-			//Unlock mutexes
-			platform_rwlock_wrunlock(table->rwlock);
 
-			//Increment the number of entries in the table (safe since we have the mutex acquired)
-			table->num_of_entries++;
-	
-			//Point entry table to us
-			entry->table = table;
-
-			//Delete old entry
-			if(existing){
-				ROFL_PIPELINE_DEBUG("[flowmod-add(%p)] Removing old entry (%p)\n", entry, existing);
-#ifdef ROFL_PIPELINE_LOCKLESS
-				tid_wait_all_not_present(&table->tid_presence_mask);	
-#endif
+	//Look for appropiate position in the table (PRIORITY|NUMBER OF MATCHES), only within the priority range
+	bucket = loop_prio_index_get(state, entry->priority);
+	if(unlikely(bucket == NULL))
+		return ROFL_OF1X_FM_FAILURE;
 
-				if(of1x_remove_flow_entry_table_specific_imp(table,existing, OF1X_FLOW_REMOVE_NO_REASON, ma_hook_ptr) != ROFL_SUCCESS){
-					assert(0);
-				}
-			}
+	//Before the entries with the same or less matches (head of its run)
+	run = loop_prio_run_position(bucket, entry->matches.num_elements);
 
-			// let the platform do the necessary add operations
-			if(ma_hook_ptr)
-				(*ma_hook_ptr)(entry);
-			plaftorm_of1x_add_entry_hook(entry);
+	//Bundles reserved the room upfront, so this never allocates for them
+	if(loop_prio_run_is_new(bucket, run, entry->matches.num_elements) && unlikely(loop_prio_run_reserve(bucket, 1) != ROFL_SUCCESS))
+		return ROFL_OF1X_FM_FAILURE;
+	if(bundle && bucket->runs_reserved > 0)
+		bucket->runs_reserved--;
 
-			return ROFL_OF1X_FM_SUCCESS;
-		}
-	}
-	
-	if(!table->entries){
-		//There are no entries in the table
-		entry->next = entry->prev = NULL;	
+	if(existing){
+		//Right before the replaced entry (same priority and run); iterators move to the new one
+		prev = existing->prev;
+	}else if(bucket->num_of_entries == 0){
+		//First entry of this priority; right after the higher priority ones
+		prev = loop_prio_index_prev_entry(state, bucket);
+	}else if(run > 0){
+		prev = bucket->runs[run-1].last;
 	}else{
-		//Last item
-		entry->next = NULL;
-		entry->prev = prev;
+		prev = bucket->first->prev;
 	}
 
+	//Set current entry
+	entry->prev = prev;
+	entry->next = (prev)? prev->next : table->entries;
+
 	//Point entry table to us
 	entry->table = table;
 
+	//Counters kept by packet processing (table statistics mode)
+	__of1x_stats_flow_set_mode(entry, table);
+
+	//Instructions used by packet processing
+	__of1x_publish_flow_entry_instructions(entry);
+
+	//Account it in the miss filter before it is visible, so that lock-free
+	//lookups never report a definite miss for an installed entry
+	__of1x_miss_filter_add_entry(table, entry);
+
 	//Prevent readers to jump in
-	platform_rwlock_wrlock(table->rwlock);
+	if(!bundle)
+		platform_rwlock_wrlock(table->rwlock);
 
-	if(!table->entries){
-		//No entries
-		table->entries = entry;
-	}else{
-		//Last
+	//Entry contents before the pointer (lock-free readers)
+	tid_memory_barrier();
+
+	if(entry->next)
+		entry->next->prev = entry;
+	if(prev)
 		prev->next = entry;
-	}
-	
-	//Unlock mutexes
-	platform_rwlock_wrunlock(table->rwlock);
-	
+	else
+		table->entries = entry;
+
 	//Increment the number of entries in the table (safe since we have the mutex acquired)
 	table->num_of_entries++;
 
-	//Delete old entry
-	if(existing){
+	loop_array_add_entry(table, state, entry);
+
+	//Unlock mutexes
+	if(!bundle)
+		platform_rwlock_wrunlock(table->rwlock);
+
+	//Update the priority range
+	loop_prio_run_add_entry(bucket, run, entry);
+	if(bucket->num_of_entries == 0){
+		bucket->first = bucket->last = entry;
+	}else{
+		if(entry->next == bucket->first)
+			bucket->first = entry;
+		if(entry->prev == bucket->last)
+			bucket->last = entry;
+	}
+	bucket->num_of_entries++;
+
+	//Delete old entry (bundles defer the destruction to the commit)
+	if(existing)
+		__of1x_flow_iterators_replace_entry(table, existing, entry);
+	if(existing && bundle){
+		ROFL_PIPELINE_DEBUG("[flowmod-add(%p)] Detaching old entry (%p)\n", entry, existing);
+
+		if(unlikely(of1x_detach_flow_entry_table_imp(table, existing, OF1X_FLOW_REMOVE_NO_REASON, bundle->ma_remove_hook_ptr, true) != ROFL_SUCCESS)){
+			assert(0);
+		}
+
+		//Replaced a member of the bundle
+		if(existing->cold->bundle_ref)
+			*existing->cold->bundle_ref = NULL;
+
+		bundle->detached[bundle->num_of_detached++] = existing;
+	}else if(existing){
 		ROFL_PIPELINE_DEBUG("[flowmod-add(%p)] Removing old entry (%p)\n", entry, existing);
-#ifdef ROFL_PIPELINE_LOCKLESS
-		tid_wait_all_not_present(&table->tid_presence_mask);	
-#endif
-		
 		if(unlikely(of1x_remove_flow_entry_table_specific_imp(table,existing, OF1X_FLOW_REMOVE_NO_REASON, ma_hook_ptr) != ROFL_SUCCESS)){
 			assert(0);
 		}
@@ -298,11 +734,65 @@ rofl_of1x_fm_result_t of1x_add_flow_entry_table_imp(of1x_flow_table_t *const tab
 	// let the platform do the necessary add operations
 	if(ma_hook_ptr)
 		(*ma_hook_ptr)(entry);
+	__of1x_strict_index_add_entry(table, entry);
+	__of1x_cookie_index_add_entry(table, entry);
+	__of1x_reverse_index_add_entry(table, entry);
+	__of1x_overlap_index_add_entry(table, entry);
+	if(!existing)
+		__of1x_flow_iterators_add_entry(table, entry);
 	plaftorm_of1x_add_entry_hook(entry);
 
 	return ROFL_OF1X_FM_SUCCESS;
 }
 
+rofl_of1x_fm_result_t of1x_add_flow_entry_table_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_overlap, bool reset_counts, void (*ma_hook_ptr)(of1x_flow_entry_t*)){
+	return of1x_add_flow_entry_table_bundle_imp(table, entry, check_overlap, reset_counts, ma_hook_ptr, NULL);
+}
+
+/*
+*
+* Candidates (table indexes)
+*
+*/
+
+//Checks if the table indexes can enumerate the candidates of a (non-strict) filter
+static inline bool of1x_loop_has_candidates(of1x_flow_table_t *const table, uint64_t cookie, uint64_t cookie_mask, bool check_cookie, uint32_t out_port, uint32_t out_group){
+	return __of1x_reverse_index_usable(table, out_port, out_group) || (check_cookie && __of1x_cookie_index_usable(table, cookie, cookie_mask));
+}
+
+/**
+* Retrieves the candidates of a (non-strict) filter from the table indexes. Requires table->mutex.
+* If no index can be used *candidates is set to NULL, and the whole table must be visited.
+*/
+static rofl_result_t of1x_loop_get_candidates(of1x_flow_table_t *const table, uint64_t cookie, uint64_t cookie_mask, bool check_cookie, uint32_t out_port, uint32_t out_group, of1x_flow_entry_t*** candidates, unsigned int* num_of_candidates){
+
+	*candidates = NULL;
+	*num_of_candidates = 0;
+
+	//Output port or group
+	if(__of1x_reverse_index_usable(table, out_port, out_group))
+		return __of1x_reverse_index_get_entries(table, out_port, out_group, candidates, num_of_candidates);
+
+	//Cookie
+	if(check_cookie && __of1x_cookie_index_usable(table, cookie, cookie_mask))
+		return __of1x_cookie_index_get_entries(table, cookie, cookie_mask, candidates, num_of_candidates);
+
+	return ROFL_SUCCESS;
+}
+
+//Iteration over the candidates, or over the whole table if there are none
+static inline of1x_flow_entry_t* of1x_loop_first_candidate(of1x_flow_table_t *const table, of1x_flow_entry_t** candidates, unsigned int num_of_candidates){
+	if(candidates)
+		return (num_of_candidates > 0)? candidates[0] : NULL;
+	return table->entries;
+}
+
+static inline of1x_flow_entry_t* of1x_loop_next_candidate(of1x_flow_entry_t* entry, of1x_flow_entry_t** candidates, unsigned int num_of_candidates, unsigned int* i){
+	if(candidates)
+		return (++(*i) < num_of_candidates)? candidates[*i] : NULL;
+	return entry->next;
+}
+
 /*
 * 
 * ENTRY removal for non-specific entries. It will remove the FIRST matching entry. This function assumes that match order of table_entry and entry are THE SAME. If not 
@@ -314,45 +804,55 @@ rofl_of1x_fm_result_t of1x_add_flow_entry_table_imp(of1x_flow_table_t *const tab
 static rofl_result_t of1x_remove_flow_entry_table_non_specific_imp(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, const enum of1x_flow_removal_strictness strict, uint32_t out_port, uint32_t out_group, of1x_flow_remove_reason_t reason, void (*ma_hook_ptr)(of1x_flow_entry_t*)){
 
 	int deleted=0; 
-	of1x_flow_entry_t *it, *it_next;
+	unsigned int i, num_of_candidates;
+	of1x_flow_entry_t *it, *it_next, **candidates;
 	of_version_t ver = table->pipeline->sw->of_ver;
 
 	if(table->num_of_entries == 0) 
 		return ROFL_SUCCESS; //according to spec 
 
-	//Loop over all the table entries	
-	for(it=table->entries; it; it=it_next){
-		
-		//Save next item
-		it_next = it->next;
-		
-		if( strict == STRICT ){
-			//Strict make sure they are equal
-			if( __of1x_flow_entry_check_equal(it, entry, out_port, out_group, true && (ver != OF_VERSION_10)) ){
+	if( strict == STRICT ){
+		//Strict make sure they are equal (at most one entry)
+		it = __of1x_strict_index_find(table, entry, out_port, out_group, true && (ver != OF_VERSION_10));
+		if(it){
 #ifdef DEBUG
-				of1x_remove_flow_entry_table_trace(entry, it, reason);
+			of1x_remove_flow_entry_table_trace(entry, it, reason);
 #endif
-				if(of1x_remove_flow_entry_table_specific_imp(table, it, reason, ma_hook_ptr) != ROFL_SUCCESS){
-					assert(0); //This should never happen
-					return ROFL_FAILURE;
-				}
-				deleted++;
-				break;
+			if(of1x_remove_flow_entry_table_specific_imp(table, it, reason, ma_hook_ptr) != ROFL_SUCCESS){
+				assert(0); //This should never happen
+				return ROFL_FAILURE;
 			}
-		}else{
-			if( __of1x_flow_entry_check_contained(it, entry, strict, true && (ver != OF_VERSION_10), out_port, out_group,false) ){
+		}
+		return ROFL_SUCCESS;
+	}
+
+	//Only visit the candidates, if the table indexes allow it
+	if(of1x_loop_get_candidates(table, entry->cookie, entry->cookie_mask, (ver != OF_VERSION_10), out_port, out_group, &candidates, &num_of_candidates) != ROFL_SUCCESS)
+		return ROFL_FAILURE;
+
+	//Loop over all the table entries (or candidates)
+	for(i=0, it=of1x_loop_first_candidate(table, candidates, num_of_candidates); it; it=it_next){
+		
+		//Save next item
+		it_next = of1x_loop_next_candidate(it, candidates, num_of_candidates, &i);
+		
+		if( __of1x_flow_entry_check_contained(it, entry, strict, true && (ver != OF_VERSION_10), out_port, out_group,false) ){
 #ifdef DEBUG
-				of1x_remove_flow_entry_table_trace(entry, it, reason);
+			of1x_remove_flow_entry_table_trace(entry, it, reason);
 #endif
-				if(of1x_remove_flow_entry_table_specific_imp(table, it, reason, ma_hook_ptr) != ROFL_SUCCESS){
-					assert(0); //This should never happen
-					return ROFL_FAILURE;
-				}
-				deleted++;
+			if(of1x_remove_flow_entry_table_specific_imp(table, it, reason, ma_hook_ptr) != ROFL_SUCCESS){
+				assert(0); //This should never happen
+				if(candidates)
+					platform_free_shared(candidates);
+				return ROFL_FAILURE;
 			}
+			deleted++;
 		}
 	}
 
+	if(candidates)
+		platform_free_shared(candidates);
+
 	//Even if no deletions are performed return SUCCESS
 	//if(deleted == 0)	
 	//	return ROFL_FAILURE; 
@@ -398,62 +898,191 @@ rofl_of1x_fm_result_t __of1x_add_flow_entry_loop(of1x_flow_table_t *const table,
 	//Green light to other threads
 	platform_mutex_unlock(table->mutex);
 
+	//Release the (replaced) entries whose grace period has elapsed
+	tid_reclaim(false);
+
 	return return_value;
 }
 rofl_of1x_fm_result_t of1x_add_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_overlap, bool reset_counts){
 	return __of1x_add_flow_entry_loop(table, entry, check_overlap, reset_counts, NULL);
 }
 
-rofl_result_t __of1x_modify_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, const enum of1x_flow_removal_strictness strict, bool reset_counts, void (*ma_add_hook_ptr)(of1x_flow_entry_t*), void (*ma_modify_hook_ptr)(of1x_flow_entry_t*)){
+/*
+* Bundle of additions. All the resources (entries, buckets and room for the
+* runs) are reserved upfront, so that only an overlap (check_overlap) can make
+* an addition fail. The rollback detaches the entries already added and
+* reinstates the replaced ones, which is allocation free as well: buckets are
+* kept until the end and a bucket never needs more runs than it had.
+*/
+rofl_of1x_fm_result_t __of1x_add_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts, void (*ma_add_hook_ptr)(of1x_flow_entry_t*), void (*ma_remove_hook_ptr)(of1x_flow_entry_t*)){
 
-	int moded=0; 
-	of1x_flow_entry_t *it;
+	unsigned int i;
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	loop_prio_bucket_t* bucket;
+	loop_bundle_t bundle;
+	of1x_flow_entry_t* entry;
+	rofl_of1x_fm_result_t result = ROFL_OF1X_FM_SUCCESS;
+
+	if(num_of_entries == 0)
+		return ROFL_OF1X_FM_SUCCESS;
+
+	//Each entry replaces at most one
+	bundle.detached = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*num_of_entries);
+	if(unlikely(bundle.detached == NULL))
+		return ROFL_OF1X_FM_FAILURE;
+	bundle.num_of_detached = 0;
+	bundle.ma_remove_hook_ptr = ma_remove_hook_ptr;
 
 	//Allow single add/remove operation over the table
 	platform_mutex_lock(table->mutex);
+
+	//Reserve resources
+	if(unlikely(table->num_of_entries + num_of_entries > OF1X_MAX_NUMBER_OF_TABLE_ENTRIES))
+		result = ROFL_OF1X_FM_FAILURE;
+
+	for(i=0;i<num_of_entries;i++){
+		entries[i]->cold->bundle_ref = &entries[i];
+		if(result != ROFL_OF1X_FM_SUCCESS)
+			continue;
+
+		//Worst case, every entry opens a run
+		bucket = loop_prio_index_get(state, entries[i]->priority);
+		if(unlikely(bucket == NULL) || unlikely(loop_prio_run_reserve(bucket, ++bucket->runs_reserved) != ROFL_SUCCESS))
+			result = ROFL_OF1X_FM_FAILURE;
+	}
+
+	//Single acquisition for the whole bundle; lock-free lookups may still see
+	//it partially applied (or rolled back)
+	platform_rwlock_wrlock(table->rwlock);
+
+	for(i=0;i<num_of_entries && result == ROFL_OF1X_FM_SUCCESS;i++){
+		result = of1x_add_flow_entry_table_bundle_imp(table, entries[i], check_overlap, reset_counts, ma_add_hook_ptr, &bundle);
+		if(result != ROFL_OF1X_FM_SUCCESS)
+			break;
+	}
+
+	if(result != ROFL_OF1X_FM_SUCCESS){
+		//Rollback (entries replaced within the bundle are NULL)
+		ROFL_PIPELINE_DEBUG("[flowmod-add-bundle] Rolling back %u entries\n", i);
+
+		while(i > 0){
+			i--;
+			if(!entries[i])
+				continue;
+			if(unlikely(of1x_detach_flow_entry_table_imp(table, entries[i], OF1X_FLOW_REMOVE_NO_REASON, ma_remove_hook_ptr, true) != ROFL_SUCCESS)){
+				assert(0);
+			}
+		}
+
+		//Give back the members to the caller, and the table entries to the table
+		while(bundle.num_of_detached > 0){
+			entry = bundle.detached[--bundle.num_of_detached];
+			if(entry->cold->bundle_ref){
+				*entry->cold->bundle_ref = entry;
+				continue;
+			}
+			if(unlikely(of1x_add_flow_entry_table_bundle_imp(table, entry, false, false, ma_add_hook_ptr, &bundle) != ROFL_OF1X_FM_SUCCESS)){
+				ROFL_PIPELINE_ERR("[flowmod-add-bundle] ERROR: unable to reinstate entry (%p)\n", entry);
+				assert(0);
+			}
+		}
+	}
+
+	platform_rwlock_wrunlock(table->rwlock);
+
+	loop_prio_index_release_empty(state);
+
+	for(i=0;i<num_of_entries;i++){
+		if(entries[i])
+			entries[i]->cold->bundle_ref = NULL;
+	}
+
+	//Single grace period, for the detached entries (only on commit) or the
+	//rolled back ones, before the caller gets them back
+	if(bundle.num_of_detached > 0 || result != ROFL_OF1X_FM_SUCCESS)
+		tid_synchronize();
+	for(i=0;i<bundle.num_of_detached;i++)
+		__of1x_destroy_flow_entry_with_reason(bundle.detached[i], OF1X_FLOW_REMOVE_NO_REASON);
+
+	//Green light to other threads
+	platform_mutex_unlock(table->mutex);
+
+	platform_free_shared(bundle.detached);
+
+	return result;
+}
+
+rofl_of1x_fm_result_t of1x_add_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts){
+	return __of1x_add_flow_entries_loop(table, entries, num_of_entries, check_overlap, reset_counts, NULL, NULL);
+}
+
+//Updates a single entry on modify
+static inline rofl_result_t of1x_modify_flow_entry_loop_update(of1x_flow_entry_t *const it, of1x_flow_entry_t *const entry, bool reset_counts, void (*ma_modify_hook_ptr)(of1x_flow_entry_t*)){
+
+	//Modify hook	
+	if(ma_modify_hook_ptr)
+		(*ma_modify_hook_ptr)(entry);
+
+	//Call platform
+	platform_of1x_modify_entry_hook(it, entry, reset_counts);
+	
+	ROFL_PIPELINE_DEBUG("[flowmod-modify(%p)] Existing entry (%p) will be updated with (%p)\n", entry, it, entry);
 	
-	//Loop over all the table entries	
-	for(it=table->entries; it; it=it->next){
+	return __of1x_update_flow_entry(it, entry, reset_counts);
+}
 
-		if( strict == STRICT ){
-			//Strict make sure they are equal
-			if( __of1x_flow_entry_check_equal(it, entry, OF1X_PORT_ANY, OF1X_GROUP_ANY, true) ){
+rofl_result_t __of1x_modify_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, const enum of1x_flow_removal_strictness strict, bool reset_counts, void (*ma_add_hook_ptr)(of1x_flow_entry_t*), void (*ma_modify_hook_ptr)(of1x_flow_entry_t*)){
 
-				//Modify hook	
-				if(ma_modify_hook_ptr)
-					(*ma_modify_hook_ptr)(entry);
-			
-				//Call platform
-				platform_of1x_modify_entry_hook(it, entry, reset_counts);
-				
-				ROFL_PIPELINE_DEBUG("[flowmod-modify(%p)] Existing entry (%p) will be updated with (%p)\n", entry, it, entry);
-				
-				if(__of1x_update_flow_entry(it, entry, reset_counts) != ROFL_SUCCESS)
-					return ROFL_FAILURE;
-				moded++;
-				break;
+	int moded=0; 
+	unsigned int i, num_of_candidates;
+	of1x_flow_entry_t *it, **candidates=NULL;
+	rofl_result_t res = ROFL_SUCCESS;
+
+	//Allow single add/remove operation over the table
+	platform_mutex_lock(table->mutex);
+	
+	if( strict == STRICT ){
+		//Strict make sure they are equal
+		it = __of1x_strict_index_find(table, entry, OF1X_PORT_ANY, OF1X_GROUP_ANY, true);
+		if(it){
+			if(of1x_modify_flow_entry_loop_update(it, entry, reset_counts, ma_modify_hook_ptr) != ROFL_SUCCESS){
+				res = ROFL_FAILURE;
+				goto MODIFY_END;
 			}
-		}else{
+			moded++;
+		}
+	}else{
+		//Only visit the candidates, if the table indexes allow it
+		if(of1x_loop_get_candidates(table, entry->cookie, entry->cookie_mask, true, OF1X_PORT_ANY, OF1X_GROUP_ANY, &candidates, &num_of_candidates) != ROFL_SUCCESS){
+			candidates = NULL;
+			res = ROFL_FAILURE;
+			goto MODIFY_END;
+		}
+
+		//Loop over all the table entries (or candidates)
+		for(i=0, it=of1x_loop_first_candidate(table, candidates, num_of_candidates); it; it=of1x_loop_next_candidate(it, candidates, num_of_candidates, &i)){
 			if( __of1x_flow_entry_check_contained(it, entry, strict, true, OF1X_PORT_ANY, OF1X_GROUP_ANY,false) ){
-	
-				//Modify hook	
-				if(ma_modify_hook_ptr)
-					(*ma_modify_hook_ptr)(entry);
-			
-				//Call platform
-				platform_of1x_modify_entry_hook(it, entry, reset_counts);
-				
-				ROFL_PIPELINE_DEBUG("[flowmod-modify(%p)] Existing entry (%p) will be updated with (%p)\n", entry, it, entry);
-				
-				if(__of1x_update_flow_entry(it, entry, reset_counts) != ROFL_SUCCESS)
-					return ROFL_FAILURE;
+				if(of1x_modify_flow_entry_loop_update(it, entry, reset_counts, ma_modify_hook_ptr) != ROFL_SUCCESS){
+					res = ROFL_FAILURE;
+					goto MODIFY_END;
+				}
 				moded++;
 			}
 		}
 	}
 
+MODIFY_END:
+	if(candidates)
+		platform_free_shared(candidates);
+
 	platform_mutex_unlock(table->mutex);
 
+	//Release the previous instruction versions whose grace period has elapsed
+	tid_reclaim(false);
+
+	if(res != ROFL_SUCCESS)
+		return res;
+
 	//According to spec
 	if(moded == 0){	
 		//TODO: remove cast
@@ -489,6 +1118,9 @@ rofl_result_t __of1x_remove_flow_entry_loop(of1x_flow_table_t *const table , of1
 		platform_mutex_unlock(table->mutex);
 	}
 
+	//Release the removed entries whose grace period has elapsed
+	tid_reclaim(false);
+
 	return result;
 }
 
@@ -496,11 +1128,64 @@ rofl_result_t of1x_remove_flow_entry_loop(of1x_flow_table_t *const table , of1x_
 	return __of1x_remove_flow_entry_loop(table, entry, specific_entry, strict, out_port, out_group, reason, mutex_acquired, NULL);
 }
 
+/*
+* Batch of specific removals (timer expirations). Requires table->mutex. The
+* entries are detached at once, notified in a single batch and released
+* after a single grace period
+*/
+rofl_result_t __of1x_remove_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries, void (*ma_hook_ptr)(of1x_flow_entry_t*)){
+
+	unsigned int i, num_of_detached = 0;
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+
+	if(num_of_entries == 0)
+		return ROFL_SUCCESS;
+
+	//Single acquisition for the whole batch; lock-free lookups may still see
+	//it partially applied
+	platform_rwlock_wrlock(table->rwlock);
+
+	for(i=0;i<num_of_entries;i++){
+		if(of1x_detach_flow_entry_table_imp(table, entries[i], reasons[i], ma_hook_ptr, true) != ROFL_SUCCESS)
+			continue;
+		entries[num_of_detached] = entries[i];
+		reasons[num_of_detached] = reasons[i];
+		num_of_detached++;
+	}
+
+	platform_rwlock_wrunlock(table->rwlock);
+
+	loop_prio_index_release_empty(state);
+
+	//Notify now, but release the entries once no packet processing thread can be using them
+	__of1x_retire_flow_entries_with_reason(entries, reasons, num_of_detached);
+	__of1x_defer_release_flow_entries(entries, num_of_detached);
+
+	return (num_of_detached == num_of_entries)? ROFL_SUCCESS : ROFL_FAILURE;
+}
+
+rofl_result_t of1x_remove_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries){
+	return __of1x_remove_flow_entries_loop(table, entries, reasons, num_of_entries, NULL);
+}
+
 /*
 *
 * Statistics
 *
 */
+//Checks if the entry is selected by the flow stats request
+static inline bool of1x_get_flow_stats_loop_is_selected(of1x_flow_entry_t* flow_stats_entry, of1x_flow_entry_t* entry, bool check_cookie, uint32_t out_port, uint32_t out_group){
+
+	//Cookie of the request
+	if(check_cookie && flow_stats_entry->cookie != OF1X_DO_NOT_CHECK_COOKIE && flow_stats_entry->cookie_mask){
+		if( ((entry->cookie ^ flow_stats_entry->cookie) & flow_stats_entry->cookie_mask) != 0x0ULL )
+			return false;
+	}
+
+	//Check if is contained 
+	return __of1x_flow_entry_check_contained(flow_stats_entry, entry, false, check_cookie, out_port, out_group, true);
+}
+
 rofl_result_t of1x_get_flow_stats_loop(struct of1x_flow_table *const table,
 		uint64_t cookie,
 		uint64_t cookie_mask,
@@ -509,9 +1194,11 @@ rofl_result_t of1x_get_flow_stats_loop(struct of1x_flow_table *const table,
 		of1x_match_group_t *const matches,
 		of1x_stats_flow_msg_t* msg){
 
-	of1x_flow_entry_t* entry, flow_stats_entry;
+	unsigned int i, num_of_candidates=0;
+	of1x_flow_entry_t* entry, flow_stats_entry, **candidates=NULL;
 	of1x_stats_single_flow_msg_t* flow_stats;
-	bool check_cookie = (table->pipeline->sw->of_ver != OF_VERSION_10);
+	bool use_index, check_cookie = (table->pipeline->sw->of_ver != OF_VERSION_10);
+	rofl_result_t res = ROFL_SUCCESS;
 
 	if( unlikely(msg==NULL) || unlikely(table==NULL) )
 		return ROFL_FAILURE;
@@ -522,16 +1209,25 @@ rofl_result_t of1x_get_flow_stats_loop(struct of1x_flow_table *const table,
 	flow_stats_entry.cookie = cookie;
 	flow_stats_entry.cookie_mask = cookie_mask;
 	check_cookie = ( table->pipeline->sw->of_ver != OF_VERSION_10 ); //Ignore cookie in OF1.0
+
+	//Use the table indexes, if possible. Indexes are only consistent under table->mutex
+	use_index = of1x_loop_has_candidates(table, cookie, cookie_mask, check_cookie, out_port, out_group);
+	if(use_index){
+		platform_mutex_lock(table->mutex);
+		if(of1x_loop_get_candidates(table, cookie, cookie_mask, check_cookie, out_port, out_group, &candidates, &num_of_candidates) != ROFL_SUCCESS){
+			platform_mutex_unlock(table->mutex);
+			return ROFL_FAILURE;
+		}
+	}
 	
 	//Mark table as being read
 	platform_rwlock_rdlock(table->rwlock);
 
 
-	//Loop over the table and calculate stats
-	for(entry = table->entries; entry!=NULL; entry = entry->next){
+	//Loop over the table (or the candidates) and calculate stats
+	for(i=0, entry = of1x_loop_first_candidate(table, candidates, num_of_candidates); entry!=NULL; entry = of1x_loop_next_candidate(entry, candidates, num_of_candidates, &i)){
 	
-		//Check if is contained 
-		if(__of1x_flow_entry_check_contained(&flow_stats_entry, entry, false, check_cookie, out_port, out_group, true)){
+		if(of1x_get_flow_stats_loop_is_selected(&flow_stats_entry, entry, check_cookie, out_port, out_group)){
 
 			// update statistics from platform
 			platform_of1x_update_stats_hook(entry);
@@ -539,8 +1235,10 @@ rofl_result_t of1x_get_flow_stats_loop(struct of1x_flow_table *const table,
 			//Create a new single flow entry and fillin 
 			flow_stats = __of1x_init_stats_single_flow_msg(entry);
 			
-			if(!flow_stats)
-				return ROFL_FAILURE;	
+			if(!flow_stats){
+				res = ROFL_FAILURE;
+				break;
+			}
 	
 			//Push this stat to the msg
 			__of1x_push_single_flow_stats_to_msg(msg, flow_stats);	
@@ -551,7 +1249,12 @@ rofl_result_t of1x_get_flow_stats_loop(struct of1x_flow_table *const table,
 	//Release the table
 	platform_rwlock_rdunlock(table->rwlock);
 
-	return ROFL_SUCCESS;
+	if(use_index){
+		platform_mutex_unlock(table->mutex);
+		platform_free_shared(candidates);
+	}
+
+	return res;
 }
 
 rofl_result_t of1x_get_flow_aggregate_stats_loop(struct of1x_flow_table *const table,
@@ -562,8 +1265,9 @@ rofl_result_t of1x_get_flow_aggregate_stats_loop(struct of1x_flow_table *const t
 		of1x_match_group_t *const matches,
 		of1x_stats_flow_aggregate_msg_t* msg){
 
-	bool check_cookie;
-	of1x_flow_entry_t* entry, flow_stats_entry;
+	bool use_index, check_cookie;
+	unsigned int i, num_of_candidates=0;
+	of1x_flow_entry_t* entry, flow_stats_entry, **candidates=NULL;
 
 	if( unlikely(msg==NULL) || unlikely(table==NULL) )
 		return ROFL_FAILURE;
@@ -575,14 +1279,23 @@ rofl_result_t of1x_get_flow_aggregate_stats_loop(struct of1x_flow_table *const t
 	flow_stats_entry.cookie_mask = cookie_mask;
 	check_cookie = ( table->pipeline->sw->of_ver != OF_VERSION_10 ); //Ignore cookie in OF1.0
 
+	//Use the table indexes, if possible. Indexes are only consistent under table->mutex
+	use_index = of1x_loop_has_candidates(table, cookie, cookie_mask, check_cookie, out_port, out_group);
+	if(use_index){
+		platform_mutex_lock(table->mutex);
+		if(of1x_loop_get_candidates(table, cookie, cookie_mask, check_cookie, out_port, out_group, &candidates, &num_of_candidates) != ROFL_SUCCESS){
+			platform_mutex_unlock(table->mutex);
+			return ROFL_FAILURE;
+		}
+	}
+
 	//Mark table as being read
 	platform_rwlock_rdlock(table->rwlock);
 
-	//Loop over the table and calculate stats
-	for(entry = table->entries; entry!=NULL; entry = entry->next){
+	//Loop over the table (or the candidates) and calculate stats
+	for(i=0, entry = of1x_loop_first_candidate(table, candidates, num_of_candidates); entry!=NULL; entry = of1x_loop_next_candidate(entry, candidates, num_of_candidates, &i)){
 	
-		//Check if is contained 
-		if(__of1x_flow_entry_check_contained(&flow_stats_entry, entry, false, check_cookie, out_port, out_group,true)){
+		if(of1x_get_flow_stats_loop_is_selected(&flow_stats_entry, entry, check_cookie, out_port, out_group)){
 			
 			//Consolidate stats
 			__of1x_stats_flow_tid_t c;
@@ -597,6 +1310,11 @@ rofl_result_t of1x_get_flow_aggregate_stats_loop(struct of1x_flow_table *const t
 	
 	//Release the table
 	platform_rwlock_rdunlock(table->rwlock);
+
+	if(use_index){
+		platform_mutex_unlock(table->mutex);
+		platform_free_shared(candidates);
+	}
 	
 	return ROFL_SUCCESS;
 }
@@ -604,25 +1322,23 @@ rofl_result_t of1x_get_flow_aggregate_stats_loop(struct of1x_flow_table *const t
 /* Group related FLOW entry lookup */ 
 of1x_flow_entry_t* of1x_find_entry_using_group_loop(of1x_flow_table_t *const table, const unsigned int group_id){
 
-	of1x_match_t* it;
 	of1x_flow_entry_t *entry;
 
+	//Use the reverse index (consistent under table->mutex)
+	platform_mutex_lock(table->mutex);
+	if(table->reverse_index.enabled){
+		entry = __of1x_reverse_index_find_first(table, OF1X_AT_GROUP, group_id);
+		platform_mutex_unlock(table->mutex);
+		return entry;
+	}
+	platform_mutex_unlock(table->mutex);
+
 	//Prevent writers to change structure during matching
 	platform_rwlock_rdlock(table->rwlock);
 	
 	//Find an entry that refers to the group with group_id
 	for(entry = table->entries;entry!=NULL;entry = entry->next){
-		
-		bool has_group = false;	
-		
-		for( it=entry->matches.head; it; it=it->next ){
-			if(__of1x_instructions_contain_group(entry, group_id)){
-				has_group = true;
-				break;
-			}
-		}
-
-		if(has_group){
+		if(__of1x_instructions_contain_group(entry, group_id)){
 			//Green light for writers
 			platform_rwlock_rdunlock(table->rwlock);
 			return entry;
@@ -647,19 +1363,102 @@ rofl_result_t of1x_destroy_loop(struct of1x_flow_table *const table){
 
 	table->entries = NULL;
 
+	//Release the priority index
+	__of1x_destroy_loop_state(table);
+
+	return ROFL_SUCCESS;
+}
+
+void of1x_dump_loop(struct of1x_flow_table *const table, bool raw_nbo){
+
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	loop_array_t* array = state->array;
+
+	ROFL_PIPELINE_INFO("\tPriority index {priorities: %u, levels: %u}\n", state->num_of_buckets, state->level);
+
+	if(array)
+		ROFL_PIPELINE_INFO("\tEntry array {slots: %u, capacity: %u, gaps: %u, builds: %u}\n", array->num_of_slots, array->capacity, array->num_of_gaps, state->num_of_array_builds);
+}
+
+/*
+* Entry array enable/disable
+*/
+rofl_result_t of1x_enable_table_loop_array(of1x_pipeline_t *const pipeline, const unsigned int table_id){
+
+	of1x_flow_table_t* table;
+	loop_state_t* state;
+	loop_array_t* array;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	//Only the loop lookup scans the array
+	if(table->matching_algorithm != of1x_loop_matching_algorithm)
+		return ROFL_FAILURE;
+
+	state = (loop_state_t*)table->matching_aux[1];
+
+	//Serialize with flow_mods
+	platform_mutex_lock(table->mutex);
+
+	if(state->array){
+		platform_mutex_unlock(table->mutex);
+		return ROFL_SUCCESS;
+	}
+
+	array = loop_array_build(table);
+	if(unlikely(array == NULL)){
+		platform_mutex_unlock(table->mutex);
+		return ROFL_FAILURE;
+	}
+	state->num_of_array_builds++;
+
+	platform_rwlock_wrlock(table->rwlock);
+	loop_array_publish(table, state, array);
+	platform_rwlock_wrunlock(table->rwlock);
+
+	platform_mutex_unlock(table->mutex);
+
+	return ROFL_SUCCESS;
+}
+
+rofl_result_t of1x_disable_table_loop_array(of1x_pipeline_t *const pipeline, const unsigned int table_id){
+
+	of1x_flow_table_t* table;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	if(table->matching_algorithm != of1x_loop_matching_algorithm)
+		return ROFL_FAILURE;
+
+	platform_mutex_lock(table->mutex);
+	platform_rwlock_wrlock(table->rwlock);
+	loop_array_publish(table, (loop_state_t*)table->matching_aux[1], NULL);
+	platform_rwlock_wrunlock(table->rwlock);
+	platform_mutex_unlock(table->mutex);
+
 	return ROFL_SUCCESS;
 }
 
 //Define the matching algorithm struct
 OF1X_REGISTER_MATCHING_ALGORITHM(loop) = {
 	//Init and destroy hooks
-	.init_hook = NULL,
+	.init_hook = of1x_init_loop,
 	.destroy_hook = of1x_destroy_loop,
 
 	//Flow mods
 	.add_flow_entry_hook = of1x_add_flow_entry_loop,
+	.add_flow_entries_hook = of1x_add_flow_entries_loop,
 	.modify_flow_entry_hook = of1x_modify_flow_entry_loop,
 	.remove_flow_entry_hook = of1x_remove_flow_entry_loop,
+	.remove_flow_entries_hook = of1x_remove_flow_entries_loop,
 
 	//Stats
 	.get_flow_stats_hook = of1x_get_flow_stats_loop,
@@ -669,7 +1468,7 @@ OF1X_REGISTER_MATCHING_ALGORITHM(loop) = {
 	.find_entry_using_group_hook = of1x_find_entry_using_group_loop,
 
 	//Dumping	
-	.dump_hook = NULL,
+	.dump_hook = of1x_dump_loop,
 	.description = LOOP_DESCRIPTION,
 };
 
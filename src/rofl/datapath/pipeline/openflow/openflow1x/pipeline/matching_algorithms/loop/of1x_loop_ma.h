@@ -5,19 +5,123 @@
 #include "../matching_algorithms.h"
 #include "../../of1x_flow_table.h"
 
+/*
+* Priority index
+*
+* Skip list (descending order) of the distinct priorities installed in the table.
+* Each node (bucket) points to the contiguous range of entries of that priority
+* in the table->entries list, so that the insertion point lookup and the
+* overlap/identical checks only touch the relevant priority range.
+*
+* Within a priority, entries are ordered by descending number of matches. The
+* bucket keeps the last entry of every run of entries with the same number of
+* matches (runs), so that the insertion point is found without walking the
+* entries of the priority, even if most of the table shares it.
+*
+* loop keeps its state in table->matching_aux[1], so that matching algorithms
+* reusing loop routines (e.g. l2hash) can keep theirs in matching_aux[0].
+*/
+#define LOOP_PRIO_INDEX_MAX_LEVEL 16
+
+#define LOOP_PRIO_RUNS_MIN_CAPACITY 4
+
+typedef struct loop_prio_run{
+	unsigned int num_of_matches;
+	of1x_flow_entry_t* last;
+}loop_prio_run_t;
+
+typedef struct loop_prio_bucket{
+	uint32_t priority;
+
+	//Range of entries with this priority (list order)
+	of1x_flow_entry_t* first;
+	of1x_flow_entry_t* last;
+	unsigned int num_of_entries;
+
+	//Runs (descending number of matches)
+	unsigned int num_of_runs;
+	unsigned int runs_capacity;
+	unsigned int runs_reserved; //Room kept for the runs of a bundle
+	loop_prio_run_t* runs;
+
+	//Skip list forward pointers
+	unsigned int level;
+	struct loop_prio_bucket* next[LOOP_PRIO_INDEX_MAX_LEVEL];
+}loop_prio_bucket_t;
+
+/*
+* Entry array (optional, see of1x_enable_table_loop_array())
+*
+* Contiguous copy of the table->entries list (same order), scanned by the
+* lookup instead of chasing the entry pointers. Besides the entry, each slot
+* holds a compact key: a copy of the first match of the entry, which is checked
+* in place before touching the entry.
+*
+* When the array is (re)built, a gap slot is left every LOOP_ARRAY_GAP_INTERVAL
+* entries, so that most insertions just fill a gap; removals leave a gap. If
+* there is no gap at the insertion point, or gaps outnumber the entries, a new
+* array is built and published by swapping the pointer. The old array is
+* released once the readers are out.
+*/
+#define LOOP_ARRAY_GAP_INTERVAL 8
+#define LOOP_ARRAY_MIN_SLACK 16
+
+typedef struct loop_array_slot{
+	//Entry or NULL (gap)
+	of1x_flow_entry_t* entry;
+
+	//Compact key. OF1X_MATCH_MAX for entries without matches
+	of1x_match_type_t type;
+	enum of1x_vlan_present vlan_present;
+	utern_t tern;
+}loop_array_slot_t;
+
+typedef struct loop_array{
+	//Slots in use (entries and gaps), allocated and gaps
+	unsigned int num_of_slots;
+	unsigned int capacity;
+	unsigned int num_of_gaps;
+
+	loop_array_slot_t* slots;
+}loop_array_t;
+
+typedef struct loop_state{
+	unsigned int level;
+	unsigned int num_of_buckets;
+	loop_prio_bucket_t head; //Sentinel
+
+	//Level generator state
+	uint32_t seed;
+
+	//Entry array (NULL if disabled)
+	loop_array_t* array;
+	unsigned int num_of_array_builds;
+}loop_state_t;
+
 //C++ extern C
 ROFL_BEGIN_DECLS
 
+rofl_result_t of1x_init_loop(struct of1x_flow_table *const table);
+void __of1x_destroy_loop_state(struct of1x_flow_table *const table);
+
 rofl_of1x_fm_result_t __of1x_add_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_overlap, bool reset_counts, void (*ma_hook_ptr)(of1x_flow_entry_t*));
 
 rofl_of1x_fm_result_t of1x_add_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_overlap, bool reset_counts);
 
+rofl_of1x_fm_result_t __of1x_add_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts, void (*ma_add_hook_ptr)(of1x_flow_entry_t*), void (*ma_remove_hook_ptr)(of1x_flow_entry_t*));
+
+rofl_of1x_fm_result_t of1x_add_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts);
+
 rofl_result_t __of1x_modify_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, const enum of1x_flow_removal_strictness strict, bool reset_counts, void (*ma_add_hook_ptr)(of1x_flow_entry_t*), void (*ma_modify_hook_ptr)(of1x_flow_entry_t*));
 
 rofl_result_t of1x_modify_flow_entry_loop(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, const enum of1x_flow_removal_strictness strict, bool reset_counts);
 
 rofl_result_t __of1x_remove_flow_entry_loop(of1x_flow_table_t *const table , of1x_flow_entry_t *const entry, of1x_flow_entry_t *const specific_entry, const enum of1x_flow_removal_strictness strict, uint32_t out_port, uint32_t out_group, of1x_flow_remove_reason_t reason, of1x_mutex_acquisition_required_t mutex_acquired, void (*ma_hook_ptr)(of1x_flow_entry_t*));
 
+rofl_result_t __of1x_remove_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries, void (*ma_hook_ptr)(of1x_flow_entry_t*));
+
+rofl_result_t of1x_remove_flow_entries_loop(of1x_flow_table_t *const table, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries);
+
 rofl_result_t of1x_remove_flow_entry_loop(of1x_flow_table_t *const table , of1x_flow_entry_t *const entry, of1x_flow_entry_t *const specific_entry, const enum of1x_flow_removal_strictness strict, uint32_t out_port, uint32_t out_group, of1x_flow_remove_reason_t reason, of1x_mutex_acquisition_required_t mutex_acquired);
 
 
@@ -41,6 +145,22 @@ of1x_flow_entry_t* of1x_find_entry_using_group_loop(of1x_flow_table_t *const tab
 
 rofl_result_t of1x_destroy_loop(struct of1x_flow_table *const table);
 
+void of1x_dump_loop(struct of1x_flow_table *const table, bool raw_nbo);
+
+/**
+* @brief Enables the entry array of a table using the loop matching algorithm.
+*
+* The lookup scans a contiguous, priority ordered, array of entries instead
+* of the list of entries. This trades some memory and flow_mod time for
+* lookup speed on large tables.
+*/
+rofl_result_t of1x_enable_table_loop_array(struct of1x_pipeline *const pipeline, const unsigned int table_id);
+
+/**
+* @brief Disables the entry array of a table (back to the list of entries)
+*/
+rofl_result_t of1x_disable_table_loop_array(struct of1x_pipeline *const pipeline, const unsigned int table_id);
+
 //C++ extern C
 ROFL_END_DECLS
 
@@ -17,45 +17,60 @@
 //C++ extern C
 ROFL_BEGIN_DECLS
 
-/* FLOW entry lookup entry point */ 
+//Checks all the matches of entry
+static inline bool of1x_loop_ma_check_matches(of1x_flow_entry_t *const entry, datapacket_t *const pkt){
+
+	of1x_match_t* it;
+
+	for( it=entry->matches.head ; it ; it=it->next ){
+		if(!__of1x_check_match(pkt, it))
+			return false;
+	}
+	return true;
+}
+
+//Scan of the entry array
+static inline of1x_flow_entry_t* of1x_loop_ma_find_array(loop_array_t* array, datapacket_t *const pkt){
+
+	unsigned int i, num_of_slots = array->num_of_slots;
+	loop_array_slot_t* slot;
+	of1x_flow_entry_t* entry;
+
+	for(i=0, slot=array->slots; i<num_of_slots; i++, slot++){
+		entry = slot->entry;
+
+		//Gap
+		if(!entry)
+			continue;
+
+		//Compact key first; the full check is still done (the key is a copy)
+		if(slot->type != OF1X_MATCH_MAX && !__of1x_check_match_field(pkt, slot->type, slot->vlan_present, &slot->tern))
+			continue;
+
+		if(of1x_loop_ma_check_matches(entry, pkt))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/* FLOW entry lookup entry point (lock-free; the caller is in an epoch, tid_epoch_enter()) */ 
 static inline of1x_flow_entry_t* of1x_find_best_match_loop_ma(of1x_flow_table_t *const table, datapacket_t *const pkt){
 	
-	of1x_match_t* it;
 	of1x_flow_entry_t *entry;
+	loop_array_t* array;
+
+	array = ((loop_state_t*)table->matching_aux[1])->array;
 
-#ifndef ROFL_PIPELINE_LOCKLESS
-	//Prevent writers to change structure during matching
-	platform_rwlock_rdlock(table->rwlock);
-#endif
-	
 	//Table is sorted out by nº of hits and priority N. First full match => best_match 
+	if(array)
+		return of1x_loop_ma_find_array(array, pkt);
+
 	for(entry = table->entries;entry!=NULL;entry = entry->next){
-		bool matched = true;
-		
-		for( it=entry->matches.head ; it ; it=it->next ){
-			if(!__of1x_check_match(pkt, it)){
-				matched = false;
-				break;
-			}
-		}
-
-		if(matched){
-#ifndef ROFL_PIPELINE_LOCKLESS
-			//Lock writers to modify the entry while packet processing. WARNING!!!! this must be released by the pipeline, once packet is processed!
-			platform_rwlock_rdlock(entry->rwlock);
-
-			//Green light for writers
-			platform_rwlock_rdunlock(table->rwlock);
-#endif
+		if(of1x_loop_ma_check_matches(entry, pkt))
 			return entry;
-		}
 	}
-	
-#ifndef ROFL_PIPELINE_LOCKLESS
-	//No match
-	//Green light for writers
-	platform_rwlock_rdunlock(table->rwlock);
-#endif
+
 	return NULL; 
 }
 
@@ -103,6 +103,25 @@ typedef struct of1x_matching_algorithm_functions{
 			bool check_overlap,
 			bool reset_counts);
 
+	/**
+	* @ingroup core_ma_of1x
+	* @brief Adds a bundle of flow entries to the table, atomically
+	*
+	* The algorithm MUST either add all the entries, as num_of_entries
+	* consecutive calls to add_flow_entry_hook would do, or none of them
+	* (rollback), leaving the table untouched. Entries of the bundle replaced
+	* by a later entry of the same bundle MUST be set to NULL in entries.
+	*
+	* This is optional. Matching algorithms not implementing it do not
+	* support of1x_add_flow_entries_table(). 
+	*/
+	rofl_of1x_fm_result_t
+	(*add_flow_entries_hook)(struct of1x_flow_table *const table,
+			of1x_flow_entry_t **const entries,
+			unsigned int num_of_entries,
+			bool check_overlap,
+			bool reset_counts);
+
 
 	/**
 	* @ingroup core_ma_of1x
@@ -161,6 +180,25 @@ typedef struct of1x_matching_algorithm_functions{
 			of1x_flow_remove_reason_t reason,
 			of1x_mutex_acquisition_required_t mutex_acquired);
 
+	/**
+	* @ingroup core_ma_of1x
+	* @brief Removes a batch of specific flow entries (e.g. expired) from the table
+	*
+	* The algorithm MUST remove the entries as consecutive calls to
+	* remove_flow_entry_hook (STRICT, specific_entry) would do, but releasing
+	* them after a single grace period. Entries no longer in the table are
+	* skipped. table->mutex is already held by the caller. The arrays may be
+	* reordered.
+	*
+	* This is optional. Matching algorithms not implementing it get the
+	* entries removed one by one (remove_flow_entry_hook).
+	*/
+	rofl_result_t
+	(*remove_flow_entries_hook)(struct of1x_flow_table *const table,
+			of1x_flow_entry_t **const entries,
+			of1x_flow_remove_reason_t *const reasons,
+			unsigned int num_of_entries);
+
 
 
 	//Packet matching lookup
@@ -7,6 +7,7 @@
 
 #include "../../../common/packet_matches.h" //TODO: evaluate if this is the best approach to update of1x_matches after actions
 #include "../../../physical_switch.h"
+#include "../../../threading.h"
 #include "../../../util/logging.h"
 #include "../../../platform/likely.h"
 #include "../../../platform/memory.h"
@@ -17,6 +18,10 @@
 //Flood port
 extern switch_port_t* flood_meta_port;
 
+static const slab_desc_t of1x_packet_action_slab_desc = { "packet action", SLAB_POOL_ACTION, sizeof(of1x_packet_action_t), NULL, NULL };
+static const slab_desc_t of1x_action_group_slab_desc = { "action group", SLAB_POOL_ACTION_GROUP, sizeof(of1x_action_group_t), NULL, NULL };
+static const slab_desc_t of1x_write_actions_slab_desc = { "write actions", SLAB_POOL_WRITE_ACTIONS, sizeof(of1x_write_actions_t), NULL, NULL };
+
 /* Actions init and destroyed */
 of1x_packet_action_t* of1x_init_packet_action(of1x_packet_action_type_t type, wrap_uint_t field, uint16_t output_send_len){
 
@@ -25,7 +30,7 @@ of1x_packet_action_t* of1x_init_packet_action(of1x_packet_action_type_t type, wr
 	if( unlikely(type==OF1X_AT_NO_ACTION) )
 		return NULL;
 
-	action = platform_malloc_shared(sizeof(of1x_packet_action_t));
+	action = (of1x_packet_action_t*)__physical_switch_alloc(&of1x_packet_action_slab_desc);
 
 	if( unlikely(action==NULL) )
 		return NULL;
@@ -433,7 +438,7 @@ of1x_packet_action_t* of1x_init_packet_action(of1x_packet_action_type_t type, wr
 
 void of1x_destroy_packet_action(of1x_packet_action_t* action){
 
-	platform_free_shared(action);
+	__slab_free(action);
 }
 
 /* Action group init and destroy */
@@ -442,7 +447,7 @@ of1x_action_group_t* of1x_init_action_group(of1x_packet_action_t* actions){
 	unsigned int number_of_actions=0, number_of_output_actions=0;
 	of1x_action_group_t* action_group;
 	
-	action_group = platform_malloc_shared(sizeof(of1x_action_group_t));
+	action_group = (of1x_action_group_t*)__physical_switch_alloc(&of1x_action_group_slab_desc);
 
 	if( unlikely(action_group==NULL) )
 		return NULL;
@@ -488,7 +493,7 @@ void of1x_destroy_action_group(of1x_action_group_t* group){
 		next = it->next; 
 		of1x_destroy_packet_action(it);
 	}
-	platform_free_shared(group);	
+	__slab_free(group);	
 }
 
 /* Addition of an action to an action group */
@@ -541,7 +546,7 @@ void of1x_push_packet_action_to_group(of1x_action_group_t* group, of1x_packet_ac
 of1x_write_actions_t* of1x_init_write_actions(){
 
 	int i;
-	of1x_write_actions_t* write_actions = platform_malloc_shared(sizeof(of1x_write_actions_t)); 
+	of1x_write_actions_t* write_actions = (of1x_write_actions_t*)__physical_switch_alloc(&of1x_write_actions_slab_desc); 
 
 	if( unlikely(write_actions==NULL) )
 		return NULL;
@@ -564,7 +569,7 @@ of1x_write_actions_t* of1x_init_write_actions(){
 }
 
 void __of1x_destroy_write_actions(of1x_write_actions_t* write_actions){
-	platform_free_shared(write_actions);	
+	__slab_free(write_actions);	
 }
 
 rofl_result_t of1x_set_packet_action_on_write_actions(of1x_write_actions_t* write_actions, of1x_packet_action_t* action){
@@ -604,6 +609,14 @@ rofl_result_t of1x_set_packet_action_on_write_actions(of1x_write_actions_t* writ
 }
 
 //Update apply/write
+static void __of1x_release_action_group(void* group){
+	of1x_destroy_action_group((of1x_action_group_t*)group);
+}
+
+static void __of1x_release_write_actions(void* group){
+	__of1x_destroy_write_actions((of1x_write_actions_t*)group);
+}
+
 rofl_result_t __of1x_update_apply_actions(of1x_action_group_t** group, of1x_action_group_t* new_group){
 
 	of1x_action_group_t* old_group = *group;
@@ -611,9 +624,9 @@ rofl_result_t __of1x_update_apply_actions(of1x_action_group_t** group, of1x_acti
 	//Transfer
 	*group = new_group;
 
-	//Release if necessary
+	//Release once packet processing can no longer be using it
 	if(old_group)
-		of1x_destroy_action_group(old_group);	
+		tid_defer_release(old_group, __of1x_release_action_group);
 
 	return ROFL_SUCCESS;
 }
@@ -625,9 +638,9 @@ rofl_result_t __of1x_update_write_actions(of1x_write_actions_t** group, of1x_wri
 	//Transfer
 	*group = new_group;
 	
-	//Destroy old group	
+	//Release once packet processing can no longer be using it
 	if(old_group)
-		__of1x_destroy_write_actions(old_group);
+		tid_defer_release(old_group, __of1x_release_write_actions);
 	
 	return ROFL_SUCCESS;
 }
@@ -638,7 +651,7 @@ bool __of1x_write_actions_has(of1x_write_actions_t* write_actions, of1x_packet_a
 	if( unlikely(write_actions==NULL))
 		return false;	
 
-	return bitmap128_is_bit_set(&write_actions->bitmap, type);
+	return bitmap128_is_bit_set(&write_actions->bitmap, type) && write_actions->actions[type].__field.u64 == value;
 }
 /*TODO specific funcions for 128 bits. So far only used for OUTPUT and GROUP actions, so not really necessary*/
 bool __of1x_apply_actions_has(const of1x_action_group_t* apply_actions_group, of1x_packet_action_type_t type, uint64_t value){
@@ -650,13 +663,15 @@ bool __of1x_apply_actions_has(const of1x_action_group_t* apply_actions_group, of
 
 	for(it=apply_actions_group->head; it; it=it->next){
 		
-		if(type != OF1X_AT_GROUP){
-			//Filter types where field cannot be 0
-			return (it->type == type) &&  (value != 0x0 && it->__field.u64 == value);
-		}else{
-			//Groups or anything else
-			return (it->type == type) &&  (it->__field.u64 == value);
-		}
+		if(it->type != type)
+			continue;
+
+		//Filter types where field cannot be 0 (groups can)
+		if(type != OF1X_AT_GROUP && value == 0x0)
+			return false;
+
+		if(it->__field.u64 == value)
+			return true;
 	}
 	return false;	
 }
@@ -666,7 +681,7 @@ of1x_packet_action_t* __of1x_copy_packet_action(of1x_packet_action_t* action){
 
 	of1x_packet_action_t* copy;
 
-	copy = platform_malloc_shared(sizeof(of1x_packet_action_t));
+	copy = (of1x_packet_action_t*)__physical_switch_alloc(&of1x_packet_action_slab_desc);
 
 	if( unlikely(copy==NULL) )
 		return NULL;
@@ -684,7 +699,7 @@ of1x_action_group_t* __of1x_copy_action_group(of1x_action_group_t* origin){
 	if( unlikely(origin==NULL) )
 		return NULL;
 
-	copy = platform_malloc_shared(sizeof(of1x_action_group_t));
+	copy = (of1x_action_group_t*)__physical_switch_alloc(&of1x_action_group_slab_desc);
 
 
 	if( unlikely(copy==NULL) )
@@ -726,7 +741,7 @@ of1x_write_actions_t* __of1x_copy_write_actions(of1x_write_actions_t* origin){
 	if( unlikely(origin==NULL) )
 		return NULL;
 
-	copy = platform_malloc_shared(sizeof(of1x_write_actions_t)); 
+	copy = (of1x_write_actions_t*)__physical_switch_alloc(&of1x_write_actions_slab_desc); 
 
 	if( unlikely(copy==NULL) )
 		return NULL;
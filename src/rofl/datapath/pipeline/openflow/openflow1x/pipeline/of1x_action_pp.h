@@ -12,6 +12,7 @@
 #include "rofl_datapath.h"
 #include "../../../util/pp_guard.h" //Never forget to include the guard
 #include "of1x_statistics_pp.h"
+#include "of1x_latency_pp.h"
 #include "of1x_action.h"
 #include "of1x_group_table.h"
 #include "of1x_flow_table.h"
@@ -97,6 +98,8 @@ static inline void __of1x_process_apply_actions(const unsigned int tid, const st
 static inline void __of1x_process_group_actions(const unsigned int tid, const struct of1x_switch* sw, const unsigned int table_id, datapacket_t *pkt, uint64_t field, of1x_group_t *group, bool replicate_pkts){
 	datapacket_t* pkt_replica;
 	of1x_bucket_t *it_bk;
+	of1x_latency_t* lat = __of1x_latency_get(sw->pipeline.latency);
+	uint64_t start = __of1x_latency_start(lat);
 	
 	platform_rwlock_rdlock(group->rwlock);
 	
@@ -147,12 +150,16 @@ static inline void __of1x_process_group_actions(const unsigned int tid, const st
 	__of1x_stats_group_update(tid, &group->stats, platform_packet_get_size_bytes(pkt));
 	platform_rwlock_rdunlock(group->rwlock);
 
+	__of1x_latency_end(tid, lat, OF1X_LATENCY_STAGE_GROUP, start);
+
 }
 
 /* Contains switch with all the different action functions */
 static inline void __of1x_process_packet_action(const unsigned int tid, const struct of1x_switch* sw, const unsigned int table_id, datapacket_t* pkt, of1x_packet_action_t* action, bool replicate_pkts, datapacket_t** reinject_pkt){
 
 	uint32_t port_id;
+	uint64_t start;
+	of1x_latency_t* lat;
 
 	switch(action->type){
 		case OF1X_AT_NO_ACTION: assert(0);
@@ -656,6 +663,9 @@ static inline void __of1x_process_packet_action(const unsigned int tid, const st
 				pkt_to_send = pkt;
 
 			//Perform output
+			lat = __of1x_latency_get(sw->pipeline.latency);
+			start = __of1x_latency_start(lat);
+
 			if( port_id < LOGICAL_SWITCH_MAX_LOG_PORTS && unlikely(NULL != sw->logical_ports[port_id].port) ){
 
 				//Single port output
@@ -709,6 +719,8 @@ static inline void __of1x_process_packet_action(const unsigned int tid, const st
 				//Drop the pkt
 				platform_packet_drop(pkt_to_send);
 			}
+
+			__of1x_latency_end(tid, lat, OF1X_LATENCY_STAGE_OUTPUT, start);
 			break;
 	}
 }
@@ -0,0 +1,443 @@
+#include "of1x_cookie_index.h"
+
+#include <assert.h>
+#include <string.h>
+#include "../../../platform/likely.h"
+#include "../../../platform/lock.h"
+#include "../../../platform/memory.h"
+#include "../../../util/logging.h"
+
+#include "of1x_flow_entry.h"
+#include "of1x_flow_table.h"
+#include "of1x_pipeline.h"
+
+//Tagged pointers
+#define OF1X_COOKIE_TRIE_IS_LEAF(p) ( ((p) & 0x1) != 0x0 )
+#define OF1X_COOKIE_TRIE_LEAF(p) ( (of1x_cookie_node_t*)((p) & ~((uintptr_t)0x1)) )
+#define OF1X_COOKIE_TRIE_NODE(p) ( (of1x_cookie_trie_node_t*)(p) )
+#define OF1X_COOKIE_TRIE_TAG_LEAF(l) ( ((uintptr_t)(l)) | 0x1 )
+
+#define OF1X_COOKIE_DIR(cookie, bit) ( (unsigned int)(((cookie) >> (bit)) & 0x1) )
+
+//Initial size of the entries array returned by queries
+#define OF1X_COOKIE_INDEX_INITIAL_RESULT_SIZE 64
+
+static inline uint32_t __of1x_cookie_index_hash(uint64_t cookie){
+	//splitmix64 finalizer
+	cookie ^= cookie >> 30;
+	cookie *= 0xBF58476D1CE4E5B9ULL;
+	cookie ^= cookie >> 27;
+	cookie *= 0x94D049BB133111EBULL;
+	cookie ^= cookie >> 31;
+	return (uint32_t)cookie;
+}
+
+void __of1x_init_cookie_index(of1x_cookie_index_t* index){
+	index->enabled = false;
+	index->buckets = NULL;
+	index->num_of_buckets = 0;
+	index->num_of_cookies = 0;
+	index->root = 0x0;
+}
+
+static void __of1x_destroy_cookie_trie(uintptr_t p){
+	of1x_cookie_trie_node_t* node;
+
+	if(p == 0x0 || OF1X_COOKIE_TRIE_IS_LEAF(p))
+		return; //Leaves are released through the hash
+
+	node = OF1X_COOKIE_TRIE_NODE(p);
+	__of1x_destroy_cookie_trie(node->child[0]);
+	__of1x_destroy_cookie_trie(node->child[1]);
+	platform_free_shared(node);
+}
+
+void __of1x_destroy_cookie_index(of1x_cookie_index_t* index){
+
+	unsigned int i;
+	of1x_cookie_node_t *it, *next;
+
+	__of1x_destroy_cookie_trie(index->root);
+
+	if(index->buckets){
+		for(i=0;i<index->num_of_buckets;i++){
+			for(it=index->buckets[i]; it; it=next){
+				next = it->next;
+				platform_free_shared(it);
+			}
+		}
+		platform_free_shared(index->buckets);
+	}
+
+	__of1x_init_cookie_index(index);
+}
+
+/*
+* Hash
+*/
+static of1x_cookie_node_t* __of1x_cookie_index_find_node(of1x_cookie_index_t* index, uint64_t cookie){
+	of1x_cookie_node_t* it;
+
+	for(it=index->buckets[__of1x_cookie_index_hash(cookie) & (index->num_of_buckets-1)]; it; it=it->next){
+		if(it->cookie == cookie)
+			return it;
+	}
+	return NULL;
+}
+
+//Doubles the number of buckets. On allocation failure chains just get longer
+static void __of1x_cookie_index_grow(of1x_cookie_index_t* index){
+
+	unsigned int i, slot, num_of_buckets = index->num_of_buckets*2;
+	of1x_cookie_node_t **buckets, *it, *next;
+
+	buckets = (of1x_cookie_node_t**)platform_malloc_shared(sizeof(of1x_cookie_node_t*)*num_of_buckets);
+	if(unlikely(buckets == NULL))
+		return;
+	platform_memset(buckets, 0, sizeof(of1x_cookie_node_t*)*num_of_buckets);
+
+	for(i=0;i<index->num_of_buckets;i++){
+		for(it=index->buckets[i]; it; it=next){
+			next = it->next;
+			slot = __of1x_cookie_index_hash(it->cookie) & (num_of_buckets-1);
+			it->next = buckets[slot];
+			buckets[slot] = it;
+		}
+	}
+
+	platform_free_shared(index->buckets);
+	index->buckets = buckets;
+	index->num_of_buckets = num_of_buckets;
+}
+
+/*
+* Crit-bit tree
+*/
+static rofl_result_t __of1x_cookie_trie_insert(of1x_cookie_index_t* index, of1x_cookie_node_t* leaf){
+
+	uintptr_t p, *where;
+	uint64_t diff;
+	unsigned int bit;
+	of1x_cookie_trie_node_t *node, *new_node;
+
+	if(index->root == 0x0){
+		index->root = OF1X_COOKIE_TRIE_TAG_LEAF(leaf);
+		return ROFL_SUCCESS;
+	}
+
+	//Find the best candidate and the critical bit
+	for(p=index->root; !OF1X_COOKIE_TRIE_IS_LEAF(p); ){
+		node = OF1X_COOKIE_TRIE_NODE(p);
+		p = node->child[OF1X_COOKIE_DIR(leaf->cookie, node->bit)];
+	}
+
+	diff = leaf->cookie ^ OF1X_COOKIE_TRIE_LEAF(p)->cookie;
+	assert(diff != 0x0ULL);
+	for(bit=63; !(diff >> bit); bit--);
+
+	new_node = (of1x_cookie_trie_node_t*)platform_malloc_shared(sizeof(of1x_cookie_trie_node_t));
+	if(unlikely(new_node == NULL))
+		return ROFL_FAILURE;
+	new_node->bit = bit;
+
+	//Nodes are ordered by decreasing critical bit
+	for(where=&index->root; !OF1X_COOKIE_TRIE_IS_LEAF(*where); ){
+		node = OF1X_COOKIE_TRIE_NODE(*where);
+		if(node->bit < bit)
+			break;
+		where = &node->child[OF1X_COOKIE_DIR(leaf->cookie, node->bit)];
+	}
+
+	new_node->child[OF1X_COOKIE_DIR(leaf->cookie, bit)] = OF1X_COOKIE_TRIE_TAG_LEAF(leaf);
+	new_node->child[!OF1X_COOKIE_DIR(leaf->cookie, bit)] = *where;
+	*where = (uintptr_t)new_node;
+
+	return ROFL_SUCCESS;
+}
+
+static void __of1x_cookie_trie_remove(of1x_cookie_index_t* index, of1x_cookie_node_t* leaf){
+
+	uintptr_t *where = &index->root, *where_parent = NULL;
+	of1x_cookie_trie_node_t* parent = NULL;
+	unsigned int dir = 0;
+
+	while(!OF1X_COOKIE_TRIE_IS_LEAF(*where)){
+		where_parent = where;
+		parent = OF1X_COOKIE_TRIE_NODE(*where);
+		dir = OF1X_COOKIE_DIR(leaf->cookie, parent->bit);
+		where = &parent->child[dir];
+	}
+
+	assert(OF1X_COOKIE_TRIE_LEAF(*where) == leaf);
+
+	if(!parent){
+		index->root = 0x0;
+		return;
+	}
+
+	//Replace the parent by the sibling
+	*where_parent = parent->child[!dir];
+	platform_free_shared(parent);
+}
+
+/*
+* Entry accounting
+*/
+void __of1x_cookie_index_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	unsigned int slot;
+	of1x_cookie_index_t* index = &table->cookie_index;
+	of1x_cookie_node_t* node;
+
+	if(likely(!index->enabled))
+		return;
+
+	node = __of1x_cookie_index_find_node(index, entry->cookie);
+
+	if(!node){
+		node = (of1x_cookie_node_t*)platform_malloc_shared(sizeof(of1x_cookie_node_t));
+		if(unlikely(node == NULL))
+			goto NO_MEMORY;
+
+		node->cookie = entry->cookie;
+		node->entries = NULL;
+		node->num_of_entries = 0;
+
+		if(unlikely(__of1x_cookie_trie_insert(index, node) != ROFL_SUCCESS)){
+			platform_free_shared(node);
+			goto NO_MEMORY;
+		}
+
+		if(index->num_of_cookies >= index->num_of_buckets)
+			__of1x_cookie_index_grow(index);
+
+		slot = __of1x_cookie_index_hash(node->cookie) & (index->num_of_buckets-1);
+		node->next = index->buckets[slot];
+		index->buckets[slot] = node;
+		index->num_of_cookies++;
+	}
+
+	//Push front
+	entry->cold->cookie_prev = NULL;
+	entry->cold->cookie_next = node->entries;
+	if(node->entries)
+		node->entries->cold->cookie_prev = entry;
+	node->entries = entry;
+	node->num_of_entries++;
+
+	return;
+
+NO_MEMORY:
+	//The index would no longer be complete
+	ROFL_PIPELINE_ERR("%s: unable to allocate memory. Disabling cookie index of table %u\n", __func__, table->number);
+	__of1x_destroy_cookie_index(index);
+}
+
+void __of1x_cookie_index_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_cookie_index_t* index = &table->cookie_index;
+	of1x_cookie_node_t *node, **it;
+
+	if(likely(!index->enabled))
+		return;
+
+	node = __of1x_cookie_index_find_node(index, entry->cookie);
+	if(unlikely(node == NULL)){
+		assert(0);
+		return;
+	}
+
+	if(entry->cold->cookie_prev)
+		entry->cold->cookie_prev->cold->cookie_next = entry->cold->cookie_next;
+	else
+		node->entries = entry->cold->cookie_next;
+	if(entry->cold->cookie_next)
+		entry->cold->cookie_next->cold->cookie_prev = entry->cold->cookie_prev;
+	entry->cold->cookie_prev = entry->cold->cookie_next = NULL;
+
+	if(--node->num_of_entries > 0)
+		return;
+
+	//Last entry with this cookie
+	__of1x_cookie_trie_remove(index, node);
+
+	for(it=&index->buckets[__of1x_cookie_index_hash(node->cookie) & (index->num_of_buckets-1)]; *it; it=&(*it)->next){
+		if(*it == node){
+			*it = node->next;
+			break;
+		}
+	}
+	index->num_of_cookies--;
+	platform_free_shared(node);
+}
+
+/*
+* Queries
+*/
+typedef struct of1x_cookie_index_result{
+	of1x_flow_entry_t** entries;
+	unsigned int num_of_entries;
+	unsigned int size;
+}of1x_cookie_index_result_t;
+
+static rofl_result_t __of1x_cookie_index_push_node(of1x_cookie_index_result_t* res, of1x_cookie_node_t* node){
+
+	unsigned int size;
+	of1x_flow_entry_t **entries, *it;
+
+	if(res->num_of_entries + node->num_of_entries > res->size){
+		for(size = res->size; size < res->num_of_entries + node->num_of_entries; size *= 2);
+
+		entries = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*size);
+		if(unlikely(entries == NULL))
+			return ROFL_FAILURE;
+
+		memcpy(entries, res->entries, sizeof(of1x_flow_entry_t*)*res->num_of_entries);
+		platform_free_shared(res->entries);
+		res->entries = entries;
+		res->size = size;
+	}
+
+	for(it=node->entries; it; it=it->cold->cookie_next)
+		res->entries[res->num_of_entries++] = it;
+
+	return ROFL_SUCCESS;
+}
+
+static rofl_result_t __of1x_cookie_trie_walk(uintptr_t p, uint64_t cookie, uint64_t cookie_mask, of1x_cookie_index_result_t* res){
+
+	of1x_cookie_node_t* leaf;
+	of1x_cookie_trie_node_t* node;
+
+	if(p == 0x0)
+		return ROFL_SUCCESS;
+
+	if(OF1X_COOKIE_TRIE_IS_LEAF(p)){
+		leaf = OF1X_COOKIE_TRIE_LEAF(p);
+		if( ((leaf->cookie ^ cookie) & cookie_mask) != 0x0ULL )
+			return ROFL_SUCCESS;
+		return __of1x_cookie_index_push_node(res, leaf);
+	}
+
+	node = OF1X_COOKIE_TRIE_NODE(p);
+
+	//Masked bit; only one of the branches can match
+	if( OF1X_COOKIE_DIR(cookie_mask, node->bit) )
+		return __of1x_cookie_trie_walk(node->child[OF1X_COOKIE_DIR(cookie, node->bit)], cookie, cookie_mask, res);
+
+	if(__of1x_cookie_trie_walk(node->child[0], cookie, cookie_mask, res) != ROFL_SUCCESS)
+		return ROFL_FAILURE;
+	return __of1x_cookie_trie_walk(node->child[1], cookie, cookie_mask, res);
+}
+
+bool __of1x_cookie_index_usable(of1x_flow_table_t *const table, uint64_t cookie, uint64_t cookie_mask){
+	return table->cookie_index.enabled && cookie_mask != 0x0ULL && cookie != OF1X_DO_NOT_CHECK_COOKIE;
+}
+
+rofl_result_t __of1x_cookie_index_get_entries(of1x_flow_table_t *const table, uint64_t cookie, uint64_t cookie_mask, of1x_flow_entry_t*** entries, unsigned int* num_of_entries){
+
+	rofl_result_t res;
+	of1x_cookie_node_t* node;
+	of1x_cookie_index_t* index = &table->cookie_index;
+	of1x_cookie_index_result_t result;
+
+	assert(index->enabled);
+
+	result.num_of_entries = 0;
+	result.size = OF1X_COOKIE_INDEX_INITIAL_RESULT_SIZE;
+	result.entries = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*result.size);
+	if(unlikely(result.entries == NULL))
+		return ROFL_FAILURE;
+
+	if(cookie_mask == 0xFFFFFFFFFFFFFFFFULL){
+		//Exact
+		node = __of1x_cookie_index_find_node(index, cookie);
+		res = (node)? __of1x_cookie_index_push_node(&result, node) : ROFL_SUCCESS;
+	}else{
+		res = __of1x_cookie_trie_walk(index->root, cookie, cookie_mask, &result);
+	}
+
+	if(unlikely(res != ROFL_SUCCESS)){
+		platform_free_shared(result.entries);
+		return ROFL_FAILURE;
+	}
+
+	*entries = result.entries;
+	*num_of_entries = result.num_of_entries;
+
+	return ROFL_SUCCESS;
+}
+
+/*
+* Enable/disable
+*/
+rofl_result_t of1x_enable_table_cookie_index(of1x_pipeline_t *const pipeline, const unsigned int table_id){
+
+	of1x_flow_table_t* table;
+	of1x_cookie_index_t* index;
+	of1x_flow_entry_t* entry;
+	bool enabled;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+	index = &table->cookie_index;
+
+	//Serialize with flow_mods
+	platform_mutex_lock(table->mutex);
+
+	if(index->enabled){
+		platform_mutex_unlock(table->mutex);
+		return ROFL_SUCCESS;
+	}
+
+	index->buckets = (of1x_cookie_node_t**)platform_malloc_shared(sizeof(of1x_cookie_node_t*)*OF1X_COOKIE_INDEX_INITIAL_BUCKETS);
+	if(unlikely(index->buckets == NULL)){
+		platform_mutex_unlock(table->mutex);
+		return ROFL_FAILURE;
+	}
+	platform_memset(index->buckets, 0, sizeof(of1x_cookie_node_t*)*OF1X_COOKIE_INDEX_INITIAL_BUCKETS);
+	index->num_of_buckets = OF1X_COOKIE_INDEX_INITIAL_BUCKETS;
+	index->num_of_cookies = 0;
+	index->root = 0x0;
+	index->enabled = true;
+
+	//Build (all matching algorithms keep the table->entries list)
+	for(entry = table->entries; entry && index->enabled; entry = entry->next)
+		__of1x_cookie_index_add_entry(table, entry);
+
+	//Disabled on allocation failure
+	enabled = index->enabled;
+
+	platform_mutex_unlock(table->mutex);
+
+	return (enabled)? ROFL_SUCCESS : ROFL_FAILURE;
+}
+
+rofl_result_t of1x_disable_table_cookie_index(of1x_pipeline_t *const pipeline, const unsigned int table_id){
+
+	of1x_flow_table_t* table;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	//The index is only used with the table->mutex held
+	platform_mutex_lock(table->mutex);
+	__of1x_destroy_cookie_index(&table->cookie_index);
+	platform_mutex_unlock(table->mutex);
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_dump_cookie_index(of1x_cookie_index_t* index){
+
+	if(!index->enabled)
+		return;
+
+	ROFL_PIPELINE_INFO("\tCookie index {distinct cookies: %u, buckets: %u}\n", index->num_of_cookies, index->num_of_buckets);
+}
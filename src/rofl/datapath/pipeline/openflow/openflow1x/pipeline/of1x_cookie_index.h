@@ -0,0 +1,132 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_COOKIE_INDEXH__
+#define __OF1X_COOKIE_INDEXH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include "rofl_datapath.h"
+
+/**
+* @file of1x_cookie_index.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 per-table cookie index
+*
+* The cookie index is an (optional) per table index of the entries by their
+* cookie. Distinct cookies are kept in a hash table, used for exact
+* (cookie_mask=0xFFFFFFFFFFFFFFFF) queries, and in a crit-bit tree (radix) over
+* the 64 bits of the cookie, used for masked queries. The tree walk only descends
+* into the branches compatible with the masked bits, so enumerating the entries of
+* an application (e.g. cookie prefix) is proportional to its number of cookies.
+*
+* The index is maintained by the matching algorithms on entry addition and
+* removal and it is only used with table->mutex held.
+*/
+
+//Initial number of buckets (MUST be a power of 2)
+#define OF1X_COOKIE_INDEX_INITIAL_BUCKETS 64
+
+//fwd decl
+struct of1x_flow_entry;
+struct of1x_flow_table;
+struct of1x_pipeline;
+
+/**
+* Distinct cookie (tree leaf)
+*/
+typedef struct of1x_cookie_node{
+	uint64_t cookie;
+
+	//Entries with this cookie (of1x_flow_entry_t::cookie_prev/cookie_next)
+	struct of1x_flow_entry* entries;
+	unsigned int num_of_entries;
+
+	//Hash chaining
+	struct of1x_cookie_node* next;
+}of1x_cookie_node_t;
+
+/**
+* Crit-bit tree internal node. Children are tagged pointers; bit 0 set means
+* leaf (of1x_cookie_node_t)
+*/
+typedef struct of1x_cookie_trie_node{
+	unsigned int bit;
+	uintptr_t child[2];
+}of1x_cookie_trie_node_t;
+
+/**
+* Per table cookie index state
+*/
+typedef struct of1x_cookie_index{
+	//Enabled flag
+	bool enabled;
+
+	//Hash of distinct cookies
+	of1x_cookie_node_t** buckets;
+	unsigned int num_of_buckets;
+	unsigned int num_of_cookies;
+
+	//Crit-bit tree
+	uintptr_t root;
+}of1x_cookie_index_t;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Init and destroy (table)
+*/
+void __of1x_init_cookie_index(of1x_cookie_index_t* index);
+void __of1x_destroy_cookie_index(of1x_cookie_index_t* index);
+
+/*
+* Accounting of entries. Shall be called by the matching algorithm on entry
+* addition/removal while holding table->mutex
+*/
+void __of1x_cookie_index_add_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+void __of1x_cookie_index_remove_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+
+/**
+* Checks if the index can be used to enumerate the candidates of a
+* cookie/cookie_mask filter
+*/
+bool __of1x_cookie_index_usable(struct of1x_flow_table *const table, uint64_t cookie, uint64_t cookie_mask);
+
+/**
+* Retrieves the entries for which (entry->cookie & cookie_mask) == (cookie & cookie_mask).
+* Requires table->mutex. The array shall be released by the caller via platform_free_shared()
+*
+* @param num_of_entries Number of entries in the array (may be 0)
+* @retval ROFL_FAILURE on memory allocation failure
+*/
+rofl_result_t __of1x_cookie_index_get_entries(struct of1x_flow_table *const table, uint64_t cookie, uint64_t cookie_mask, struct of1x_flow_entry*** entries, unsigned int* num_of_entries);
+
+/**
+* @brief Enables the cookie index of a table
+* @ingroup core_of1x
+*
+* The index is built from the existing entries of the table.
+*
+* @param pipeline Switch pipeline
+* @param table_id Table index
+*/
+rofl_result_t of1x_enable_table_cookie_index(struct of1x_pipeline *const pipeline, const unsigned int table_id);
+
+/**
+* @brief Disables (and releases) the cookie index of a table
+* @ingroup core_of1x
+*/
+rofl_result_t of1x_disable_table_cookie_index(struct of1x_pipeline *const pipeline, const unsigned int table_id);
+
+/*
+* Dump
+*/
+void __of1x_dump_cookie_index(of1x_cookie_index_t* index);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_COOKIE_INDEX
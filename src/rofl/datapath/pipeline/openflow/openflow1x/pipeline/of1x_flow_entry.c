@@ -7,6 +7,8 @@
 
 #include <assert.h>
 #include "../of1x_switch.h"
+#include "../../../physical_switch.h"
+#include "../../../threading.h"
 #include "of1x_pipeline.h"
 #include "of1x_flow_table.h"
 #include "of1x_action.h"
@@ -15,81 +17,239 @@
 #include "../../../util/logging.h"
 
 
+/*
+* Object pool constructor and destructor. The locks, the per thread counters
+* and the cold part of the entry are kept across allocations
+*/
+static rofl_result_t __of1x_flow_entry_ctor(void* obj){
+
+	of1x_flow_entry_t* entry = (of1x_flow_entry_t*)obj;
+
+	entry->cold = (of1x_flow_entry_cold_t*)platform_malloc_shared(sizeof(of1x_flow_entry_cold_t));
+	if( unlikely(NULL==entry->cold) )
+		return ROFL_FAILURE;
+
+	entry->rwlock = platform_rwlock_init(NULL);
+	if( unlikely(NULL==entry->rwlock) )
+		goto CTOR_ERROR_RWLOCK;
+
+	entry->stats.mutex = platform_mutex_init(NULL);
+	if( unlikely(NULL==entry->stats.mutex) )
+		goto CTOR_ERROR_MUTEX;
+
+	if( unlikely(__of1x_stats_slab_alloc(&__of1x_stats_flow_slab, &entry->stats.__id) != ROFL_SUCCESS) )
+		goto CTOR_ERROR_COUNTERS;
+
+	return ROFL_SUCCESS;
+
+CTOR_ERROR_COUNTERS:
+	platform_mutex_destroy(entry->stats.mutex);
+CTOR_ERROR_MUTEX:
+	platform_rwlock_destroy(entry->rwlock);
+CTOR_ERROR_RWLOCK:
+	platform_free_shared(entry->cold);
+	return ROFL_FAILURE;
+}
+
+static void __of1x_flow_entry_dtor(void* obj){
+
+	of1x_flow_entry_t* entry = (of1x_flow_entry_t*)obj;
+
+	__of1x_stats_slab_free(&__of1x_stats_flow_slab, entry->stats.__id);
+	platform_mutex_destroy(entry->stats.mutex);
+	platform_rwlock_destroy(entry->rwlock);
+	platform_free_shared(entry->cold);
+}
+
+static const slab_desc_t of1x_flow_entry_slab_desc = { "flow entry", SLAB_POOL_FLOW_ENTRY, sizeof(of1x_flow_entry_t), __of1x_flow_entry_ctor, __of1x_flow_entry_dtor };
+
 /*
 * Intializer and destructor
 */
 
 of1x_flow_entry_t* of1x_init_flow_entry(bool notify_removal){
 
-	of1x_flow_entry_t* entry = (of1x_flow_entry_t*)platform_malloc_shared(sizeof(of1x_flow_entry_t));
+	platform_rwlock_t* rwlock;
+	platform_mutex_t* stats_mutex;
+	uint32_t stats_id;
+	of1x_flow_entry_cold_t* cold;
+	of1x_instruction_group_t* version;
+	of1x_flow_entry_t* entry = (of1x_flow_entry_t*)__physical_switch_alloc(&of1x_flow_entry_slab_desc);
 	
 	if( unlikely(entry==NULL) )
 		return NULL;
 
-	platform_memset(entry,0,sizeof(of1x_flow_entry_t));	
-	
-	entry->rwlock = platform_rwlock_init(NULL);
-	if( unlikely(NULL==entry->rwlock) ){
-		platform_free_shared(entry);
-		assert(0);
-		return NULL; 
+	//Version of the instructions for packet processing
+	version = (of1x_instruction_group_t*)platform_malloc_shared(sizeof(of1x_instruction_group_t));
+	if( unlikely(version==NULL) ){
+		__slab_free(entry);
+		return NULL;
 	}
+
+	//Keep the (constructed) locks and cold part
+	rwlock = entry->rwlock;
+	stats_mutex = entry->stats.mutex;
+	stats_id = entry->stats.__id;
+	cold = entry->cold;
+	platform_memset(entry,0,sizeof(of1x_flow_entry_t));	
+	platform_memset(cold,0,sizeof(of1x_flow_entry_cold_t));	
+	entry->rwlock = rwlock;
+	entry->stats.mutex = stats_mutex;
+	entry->stats.__id = stats_id;
+	entry->cold = cold;
+	entry->pp_inst_grp = version;
 	
 	//Init matches
 	__of1x_init_match_group(&entry->matches);
 	
 	//Init instructions	
 	__of1x_init_instruction_group(&entry->inst_grp);
+	*entry->pp_inst_grp = entry->inst_grp;
 
 	//init stats
 	__of1x_init_flow_stats(entry);
 
 	//Flags
-	entry->notify_removal = notify_removal;
+	entry->cold->notify_removal = notify_removal;
 	
 	return entry;	
 
 }
 
 
-//This function is meant to only be used internally
-rofl_result_t __of1x_destroy_flow_entry_with_reason(of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason){
-	
-	//wait for any thread which is still using the entry (processing a packet)
-	platform_rwlock_wrlock(entry->rwlock);
-	
+//Destroys the timers and prepares the removal notification. Returns true if it has to be notified
+static bool __of1x_retire_flow_entry_prepare(of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason){
+
 	//destroying timers, if any
 	__of1x_destroy_timer_entries(entry);
 
+	if(!entry->cold->notify_removal || reason == OF1X_FLOW_REMOVE_NO_REASON)
+		return false;
+
+	//Safety checks
+	if(entry->table && entry->table->pipeline && entry->table->pipeline->sw){
+		__of1x_stats_flow_tid_t consolidated_stats;
+
+		//Consolidate stats so that users of the pipeline can use counters
+		__of1x_stats_flow_consolidate(&entry->stats, &consolidated_stats);
+		__of1x_stats_flow_reset_counts(entry);
+		*__of1x_stats_flow_counters(&entry->stats, 0) = consolidated_stats;
+		return true;
+	}
+
+	return false;
+}
+
+//Destroys the timers and notifies the removal, if requested
+void __of1x_retire_flow_entry_with_reason(of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason){
+	
 	//Notify flow removed
-	if(entry->notify_removal && (reason != OF1X_FLOW_REMOVE_NO_REASON ) ){
-		//Safety checks
-		if(entry->table && entry->table->pipeline && entry->table->pipeline->sw){
-			__of1x_stats_flow_tid_t consolidated_stats;
-			
-			//Consolidate stats so that users of the pipeline can use counters
-			__of1x_stats_flow_consolidate(&entry->stats, &consolidated_stats);
-			__of1x_stats_flow_reset_counts(entry);
-			entry->stats.s.counters = consolidated_stats;
-					
-			//Then notify	
-			platform_of1x_notify_flow_removed(entry->table->pipeline->sw, reason, entry);	
-		}	
-	}	
+	if(__of1x_retire_flow_entry_prepare(entry, reason))
+		platform_of1x_notify_flow_removed(entry->table->pipeline->sw, reason, entry);	
+}
+
+//Entries of the same table. The ones notified are moved to the front
+void __of1x_retire_flow_entries_with_reason(of1x_flow_entry_t** entries, of1x_flow_remove_reason_t* reasons, unsigned int num_of_entries){
+
+	unsigned int i, num_of_notified = 0;
+	of1x_flow_entry_t* entry;
+	of1x_flow_remove_reason_t reason;
+
+	for(i=0;i<num_of_entries;i++){
+		if(!__of1x_retire_flow_entry_prepare(entries[i], reasons[i]))
+			continue;
+
+		entry = entries[i];
+		reason = reasons[i];
+		entries[i] = entries[num_of_notified];
+		reasons[i] = reasons[num_of_notified];
+		entries[num_of_notified] = entry;
+		reasons[num_of_notified] = reason;
+		num_of_notified++;
+	}
+
+	if(num_of_notified == 0)
+		return;
+
+	//Then notify (all at once if the platform supports it)
+#ifdef ROFL_PIPELINE_BATCH_FLOW_REMOVED
+	platform_of1x_notify_flows_removed(entries[0]->table->pipeline->sw, entries, reasons, num_of_notified);
+#else
+	for(i=0;i<num_of_notified;i++)
+		platform_of1x_notify_flow_removed(entries[i]->table->pipeline->sw, reasons[i], entries[i]);
+#endif
+}
+
+//Batch of entries released after a single grace period
+typedef struct __of1x_flow_entry_batch{
+	unsigned int num_of_entries;
+	of1x_flow_entry_t** entries;
+}__of1x_flow_entry_batch_t;
+
+static void __of1x_release_flow_entries(void* obj){
+
+	unsigned int i;
+	__of1x_flow_entry_batch_t* batch = (__of1x_flow_entry_batch_t*)obj;
+
+	for(i=0;i<batch->num_of_entries;i++)
+		__of1x_release_flow_entry(batch->entries[i]);
+	platform_free_shared(batch);
+}
+
+void __of1x_defer_release_flow_entries(of1x_flow_entry_t** entries, unsigned int num_of_entries){
+
+	unsigned int i;
+	__of1x_flow_entry_batch_t* batch;
+
+	if(num_of_entries == 0)
+		return;
+
+	batch = (__of1x_flow_entry_batch_t*)platform_malloc_shared(sizeof(__of1x_flow_entry_batch_t) + sizeof(of1x_flow_entry_t*)*num_of_entries);
+	if(unlikely(batch == NULL)){
+		//One by one
+		for(i=0;i<num_of_entries;i++)
+			tid_defer_release(entries[i], __of1x_release_flow_entry);
+		return;
+	}
+
+	batch->num_of_entries = num_of_entries;
+	batch->entries = (of1x_flow_entry_t**)(batch+1);
+	for(i=0;i<num_of_entries;i++)
+		batch->entries[i] = entries[i];
+
+	tid_defer_release(batch, __of1x_release_flow_entries);
+}
+
+//Releases the entry (of1x_flow_entry_t*) and its resources
+void __of1x_release_flow_entry(void* entry){
+
+	of1x_flow_entry_t* e = (of1x_flow_entry_t*)entry;
 
 	//destroy stats
-	__of1x_destroy_flow_stats(entry);
+	__of1x_destroy_flow_stats(e);
 
 	//Destroy matches group 
-	__of1x_destroy_match_group(&entry->matches);
+	__of1x_destroy_match_group(&e->matches);
 
-	//Destroy instructions
-	__of1x_destroy_instruction_group(&entry->inst_grp);
+	//Destroy instructions (a published version only holds references)
+	__of1x_destroy_instruction_group(&e->inst_grp);
+	platform_free_shared(e->pp_inst_grp);
 	
-	platform_rwlock_destroy(entry->rwlock);
+	//Return the entry (and its locks) to the pool
+	__slab_free(e);	
+}
+
+//This function is meant to only be used internally
+rofl_result_t __of1x_destroy_flow_entry_with_reason(of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason){
 	
-	//Destroy entry itself
-	platform_free_shared(entry);	
+	//wait for any thread which is still using the entry (processing a packet)
+	platform_rwlock_wrlock(entry->rwlock);
+
+	__of1x_retire_flow_entry_with_reason(entry, reason);
+
+	platform_rwlock_wrunlock(entry->rwlock);
+
+	__of1x_release_flow_entry(entry);
 	
 	return ROFL_SUCCESS;
 }
@@ -110,8 +270,23 @@ rofl_result_t of1x_add_match_to_entry(of1x_flow_entry_t* entry, of1x_match_t* ma
 	return ROFL_SUCCESS;
 }
 
+static void __of1x_release_instruction_version(void* version){
+	platform_free_shared(version);
+}
+
+void __of1x_publish_flow_entry_instructions(of1x_flow_entry_t* entry){
+	//Not visible yet; the caller orders it before the entry pointer
+	*entry->pp_inst_grp = entry->inst_grp;
+}
+
 rofl_result_t __of1x_update_flow_entry(of1x_flow_entry_t* entry_to_update, of1x_flow_entry_t* mod, bool reset_counts){
 
+	of1x_instruction_group_t update, *version, *prev_version;
+
+	//New version of the instructions for packet processing
+	version = (of1x_instruction_group_t*)platform_malloc_shared(sizeof(of1x_instruction_group_t));
+	if( unlikely(version == NULL) )
+		return ROFL_FAILURE;
 
 	// let the platform do the necessary updates
 	platform_of1x_modify_entry_hook(entry_to_update, mod, reset_counts);
@@ -119,21 +294,38 @@ rofl_result_t __of1x_update_flow_entry(of1x_flow_entry_t* entry_to_update, of1x_
 	//Lock entry
 	platform_rwlock_wrlock(entry_to_update->rwlock);
 
-	//Copy instructions
-	__of1x_update_instructions(&entry_to_update->inst_grp, &mod->inst_grp);
+	//Copy instructions (the replaced actions are released after a grace period)
+	update = entry_to_update->inst_grp;
+	__of1x_update_instructions(&update, &mod->inst_grp);
+
+	//Publish (contents before the pointer)
+	*version = update;
+	prev_version = entry_to_update->pp_inst_grp;
+	tid_memory_barrier();
+	entry_to_update->pp_inst_grp = version;
+
+	//Packet processing never reads inst_grp in place
+	tid_defer_release(prev_version, __of1x_release_instruction_version);
+	entry_to_update->inst_grp = update;
 
 	//Reset counts
 	if(reset_counts){
 		__of1x_stats_flow_reset_counts(entry_to_update);
-		__of1x_reset_last_packet_count_idle_timeout(&entry_to_update->timer_info);
+		__of1x_reset_last_packet_count_idle_timeout(&entry_to_update->cold->timer_info);
 	}
 
 	//Update flags from the new modification flowmod
 	entry_to_update->flags = mod->flags;
+	if(entry_to_update->table)
+		__of1x_stats_flow_set_mode(entry_to_update, entry_to_update->table);
 
 	//Unlock
 	platform_rwlock_wrunlock(entry_to_update->rwlock);
 
+	//Output ports and groups may have changed
+	if(entry_to_update->table)
+		__of1x_reverse_index_update_entry(entry_to_update->table, entry_to_update);
+
 	return ROFL_SUCCESS;
 }
 /**
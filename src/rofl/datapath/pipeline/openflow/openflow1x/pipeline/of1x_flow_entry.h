@@ -64,55 +64,120 @@ typedef void of1x_flow_entry_platform_state_t;
 //Do not check cookie value
 #define OF1X_DO_NOT_CHECK_COOKIE 0xffffffffffffffffULL
 
+/**
+* Flow entry cold state; management state never accessed in the
+* packet processing path. Reached through of1x_flow_entry_t::cold
+* @ingroup core_of1x 
+*/
+typedef struct of1x_flow_entry_cold{
+
+	//Notify when removed
+	bool notify_removal;
+
+	//Timers
+	struct of1x_timers_info timer_info;
+
+	//Strict-match index chaining (maintained by the table)
+	uint32_t strict_hash;
+	struct of1x_flow_entry* strict_next;
+
+	//Cookie index chaining (maintained by the table)
+	struct of1x_flow_entry* cookie_prev;
+	struct of1x_flow_entry* cookie_next;
+
+	//Output port and group references (reverse index)
+	struct of1x_reverse_ref* out_refs;
+
+	//Overlap index (maintained by the table)
+	struct of1x_overlap_class* overlap_class;
+	of1x_match_t* overlap_match;
+	uint32_t overlap_hash;
+	struct of1x_flow_entry* overlap_hash_next;
+	struct of1x_flow_entry* overlap_prev;
+	struct of1x_flow_entry* overlap_next;
+
+	//Slot in the matching algorithm entry array, if any (e.g. loop)
+	unsigned int ma_slot;
+
+	//Slot of the caller's array, while being added by a bundle (of1x_add_flow_entries_table())
+	struct of1x_flow_entry** bundle_ref;
+
+	//Table generation when inserted (of1x_flow_iterator.h)
+	uint64_t generation;
+
+	//Rate estimation (of1x_sample_flow_rates())
+	__of1x_stats_flow_rate_t rate;
+}of1x_flow_entry_cold_t;
+
 /**
 * OpenFlow v1.0, 1.2 and 1.3.2 flow entry structure
+*
+* The fields accessed in the packet processing path (lookup and instruction
+* processing) are kept at the beginning of the structure, within its first two
+* cache lines, so that table scans touch as few cache lines as possible.
+* Management only state, including the instruction group (packet processing
+* reads pp_inst_grp), is kept at the end or in the cold part
+* (of1x_flow_entry_cold_t).
+*
 * @ingroup core_of1x 
 */
 typedef struct of1x_flow_entry{
 	
+	/*
+	* Hot (packet processing)
+	*/
+
 	//Entry priority(lowest 16 bit is the OF priority)
 	//17th bit is only set to 1/0 for OF1.0 (is wildcarded or not) 
 	uint32_t priority;
 	
-	//Previous entry
-	struct of1x_flow_entry* prev;
-	
 	//Next entry
 	struct of1x_flow_entry* next;
 
-	//Table in which rule is inserted (for fast safety checkings)
-	struct of1x_flow_table* table;
-	
 	//Matches
 	of1x_match_group_t matches;
-	
-	//Instructions
-	of1x_instruction_group_t inst_grp;
+
+	//Instructions used by packet processing (RCU). Allocated with the entry,
+	//filled on insertion (__of1x_publish_flow_entry_instructions()) and
+	//replaced by every modification (__of1x_update_flow_entry())
+	of1x_instruction_group_t* pp_inst_grp;
 
 	//Cookie
 	uint64_t cookie;
-	uint64_t cookie_mask;
 
-	//Notify when removed
-	bool notify_removal;
+	//statistics (packet processing only reads the leading counter id, mode
+	//and last use; the time and mutex that follow are management state)
+	of1x_stats_flow_t stats;
 
-	//Timers
-	struct of1x_timers_info timer_info;
+	/*
+	* Management
+	*/
+
+	//Instructions (management copy; packet processing uses pp_inst_grp)
+	of1x_instruction_group_t inst_grp;
+
+	//RWlock (serializes management updates; packet processing does not lock)
+	platform_rwlock_t* rwlock;
+
+	//Previous entry
+	struct of1x_flow_entry* prev;
+
+	//Table in which rule is inserted (for fast safety checkings)
+	struct of1x_flow_table* table;
+	
+	uint64_t cookie_mask;
 
 	//Opaque flags bitmap
 	//This is necessary for OF1.3 and beyond, since
 	//the insertion flags need to kept for future 
 	//flow_stats request... none-sense
 	uint32_t flags;
-	
-	//statistics
-	of1x_stats_flow_t stats;
-
-	//RWlock
-	platform_rwlock_t* rwlock;
 
 	//Platform agnostic pointer
 	of1x_flow_entry_platform_state_t* platform_state;
+
+	//Cold state (always valid for entries created via of1x_init_flow_entry())
+	of1x_flow_entry_cold_t* cold;
 }of1x_flow_entry_t;
 
 //C++ extern C
@@ -127,6 +192,17 @@ of1x_flow_entry_t* of1x_init_flow_entry(bool notify_removal);
 //This should never be used from outside the library
 rofl_result_t __of1x_destroy_flow_entry_with_reason(of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason); 
 
+//Two halves of __of1x_destroy_flow_entry_with_reason(), so that the release
+//can be deferred (tid_defer_release()) once the entry is unlinked 
+void __of1x_retire_flow_entry_with_reason(of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason); 
+void __of1x_release_flow_entry(void* entry); 
+
+//Batch versions; notifications are delivered at once if the platform supports it
+//(ROFL_PIPELINE_BATCH_FLOW_REMOVED) and the entries released after a single grace
+//period. The arrays may be reordered
+void __of1x_retire_flow_entries_with_reason(of1x_flow_entry_t** entries, of1x_flow_remove_reason_t* reasons, unsigned int num_of_entries);
+void __of1x_defer_release_flow_entries(of1x_flow_entry_t** entries, unsigned int num_of_entries);
+
 /**
 * @brief Destroy the flow entry, including stats, instructions and actions 
 * @ingroup core_of1x 
@@ -140,7 +216,12 @@ rofl_result_t of1x_destroy_flow_entry(of1x_flow_entry_t* entry);
 */
 rofl_result_t of1x_add_match_to_entry(of1x_flow_entry_t* entry, of1x_match_t* match);
 
-//Update entry
+//Copies the instructions to the version used by packet processing. Must be
+//called before the entry is visible to packet processing (insertion)
+void __of1x_publish_flow_entry_instructions(of1x_flow_entry_t* entry);
+
+//Update entry. Instructions are published as a new version (pp_inst_grp); the
+//previous one is released after a grace period
 rofl_result_t __of1x_update_flow_entry(of1x_flow_entry_t* entry_to_update, of1x_flow_entry_t* mod, bool reset_counts);
 
 //Fast validation against OF version
@@ -0,0 +1,187 @@
+#include "of1x_flow_iterator.h"
+
+#include "../../../platform/lock.h"
+#include "../../../platform/memory.h"
+
+#include "of1x_pipeline.h"
+#include "of1x_flow_entry.h"
+#include "of1x_flow_table.h"
+#include "../of1x_switch.h"
+
+/*
+* Registration (table->mutex)
+*/
+static void __of1x_flow_iterator_register(of1x_flow_table_t *const table, of1x_flow_iterator_t* it){
+
+	it->prev_it = NULL;
+	it->next_it = table->iterators;
+	if(table->iterators)
+		table->iterators->prev_it = it;
+	table->iterators = it;
+	it->registered = true;
+}
+
+static void __of1x_flow_iterator_unregister(of1x_flow_table_t *const table, of1x_flow_iterator_t* it){
+
+	if(it->prev_it)
+		it->prev_it->next_it = it->next_it;
+	else
+		table->iterators = it->next_it;
+	if(it->next_it)
+		it->next_it->prev_it = it->prev_it;
+
+	it->prev_it = it->next_it = NULL;
+	it->registered = false;
+}
+
+void __of1x_flow_iterators_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+	entry->cold->generation = ++table->generation;
+}
+
+void __of1x_flow_iterators_replace_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const existing, of1x_flow_entry_t *const entry){
+
+	of1x_flow_iterator_t* it;
+
+	entry->cold->generation = existing->cold->generation;
+
+	for(it=table->iterators; it; it=it->next_it){
+		if(it->next == existing)
+			it->next = entry;
+	}
+}
+
+void __of1x_flow_iterators_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_flow_iterator_t* it;
+
+	table->generation++;
+
+	for(it=table->iterators; it; it=it->next_it){
+		if(it->next == entry)
+			it->next = entry->next;
+	}
+}
+
+/*
+* Iterator
+*/
+rofl_result_t of1x_init_flow_iterator(of1x_flow_iterator_t* it, of1x_pipeline_t* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, of1x_match_group_t *const matches){
+
+	//Verify table_id
+	if(table_id >= pipeline->num_of_tables && table_id != OF1X_FLOW_TABLE_ALL)
+		return ROFL_FAILURE;
+
+	platform_memset(it, 0, sizeof(*it));
+
+	it->pipeline = pipeline;
+	it->cookie = cookie;
+	it->cookie_mask = cookie_mask;
+	it->out_port = out_port;
+	it->out_group = out_group;
+	if(matches)
+		it->matches = *matches;
+
+	//Set the tables to go through
+	if(table_id == OF1X_FLOW_TABLE_ALL){
+		it->table_id = 0;
+		it->last_table_id = pipeline->num_of_tables-1;
+	}else{
+		it->table_id = it->last_table_id = table_id;
+	}
+
+	return ROFL_SUCCESS;
+}
+
+void of1x_release_flow_iterator(of1x_flow_iterator_t* it){
+
+	of1x_flow_table_t* table;
+
+	if(!it->registered)
+		return;
+
+	table = &it->pipeline->tables[it->table_id];
+
+	platform_mutex_lock(table->mutex);
+	__of1x_flow_iterator_unregister(table, it);
+	platform_mutex_unlock(table->mutex);
+}
+
+//Same selection as of1x_get_flow_stats()
+static inline bool __of1x_flow_iterator_is_selected(of1x_flow_entry_t* filter_entry, of1x_flow_entry_t* entry, bool check_cookie, uint32_t out_port, uint32_t out_group){
+
+	//Cookie of the request
+	if(check_cookie && filter_entry->cookie != OF1X_DO_NOT_CHECK_COOKIE && filter_entry->cookie_mask){
+		if( ((entry->cookie ^ filter_entry->cookie) & filter_entry->cookie_mask) != 0x0ULL )
+			return false;
+	}
+
+	//Check if is contained
+	return __of1x_flow_entry_check_contained(filter_entry, entry, false, check_cookie, out_port, out_group, true);
+}
+
+rofl_result_t of1x_flow_iterator_next_chunk(of1x_flow_iterator_t* it, unsigned int max_entries, of1x_flow_iterator_cb_t callback, void* opaque, unsigned int* num_of_entries){
+
+	unsigned int scanned;
+	bool check_cookie = ( it->pipeline->sw->of_ver != OF_VERSION_10 ); //Ignore cookie in OF1.0
+	of1x_flow_table_t* table;
+	of1x_flow_entry_t *entry, filter_entry;
+
+	*num_of_entries = 0;
+
+	//Filter entry for easy comparison
+	platform_memset(&filter_entry,0,sizeof(of1x_flow_entry_t));
+	filter_entry.matches = it->matches;
+	filter_entry.cookie = it->cookie;
+	filter_entry.cookie_mask = it->cookie_mask;
+
+	while(!it->done && *num_of_entries < max_entries){
+
+		table = &it->pipeline->tables[it->table_id];
+
+		//Serialize with flow_mods (released every OF1X_FLOW_ITERATOR_MAX_SCAN entries)
+		platform_mutex_lock(table->mutex);
+
+		if(!it->registered){
+			__of1x_flow_iterator_register(table, it);
+			it->next = table->entries;
+			it->generation = table->generation;
+		}
+
+		for(scanned=0, entry=it->next; entry && scanned < OF1X_FLOW_ITERATOR_MAX_SCAN; entry=entry->next, scanned++){
+
+			//Inserted after the iteration started
+			if(entry->cold->generation > it->generation)
+				continue;
+
+			if(!__of1x_flow_iterator_is_selected(&filter_entry, entry, check_cookie, it->out_port, it->out_group))
+				continue;
+
+			if(*num_of_entries == max_entries || !(*callback)(entry, opaque))
+				break;
+
+			(*num_of_entries)++;
+		}
+
+		if(entry){
+			//Let flow_mods in
+			it->next = entry;
+			platform_mutex_unlock(table->mutex);
+
+			if(scanned < OF1X_FLOW_ITERATOR_MAX_SCAN)
+				break; //Chunk done
+			continue;
+		}
+
+		//Table done
+		__of1x_flow_iterator_unregister(table, it);
+		it->next = NULL;
+		platform_mutex_unlock(table->mutex);
+
+		if(it->table_id == it->last_table_id)
+			it->done = true;
+		else
+			it->table_id++;
+	}
+
+	return ROFL_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_FLOW_ITERATOR_H__
+#define __OF1X_FLOW_ITERATOR_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include "rofl_datapath.h"
+#include "of1x_match.h"
+
+/**
+* @file of1x_flow_iterator.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 incremental (resumable) flow table iteration
+*
+* Walks the entries of one or all the tables in chunks, holding the
+* table->mutex only while a chunk is being retrieved (and at most for
+* OF1X_FLOW_ITERATOR_MAX_SCAN entries), so that flow-mods are not delayed by
+* long dumps.
+*
+* The iterator survives concurrent modifications:
+*
+* - Iterators are registered in the table they are positioned in, and are
+*   moved forward when the entry they point to is removed.
+* - Entries are stamped with the table generation (incremented on every
+*   insertion and removal) when inserted. Entries inserted after the iteration
+*   of the table started are skipped.
+*
+* - An entry replacing an existing one (flow_mod add of an identical entry) is
+*   inserted right before it and takes over its stamp and its iterators, so
+*   that it is visited instead of the replaced one (unless the replaced one
+*   was already visited).
+*
+* Hence entries present during the whole iteration are visited exactly once,
+* and entries inserted meanwhile never.
+*
+* Usage:
+*
+* of1x_init_flow_iterator(&it, pipeline, table_id, cookie, cookie_mask, out_port, out_group, matches);
+* while(!it.done){
+*	if(of1x_flow_iterator_next_chunk(&it, max_entries, callback, opaque, &num_of_entries) != ROFL_SUCCESS)
+*		break;
+* }
+* of1x_release_flow_iterator(&it);
+*/
+
+//Entries visited per table->mutex hold
+#define OF1X_FLOW_ITERATOR_MAX_SCAN 1024
+
+//fwd decl
+struct of1x_flow_entry;
+struct of1x_flow_table;
+struct of1x_pipeline;
+
+/**
+* @ingroup core_of1x
+* Chunk callback. Called with the table->mutex held; the entry must not be
+* modified nor referenced afterwards. Returning false stops the chunk; the
+* entry is then the first one of the next chunk.
+*/
+typedef bool (*of1x_flow_iterator_cb_t)(struct of1x_flow_entry* entry, void* opaque);
+
+/**
+* @ingroup core_of1x
+* Flow table iterator. Allocated by the caller; the contents are private
+* (except done)
+*/
+typedef struct of1x_flow_iterator{
+	//Filters
+	struct of1x_pipeline* pipeline;
+	uint64_t cookie;
+	uint64_t cookie_mask;
+	uint32_t out_port;
+	uint32_t out_group;
+	of1x_match_group_t matches;
+	unsigned int last_table_id;
+
+	//Position; next entry to visit of table_id (if registered)
+	unsigned int table_id;
+	struct of1x_flow_entry* next;
+
+	//Table generation when the iteration of table_id started
+	uint64_t generation;
+
+	//Registered in table_id (of1x_flow_table_t::iterators)
+	bool registered;
+	struct of1x_flow_iterator* prev_it;
+	struct of1x_flow_iterator* next_it;
+
+	//All the entries have been visited
+	bool done;
+}of1x_flow_iterator_t;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/**
+* @brief Initializes a flow table iterator
+* @ingroup core_of1x
+*
+* The filters are the ones of of1x_get_flow_stats() (match subset, cookie,
+* out_port and out_group). The matches are not copied; they must remain valid
+* until the iterator is released.
+*
+* @param table_id Table index, or OF1X_FLOW_TABLE_ALL
+* @param cookie_mask 0x0 not to filter by cookie (always in OF1.0)
+* @param matches Match subset, or NULL not to filter by match
+*/
+rofl_result_t of1x_init_flow_iterator(of1x_flow_iterator_t* it, struct of1x_pipeline* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, of1x_match_group_t *const matches);
+
+/**
+* @brief Retrieves the next chunk of entries
+* @ingroup core_of1x
+*
+* Calls callback for up to max_entries entries, and advances the iterator.
+* Sets it->done once all the entries have been visited.
+*
+* @param num_of_entries Number of entries consumed by the callback
+*/
+rofl_result_t of1x_flow_iterator_next_chunk(of1x_flow_iterator_t* it, unsigned int max_entries, of1x_flow_iterator_cb_t callback, void* opaque, unsigned int* num_of_entries);
+
+/**
+* @brief Releases the iterator (mandatory, also if the iteration is not finished)
+* @ingroup core_of1x
+*
+* Iterators must be released before the switch is destroyed.
+*/
+void of1x_release_flow_iterator(of1x_flow_iterator_t* it);
+
+//Stamps the entry being inserted with the table generation. Requires table->mutex
+void __of1x_flow_iterators_add_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+
+//Stamps entry, inserted right before existing (to be detached), as existing and moves
+//the iterators positioned at existing to entry. Requires table->mutex
+void __of1x_flow_iterators_replace_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const existing, struct of1x_flow_entry *const entry);
+
+//Moves forward the iterators positioned at entry (being detached). Requires table->mutex
+void __of1x_flow_iterators_remove_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_FLOW_ITERATOR
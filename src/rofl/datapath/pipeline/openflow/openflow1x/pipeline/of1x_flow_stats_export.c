@@ -0,0 +1,186 @@
+#include "of1x_flow_stats_export.h"
+
+#include <limits.h>
+#include "../of1x_async_events_hooks.h"
+
+#include "of1x_pipeline.h"
+#include "of1x_flow_entry.h"
+#include "of1x_flow_table.h"
+#include "of1x_statistics.h"
+
+/*
+* Cursor
+*/
+rofl_result_t of1x_init_flow_stats_cursor(of1x_flow_stats_cursor_t* cursor, of1x_pipeline_t* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, of1x_match_group_t *const matches){
+	return of1x_init_flow_iterator(cursor, pipeline, table_id, cookie, cookie_mask, out_port, out_group, matches);
+}
+
+void of1x_release_flow_stats_cursor(of1x_flow_stats_cursor_t* cursor){
+	of1x_release_flow_iterator(cursor);
+}
+
+/*
+* Export
+*/
+
+static inline size_t __of1x_flow_stats_export_align(size_t len){
+	return (len + OF1X_FLOW_STATS_EXPORT_ALIGN-1) & ~((size_t)OF1X_FLOW_STATS_EXPORT_ALIGN-1);
+}
+
+//Size of the instructions blob
+static size_t __of1x_flow_stats_export_instructions_len(of1x_instruction_group_t* inst_grp){
+
+	unsigned int i;
+	size_t len = 0;
+	of1x_instruction_t* inst;
+
+	for(i=0;i<OF1X_IT_MAX;i++){
+		inst = &inst_grp->instructions[i];
+		if(inst->type == OF1X_IT_NO_INSTRUCTION)
+			continue;
+
+		len += sizeof(of1x_flow_stats_instruction_t);
+		if(inst->type == OF1X_IT_APPLY_ACTIONS && inst->apply_actions)
+			len += sizeof(of1x_flow_stats_action_t)*inst->apply_actions->num_of_actions;
+		else if(inst->type == OF1X_IT_WRITE_ACTIONS && inst->write_actions)
+			len += sizeof(of1x_flow_stats_action_t)*inst->write_actions->num_of_actions;
+	}
+
+	return len;
+}
+
+static inline void __of1x_flow_stats_export_action(of1x_flow_stats_action_t* dst, of1x_packet_action_t* action){
+	dst->type = action->type;
+	dst->__field = action->__field;
+	dst->send_len = action->send_len;
+}
+
+//Flattens the instructions; returns the number of instructions
+static uint32_t __of1x_flow_stats_export_instructions(of1x_instruction_group_t* inst_grp, uint8_t* blob){
+
+	unsigned int i, j;
+	uint32_t num_of_instructions = 0;
+	of1x_instruction_t* inst;
+	of1x_flow_stats_instruction_t* dst = (of1x_flow_stats_instruction_t*)blob;
+	of1x_flow_stats_action_t* actions;
+	of1x_packet_action_t* action;
+
+	for(i=0;i<OF1X_IT_MAX;i++){
+		inst = &inst_grp->instructions[i];
+		if(inst->type == OF1X_IT_NO_INSTRUCTION)
+			continue;
+
+		dst->type = inst->type;
+		dst->num_of_actions = 0;
+		dst->write_metadata = inst->write_metadata;
+		dst->go_to_table = inst->go_to_table;
+		actions = of1x_flow_stats_instruction_actions(dst);
+
+		if(inst->type == OF1X_IT_APPLY_ACTIONS && inst->apply_actions){
+			for(action=inst->apply_actions->head; action; action=action->next)
+				__of1x_flow_stats_export_action(&actions[dst->num_of_actions++], action);
+		}else if(inst->type == OF1X_IT_WRITE_ACTIONS && inst->write_actions){
+			for(j=0;j<OF1X_AT_NUMBER && dst->num_of_actions < inst->write_actions->num_of_actions;j++){
+				if(bitmap128_is_bit_set(&inst->write_actions->bitmap, j))
+					__of1x_flow_stats_export_action(&actions[dst->num_of_actions++], &inst->write_actions->actions[j]);
+			}
+		}
+
+		num_of_instructions++;
+		dst = of1x_flow_stats_next_instruction(dst);
+	}
+
+	return num_of_instructions;
+}
+
+//Buffer being filled
+typedef struct of1x_flow_stats_export_buf{
+	uint8_t* buf;
+	size_t records_len;
+	size_t blobs_start;
+	unsigned int num_of_records;
+}of1x_flow_stats_export_buf_t;
+
+//Iterator callback; exports the entry if it fits
+static bool __of1x_flow_stats_export_entry(of1x_flow_entry_t* entry, void* opaque){
+
+	of1x_flow_stats_export_buf_t* exp = (of1x_flow_stats_export_buf_t*)opaque;
+	size_t matches_len, instructions_len;
+	of1x_flow_stats_record_t* record;
+	of1x_flow_stats_match_t* match;
+	of1x_match_t* it;
+	__of1x_stats_flow_tid_t c;
+
+	//Room for the record and its blobs
+	matches_len = __of1x_flow_stats_export_align(sizeof(of1x_flow_stats_match_t)*entry->matches.num_elements);
+	instructions_len = __of1x_flow_stats_export_align(__of1x_flow_stats_export_instructions_len(&entry->inst_grp));
+
+	if( exp->records_len+sizeof(of1x_flow_stats_record_t)+matches_len+instructions_len > exp->blobs_start )
+		return false; //Next chunk
+
+	// update statistics from platform
+	platform_of1x_update_stats_hook(entry);
+
+	record = (of1x_flow_stats_record_t*)(exp->buf+exp->records_len);
+	exp->records_len += sizeof(of1x_flow_stats_record_t);
+	exp->num_of_records++;
+
+	//Fill static values
+	record->table_id = entry->table->number;
+	record->priority = entry->priority;
+	record->cookie = entry->cookie;
+	record->idle_timeout = entry->cold->timer_info.idle_timeout;
+	record->hard_timeout = entry->cold->timer_info.hard_timeout;
+	record->flags = entry->flags;
+
+	//Aggregate stats
+	__of1x_stats_flow_consolidate(&entry->stats, &c);
+	record->packet_count = c.packet_count;
+	record->byte_count = c.byte_count;
+	of1x_stats_flow_get_rates(entry, &record->packet_rate, &record->byte_rate);
+
+	//Get durations
+	of1x_stats_flow_get_duration(entry, &record->duration_sec, &record->duration_nsec);
+
+	//Matches
+	exp->blobs_start -= matches_len;
+	record->matches_offset = exp->blobs_start;
+	record->num_of_matches = 0;
+	match = (of1x_flow_stats_match_t*)(exp->buf+exp->blobs_start);
+	for(it=entry->matches.head; it; it=it->next, match++){
+		match->type = it->type;
+		match->__tern = it->__tern;
+		match->vlan_present = it->vlan_present;
+		record->num_of_matches++;
+	}
+
+	//Instructions
+	exp->blobs_start -= instructions_len;
+	record->instructions_offset = exp->blobs_start;
+	record->instructions_len = instructions_len;
+	record->num_of_instructions = __of1x_flow_stats_export_instructions(&entry->inst_grp, exp->buf+exp->blobs_start);
+
+	return true;
+}
+
+rofl_result_t of1x_export_flow_stats(of1x_flow_stats_cursor_t* cursor, void* buffer, size_t size, unsigned int* num_of_records){
+
+	unsigned int num_of_entries;
+	of1x_flow_stats_export_buf_t exp;
+
+	exp.buf = (uint8_t*)buffer;
+	exp.records_len = 0;
+	exp.blobs_start = size & ~((size_t)OF1X_FLOW_STATS_EXPORT_ALIGN-1);
+	exp.num_of_records = 0;
+
+	//The buffer bounds the chunk
+	of1x_flow_iterator_next_chunk(cursor, UINT_MAX, __of1x_flow_stats_export_entry, &exp, &num_of_entries);
+
+	*num_of_records = exp.num_of_records;
+
+	//The next flow does not fit in the (empty) buffer
+	if(exp.num_of_records == 0 && !cursor->done)
+		return ROFL_FAILURE;
+
+	return ROFL_SUCCESS;
+}
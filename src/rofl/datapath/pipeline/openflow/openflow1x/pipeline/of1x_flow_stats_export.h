@@ -0,0 +1,184 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_FLOW_STATS_EXPORT_H__
+#define __OF1X_FLOW_STATS_EXPORT_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include "rofl_datapath.h"
+#include "../../../common/ternary_fields.h"
+#include "of1x_match.h"
+#include "of1x_action.h"
+#include "of1x_instruction.h"
+#include "of1x_flow_iterator.h"
+
+/**
+* @file of1x_flow_stats_export.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 streaming (allocation free) flow stats export
+*
+* of1x_get_flow_stats() allocates a message per flow, plus copies of all its
+* matches and instructions. The export API instead fills a caller provided
+* buffer, chunk by chunk, through a cursor:
+*
+* - Fixed size records (of1x_flow_stats_record_t) are placed at the beginning
+*   of the buffer, in table order.
+* - The matches and instructions of each record are flattened into blobs
+*   (arrays of of1x_flow_stats_match_t and of1x_flow_stats_instruction_t,
+*   each instruction followed by its actions) placed from the end of the
+*   buffer downwards. Records refer to them by offset (from the beginning of
+*   the buffer).
+*
+* Flows are walked with a flow table iterator (of1x_flow_iterator.h), so the
+* table->mutex is only held while a chunk is being filled, and flow-mods in
+* between never invalidate the cursor: entries present during the whole export
+* are exported exactly once, entries added meanwhile never.
+*
+* Usage:
+*
+* of1x_init_flow_stats_cursor(&cursor, pipeline, table_id, ...);
+* while(!cursor.done){
+*	if(of1x_export_flow_stats(&cursor, buffer, size, &num_of_records) != ROFL_SUCCESS)
+*		break;
+*	//Serialize records...
+* }
+* of1x_release_flow_stats_cursor(&cursor);
+*/
+
+//Alignment of the blobs within the buffer
+#define OF1X_FLOW_STATS_EXPORT_ALIGN 16
+
+//fwd decl
+struct of1x_pipeline;
+
+/**
+* @ingroup core_of1x
+* Exported match (flat copy of of1x_match_t value and mask, in NBO)
+*/
+typedef struct of1x_flow_stats_match{
+	of1x_match_type_t type;
+	utern_t __tern;
+	enum of1x_vlan_present vlan_present;
+}of1x_flow_stats_match_t;
+
+/**
+* @ingroup core_of1x
+* Exported action (group id in __field for OF1X_AT_GROUP)
+*/
+typedef struct of1x_flow_stats_action{
+	of1x_packet_action_type_t type;
+	wrap_uint_t __field;
+	uint16_t send_len;
+}of1x_flow_stats_action_t;
+
+/**
+* @ingroup core_of1x
+* Exported instruction. APPLY_ACTIONS and WRITE_ACTIONS instructions are
+* followed by num_of_actions of1x_flow_stats_action_t
+*/
+typedef struct of1x_flow_stats_instruction{
+	of1x_instruction_type_t type;
+	uint32_t num_of_actions;
+	of1x_write_metadata_t write_metadata;
+	unsigned int go_to_table;
+}of1x_flow_stats_instruction_t;
+
+/**
+* @ingroup core_of1x
+* Exported flow (same contents as of1x_stats_single_flow_msg_t)
+*/
+typedef struct of1x_flow_stats_record{
+	uint8_t table_id;
+	uint16_t priority;
+	uint64_t cookie;
+
+	uint32_t duration_sec;
+	uint32_t duration_nsec;
+
+	uint16_t idle_timeout;
+	uint16_t hard_timeout;
+
+	uint16_t flags;
+
+	uint64_t packet_count;
+	uint64_t byte_count;
+
+	//Estimated rates, per second (of1x_sample_flow_rates())
+	uint64_t packet_rate;
+	uint64_t byte_rate;
+
+	//Matches blob (of1x_flow_stats_match_t[num_of_matches])
+	uint32_t matches_offset;
+	uint32_t num_of_matches;
+
+	//Instructions blob (num_of_instructions of1x_flow_stats_instruction_t, with their actions)
+	uint32_t instructions_offset;
+	uint32_t instructions_len;
+	uint32_t num_of_instructions;
+}of1x_flow_stats_record_t;
+
+/**
+* @ingroup core_of1x
+* Export cursor (a flow table iterator, see of1x_flow_iterator.h). Allocated
+* by the caller; the contents are private (except done)
+*/
+typedef of1x_flow_iterator_t of1x_flow_stats_cursor_t;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/**
+* @brief Initializes a flow stats export cursor
+* @ingroup core_of1x
+*
+* The request parameters are the ones of of1x_get_flow_stats(). The matches
+* are not copied; they must remain valid until the cursor is released.
+*
+* @param table_id Table index, or OF1X_FLOW_TABLE_ALL
+*/
+rofl_result_t of1x_init_flow_stats_cursor(of1x_flow_stats_cursor_t* cursor, struct of1x_pipeline* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, of1x_match_group_t *const matches);
+
+/**
+* @brief Exports the next chunk of flow stats into buffer
+* @ingroup core_of1x
+*
+* Fills as many records as fit in the buffer, and advances the cursor. Sets
+* cursor->done once all the flows have been exported.
+*
+* @param buffer Buffer (aligned to OF1X_FLOW_STATS_EXPORT_ALIGN)
+* @param size Buffer size
+* @param num_of_records Number of records filled
+* @retval ROFL_FAILURE if the buffer cannot hold the next flow
+*/
+rofl_result_t of1x_export_flow_stats(of1x_flow_stats_cursor_t* cursor, void* buffer, size_t size, unsigned int* num_of_records);
+
+/**
+* @brief Releases the cursor (mandatory, also if the export is not finished)
+* @ingroup core_of1x
+*
+* Cursors must be released before the switch is destroyed.
+*/
+void of1x_release_flow_stats_cursor(of1x_flow_stats_cursor_t* cursor);
+
+//Blob accessors
+static inline of1x_flow_stats_match_t* of1x_flow_stats_record_matches(void* buffer, of1x_flow_stats_record_t* record){
+	return (of1x_flow_stats_match_t*)((uint8_t*)buffer + record->matches_offset);
+}
+static inline of1x_flow_stats_instruction_t* of1x_flow_stats_record_instructions(void* buffer, of1x_flow_stats_record_t* record){
+	return (of1x_flow_stats_instruction_t*)((uint8_t*)buffer + record->instructions_offset);
+}
+//Actions of an instruction, and next instruction
+static inline of1x_flow_stats_action_t* of1x_flow_stats_instruction_actions(of1x_flow_stats_instruction_t* inst){
+	return (of1x_flow_stats_action_t*)(inst+1);
+}
+static inline of1x_flow_stats_instruction_t* of1x_flow_stats_next_instruction(of1x_flow_stats_instruction_t* inst){
+	return (of1x_flow_stats_instruction_t*)(of1x_flow_stats_instruction_actions(inst)+inst->num_of_actions);
+}
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_FLOW_STATS_EXPORT
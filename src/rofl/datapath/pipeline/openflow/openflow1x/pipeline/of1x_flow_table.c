@@ -2,12 +2,14 @@
 
 #include "../../../platform/likely.h"
 #include "../../../platform/lock.h"
+#include "../../../platform/memory.h"
 #include "../../../util/logging.h"
 
 #include "of1x_group_table.h"
 #include "of1x_pipeline.h"
 #include "of1x_action.h"
 #include "of1x_match.h"
+#include "of1x_flow_iterator.h"
 #include "../of1x_switch.h"
 
 
@@ -322,6 +324,120 @@ void __of13_set_table_defaults(of1x_flow_table_t* table){
 
 
 /* Initalizer. Table struct has been allocated by pipeline initializer. */
+/*
+* Strict-match index
+*/
+static rofl_result_t __of1x_init_strict_index(of1x_strict_index_t* index){
+	index->buckets = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*OF1X_STRICT_INDEX_INITIAL_BUCKETS);
+	if(unlikely(index->buckets == NULL))
+		return ROFL_FAILURE;
+
+	platform_memset(index->buckets, 0, sizeof(of1x_flow_entry_t*)*OF1X_STRICT_INDEX_INITIAL_BUCKETS);
+	index->num_of_buckets = OF1X_STRICT_INDEX_INITIAL_BUCKETS;
+	index->num_of_entries = 0;
+
+	return ROFL_SUCCESS;
+}
+
+static void __of1x_destroy_strict_index(of1x_strict_index_t* index){
+	if(index->buckets)
+		platform_free_shared(index->buckets);
+	index->buckets = NULL;
+	index->num_of_buckets = index->num_of_entries = 0;
+}
+
+static inline uint32_t __of1x_strict_index_hash(of1x_flow_entry_t *const entry){
+	uint32_t hash = __of1x_match_group_hash(&entry->matches);
+
+	//Mix in the (full) priority
+	hash ^= entry->priority * 0x9E3779B1;
+	hash ^= hash >> 15;
+	return hash;
+}
+
+//Doubles the number of buckets. On allocation failure chains just get longer
+static void __of1x_strict_index_grow(of1x_strict_index_t* index){
+
+	unsigned int i, num_of_buckets = index->num_of_buckets*2;
+	of1x_flow_entry_t **buckets, *it, *next;
+
+	buckets = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*num_of_buckets);
+	if(unlikely(buckets == NULL))
+		return;
+	platform_memset(buckets, 0, sizeof(of1x_flow_entry_t*)*num_of_buckets);
+
+	for(i=0;i<index->num_of_buckets;i++){
+		for(it=index->buckets[i]; it; it=next){
+			next = it->cold->strict_next;
+			it->cold->strict_next = buckets[it->cold->strict_hash & (num_of_buckets-1)];
+			buckets[it->cold->strict_hash & (num_of_buckets-1)] = it;
+		}
+	}
+
+	platform_free_shared(index->buckets);
+	index->buckets = buckets;
+	index->num_of_buckets = num_of_buckets;
+}
+
+void __of1x_strict_index_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_strict_index_t* index = &table->strict_index;
+	of1x_flow_entry_t** bucket;
+
+	if(unlikely(index->buckets == NULL))
+		return;
+
+	if(index->num_of_entries >= index->num_of_buckets*OF1X_STRICT_INDEX_MAX_LOAD)
+		__of1x_strict_index_grow(index);
+
+	entry->cold->strict_hash = __of1x_strict_index_hash(entry);
+	bucket = &index->buckets[entry->cold->strict_hash & (index->num_of_buckets-1)];
+	entry->cold->strict_next = *bucket;
+	*bucket = entry;
+	index->num_of_entries++;
+}
+
+void __of1x_strict_index_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_strict_index_t* index = &table->strict_index;
+	of1x_flow_entry_t** it;
+
+	if(unlikely(index->buckets == NULL))
+		return;
+
+	for(it = &index->buckets[entry->cold->strict_hash & (index->num_of_buckets-1)]; *it; it = &(*it)->cold->strict_next){
+		if(*it == entry){
+			*it = entry->cold->strict_next;
+			entry->cold->strict_next = NULL;
+			index->num_of_entries--;
+			return;
+		}
+	}
+
+	assert(0); //Entry not indexed
+}
+
+of1x_flow_entry_t* __of1x_strict_index_find(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, uint32_t out_port, uint32_t out_group, bool check_cookie){
+
+	of1x_strict_index_t* index = &table->strict_index;
+	of1x_flow_entry_t* it;
+	uint32_t hash;
+
+	if(unlikely(index->buckets == NULL))
+		return NULL;
+
+	hash = __of1x_strict_index_hash(entry);
+
+	for(it = index->buckets[hash & (index->num_of_buckets-1)]; it; it = it->cold->strict_next){
+		if(it->cold->strict_hash != hash)
+			continue;
+		if( __of1x_flow_entry_check_equal(it, entry, out_port, out_group, check_cookie) )
+			return it;
+	}
+
+	return NULL;
+}
+
 rofl_result_t __of1x_init_table(struct of1x_pipeline* pipeline, of1x_flow_table_t* table, const unsigned int table_index, const enum of1x_matching_algorithm_available algorithm){
 
 	//Safety checks
@@ -336,15 +452,13 @@ rofl_result_t __of1x_init_table(struct of1x_pipeline* pipeline, of1x_flow_table_
 	if( unlikely(NULL==table->rwlock) )
 		return ROFL_FAILURE;
 
-#ifdef ROFL_PIPELINE_LOCKLESS
-	tid_init_presence_mask(&table->tid_presence_mask);
-#endif
-	
 	table->pipeline = pipeline;
 	table->number = table_index;
 	table->entries = NULL;
 	table->num_of_entries = 0;
 	table->max_entries = OF1X_MAX_NUMBER_OF_TABLE_ENTRIES;
+	table->iterators = NULL;
+	table->generation = 0;
 
 	//Set name
 	snprintf(table->name, OF1X_MAX_TABLE_NAME_LEN, "table%u", table_index);
@@ -363,16 +477,8 @@ rofl_result_t __of1x_init_table(struct of1x_pipeline* pipeline, of1x_flow_table_
 	table->matching_aux[0] = NULL; 
 	table->matching_aux[1] = NULL;
 
-	//Initializing timers. NOTE does that need to be done here or somewhere else?
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	if(__of1x_timer_group_static_init(table) != ROFL_SUCCESS){
-		platform_mutex_destroy(table->mutex);
-		platform_rwlock_destroy(table->rwlock);
-		return ROFL_FAILURE;
-	}
-#else
-	table->timers = NULL;
-#endif
+	//Initializing timers
+	__of1x_init_timer_wheel(table);
 
 	switch(pipeline->sw->of_ver){
 		case OF_VERSION_10:
@@ -391,7 +497,44 @@ rofl_result_t __of1x_init_table(struct of1x_pipeline* pipeline, of1x_flow_table_
 	}
 
 	//Init stats
-	__of1x_stats_table_init(table);
+	if(__of1x_stats_table_init(table) != ROFL_SUCCESS){
+		platform_mutex_destroy(table->mutex);
+		platform_rwlock_destroy(table->rwlock);
+		return ROFL_FAILURE;
+	}
+
+	//Miss filter is disabled by default
+	__of1x_init_miss_filter(&table->miss_filter);
+
+	//Heavy hitter detection is disabled by default
+	table->heavy_hitters = NULL;
+
+	//Cookie index is disabled by default
+	__of1x_init_cookie_index(&table->cookie_index);
+
+	//Strict-match index
+	if(__of1x_init_strict_index(&table->strict_index) != ROFL_SUCCESS){
+		platform_mutex_destroy(table->mutex);
+		platform_rwlock_destroy(table->rwlock);
+		return ROFL_FAILURE;
+	}
+
+	//Reverse index
+	if(__of1x_init_reverse_index(&table->reverse_index) != ROFL_SUCCESS){
+		__of1x_destroy_strict_index(&table->strict_index);
+		platform_mutex_destroy(table->mutex);
+		platform_rwlock_destroy(table->rwlock);
+		return ROFL_FAILURE;
+	}
+
+	//Overlap-check index
+	if(__of1x_init_overlap_index(&table->overlap_index) != ROFL_SUCCESS){
+		__of1x_destroy_strict_index(&table->strict_index);
+		__of1x_destroy_reverse_index(&table->reverse_index);
+		platform_mutex_destroy(table->mutex);
+		platform_rwlock_destroy(table->rwlock);
+		return ROFL_FAILURE;
+	}
 
 	//Allow matching algorithms to do stuff	
 	if(of1x_matching_algorithms[table->matching_algorithm].init_hook){
@@ -400,6 +543,9 @@ rofl_result_t __of1x_init_table(struct of1x_pipeline* pipeline, of1x_flow_table_
 		result = of1x_matching_algorithms[table->matching_algorithm].init_hook(table);
 		
 		if(result != ROFL_SUCCESS){
+			__of1x_destroy_strict_index(&table->strict_index);
+			__of1x_destroy_reverse_index(&table->reverse_index);
+			__of1x_destroy_overlap_index(&table->overlap_index);
 			platform_mutex_destroy(table->mutex);
 			platform_rwlock_destroy(table->rwlock);
 			return result;
@@ -422,13 +568,27 @@ rofl_result_t __of1x_destroy_table(of1x_flow_table_t* table){
 	platform_mutex_destroy(table->mutex);
 	platform_rwlock_destroy(table->rwlock);
 	
-	//Destroy timers
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	__of1x_timer_group_static_destroy(table);
-#endif
 	//Destroy stats
 	__of1x_stats_table_destroy(table);
 
+	//Destroy miss filter
+	__of1x_destroy_miss_filter(&table->miss_filter);
+
+	//Destroy heavy hitter detection
+	__of1x_destroy_heavy_hitters(table);
+
+	//Destroy strict-match index
+	__of1x_destroy_strict_index(&table->strict_index);
+
+	//Destroy cookie index
+	__of1x_destroy_cookie_index(&table->cookie_index);
+
+	//Destroy reverse index
+	__of1x_destroy_reverse_index(&table->reverse_index);
+
+	//Destroy overlap-check index
+	__of1x_destroy_overlap_index(&table->overlap_index);
+
 	//Do NOT free table, since it was allocated in a single buffer in pipeline.c	
 	return ROFL_SUCCESS;
 }
@@ -498,6 +658,64 @@ inline rofl_of1x_fm_result_t of1x_add_flow_entry_table(of1x_pipeline_t *const pi
 }
 
 
+rofl_of1x_fm_result_t of1x_add_flow_entries_table(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts){
+
+	unsigned int i;
+	rofl_of1x_fm_result_t result;
+	of1x_flow_table_t* table;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables)){
+		ROFL_PIPELINE_ERR("[flowmod-add-bundle] ERROR: invalid table id %u > switch max table id: %u\n", table_id, pipeline->num_of_tables-1);
+		assert(0);
+		return ROFL_OF1X_FM_FAILURE;
+	}
+
+	table = &pipeline->tables[table_id];
+
+	if(unlikely(of1x_matching_algorithms[table->matching_algorithm].add_flow_entries_hook == NULL)){
+		ROFL_PIPELINE_ERR("[flowmod-add-bundle] ERROR: matching algorithm of table %u does not support bundles\n", table_id);
+		return ROFL_OF1X_FM_FAILURE;
+	}
+
+	//Take rd lock over the grouptable (avoid deletion of groups while flow entry insertion)
+	platform_rwlock_rdlock(pipeline->groups->rwlock);
+
+	//Verify all the entries first
+	for(i=0;i<num_of_entries;i++){
+		if(unlikely(__of1x_validate_flow_entry(entries[i], pipeline, table_id) != ROFL_SUCCESS)){
+			//Release rdlock
+			platform_rwlock_rdunlock(pipeline->groups->rwlock);
+			ROFL_PIPELINE_INFO("[flowmod-add-bundle] Entry %u (%p) FAILED validation. Ignoring bundle...\n", i, entries[i]);
+			return ROFL_OF1X_FM_FAILURE;
+		}
+	}
+
+	//Perform insertion (node that in 1.0 operation ADD must always reset counters on overlap)
+	result = of1x_matching_algorithms[table->matching_algorithm].add_flow_entries_hook(table, entries, num_of_entries, check_overlap, reset_counts || ( pipeline->sw->of_ver == OF_VERSION_10 ));
+
+	if(result != ROFL_OF1X_FM_SUCCESS){
+		//Release rdlock
+		platform_rwlock_rdunlock(pipeline->groups->rwlock);
+		ROFL_PIPELINE_INFO("[flowmod-add-bundle] FAILED, reason: %u. Rolled back\n", result);
+		return result;
+	}
+
+	//Add timers (entries replaced within the bundle are NULL)
+	for(i=0;i<num_of_entries;i++){
+		if(entries[i])
+			__of1x_add_timer(table, entries[i]);
+		entries[i] = NULL;
+	}
+
+	ROFL_PIPELINE_INFO("[flowmod-add-bundle] Succesful, %u entries.\n", num_of_entries);
+
+	//Release rdlock
+	platform_rwlock_rdunlock(pipeline->groups->rwlock);
+
+	return result;
+}
+
 inline rofl_result_t of1x_modify_flow_entry_table(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_flow_entry_t **const entry, const enum of1x_flow_removal_strictness strict, bool reset_counts){
 	rofl_result_t result;
 	of1x_flow_table_t* table;
@@ -605,6 +823,32 @@ inline rofl_result_t of1x_remove_flow_entry_table(of1x_pipeline_t *const pipelin
 
 }
 
+rofl_result_t of1x_remove_flow_entries_using_port(of1x_pipeline_t *const pipeline, uint32_t port_num){
+
+	unsigned int i;
+	of1x_flow_table_t* table;
+	of1x_flow_entry_t* entry;
+	rofl_result_t result = ROFL_SUCCESS;
+
+	if(port_num == OF1X_PORT_ANY)
+		return ROFL_FAILURE;
+
+	//Empty entry (matches everything)
+	entry = of1x_init_flow_entry(false);
+	if(!entry)
+		return ROFL_FAILURE;
+
+	for(i=0;i<pipeline->num_of_tables;i++){
+		table = &pipeline->tables[i];
+		if(of1x_matching_algorithms[table->matching_algorithm].remove_flow_entry_hook(table, entry, NULL, NOT_STRICT, port_num, OF1X_GROUP_ANY, OF1X_FLOW_REMOVE_DELETE, MUTEX_NOT_ACQUIRED) != ROFL_SUCCESS)
+			result = ROFL_FAILURE;
+	}
+
+	of1x_destroy_flow_entry(entry);
+
+	return result;
+}
+
 //This API call should NOT be called from outside pipeline library
 rofl_result_t __of1x_remove_specific_flow_entry_table(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_flow_entry_t *const specific_entry, of1x_flow_remove_reason_t reason, of1x_mutex_acquisition_required_t mutex_acquired){
 	of1x_flow_table_t* table;
@@ -619,10 +863,56 @@ rofl_result_t __of1x_remove_specific_flow_entry_table(of1x_pipeline_t *const pip
 	return of1x_matching_algorithms[table->matching_algorithm].remove_flow_entry_hook(table, NULL, specific_entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY, reason, mutex_acquired);
 }
 
+//Removes a batch of entries; table->mutex MUST be held by the caller (timers)
+rofl_result_t __of1x_remove_specific_flow_entries_table(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries){
+	unsigned int i;
+	of1x_flow_table_t* table;
+	rofl_result_t res = ROFL_SUCCESS;
+	
+	//Verify table_id
+	if(table_id >= pipeline->num_of_tables)
+		return ROFL_FAILURE;
+
+	//Recover table pointer
+	table = &pipeline->tables[table_id];
+
+	//Use the batch hook, if the matching algorithm has it
+	if(of1x_matching_algorithms[table->matching_algorithm].remove_flow_entries_hook)
+		return of1x_matching_algorithms[table->matching_algorithm].remove_flow_entries_hook(table, entries, reasons, num_of_entries);
+
+	for(i=0;i<num_of_entries;i++){
+		if(of1x_matching_algorithms[table->matching_algorithm].remove_flow_entry_hook(table, NULL, entries[i], STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY, reasons[i], MUTEX_ALREADY_ACQUIRED_BY_TIMER_EXPIRATION) != ROFL_SUCCESS)
+			res = ROFL_FAILURE;
+	}
+
+	return res;
+}
+
 /* Dump methods */
+
+//Entries dumped per table->mutex hold
+#define OF1X_DUMP_TABLE_CHUNK 64
+
+//Dump iterator state
+typedef struct of1x_dump_table_state{
+	unsigned int num_of_entries;
+	bool raw_nbo;
+}of1x_dump_table_state_t;
+
+static bool __of1x_dump_table_entry(of1x_flow_entry_t* entry, void* opaque){
+
+	of1x_dump_table_state_t* state = (of1x_dump_table_state_t*)opaque;
+
+	ROFL_PIPELINE_INFO("\t[%u] ",state->num_of_entries++);
+	of1x_dump_flow_entry(entry, state->raw_nbo);
+
+	return true;
+}
+
 void of1x_dump_table(of1x_flow_table_t* table, bool raw_nbo){
-	of1x_flow_entry_t* entry;
-	int i;	
+	unsigned int num_of_entries;
+	of1x_flow_iterator_t it;
+	of1x_dump_table_state_t state;
 
 	__of1x_stats_table_tid_t c;
 
@@ -630,28 +920,35 @@ void of1x_dump_table(of1x_flow_table_t* table, bool raw_nbo){
 	__of1x_stats_table_consolidate(&table->stats, &c);
 
 	ROFL_PIPELINE_INFO("\n"); //This is done in purpose 
-	ROFL_PIPELINE_INFO("Dumping table # %u (%p). Default action: %s, num. of entries: %d, ma: %u statistics {looked up: %u, matched: %u}\n", table->number, table, __of1x_flow_table_miss_config_str[table->default_action],table->num_of_entries, table->matching_algorithm,  c.lookup_count, c.matched_count);
-
-	//Take rd lock over the grouptable (avoid deletion of groups while flow entry insertion)
-	platform_rwlock_rdlock(table->rwlock);
-
-	if(!table->entries){
+	ROFL_PIPELINE_INFO("Dumping table # %u (%p). Default action: %s, num. of entries: %d, ma: %u statistics {looked up: %u, matched: %u, filtered misses: %u}\n", table->number, table, __of1x_flow_table_miss_config_str[table->default_action],table->num_of_entries, table->matching_algorithm,  c.lookup_count, c.matched_count, c.filtered_miss_count);
+	__of1x_dump_miss_filter(&table->miss_filter);
+	__of1x_dump_heavy_hitters(table->heavy_hitters);
+	__of1x_dump_cookie_index(&table->cookie_index);
+	__of1x_dump_reverse_index(&table->reverse_index);
+	__of1x_dump_overlap_index(&table->overlap_index);
+
+	//Dump the entries in chunks, so that flow_mods are not delayed
+	state.num_of_entries = 0;
+	state.raw_nbo = raw_nbo;
+	if(of1x_init_flow_iterator(&it, table->pipeline, table->number, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, NULL) != ROFL_SUCCESS)
+		return;
+	while(!it.done)
+		of1x_flow_iterator_next_chunk(&it, OF1X_DUMP_TABLE_CHUNK, __of1x_dump_table_entry, &state, &num_of_entries);
+	of1x_release_flow_iterator(&it);
+
+	if(state.num_of_entries == 0){
 		ROFL_PIPELINE_INFO("\t[*] No entries\n");
-		goto DUMP_TABLE_END;
-	}
-	for(entry=table->entries, i=0;entry!=NULL;entry=entry->next,i++){
-		ROFL_PIPELINE_INFO("\t[%d] ",i);
-		of1x_dump_flow_entry(entry, raw_nbo);
+		return;
 	}
-	
+
 	ROFL_PIPELINE_INFO("\t[*] No more entries...\n");
 	
 	if(of1x_matching_algorithms[table->matching_algorithm].dump_hook){
+		//Take rd lock over the matching algorithm state
+		platform_rwlock_rdlock(table->rwlock);
 		ROFL_PIPELINE_INFO("\tMatching algorithm %u specific state\n", table->matching_algorithm);
 		of1x_matching_algorithms[table->matching_algorithm].dump_hook(table, raw_nbo);
+		platform_rwlock_rdunlock(table->rwlock);
 	}
 	ROFL_PIPELINE_INFO("\n");
-
-DUMP_TABLE_END:
-	platform_rwlock_rdunlock(table->rwlock);
 }
@@ -15,6 +15,11 @@
 #include "of1x_flow_entry.h"
 #include "of1x_timers.h"
 #include "of1x_statistics.h"
+#include "of1x_miss_filter.h"
+#include "of1x_heavy_hitters.h"
+#include "of1x_cookie_index.h"
+#include "of1x_reverse_index.h"
+#include "of1x_overlap_index.h"
 #include "of1x_utils.h"
 #include "matching_algorithms/matching_algorithms.h"
 
@@ -47,8 +52,8 @@
 #define OF1X_MAX_TABLE_NAME_LEN 32
 
 //fwd decl
-struct of1x_timer_group;
 struct of1x_pipeline;
+struct of1x_flow_iterator;
 
 //Agnostic auxiliary matching structures. 
 typedef void matching_auxiliary_t;
@@ -84,6 +89,26 @@ typedef struct{
 }of1x_flow_table_config_t;
 
 
+//Initial number of buckets of the strict-match index (MUST be a power of 2)
+#define OF1X_STRICT_INDEX_INITIAL_BUCKETS 64
+//Max. avg. chain length before growing the index
+#define OF1X_STRICT_INDEX_MAX_LOAD 2
+
+/**
+* Strict-match index
+*
+* Entries are hashed by (priority, match set) and chained through
+* of1x_flow_entry_t::strict_next, so that strict flow-mods (and the identical
+* entry check on addition) do not need to scan the whole table. The index
+* is maintained by the matching algorithms on entry addition and removal and
+* it is only used by the control path (table->mutex held).
+*/
+typedef struct of1x_strict_index{
+	struct of1x_flow_entry** buckets;
+	unsigned int num_of_buckets;
+	unsigned int num_of_entries;
+}of1x_strict_index_t;
+
 /**
  * OpenFlow v1.0, 1.2 and 1.3.2 flow table abstraction
  */
@@ -104,11 +129,8 @@ typedef struct of1x_flow_table{
 	unsigned int num_of_entries;
 	unsigned int max_entries;    	/* Max number of entries supported. */
 
-	//Timers associated
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	unsigned int current_timer_group; /*in case of static allocation indicates the timer group*/
-#endif
-	struct of1x_timer_group* timers;
+	//Timers associated (hierarchical timing wheel; protected by mutex)
+	of1x_timer_wheel_t timers;
 	
 	//Table config
 	of1x_flow_table_miss_config_t default_action; 
@@ -116,6 +138,28 @@ typedef struct of1x_flow_table{
 
 	//statistics
 	of1x_stats_table_t stats;
+
+	//Miss filter (optional)
+	of1x_miss_filter_t miss_filter;
+
+	//Heavy hitter detection (optional, RCU)
+	of1x_heavy_hitters_t* heavy_hitters;
+
+	//Strict-match index
+	of1x_strict_index_t strict_index;
+
+	//Cookie index (optional)
+	of1x_cookie_index_t cookie_index;
+
+	//Output port and group reverse index
+	of1x_reverse_index_t reverse_index;
+
+	//Overlap-check index
+	of1x_overlap_index_t overlap_index;
+
+	//Iterators positioned in the table, and generation (of1x_flow_iterator.h)
+	struct of1x_flow_iterator* iterators;
+	uint64_t generation;
 	
 	/**
 	* Place-holder to allow matching algorithms
@@ -123,10 +167,6 @@ typedef struct of1x_flow_table{
 	*/
 	matching_auxiliary_t* matching_aux[2];
 
-#ifdef ROFL_PIPELINE_LOCKLESS
-	tid_presence_t tid_presence_mask;
-#endif 
-
 	//Mutexes
 	platform_mutex_t* mutex; //Mutual exclusion among insertion/deletion threads
 	platform_rwlock_t* rwlock; //Readers mutex
@@ -167,6 +207,19 @@ void __of13_set_table_defaults(of1x_flow_table_t* table);
 
 rofl_result_t __of1x_destroy_table(of1x_flow_table_t* table);
 
+/*
+* Strict-match index. Add/remove shall be called by the matching algorithm on
+* entry addition/removal while holding table->mutex
+*/
+void __of1x_strict_index_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry);
+void __of1x_strict_index_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry);
+
+/**
+* Finds the entry of the table which is equal (same priority and matches) to entry,
+* according to __of1x_flow_entry_check_equal(). Requires table->mutex.
+*/
+of1x_flow_entry_t* __of1x_strict_index_find(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, uint32_t out_port, uint32_t out_group, bool check_cookie);
+
 /*
 * Flow-mod installation, modify and removal
 */
@@ -198,6 +251,34 @@ rofl_result_t __of1x_destroy_table(of1x_flow_table_t* table);
 */
 rofl_of1x_fm_result_t of1x_add_flow_entry_table(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_flow_entry_t **const entry, bool check_overlap, bool reset_counts);
 
+/**
+* @ingroup core_of1x 
+* Add a bundle of flow_entries to a table, atomically.
+*
+* Equivalent to num_of_entries calls to of1x_add_flow_entry_table(), but all the
+* entries are validated first, and then added under a single acquisition of the
+* table locks and a single wait for the packet processing threads. Either all
+* the entries are added or none (rollback).
+*
+* The bundle is atomic for other flow_mods, but not for packets: lookups do not
+* take the table locks, so packets may be matched against a partially applied
+* bundle and, if it fails, against entries that are then rolled back (or without
+* the entries they replaced). No packet uses a rolled back entry once the call
+* has returned.
+*
+* If (and only if) the operation is successful (ROFL_OF1X_FM_SUCCESS) all the
+* pointers in entries are set to NULL. Otherwise the entries are still owned by
+* the caller.
+*
+* @param pipeline Switch pipeline
+* @param table_id Table index
+* @param entries Array of of1x_flow_entry_t previously initialized with of1x_init_flow_entry()
+* @param num_of_entries Number of entries
+* @param check_overlap Do not install if there are overlapping entries (would match the same packet), including other entries of the bundle
+* @param reset_counts If overlap flag is false, reset the counters on entry overwrite 
+*/
+rofl_of1x_fm_result_t of1x_add_flow_entries_table(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_flow_entry_t **const entries, unsigned int num_of_entries, bool check_overlap, bool reset_counts);
+
 /**
 * @ingroup core_of1x 
 * Modify flow_entry(s) in the table
@@ -245,9 +326,26 @@ rofl_result_t of1x_modify_flow_entry_table(struct of1x_pipeline *const pipeline,
 */
 rofl_result_t of1x_remove_flow_entry_table(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_flow_entry_t* entry, const enum of1x_flow_removal_strictness strict, uint32_t out_port, uint32_t out_group);
 
+/**
+* @ingroup core_of1x 
+* Removes all the flow_entries, of all the tables, that output to port_num.
+*
+* Meant to be called when a port is detached or goes down, to flush the entries
+* pointing to it. Equivalent to a NOT STRICT removal of an empty entry with
+* out_port=port_num in each table, but it only visits the affected entries (reverse
+* index).
+*
+* @param pipeline Switch pipeline
+* @param port_num Port number
+*/
+rofl_result_t of1x_remove_flow_entries_using_port(struct of1x_pipeline *const pipeline, uint32_t port_num);
+
 //This API call is meant to ONLY be used internally within the pipeline library (timers)
 rofl_result_t __of1x_remove_specific_flow_entry_table(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_flow_entry_t *const specific_entry, of1x_flow_remove_reason_t reason, of1x_mutex_acquisition_required_t mutex_acquired);
 
+//Batch version (timers); table->mutex MUST be held by the caller. The arrays may be reordered
+rofl_result_t __of1x_remove_specific_flow_entries_table(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_flow_entry_t **const entries, of1x_flow_remove_reason_t *const reasons, unsigned int num_of_entries);
+
 /*
 * Table dumping. Not recommended to use it directly
 *
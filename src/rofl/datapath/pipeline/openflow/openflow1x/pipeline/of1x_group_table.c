@@ -255,8 +255,11 @@ rofl_of1x_gm_result_t __of1x_init_group(of1x_group_table_t *gt, of1x_group_type_
 	ge->id = id;
 	ge->type = type;
 	ge->group_table = gt;
+	if(__of1x_init_group_stats(&ge->stats) != ROFL_SUCCESS){
+		platform_free_shared(ge);
+		return ROFL_OF1X_GM_OGRUPS;
+	}
 	ge->rwlock = platform_rwlock_init(NULL);
-	__of1x_init_group_stats(&ge->stats);
 	
 	// Count the number of output actions existing inside the group. WARNING For select type groups the count depends on the bucket used!
 	ge->num_of_output_actions = 0;
@@ -489,7 +492,10 @@ of1x_bucket_t* of1x_init_bucket(uint16_t weight, uint32_t port, uint32_t group,
 	bk->port= port;
 	bk->group= group;
 	bk->actions = actions;// actions must be already initialized
-	__of1x_init_bucket_stats(&bk->stats);
+	if( unlikely(__of1x_init_bucket_stats(&bk->stats) != ROFL_SUCCESS) ){
+		platform_free_shared(bk);
+		return NULL;
+	}
 	
 	return bk;
 }
@@ -0,0 +1,245 @@
+#include "of1x_heavy_hitters.h"
+
+#include "../../../platform/likely.h"
+#include "../../../platform/lock.h"
+#include "../../../platform/memory.h"
+#include "../../../util/logging.h"
+
+#include "of1x_flow_table.h"
+#include "of1x_pipeline.h"
+
+/*
+* Allocation and release
+*/
+static of1x_heavy_hitters_t* __of1x_init_heavy_hitters(of1x_hh_key_type_t key_type){
+
+	of1x_heavy_hitters_t* hh = (of1x_heavy_hitters_t*)platform_malloc_shared(sizeof(of1x_heavy_hitters_t));
+
+	if(unlikely(hh == NULL))
+		return NULL;
+
+	hh->key_type = key_type;
+	hh->num_of_tids = tid_get_num_of_tids();
+	hh->tid_size = (sizeof(__of1x_hh_tid_t) + TID_CACHE_LINE_SIZE-1) & ~((size_t)TID_CACHE_LINE_SIZE-1);
+
+	hh->mem = platform_malloc_shared(hh->tid_size*hh->num_of_tids + TID_CACHE_LINE_SIZE);
+	if(unlikely(hh->mem == NULL)){
+		platform_free_shared(hh);
+		return NULL;
+	}
+	hh->tids = (uint8_t*)(((uintptr_t)hh->mem + TID_CACHE_LINE_SIZE-1) & ~((uintptr_t)TID_CACHE_LINE_SIZE-1));
+	platform_memset(hh->tids, 0, hh->tid_size*hh->num_of_tids);
+
+	hh->mutex = platform_mutex_init(NULL);
+	if(unlikely(hh->mutex == NULL)){
+		platform_free_shared(hh->mem);
+		platform_free_shared(hh);
+		return NULL;
+	}
+
+	return hh;
+}
+
+static void __of1x_release_heavy_hitters(void* obj){
+
+	of1x_heavy_hitters_t* hh = (of1x_heavy_hitters_t*)obj;
+
+	platform_mutex_destroy(hh->mutex);
+	platform_free_shared(hh->mem);
+	platform_free_shared(hh);
+}
+
+void __of1x_destroy_heavy_hitters(of1x_flow_table_t *const table){
+
+	if(table->heavy_hitters)
+		__of1x_release_heavy_hitters(table->heavy_hitters);
+	table->heavy_hitters = NULL;
+}
+
+/*
+* Enable/disable
+*/
+rofl_result_t of1x_enable_table_heavy_hitters(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_hh_key_type_t key_type){
+
+	of1x_flow_table_t* table;
+	of1x_heavy_hitters_t *hh, *old;
+
+	//Verify table_id and key
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	if(unlikely(key_type >= __OF1X_HH_KEY_MAX)){
+		ROFL_PIPELINE_ERR("%s: unsupported heavy hitter key %u\n", __func__, key_type);
+		return ROFL_FAILURE;
+	}
+
+	table = &pipeline->tables[table_id];
+
+	hh = __of1x_init_heavy_hitters(key_type);
+	if(unlikely(hh == NULL))
+		return ROFL_FAILURE;
+
+	platform_mutex_lock(table->mutex);
+
+	//Publish (packet processing may still be using the old one)
+	old = table->heavy_hitters;
+	tid_memory_barrier();
+	table->heavy_hitters = hh;
+
+	platform_mutex_unlock(table->mutex);
+
+	if(old)
+		tid_defer_release(old, __of1x_release_heavy_hitters);
+
+	return ROFL_SUCCESS;
+}
+
+rofl_result_t of1x_disable_table_heavy_hitters(of1x_pipeline_t *const pipeline, const unsigned int table_id){
+
+	of1x_flow_table_t* table;
+	of1x_heavy_hitters_t* old;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	platform_mutex_lock(table->mutex);
+	old = table->heavy_hitters;
+	table->heavy_hitters = NULL;
+	platform_mutex_unlock(table->mutex);
+
+	if(old)
+		tid_defer_release(old, __of1x_release_heavy_hitters);
+
+	return ROFL_SUCCESS;
+}
+
+/*
+* Merge
+*/
+
+//Estimation of the key over all TIDs (merged sketch)
+static uint64_t __of1x_hh_estimation(of1x_heavy_hitters_t* hh, uint64_t hash){
+
+	unsigned int i, tid, slot;
+	uint64_t count, estimation = UINT64_MAX;
+
+	for(i=0;i<OF1X_HH_SKETCH_DEPTH;i++){
+		slot = __of1x_hh_slot(hash, i);
+		for(tid=0, count=0;tid<hh->num_of_tids;tid++)
+			count += __of1x_hh_tid(hh, tid)->sketch[i][slot];
+		if(count < estimation)
+			estimation = count;
+	}
+
+	return estimation;
+}
+
+//Copies the candidate, unless it is being replaced
+static inline bool __of1x_hh_read_candidate(__of1x_hh_candidate_t* c, of1x_hh_key_t* key, uint64_t* hash){
+
+	uint32_t seq = c->seq;
+
+	if(seq & 0x1)
+		return false;
+	tid_memory_barrier();
+	*key = c->key;
+	*hash = c->hash;
+	tid_memory_barrier();
+
+	return c->seq == seq;
+}
+
+rofl_result_t of1x_get_table_heavy_hitters(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_heavy_hitter_t* hh_list, unsigned int* num_of_hh, uint64_t* packet_count){
+
+	unsigned int i, j, tid, num_of_candidates = 0;
+	uint64_t *hashes, hash;
+	of1x_hh_key_t key;
+	of1x_heavy_hitter_t* candidates, tmp;
+	of1x_flow_table_t* table;
+	of1x_heavy_hitters_t* hh;
+	__of1x_hh_tid_t* s;
+
+	*num_of_hh = 0;
+	*packet_count = 0;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	//Keeps it from being replaced
+	platform_mutex_lock(table->mutex);
+
+	hh = table->heavy_hitters;
+	if(!hh){
+		platform_mutex_unlock(table->mutex);
+		return ROFL_FAILURE;
+	}
+
+	candidates = (of1x_heavy_hitter_t*)platform_malloc_shared(sizeof(of1x_heavy_hitter_t)*OF1X_HH_TOP_K*hh->num_of_tids);
+	hashes = (uint64_t*)platform_malloc_shared(sizeof(uint64_t)*OF1X_HH_TOP_K*hh->num_of_tids);
+	if(unlikely(candidates == NULL || hashes == NULL)){
+		platform_mutex_unlock(table->mutex);
+		platform_free_shared(candidates);
+		platform_free_shared(hashes);
+		return ROFL_FAILURE;
+	}
+
+	//Candidates of all TIDs (once)
+	for(tid=0;tid<hh->num_of_tids;tid++){
+		s = __of1x_hh_tid(hh, tid);
+		*packet_count += s->packet_count;
+
+		for(i=0;i<s->num_of_candidates && i<OF1X_HH_TOP_K;i++){
+			if(!__of1x_hh_read_candidate(&s->candidates[i], &key, &hash))
+				continue;
+
+			for(j=0;j<num_of_candidates;j++){
+				if(hashes[j] == hash && __of1x_hh_key_equal(&candidates[j].key, &key))
+					break;
+			}
+			if(j < num_of_candidates)
+				continue;
+
+			hashes[num_of_candidates] = hash;
+			candidates[num_of_candidates].key = key;
+			candidates[num_of_candidates].packet_count = __of1x_hh_estimation(hh, hash);
+			num_of_candidates++;
+		}
+	}
+
+	platform_mutex_unlock(table->mutex);
+
+	//Top (partial selection sort)
+	for(i=0;i<num_of_candidates && i<OF1X_HH_TOP_K;i++){
+		for(j=i+1;j<num_of_candidates;j++){
+			if(candidates[j].packet_count > candidates[i].packet_count){
+				tmp = candidates[i];
+				candidates[i] = candidates[j];
+				candidates[j] = tmp;
+			}
+		}
+		hh_list[i] = candidates[i];
+	}
+	*num_of_hh = i;
+
+	platform_free_shared(candidates);
+	platform_free_shared(hashes);
+
+	return ROFL_SUCCESS;
+}
+
+/*
+* Dump
+*/
+void __of1x_dump_heavy_hitters(of1x_heavy_hitters_t* hh){
+
+	if(!hh)
+		return;
+
+	ROFL_PIPELINE_INFO("\tHeavy hitters {key: %u, TIDs: %u, sketch: %ux%u, candidates per TID: %u}\n", hh->key_type, hh->num_of_tids, OF1X_HH_SKETCH_DEPTH, OF1X_HH_SKETCH_WIDTH, OF1X_HH_TOP_K);
+}
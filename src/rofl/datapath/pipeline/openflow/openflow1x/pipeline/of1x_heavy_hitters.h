@@ -0,0 +1,204 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_HEAVY_HITTERSH__
+#define __OF1X_HEAVY_HITTERSH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "../../../threading.h"
+#include "../../../platform/lock.h"
+
+/**
+* @file of1x_heavy_hitters.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 per-table heavy hitter detection
+*
+* Heavy hitter detection is an (optional) per table estimation of the packets
+* looked up in the table per key (e.g. IPv4 source), independently of the
+* entries (e.g. the keys hitting a default route).
+*
+* Every TID keeps its own count-min sketch and its own candidates (space-saving
+* top of the keys with the highest estimations), in fixed memory allocated on
+* enable. Packet processing updates them without locks nor atomic operations
+* (one hash and OF1X_HH_SKETCH_DEPTH counter increments per packet); they are
+* only merged on demand (of1x_get_table_heavy_hitters()).
+*/
+
+//Count-min sketch rows and counters per row (MUST be a power of 2)
+#define OF1X_HH_SKETCH_DEPTH 4
+#define OF1X_HH_SKETCH_WIDTH 2048
+#define OF1X_HH_SKETCH_WIDTH_MASK (OF1X_HH_SKETCH_WIDTH-1)
+
+//Candidates per TID, and heavy hitters reported
+#define OF1X_HH_TOP_K 16
+
+//fwd decl
+struct of1x_flow_table;
+struct of1x_pipeline;
+
+/**
+* @ingroup core_of1x
+* Heavy hitter key
+*/
+typedef enum of1x_hh_key_type{
+	OF1X_HH_KEY_IPV4_SRC = 0,	/* IPv4 source */
+	OF1X_HH_KEY_IPV4_DST,		/* IPv4 destination */
+	OF1X_HH_KEY_IPV4_SRC_DST,	/* IPv4 source and destination */
+	OF1X_HH_KEY_IPV4_5TUPLE,	/* IPv4 source and destination, IP protocol, TCP/UDP source and destination ports */
+	OF1X_HH_KEY_ETH_SRC,		/* Ethernet source */
+	__OF1X_HH_KEY_MAX
+}of1x_hh_key_type_t;
+
+/**
+* @ingroup core_of1x
+* Key values (NBO, as in the packet). Fields not part of the key are 0
+*/
+typedef struct of1x_hh_key{
+	uint64_t eth_src;
+	uint32_t ipv4_src;
+	uint32_t ipv4_dst;
+	uint16_t tp_src;
+	uint16_t tp_dst;
+	uint8_t ip_proto;
+}of1x_hh_key_t;
+
+/**
+* @ingroup core_of1x
+* Heavy hitter (of1x_get_table_heavy_hitters())
+*/
+typedef struct of1x_heavy_hitter{
+	of1x_hh_key_t key;
+
+	//Estimated number of packets (never below the actual one)
+	uint64_t packet_count;
+}of1x_heavy_hitter_t;
+
+//Candidate (space-saving). seq is odd while the key is being replaced
+typedef struct __of1x_hh_candidate{
+	volatile uint32_t seq;
+	uint64_t hash;
+	of1x_hh_key_t key;
+	uint64_t count;
+}__of1x_hh_candidate_t;
+
+//Per TID state (cache line aligned)
+typedef struct __of1x_hh_tid{
+	//Packets with the key fields
+	uint64_t packet_count;
+
+	//Candidates, and the one with the lowest count
+	unsigned int num_of_candidates;
+	unsigned int min_candidate;
+	__of1x_hh_candidate_t candidates[OF1X_HH_TOP_K];
+
+	//Count-min sketch
+	uint64_t sketch[OF1X_HH_SKETCH_DEPTH][OF1X_HH_SKETCH_WIDTH];
+}__of1x_hh_tid_t;
+
+/**
+* Per table heavy hitter state; published in of1x_flow_table_t::heavy_hitters
+* (RCU), replaced on every enable
+*/
+typedef struct of1x_heavy_hitters{
+	of1x_hh_key_type_t key_type;
+
+	//Per TID state (tid_size bytes each, from tids)
+	unsigned int num_of_tids;
+	size_t tid_size;
+	uint8_t* tids;
+
+	//Serializes the updates over the shared ROFL_PIPELINE_LOCKED_TID state
+	platform_mutex_t* mutex;
+
+	//Allocated buffer
+	void* mem;
+}of1x_heavy_hitters_t;
+
+static inline __of1x_hh_tid_t* __of1x_hh_tid(of1x_heavy_hitters_t* hh, unsigned int tid){
+	return (__of1x_hh_tid_t*)(hh->tids + tid*hh->tid_size);
+}
+
+/*
+* Key hash (64 bit finalizer over the key words); rows use double hashing
+*/
+static inline uint64_t __of1x_hh_mix(uint64_t h){
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint64_t __of1x_hh_hash(const of1x_hh_key_t* key){
+	uint64_t h;
+
+	h = __of1x_hh_mix(key->eth_src);
+	h = __of1x_hh_mix(h ^ (((uint64_t)key->ipv4_src << 32) | key->ipv4_dst));
+	return __of1x_hh_mix(h ^ (((uint64_t)key->tp_src << 24) | ((uint64_t)key->tp_dst << 8) | key->ip_proto));
+}
+
+static inline unsigned int __of1x_hh_slot(uint64_t hash, unsigned int row){
+	uint32_t h1 = (uint32_t)hash;
+	uint32_t h2 = (uint32_t)(hash >> 32) | 0x1; //Odd, to visit different slots
+
+	return (h1 + row*h2) & OF1X_HH_SKETCH_WIDTH_MASK;
+}
+
+static inline bool __of1x_hh_key_equal(const of1x_hh_key_t* a, const of1x_hh_key_t* b){
+	return a->eth_src == b->eth_src && a->ipv4_src == b->ipv4_src && a->ipv4_dst == b->ipv4_dst &&
+		a->tp_src == b->tp_src && a->tp_dst == b->tp_dst && a->ip_proto == b->ip_proto;
+}
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Destroy (table)
+*/
+void __of1x_destroy_heavy_hitters(struct of1x_flow_table *const table);
+
+/**
+* @brief Enables (or resets) the heavy hitter detection of a table
+* @ingroup core_of1x
+*
+* Estimations start from scratch. Packets without the key fields are not
+* accounted.
+*
+* @param pipeline Switch pipeline
+* @param table_id Table index
+* @param key_type Key
+*/
+rofl_result_t of1x_enable_table_heavy_hitters(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_hh_key_type_t key_type);
+
+/**
+* @brief Disables the heavy hitter detection of a table
+* @ingroup core_of1x
+*/
+rofl_result_t of1x_disable_table_heavy_hitters(struct of1x_pipeline *const pipeline, const unsigned int table_id);
+
+/**
+* @brief Retrieves the heavy hitters of a table, in decreasing order
+* @ingroup core_of1x
+*
+* Merges the state of all the TIDs.
+*
+* @param hh Array of (at least) OF1X_HH_TOP_K heavy hitters
+* @param num_of_hh Number of heavy hitters filled
+* @param packet_count Packets accounted (with the key fields) since enabled
+* @retval ROFL_FAILURE if not enabled
+*/
+rofl_result_t of1x_get_table_heavy_hitters(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_heavy_hitter_t* hh, unsigned int* num_of_hh, uint64_t* packet_count);
+
+/*
+* Dump
+*/
+void __of1x_dump_heavy_hitters(of1x_heavy_hitters_t* hh);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_HEAVY_HITTERS
@@ -0,0 +1,183 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_HEAVY_HITTERS_PPH__
+#define __OF1X_HEAVY_HITTERS_PPH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "../../../util/pp_guard.h" //Never forget to include the guard
+#include "../../../common/datapacket.h"
+#include "../../../platform/likely.h"
+#include "../../../platform/packet.h"
+#include "of1x_heavy_hitters.h"
+#include "of1x_flow_table.h"
+#include "of1x_utils.h"
+
+/**
+* @file of1x_heavy_hitters_pp.h
+* @brief Heavy hitter detection packet processing routines
+*/
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Recovers the key from the packet. Returns false if the packet does not have
+* the key fields
+*/
+static inline bool __of1x_hh_get_pkt_key(of1x_hh_key_type_t type, datapacket_t *const pkt, of1x_hh_key_t* key){
+
+	uint8_t* proto;
+	uint16_t *src, *dst;
+	uint32_t *ipv4_src, *ipv4_dst;
+	uint64_t* eth_src;
+
+	key->eth_src = 0x0ULL;
+	key->ipv4_src = key->ipv4_dst = 0x0;
+	key->tp_src = key->tp_dst = 0x0;
+	key->ip_proto = 0x0;
+
+	if(type == OF1X_HH_KEY_ETH_SRC){
+		eth_src = platform_packet_get_eth_src(pkt);
+		if(unlikely(eth_src == NULL))
+			return false;
+		key->eth_src = *eth_src & OF1X_48_BITS_MASK;
+		return true;
+	}
+
+	if(type != OF1X_HH_KEY_IPV4_DST){
+		ipv4_src = platform_packet_get_ipv4_src(pkt);
+		if(ipv4_src == NULL)
+			return false;
+		key->ipv4_src = *ipv4_src;
+	}
+	if(type != OF1X_HH_KEY_IPV4_SRC){
+		ipv4_dst = platform_packet_get_ipv4_dst(pkt);
+		if(ipv4_dst == NULL)
+			return false;
+		key->ipv4_dst = *ipv4_dst;
+	}
+
+	if(type != OF1X_HH_KEY_IPV4_5TUPLE)
+		return true;
+
+	proto = platform_packet_get_ip_proto(pkt);
+	if(proto == NULL)
+		return false;
+	key->ip_proto = *proto;
+
+	//Ports (non TCP/UDP packets are keyed with 0)
+	src = platform_packet_get_tcp_src(pkt);
+	if(src){
+		dst = platform_packet_get_tcp_dst(pkt);
+	}else{
+		src = platform_packet_get_udp_src(pkt);
+		dst = platform_packet_get_udp_dst(pkt);
+	}
+	if(src && dst){
+		key->tp_src = *src;
+		key->tp_dst = *dst;
+	}
+
+	return true;
+}
+
+//Updates the candidates of the TID with the estimation of the key
+static inline void __of1x_hh_update_candidates(__of1x_hh_tid_t* s, const of1x_hh_key_t* key, uint64_t hash, uint64_t estimation){
+
+	unsigned int i;
+	__of1x_hh_candidate_t* c;
+
+	//Never index past the candidates array
+	if(unlikely(s->num_of_candidates > OF1X_HH_TOP_K))
+		s->num_of_candidates = OF1X_HH_TOP_K;
+	if(unlikely(s->min_candidate >= s->num_of_candidates))
+		s->min_candidate = 0;
+
+	//Not heavier than the lightest candidate (most packets)
+	if(s->num_of_candidates == OF1X_HH_TOP_K && estimation <= s->candidates[s->min_candidate].count)
+		return;
+
+	for(i=0;i<s->num_of_candidates;i++){
+		c = &s->candidates[i];
+		if(c->hash == hash && __of1x_hh_key_equal(&c->key, key))
+			break;
+	}
+
+	if(i == s->num_of_candidates){
+		//New candidate; replaces the lightest one
+		if(s->num_of_candidates < OF1X_HH_TOP_K)
+			s->num_of_candidates++;
+		else
+			i = s->min_candidate;
+
+		c = &s->candidates[i];
+		c->seq++;
+		tid_memory_barrier();
+		c->hash = hash;
+		c->key = *key;
+		tid_memory_barrier();
+		c->seq++;
+	}
+
+	c->count = estimation;
+
+	//Lightest candidate
+	if(i == s->min_candidate || s->num_of_candidates < OF1X_HH_TOP_K){
+		s->min_candidate = 0;
+		for(i=1;i<s->num_of_candidates;i++){
+			if(s->candidates[i].count < s->candidates[s->min_candidate].count)
+				s->min_candidate = i;
+		}
+	}
+}
+
+/**
+* Accounts the packet in the heavy hitter detection of the table (if enabled).
+* The state of ROFL_PIPELINE_LOCKED_TID is shared by several threads, so its
+* updates are serialized (hh->mutex)
+*/
+static inline void __of1x_hh_update(const unsigned int tid, of1x_flow_table_t *const table, datapacket_t *const pkt){
+
+	unsigned int i;
+	uint64_t hash, estimation, *counter;
+	of1x_hh_key_t key;
+	__of1x_hh_tid_t* s;
+	of1x_heavy_hitters_t* hh = table->heavy_hitters;
+
+	if(likely(hh == NULL))
+		return;
+
+	if(!__of1x_hh_get_pkt_key(hh->key_type, pkt, &key))
+		return;
+
+	s = __of1x_hh_tid(hh, tid);
+	hash = __of1x_hh_hash(&key);
+
+	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID))
+		platform_mutex_lock(hh->mutex);
+
+	s->packet_count++;
+
+	//Sketch
+	estimation = UINT64_MAX;
+	for(i=0;i<OF1X_HH_SKETCH_DEPTH;i++){
+		counter = &s->sketch[i][__of1x_hh_slot(hash, i)];
+		if(++(*counter) < estimation)
+			estimation = *counter;
+	}
+
+	__of1x_hh_update_candidates(s, &key, hash, estimation);
+
+	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID))
+		platform_mutex_unlock(hh->mutex);
+}
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_HEAVY_HITTERS_PP
@@ -40,6 +40,18 @@ static void __of1x_destroy_instruction(of1x_instruction_t* inst){
 		__of1x_destroy_write_actions(inst->write_actions);
 }
 
+//Recalculates the bitmap of present instructions
+static void __of1x_update_present_instructions(of1x_instruction_group_t* group){
+
+	unsigned int i;
+
+	group->__present = 0x0;
+	for(i=0;i<OF1X_IT_MAX;i++){
+		if(group->instructions[i].type == i && i != OF1X_IT_NO_INSTRUCTION)
+			group->__present |= 1U << i;
+	}
+}
+
 /* Instruction groups init and destroy */
 void __of1x_init_instruction_group(of1x_instruction_group_t* group){
 	
@@ -61,6 +73,7 @@ void of1x_remove_instruction_from_the_group(of1x_instruction_group_t* group, of1
 	
 	__of1x_destroy_instruction(&group->instructions[type]);
 	group->num_of_instructions--;
+	__of1x_update_present_instructions(group);
 }
 
 //Addition of instruction to group
@@ -71,6 +84,7 @@ void of1x_add_instruction_to_group(of1x_instruction_group_t* group, of1x_instruc
 		
 	__of1x_init_instruction(&group->instructions[type], type, apply_actions, write_actions, write_metadata, go_to_table);
 	group->num_of_instructions++;
+	__of1x_update_present_instructions(group);
 
 
 	//Note: Num of actions and has_multiple_outputs are calculated during validation of the flow, since
@@ -108,6 +122,7 @@ rofl_result_t __of1x_update_instructions(of1x_instruction_group_t* group, of1x_i
 
 	//Static stuff
 	group->num_of_instructions = new_group->num_of_instructions;
+	__of1x_update_present_instructions(group);
 	
 	return ROFL_SUCCESS;
 }
@@ -151,6 +166,8 @@ void __of1x_copy_instruction_group(of1x_instruction_group_t* origin, of1x_instru
 					break;	
 		}
 	}	
+
+	__of1x_update_present_instructions(dest);
 }
 
 
@@ -274,6 +291,7 @@ rofl_result_t __of1x_validate_instructions(of1x_instruction_group_t* inst_grp, o
 	
 	//update has multiple outputs flag
 	inst_grp->num_of_outputs = num_of_output_actions;
+	__of1x_update_present_instructions(inst_grp);
 	
 	return ROFL_SUCCESS;
 }
@@ -99,14 +99,19 @@ typedef struct of1x_instruction_group{
 	//Number of actions in the list
 	unsigned int num_of_instructions;
 
-	of1x_instruction_t instructions[OF1X_IT_MAX]; //Latest must ALWAYS be MAX
-	
 	//Flag indicating that there are multiple 
 	//outputs in several instructions/in an apply 
 	//actions group.
 	//Note: this does NOT reflect the exact number of output 
 	//actions when groups are used
 	unsigned int num_of_outputs;
+
+	//Bitmap of the present instructions (bit OF1X_IT_XX), so that packet
+	//processing only touches the instructions[] slots in use.
+	//Maintained by the instruction group API
+	bitmap32_t __present;
+
+	of1x_instruction_t instructions[OF1X_IT_MAX]; //Latest must ALWAYS be MAX
 	
 }of1x_instruction_group_t;
 
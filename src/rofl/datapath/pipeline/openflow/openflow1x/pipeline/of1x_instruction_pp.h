@@ -24,7 +24,7 @@ ROFL_BEGIN_DECLS
 
 static inline bool  __of1x_process_instructions_must_replicate(const of1x_instruction_group_t* inst_grp){
 
-	bool has_goto = inst_grp->instructions[OF1X_IT_GOTO_TABLE].type == OF1X_IT_GOTO_TABLE;
+	bool has_goto = (inst_grp->__present & (1U << OF1X_IT_GOTO_TABLE)) != 0;
 	unsigned int n_out = inst_grp->num_of_outputs; 
 
 	return  ( (n_out == 1) && (has_goto) ) || ( n_out > 1); 
@@ -33,55 +33,47 @@ static inline bool  __of1x_process_instructions_must_replicate(const of1x_instru
 /* Process instructions */
 static inline unsigned int __of1x_process_instructions(const unsigned int tid, const struct of1x_switch* sw, const unsigned int table_id, datapacket_t *const pkt, const of1x_instruction_group_t* instructions){
 
-	of1x_instruction_t* inst = (of1x_instruction_t*)&instructions->instructions[OF1X_IT_APPLY_ACTIONS]; 
+	const of1x_instruction_t* inst;
+	bitmap32_t present = instructions->__present;
 
 	/**
-	* Unrolled instructions loop
+	* Unrolled instructions loop. Only the instructions present are
+	* accessed
 	*/
 
 	//Check all instructions in order
-	if(inst->type == OF1X_IT_APPLY_ACTIONS)
+	if(present & (1U << OF1X_IT_APPLY_ACTIONS)){
+		inst = &instructions->instructions[OF1X_IT_APPLY_ACTIONS];
 		__of1x_process_apply_actions(tid, sw, table_id, pkt, inst->apply_actions, __of1x_process_instructions_must_replicate(instructions), NULL); 
+	}
 
-	//Next instruction
-	inst++; 
-	
-	if(inst->type == OF1X_IT_CLEAR_ACTIONS)
+	if(present & (1U << OF1X_IT_CLEAR_ACTIONS))
 		__of1x_clear_write_actions(&pkt->write_actions.of1x);
 
-	//Next instruction
-	inst++;
-	
-	if(inst->type == OF1X_IT_WRITE_ACTIONS)
+	if(present & (1U << OF1X_IT_WRITE_ACTIONS)){
+		inst = &instructions->instructions[OF1X_IT_WRITE_ACTIONS];
 		__of1x_update_packet_write_actions(&pkt->write_actions.of1x, inst->write_actions);
+	}
 	
-	//Next instruction
-	inst++;
-	
-	if(inst->type == OF1X_IT_WRITE_METADATA){
+	if(present & (1U << OF1X_IT_WRITE_METADATA)){
+		inst = &instructions->instructions[OF1X_IT_WRITE_METADATA];
 		pkt->__metadata = (pkt->__metadata & ~inst->write_metadata.metadata_mask) |
 				(inst->write_metadata.metadata & inst->write_metadata.metadata_mask);
 	}
 	
-	//Next instruction
-	inst++;
-
-	if(inst->type == OF1X_IT_EXPERIMENTER){
+	if(present & (1U << OF1X_IT_EXPERIMENTER)){
 		//TODO:
 	}
 	
-	//Next instruction
-	inst++;
-
-	if(inst->type == OF1X_IT_METER){
+	if(present & (1U << OF1X_IT_METER)){
 		//TODO:
 	}
 	
-	//Next instruction (GOTO table)
-	inst++;
+	//GOTO table; 0 means NO go-to-table
+	if(present & (1U << OF1X_IT_GOTO_TABLE))
+		return instructions->instructions[OF1X_IT_GOTO_TABLE].go_to_table;
 
-	//Will be 0 (NO go-to-table) due to memset() of isntruction group
-	return inst->go_to_table;
+	return 0;
 }
 
 //C++ extern C
@@ -0,0 +1,259 @@
+#include "of1x_latency.h"
+
+#include "../../../platform/likely.h"
+#include "../../../platform/lock.h"
+#include "../../../platform/memory.h"
+#include "../../../util/logging.h"
+
+#include "of1x_pipeline.h"
+#include "../of1x_switch.h"
+
+//Stage names (dump)
+static const char* __of1x_latency_stage_str[__OF1X_LATENCY_STAGE_MAX] = {
+	"pipeline",
+	"instructions",
+	"write actions",
+	"group",
+	"output",
+	"lookup"
+};
+
+/*
+* Allocation and release
+*/
+#ifdef ROFL_PIPELINE_LATENCY_HISTOGRAMS
+static of1x_latency_t* __of1x_init_latency(unsigned int num_of_tables){
+
+	of1x_latency_t* lat = (of1x_latency_t*)platform_malloc_shared(sizeof(of1x_latency_t));
+
+	if(unlikely(lat == NULL))
+		return NULL;
+
+	lat->num_of_histograms = OF1X_LATENCY_STAGE_LOOKUP + num_of_tables;
+	lat->num_of_tids = tid_get_num_of_tids();
+	lat->tid_size = (sizeof(of1x_latency_histogram_t)*lat->num_of_histograms + TID_CACHE_LINE_SIZE-1) & ~((size_t)TID_CACHE_LINE_SIZE-1);
+
+	lat->mem = platform_malloc_shared(lat->tid_size*lat->num_of_tids + TID_CACHE_LINE_SIZE);
+	if(unlikely(lat->mem == NULL)){
+		platform_free_shared(lat);
+		return NULL;
+	}
+	lat->tids = (uint8_t*)(((uintptr_t)lat->mem + TID_CACHE_LINE_SIZE-1) & ~((uintptr_t)TID_CACHE_LINE_SIZE-1));
+	platform_memset(lat->tids, 0, lat->tid_size*lat->num_of_tids);
+
+	return lat;
+}
+#endif
+
+static void __of1x_release_latency(void* obj){
+
+	of1x_latency_t* lat = (of1x_latency_t*)obj;
+
+	platform_free_shared(lat->mem);
+	platform_free_shared(lat);
+}
+
+void __of1x_destroy_latency(of1x_pipeline_t *const pipeline){
+
+	if(pipeline->latency)
+		__of1x_release_latency(pipeline->latency);
+	pipeline->latency = NULL;
+}
+
+/*
+* Enable/disable
+*/
+rofl_result_t of1x_enable_latency_histograms(of1x_pipeline_t *const pipeline){
+
+#ifdef ROFL_PIPELINE_LATENCY_HISTOGRAMS
+	of1x_latency_t *lat, *old;
+
+	lat = __of1x_init_latency(pipeline->num_of_tables);
+	if(unlikely(lat == NULL))
+		return ROFL_FAILURE;
+
+	platform_mutex_lock(pipeline->sw->mutex);
+
+	//Publish (packet processing may still be using the old one)
+	old = pipeline->latency;
+	tid_memory_barrier();
+	pipeline->latency = lat;
+
+	platform_mutex_unlock(pipeline->sw->mutex);
+
+	if(old)
+		tid_defer_release(old, __of1x_release_latency);
+
+	return ROFL_SUCCESS;
+#else
+	ROFL_PIPELINE_ERR("%s: pipeline compiled without latency histograms (--with-pipeline-latency-histograms)\n", __func__);
+	return ROFL_FAILURE;
+#endif
+}
+
+rofl_result_t of1x_disable_latency_histograms(of1x_pipeline_t *const pipeline){
+
+	of1x_latency_t* old;
+
+	platform_mutex_lock(pipeline->sw->mutex);
+	old = pipeline->latency;
+	pipeline->latency = NULL;
+	platform_mutex_unlock(pipeline->sw->mutex);
+
+	if(old)
+		tid_defer_release(old, __of1x_release_latency);
+
+	return ROFL_SUCCESS;
+}
+
+/*
+* Merge
+*/
+static void __of1x_latency_merge(of1x_latency_t* lat, unsigned int index, of1x_latency_histogram_t* hist){
+
+	unsigned int tid, i;
+	of1x_latency_histogram_t* h;
+
+	platform_memset(hist, 0, sizeof(*hist));
+
+	for(tid=0;tid<lat->num_of_tids;tid++){
+		h = __of1x_latency_histogram(lat, tid, index);
+
+		hist->count += h->count;
+		hist->sum += h->sum;
+		if(h->max > hist->max)
+			hist->max = h->max;
+		for(i=0;i<OF1X_LATENCY_NUM_OF_BUCKETS;i++)
+			hist->buckets[i] += h->buckets[i];
+	}
+}
+
+rofl_result_t of1x_get_latency_histogram(of1x_pipeline_t *const pipeline, of1x_latency_stage_t stage, unsigned int table_id, of1x_latency_histogram_t* hist){
+
+	of1x_latency_t* lat;
+
+	//Verify stage and table_id
+	if(unlikely(stage >= __OF1X_LATENCY_STAGE_MAX))
+		return ROFL_FAILURE;
+	if(unlikely(stage == OF1X_LATENCY_STAGE_LOOKUP && table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	//Keeps it from being replaced
+	platform_mutex_lock(pipeline->sw->mutex);
+
+	lat = pipeline->latency;
+	if(!lat){
+		platform_mutex_unlock(pipeline->sw->mutex);
+		return ROFL_FAILURE;
+	}
+
+	__of1x_latency_merge(lat, __of1x_latency_index(stage, table_id), hist);
+
+	platform_mutex_unlock(pipeline->sw->mutex);
+
+	return ROFL_SUCCESS;
+}
+
+uint64_t of1x_latency_histogram_percentile(const of1x_latency_histogram_t* hist, unsigned int per_100000){
+
+	unsigned int i;
+	uint64_t rank, acc = 0, value;
+
+	if(hist->count == 0)
+		return 0;
+
+	//Rank of the percentile (1..count)
+	if(per_100000 > 100000)
+		per_100000 = 100000;
+	rank = (hist->count*per_100000 + 99999) / 100000;
+	if(rank == 0)
+		rank = 1;
+
+	for(i=0;i<OF1X_LATENCY_NUM_OF_BUCKETS;i++){
+		acc += hist->buckets[i];
+		if(acc >= rank)
+			break;
+	}
+
+	value = __of1x_latency_bucket_max(i);
+
+	return (value > hist->max)? hist->max : value;
+}
+
+static void __of1x_latency_fill_stats(const of1x_latency_histogram_t* hist, of1x_latency_stats_t* stats){
+	stats->count = hist->count;
+	stats->mean = (hist->count)? hist->sum / hist->count : 0;
+	stats->max = hist->max;
+	stats->p50 = of1x_latency_histogram_percentile(hist, 50000);
+	stats->p99 = of1x_latency_histogram_percentile(hist, 99000);
+	stats->p999 = of1x_latency_histogram_percentile(hist, 99900);
+}
+
+rofl_result_t of1x_get_latency_stats(of1x_pipeline_t *const pipeline, of1x_latency_stage_t stage, unsigned int table_id, of1x_latency_stats_t* stats){
+
+	of1x_latency_histogram_t* hist;
+
+	hist = (of1x_latency_histogram_t*)platform_malloc_shared(sizeof(of1x_latency_histogram_t));
+	if(unlikely(hist == NULL))
+		return ROFL_FAILURE;
+
+	if(of1x_get_latency_histogram(pipeline, stage, table_id, hist) != ROFL_SUCCESS){
+		platform_free_shared(hist);
+		return ROFL_FAILURE;
+	}
+
+	__of1x_latency_fill_stats(hist, stats);
+
+	platform_free_shared(hist);
+
+	return ROFL_SUCCESS;
+}
+
+/*
+* Dump
+*/
+static void __of1x_dump_latency_stats(const char* stage, int table_id, of1x_latency_stats_t* stats){
+
+	if(table_id < 0)
+		ROFL_PIPELINE_INFO("\t%s: ", stage);
+	else
+		ROFL_PIPELINE_INFO("\t%s #%d: ", stage, table_id);
+
+	ROFL_PIPELINE_INFO_NO_PREFIX("{count: %" PRIu64 ", mean: %" PRIu64 ", p50: %" PRIu64 ", p99: %" PRIu64 ", p99.9: %" PRIu64 ", max: %" PRIu64 "}\n", stats->count, stats->mean, stats->p50, stats->p99, stats->p999, stats->max);
+}
+
+void __of1x_dump_latency(of1x_pipeline_t *const pipeline){
+
+	unsigned int i;
+	of1x_latency_t* lat;
+	of1x_latency_stats_t stats;
+	of1x_latency_histogram_t* hist;
+
+	if(!pipeline->latency)
+		return;
+
+	hist = (of1x_latency_histogram_t*)platform_malloc_shared(sizeof(of1x_latency_histogram_t));
+	if(unlikely(hist == NULL))
+		return;
+
+	platform_mutex_lock(pipeline->sw->mutex);
+
+	lat = pipeline->latency;
+	if(lat){
+		ROFL_PIPELINE_INFO("Latency (cycles), TIDs: %u\n", lat->num_of_tids);
+
+		for(i=0;i<lat->num_of_histograms;i++){
+			__of1x_latency_merge(lat, i, hist);
+			__of1x_latency_fill_stats(hist, &stats);
+
+			if(i < OF1X_LATENCY_STAGE_LOOKUP)
+				__of1x_dump_latency_stats(__of1x_latency_stage_str[i], -1, &stats);
+			else if(stats.count) //Only the tables in use
+				__of1x_dump_latency_stats(__of1x_latency_stage_str[OF1X_LATENCY_STAGE_LOOKUP], i-OF1X_LATENCY_STAGE_LOOKUP, &stats);
+		}
+	}
+
+	platform_mutex_unlock(pipeline->sw->mutex);
+
+	platform_free_shared(hist);
+}
@@ -0,0 +1,218 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_LATENCYH__
+#define __OF1X_LATENCYH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "../../../threading.h"
+
+/**
+* @file of1x_latency.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 pipeline per stage latency histograms
+*
+* When the pipeline is compiled with --with-pipeline-latency-histograms
+* (ROFL_PIPELINE_LATENCY_HISTOGRAMS), the packet processing API has
+* instrumentation points that measure the cycles spent in every stage:
+*
+* - The whole pipeline pass
+* - The lookup of every table (including the miss filter)
+* - The processing of the instructions of the matched entry
+* - The processing of the write actions (action set)
+* - The processing of every group
+* - Every output (including PACKET_INs)
+*
+* Stages are nested (e.g. outputs are also accounted in the instructions or
+* write actions stage that performed them). Cycles are TSC ticks in x86, and
+* nanoseconds elsewhere.
+*
+* Histograms are enabled at runtime (of1x_enable_latency_histograms()); when
+* disabled, an instrumentation point costs a NULL pointer check. Without
+* ROFL_PIPELINE_LATENCY_HISTOGRAMS, instrumentation points are compiled out
+* and the histograms cannot be enabled.
+*
+* Every TID records in its own (log-linear, HDR-like) histograms, without
+* locks nor atomic operations. Histograms are merged on demand
+* (of1x_get_latency_histogram(), of1x_get_latency_stats()).
+*/
+
+//Linear sub-buckets per power of 2 (precision: 1/OF1X_LATENCY_SUB_BUCKETS)
+#define OF1X_LATENCY_SUB_BUCKET_BITS 4
+#define OF1X_LATENCY_SUB_BUCKETS (1<<OF1X_LATENCY_SUB_BUCKET_BITS)
+
+//Values of OF1X_LATENCY_MAX_BITS bits or more are accounted in the last (overflow) bucket
+#define OF1X_LATENCY_MAX_BITS 36
+#define OF1X_LATENCY_NUM_OF_BUCKETS ((OF1X_LATENCY_MAX_BITS-OF1X_LATENCY_SUB_BUCKET_BITS+1)*OF1X_LATENCY_SUB_BUCKETS + 1)
+
+//fwd decl
+struct of1x_pipeline;
+
+/**
+* @ingroup core_of1x
+* Pipeline stages
+*/
+typedef enum of1x_latency_stage{
+	OF1X_LATENCY_STAGE_PIPELINE = 0,	/* Whole pipeline pass */
+	OF1X_LATENCY_STAGE_INSTRUCTIONS,	/* Instructions of the matched entry */
+	OF1X_LATENCY_STAGE_WRITE_ACTIONS,	/* Action set */
+	OF1X_LATENCY_STAGE_GROUP,		/* Group */
+	OF1X_LATENCY_STAGE_OUTPUT,		/* Output (and PACKET_IN) */
+	OF1X_LATENCY_STAGE_LOOKUP,		/* Table lookup (one histogram per table); MUST be the last one */
+	__OF1X_LATENCY_STAGE_MAX
+}of1x_latency_stage_t;
+
+/**
+* @ingroup core_of1x
+* Log-linear histogram (cycles)
+*/
+typedef struct of1x_latency_histogram{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[OF1X_LATENCY_NUM_OF_BUCKETS];
+}of1x_latency_histogram_t;
+
+/**
+* @ingroup core_of1x
+* Latency summary of a stage (cycles). Percentiles are the upper bound of the
+* bucket they fall in
+*/
+typedef struct of1x_latency_stats{
+	uint64_t count;
+	uint64_t mean;
+	uint64_t max;
+	uint64_t p50;
+	uint64_t p99;
+	uint64_t p999;
+}of1x_latency_stats_t;
+
+/**
+* Per pipeline latency state; published in of1x_pipeline_t::latency (RCU),
+* replaced on every enable
+*/
+typedef struct of1x_latency{
+	//Histograms per TID (OF1X_LATENCY_STAGE_LOOKUP + num_of_tables)
+	unsigned int num_of_histograms;
+
+	//Per TID histograms (tid_size bytes each, from tids)
+	unsigned int num_of_tids;
+	size_t tid_size;
+	uint8_t* tids;
+
+	//Allocated buffer
+	void* mem;
+}of1x_latency_t;
+
+//Histogram index of a stage
+static inline unsigned int __of1x_latency_index(of1x_latency_stage_t stage, unsigned int table_id){
+	return (stage == OF1X_LATENCY_STAGE_LOOKUP)? OF1X_LATENCY_STAGE_LOOKUP+table_id : stage;
+}
+
+static inline of1x_latency_histogram_t* __of1x_latency_histogram(of1x_latency_t* lat, unsigned int tid, unsigned int index){
+	return ((of1x_latency_histogram_t*)(lat->tids + tid*lat->tid_size)) + index;
+}
+
+//Bucket of a value
+static inline unsigned int __of1x_latency_bucket(uint64_t value){
+
+	unsigned int shift;
+
+	if(value < (OF1X_LATENCY_SUB_BUCKETS<<1))
+		return (unsigned int)value;
+
+	//Position of the MSB over the sub-bucket bits
+	shift = 63 - __builtin_clzll(value) - OF1X_LATENCY_SUB_BUCKET_BITS;
+	if(shift > OF1X_LATENCY_MAX_BITS - OF1X_LATENCY_SUB_BUCKET_BITS - 1)
+		return OF1X_LATENCY_NUM_OF_BUCKETS-1;
+
+	return ((shift+1) << OF1X_LATENCY_SUB_BUCKET_BITS) + (unsigned int)(value >> shift) - OF1X_LATENCY_SUB_BUCKETS;
+}
+
+//Highest value of a bucket
+static inline uint64_t __of1x_latency_bucket_max(unsigned int bucket){
+
+	unsigned int shift;
+	uint64_t sub;
+
+	if(bucket < (OF1X_LATENCY_SUB_BUCKETS<<1))
+		return bucket;
+	if(bucket >= OF1X_LATENCY_NUM_OF_BUCKETS-1)
+		return UINT64_MAX;
+
+	shift = (bucket >> OF1X_LATENCY_SUB_BUCKET_BITS) - 1;
+	sub = OF1X_LATENCY_SUB_BUCKETS + (bucket & (OF1X_LATENCY_SUB_BUCKETS-1));
+
+	return ((sub+1) << shift) - 1;
+}
+
+static inline void __of1x_latency_histogram_record(of1x_latency_histogram_t* hist, uint64_t value){
+	hist->count++;
+	hist->sum += value;
+	if(value > hist->max)
+		hist->max = value;
+	hist->buckets[__of1x_latency_bucket(value)]++;
+}
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Destroy (pipeline)
+*/
+void __of1x_destroy_latency(struct of1x_pipeline *const pipeline);
+
+/**
+* @brief Enables (or resets) the latency histograms of the pipeline
+* @ingroup core_of1x
+*
+* @retval ROFL_FAILURE if the pipeline was not compiled with
+* --with-pipeline-latency-histograms
+*/
+rofl_result_t of1x_enable_latency_histograms(struct of1x_pipeline *const pipeline);
+
+/**
+* @brief Disables the latency histograms of the pipeline
+* @ingroup core_of1x
+*/
+rofl_result_t of1x_disable_latency_histograms(struct of1x_pipeline *const pipeline);
+
+/**
+* @brief Retrieves the histogram of a stage, merged over all the TIDs
+* @ingroup core_of1x
+*
+* @param table_id Table index (only for OF1X_LATENCY_STAGE_LOOKUP)
+* @retval ROFL_FAILURE if not enabled
+*/
+rofl_result_t of1x_get_latency_histogram(struct of1x_pipeline *const pipeline, of1x_latency_stage_t stage, unsigned int table_id, of1x_latency_histogram_t* hist);
+
+/**
+* @brief Retrieves the count, mean, max and p50/p99/p99.9 of a stage
+* @ingroup core_of1x
+*
+* @param table_id Table index (only for OF1X_LATENCY_STAGE_LOOKUP)
+* @retval ROFL_FAILURE if not enabled
+*/
+rofl_result_t of1x_get_latency_stats(struct of1x_pipeline *const pipeline, of1x_latency_stage_t stage, unsigned int table_id, of1x_latency_stats_t* stats);
+
+/**
+* @brief Percentile of a histogram
+* @ingroup core_of1x
+*
+* @param per_100000 Percentile in units of 0.001% (e.g. 99900 for p99.9)
+* @retval The upper bound of the bucket of the percentile (capped by the max), or 0 if empty
+*/
+uint64_t of1x_latency_histogram_percentile(const of1x_latency_histogram_t* hist, unsigned int per_100000);
+
+/*
+* Dump
+*/
+void __of1x_dump_latency(struct of1x_pipeline *const pipeline);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_LATENCY
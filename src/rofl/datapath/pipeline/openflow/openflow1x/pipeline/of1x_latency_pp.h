@@ -0,0 +1,85 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_LATENCY_PPH__
+#define __OF1X_LATENCY_PPH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "../../../util/pp_guard.h" //Never forget to include the guard
+#include "../../../platform/likely.h"
+#include "of1x_latency.h"
+
+#if defined(ROFL_PIPELINE_LATENCY_HISTOGRAMS) && !defined(__x86_64__) && !defined(__i386__)
+#include <time.h>
+#endif
+
+/**
+* @file of1x_latency_pp.h
+* @brief Pipeline latency instrumentation points
+*
+* Usage (the three calls compile to nothing without
+* ROFL_PIPELINE_LATENCY_HISTOGRAMS):
+*
+* lat = __of1x_latency_get(pipeline->latency);
+* start = __of1x_latency_start(lat);
+* ... stage ...
+* __of1x_latency_end(tid, lat, index, start);
+*/
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+//Cycle counter
+static inline uint64_t __of1x_latency_cycles(void){
+#if defined(__x86_64__) || defined(__i386__)
+	uint32_t lo, hi;
+	__asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t)hi << 32) | lo;
+#elif defined(ROFL_PIPELINE_LATENCY_HISTOGRAMS)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+/**
+* Current latency state of the pipeline (NULL if disabled)
+*/
+static inline of1x_latency_t* __of1x_latency_get(of1x_latency_t* latency){
+#ifdef ROFL_PIPELINE_LATENCY_HISTOGRAMS
+	return latency;
+#else
+	return NULL;
+#endif
+}
+
+/**
+* Start of a stage
+*/
+static inline uint64_t __of1x_latency_start(of1x_latency_t* lat){
+	if(likely(lat == NULL))
+		return 0;
+	return __of1x_latency_cycles();
+}
+
+/**
+* End of a stage; records the cycles since start in the TID histogram
+*/
+static inline void __of1x_latency_end(const unsigned int tid, of1x_latency_t* lat, unsigned int index, uint64_t start){
+
+	if(likely(lat == NULL))
+		return;
+
+	__of1x_latency_histogram_record(__of1x_latency_histogram(lat, tid, index), __of1x_latency_cycles() - start);
+}
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_LATENCY_PP
@@ -4,9 +4,12 @@
 #include "../../../common/datapacket.h"
 #include "../../../common/protocol_constants.h"
 #include "../../../platform/memory.h"
+#include "../../../physical_switch.h"
 #include "../../../platform/likely.h"
 #include "../../../util/logging.h"
 
+static const slab_desc_t of1x_match_slab_desc = { "match", SLAB_POOL_MATCH, sizeof(of1x_match_t), NULL, NULL };
+
 /*
 * Initializers 
 */
@@ -16,13 +19,13 @@
 
 //Phy
 of1x_match_t* of1x_init_port_in_match(uint32_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_IN_PORT; 
-	match->__tern = __init_utern32(value,OF1X_4_BYTE_MASK); //No wildcard
+	__set_utern32(&match->__tern, value,OF1X_4_BYTE_MASK); //No wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -36,13 +39,13 @@ of1x_match_t* of1x_init_port_in_match(uint32_t value){
 }
 
 of1x_match_t* of1x_init_port_in_phy_match(uint32_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_IN_PHY_PORT; 
-	match->__tern = __init_utern32(value,OF1X_4_BYTE_MASK); //No wildcard 
+	__set_utern32(&match->__tern, value,OF1X_4_BYTE_MASK); //No wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -57,13 +60,13 @@ of1x_match_t* of1x_init_port_in_phy_match(uint32_t value){
 
 //METADATA
 of1x_match_t* of1x_init_metadata_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_METADATA; 
-	match->__tern = __init_utern64(value, mask);
+	__set_utern64(&match->__tern, value, mask);
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -81,7 +84,7 @@ of1x_match_t* of1x_init_metadata_match(uint64_t value, uint64_t mask){
 
 //ETHERNET
 of1x_match_t* of1x_init_eth_dst_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -91,7 +94,7 @@ of1x_match_t* of1x_init_eth_dst_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 	
 	match->type = OF1X_MATCH_ETH_DST; 
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 
 
 	//Set fast validation flags	
@@ -108,7 +111,7 @@ of1x_match_t* of1x_init_eth_dst_match(uint64_t value, uint64_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_eth_src_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -118,7 +121,7 @@ of1x_match_t* of1x_init_eth_src_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 
 	match->type = OF1X_MATCH_ETH_SRC; 
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 	
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -134,7 +137,7 @@ of1x_match_t* of1x_init_eth_src_match(uint64_t value, uint64_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_eth_type_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -142,7 +145,7 @@ of1x_match_t* of1x_init_eth_type_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_ETH_TYPE; 
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //No wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //No wildcard 
 	
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -157,7 +160,7 @@ of1x_match_t* of1x_init_eth_type_match(uint16_t value){
 
 //8021.q
 of1x_match_t* of1x_init_vlan_vid_match(uint16_t value, uint16_t mask, enum of1x_vlan_present vlan_present){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -169,7 +172,7 @@ of1x_match_t* of1x_init_vlan_vid_match(uint16_t value, uint16_t mask, enum of1x_
 	match->type = OF1X_MATCH_VLAN_VID; 
 	//Setting values; note that value includes the flag HAS_VLAN in the 13th bit
 	//The mask is set to be strictly 12 bits, so only matching the VLAN ID itself
-	match->__tern = __init_utern16(value&OF1X_VLAN_ID_MASK,mask&OF1X_VLAN_ID_MASK);
+	__set_utern16(&match->__tern, value&OF1X_VLAN_ID_MASK,mask&OF1X_VLAN_ID_MASK);
 	match->vlan_present = vlan_present;
 
 	//Set fast validation flags	
@@ -186,7 +189,7 @@ of1x_match_t* of1x_init_vlan_vid_match(uint16_t value, uint16_t mask, enum of1x_
 	return match;
 }
 of1x_match_t* of1x_init_vlan_pcp_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -195,7 +198,7 @@ of1x_match_t* of1x_init_vlan_pcp_match(uint8_t value){
 	value = OF1X_VLAN_PCP_ALIGN(value);
 
 	match->type = OF1X_MATCH_VLAN_PCP; 
-	match->__tern = __init_utern8(value&OF1X_3MSBITS_MASK,OF1X_3MSBITS_MASK); //Ensure only 3 bit value, no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_3MSBITS_MASK,OF1X_3MSBITS_MASK); //Ensure only 3 bit value, no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -210,7 +213,7 @@ of1x_match_t* of1x_init_vlan_pcp_match(uint8_t value){
 
 //MPLS
 of1x_match_t* of1x_init_mpls_label_match(uint32_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -219,7 +222,7 @@ of1x_match_t* of1x_init_mpls_label_match(uint32_t value){
 	value = HTONB32(OF1X_MPLS_LABEL_ALIGN(value));
 
 	match->type = OF1X_MATCH_MPLS_LABEL; 
-	match->__tern = __init_utern32(value&OF1X_20_BITS_MASK,OF1X_20_BITS_MASK); //no wildcard?? wtf! 
+	__set_utern32(&match->__tern, value&OF1X_20_BITS_MASK,OF1X_20_BITS_MASK); //no wildcard?? wtf! 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -232,7 +235,7 @@ of1x_match_t* of1x_init_mpls_label_match(uint32_t value){
 	return match;
 }
 of1x_match_t* of1x_init_mpls_tc_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -241,7 +244,7 @@ of1x_match_t* of1x_init_mpls_tc_match(uint8_t value){
 	value = OF1X_MPLS_TC_ALIGN(value);
 
 	match->type = OF1X_MATCH_MPLS_TC; 
-	match->__tern = __init_utern8(value&OF1X_BITS_12AND3_MASK,OF1X_BITS_12AND3_MASK); //Ensure only 3 bit value, no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_BITS_12AND3_MASK,OF1X_BITS_12AND3_MASK); //Ensure only 3 bit value, no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -254,13 +257,13 @@ of1x_match_t* of1x_init_mpls_tc_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_mpls_bos_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_MPLS_BOS; 
-	match->__tern = __init_utern8(value&OF1X_BIT0_MASK,OF1X_BIT0_MASK); //Ensure only 1 bit value, no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_BIT0_MASK,OF1X_BIT0_MASK); //Ensure only 1 bit value, no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_13;	//First supported in OF1.3
@@ -275,7 +278,7 @@ of1x_match_t* of1x_init_mpls_bos_match(uint8_t value){
 
 //ARP
 of1x_match_t* of1x_init_arp_opcode_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -284,7 +287,7 @@ of1x_match_t* of1x_init_arp_opcode_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_ARP_OP;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //No wildcard
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //No wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0 (1.0: lower 8bits of opcode)
@@ -297,7 +300,7 @@ of1x_match_t* of1x_init_arp_opcode_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_arp_tha_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -307,7 +310,7 @@ of1x_match_t* of1x_init_arp_tha_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 
 	match->type = OF1X_MATCH_ARP_THA;
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 
 
 	//Set fast validation flags	
@@ -324,7 +327,7 @@ of1x_match_t* of1x_init_arp_tha_match(uint64_t value, uint64_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_arp_sha_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -334,7 +337,7 @@ of1x_match_t* of1x_init_arp_sha_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 
 	match->type = OF1X_MATCH_ARP_SHA;
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -350,7 +353,7 @@ of1x_match_t* of1x_init_arp_sha_match(uint64_t value, uint64_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_arp_tpa_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -360,7 +363,7 @@ of1x_match_t* of1x_init_arp_tpa_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(mask);
 
 	match->type = OF1X_MATCH_ARP_TPA;
-	match->__tern = __init_utern32(value,mask);
+	__set_utern32(&match->__tern, value,mask);
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -376,7 +379,7 @@ of1x_match_t* of1x_init_arp_tpa_match(uint32_t value, uint32_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_arp_spa_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -386,7 +389,7 @@ of1x_match_t* of1x_init_arp_spa_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(mask);
 
 	match->type = OF1X_MATCH_ARP_SPA;
-	match->__tern = __init_utern32(value,mask);
+	__set_utern32(&match->__tern, value,mask);
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -404,13 +407,13 @@ of1x_match_t* of1x_init_arp_spa_match(uint32_t value, uint32_t mask){
 
 //NW
 of1x_match_t* of1x_init_nw_proto_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_NW_PROTO; 
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -423,7 +426,7 @@ of1x_match_t* of1x_init_nw_proto_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_nw_src_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -433,7 +436,7 @@ of1x_match_t* of1x_init_nw_src_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(mask);
 
 	match->type = OF1X_MATCH_NW_SRC;
-	match->__tern = __init_utern32(value,mask); 
+	__set_utern32(&match->__tern, value,mask); 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -449,7 +452,7 @@ of1x_match_t* of1x_init_nw_src_match(uint32_t value, uint32_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_nw_dst_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -459,7 +462,7 @@ of1x_match_t* of1x_init_nw_dst_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(mask);
 
 	match->type = OF1X_MATCH_NW_DST;
-	match->__tern = __init_utern32(value,mask); 
+	__set_utern32(&match->__tern, value,mask); 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -477,7 +480,7 @@ of1x_match_t* of1x_init_nw_dst_match(uint32_t value, uint32_t mask){
 
 //IPv4
 of1x_match_t* of1x_init_ip4_src_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -487,7 +490,7 @@ of1x_match_t* of1x_init_ip4_src_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(mask);
 
 	match->type = OF1X_MATCH_IPV4_SRC;
-	match->__tern = __init_utern32(value,mask); 
+	__set_utern32(&match->__tern, value,mask); 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -503,7 +506,7 @@ of1x_match_t* of1x_init_ip4_src_match(uint32_t value, uint32_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_ip4_dst_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -513,7 +516,7 @@ of1x_match_t* of1x_init_ip4_dst_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(mask);
 
 	match->type = OF1X_MATCH_IPV4_DST;
-	match->__tern = __init_utern32(value,mask); 
+	__set_utern32(&match->__tern, value,mask); 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -529,13 +532,13 @@ of1x_match_t* of1x_init_ip4_dst_match(uint32_t value, uint32_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_ip_proto_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_IP_PROTO; 
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -548,7 +551,7 @@ of1x_match_t* of1x_init_ip_proto_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_ip_dscp_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -557,7 +560,7 @@ of1x_match_t* of1x_init_ip_dscp_match(uint8_t value){
 	value = OF1X_IP_DSCP_ALIGN(value);
 
 	match->type = OF1X_MATCH_IP_DSCP; 
-	match->__tern = __init_utern8(value&OF1X_6MSBITS_MASK,OF1X_6MSBITS_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_6MSBITS_MASK,OF1X_6MSBITS_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0 (ToS)
@@ -571,13 +574,13 @@ of1x_match_t* of1x_init_ip_dscp_match(uint8_t value){
 }
 
 of1x_match_t* of1x_init_ip_ecn_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_IP_ECN; 
-	match->__tern = __init_utern8(value&OF1X_2LSBITS_MASK,OF1X_2LSBITS_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_2LSBITS_MASK,OF1X_2LSBITS_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -592,7 +595,7 @@ of1x_match_t* of1x_init_ip_ecn_match(uint8_t value){
 
 //IPv6
 of1x_match_t* of1x_init_ip6_src_match(uint128__t value, uint128__t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -603,7 +606,7 @@ of1x_match_t* of1x_init_ip6_src_match(uint128__t value, uint128__t mask){
 
 	uint128__t fixed_mask = {{0xff,0xff,0xff,0xff, 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff, 0xff,0xff,0xff,0xff}};
 	match->type = OF1X_MATCH_IPV6_SRC;
-	match->__tern = __init_utern128(value,mask); 
+	__set_utern128(&match->__tern, value,mask); 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -619,7 +622,7 @@ of1x_match_t* of1x_init_ip6_src_match(uint128__t value, uint128__t mask){
 	return match;
 }
 of1x_match_t* of1x_init_ip6_dst_match(uint128__t value, uint128__t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -630,7 +633,7 @@ of1x_match_t* of1x_init_ip6_dst_match(uint128__t value, uint128__t mask){
 
 	uint128__t fixed_mask = {{0xff,0xff,0xff,0xff, 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff, 0xff,0xff,0xff,0xff}};
 	match->type = OF1X_MATCH_IPV6_DST;
-	match->__tern = __init_utern128(value,mask); 
+	__set_utern128(&match->__tern, value,mask); 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -646,7 +649,7 @@ of1x_match_t* of1x_init_ip6_dst_match(uint128__t value, uint128__t mask){
 	return match;
 }
 of1x_match_t* of1x_init_ip6_flabel_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -656,7 +659,7 @@ of1x_match_t* of1x_init_ip6_flabel_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(OF1X_IP6_FLABEL_ALIGN(mask));
 
 	match->type = OF1X_MATCH_IPV6_FLABEL;
-	match->__tern = __init_utern32(value&OF1X_20_BITS_IPV6_FLABEL_MASK,mask&OF1X_20_BITS_IPV6_FLABEL_MASK); // ensure 20 bits. 
+	__set_utern32(&match->__tern, value&OF1X_20_BITS_IPV6_FLABEL_MASK,mask&OF1X_20_BITS_IPV6_FLABEL_MASK); // ensure 20 bits. 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -669,7 +672,7 @@ of1x_match_t* of1x_init_ip6_flabel_match(uint32_t value, uint32_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_ip6_nd_target_match(uint128__t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -680,7 +683,7 @@ of1x_match_t* of1x_init_ip6_nd_target_match(uint128__t value){
 	uint128__t mask = {{0xff,0xff,0xff,0xff, 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff, 0xff,0xff,0xff,0xff}};
 	
 	match->type = OF1X_MATCH_IPV6_ND_TARGET;
-	match->__tern = __init_utern128(value,mask); //No wildcard
+	__set_utern128(&match->__tern, value,mask); //No wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -693,7 +696,7 @@ of1x_match_t* of1x_init_ip6_nd_target_match(uint128__t value){
 	return match;
 }
 of1x_match_t* of1x_init_ip6_nd_sll_match(uint64_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -702,7 +705,7 @@ of1x_match_t* of1x_init_ip6_nd_sll_match(uint64_t value){
 	value = HTONB64(OF1X_MAC_ALIGN(value));
 
 	match->type = OF1X_MATCH_IPV6_ND_SLL;
-	match->__tern = __init_utern64(value & OF1X_48_BITS_MASK, OF1X_48_BITS_MASK); //ensure 48 bits. No wildcard
+	__set_utern64(&match->__tern, value & OF1X_48_BITS_MASK, OF1X_48_BITS_MASK); //ensure 48 bits. No wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -715,7 +718,7 @@ of1x_match_t* of1x_init_ip6_nd_sll_match(uint64_t value){
 	return match;
 }
 of1x_match_t* of1x_init_ip6_nd_tll_match(uint64_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -724,7 +727,7 @@ of1x_match_t* of1x_init_ip6_nd_tll_match(uint64_t value){
 	value = HTONB64(OF1X_MAC_ALIGN(value));
 
 	match->type = OF1X_MATCH_IPV6_ND_TLL;
-	match->__tern = __init_utern64(value & OF1X_48_BITS_MASK, OF1X_48_BITS_MASK); //ensure 48 bits. No wildcard
+	__set_utern64(&match->__tern, value & OF1X_48_BITS_MASK, OF1X_48_BITS_MASK); //ensure 48 bits. No wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -737,7 +740,7 @@ of1x_match_t* of1x_init_ip6_nd_tll_match(uint64_t value){
 	return match;
 }
 of1x_match_t* of1x_init_ip6_exthdr_match(uint16_t value, uint16_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -745,7 +748,7 @@ of1x_match_t* of1x_init_ip6_exthdr_match(uint16_t value, uint16_t mask){
 	// TODO Align to pipeline convention (NBO, lower memory address) -- currently not implemented
 
 	match->type = OF1X_MATCH_IPV6_EXTHDR;
-	match->__tern = __init_utern16(value&OF1X_9_BITS_MASK, mask & OF1X_9_BITS_MASK );  //ensure 9 bits, with Wildcard
+	__set_utern16(&match->__tern, value&OF1X_9_BITS_MASK, mask & OF1X_9_BITS_MASK );  //ensure 9 bits, with Wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_13;	//First supported in OF1.2
@@ -763,13 +766,13 @@ of1x_match_t* of1x_init_ip6_exthdr_match(uint16_t value, uint16_t mask){
 
 //ICMPV6
 of1x_match_t* of1x_init_icmpv6_type_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_ICMPV6_TYPE;
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK);
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK);
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -782,13 +785,13 @@ of1x_match_t* of1x_init_icmpv6_type_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_icmpv6_code_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_ICMPV6_CODE;
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK);
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK);
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -803,7 +806,7 @@ of1x_match_t* of1x_init_icmpv6_code_match(uint8_t value){
 
 //TCP
 of1x_match_t* of1x_init_tcp_src_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -812,7 +815,7 @@ of1x_match_t* of1x_init_tcp_src_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_TCP_SRC;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -826,7 +829,7 @@ of1x_match_t* of1x_init_tcp_src_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_tcp_dst_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -835,7 +838,7 @@ of1x_match_t* of1x_init_tcp_dst_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_TCP_DST;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -849,7 +852,7 @@ of1x_match_t* of1x_init_tcp_dst_match(uint16_t value){
 }
 //UDP
 of1x_match_t* of1x_init_udp_src_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -858,7 +861,7 @@ of1x_match_t* of1x_init_udp_src_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_UDP_SRC;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -871,7 +874,7 @@ of1x_match_t* of1x_init_udp_src_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_udp_dst_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -880,7 +883,7 @@ of1x_match_t* of1x_init_udp_dst_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_UDP_DST;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -895,7 +898,7 @@ of1x_match_t* of1x_init_udp_dst_match(uint16_t value){
 
 //SCTP
 of1x_match_t* of1x_init_sctp_src_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -904,7 +907,7 @@ of1x_match_t* of1x_init_sctp_src_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_SCTP_SRC;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -918,7 +921,7 @@ of1x_match_t* of1x_init_sctp_src_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_sctp_dst_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -927,7 +930,7 @@ of1x_match_t* of1x_init_sctp_dst_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_SCTP_DST;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -942,7 +945,7 @@ of1x_match_t* of1x_init_sctp_dst_match(uint16_t value){
 
 //TP
 of1x_match_t* of1x_init_tp_src_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -951,7 +954,7 @@ of1x_match_t* of1x_init_tp_src_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_TP_SRC;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -964,7 +967,7 @@ of1x_match_t* of1x_init_tp_src_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_tp_dst_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -973,7 +976,7 @@ of1x_match_t* of1x_init_tp_dst_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_TP_DST;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_10;	//First supported in OF1.0
@@ -987,13 +990,13 @@ of1x_match_t* of1x_init_tp_dst_match(uint16_t value){
 }
 //ICMPv4
 of1x_match_t* of1x_init_icmpv4_type_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_ICMPV4_TYPE; 
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -1006,13 +1009,13 @@ of1x_match_t* of1x_init_icmpv4_type_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_icmpv4_code_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_ICMPV4_CODE; 
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -1027,7 +1030,7 @@ of1x_match_t* of1x_init_icmpv4_code_match(uint8_t value){
 
 //PBB
 of1x_match_t* of1x_init_pbb_isid_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1037,7 +1040,7 @@ of1x_match_t* of1x_init_pbb_isid_match(uint32_t value, uint32_t mask){
 	mask = HTONB32(OF1X_PBB_ISID_ALIGN(mask));
 
 	match->type = OF1X_MATCH_PBB_ISID;
-	match->__tern = __init_utern32(value&OF1X_3_BYTE_MASK, mask&OF1X_3_BYTE_MASK); //no wildcard 
+	__set_utern32(&match->__tern, value&OF1X_3_BYTE_MASK, mask&OF1X_3_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_13;	//First supported in OF1.3
@@ -1055,7 +1058,7 @@ of1x_match_t* of1x_init_pbb_isid_match(uint32_t value, uint32_t mask){
 
 //Tunnel Id
 of1x_match_t* of1x_init_tunnel_id_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1063,7 +1066,7 @@ of1x_match_t* of1x_init_tunnel_id_match(uint64_t value, uint64_t mask){
 	//TODO align?
 
 	match->type = OF1X_MATCH_TUNNEL_ID; 
-	match->__tern = __init_utern64(value, mask); //no wildcard 
+	__set_utern64(&match->__tern, value, mask); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_13;	//First supported in OF1.3
@@ -1085,13 +1088,13 @@ of1x_match_t* of1x_init_tunnel_id_match(uint64_t value, uint64_t mask){
 
 //PPPoE
 of1x_match_t* of1x_init_pppoe_code_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_PPPOE_CODE; 
-	match->__tern = __init_utern8(value&OF1X_1_BYTE_MASK,OF1X_1_BYTE_MASK); //no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_1_BYTE_MASK,OF1X_1_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1104,13 +1107,13 @@ of1x_match_t* of1x_init_pppoe_code_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_pppoe_type_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_PPPOE_TYPE; 
-	match->__tern = __init_utern8(value&OF1X_4_BITS_MASK,OF1X_4_BITS_MASK); //Ensure only 4 bit value, no wildcard 
+	__set_utern8(&match->__tern, value&OF1X_4_BITS_MASK,OF1X_4_BITS_MASK); //Ensure only 4 bit value, no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1123,7 +1126,7 @@ of1x_match_t* of1x_init_pppoe_type_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_pppoe_session_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1132,7 +1135,7 @@ of1x_match_t* of1x_init_pppoe_session_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_PPPOE_SID; 
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1145,7 +1148,7 @@ of1x_match_t* of1x_init_pppoe_session_match(uint16_t value){
 }
 //PPP
 of1x_match_t* of1x_init_ppp_prot_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1154,7 +1157,7 @@ of1x_match_t* of1x_init_ppp_prot_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_PPP_PROT; 
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard 
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard 
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1168,13 +1171,13 @@ of1x_match_t* of1x_init_ppp_prot_match(uint16_t value){
 }
 //GTP
 of1x_match_t* of1x_init_gtp_msg_type_match(uint8_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_GTP_MSG_TYPE;
-	match->__tern = __init_utern8(value,OF1X_1_BYTE_MASK); //no wildcard
+	__set_utern8(&match->__tern, value,OF1X_1_BYTE_MASK); //no wildcard
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1187,7 +1190,7 @@ of1x_match_t* of1x_init_gtp_msg_type_match(uint8_t value){
 	return match;
 }
 of1x_match_t* of1x_init_gtp_teid_match(uint32_t value, uint32_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 	
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1196,7 +1199,7 @@ of1x_match_t* of1x_init_gtp_teid_match(uint32_t value, uint32_t mask){
 	value = HTONB32(value);
 
 	match->type = OF1X_MATCH_GTP_TEID;
-	match->__tern = __init_utern32(value, mask);
+	__set_utern32(&match->__tern, value, mask);
 
 	//Set fast validation flags	
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1213,13 +1216,13 @@ of1x_match_t* of1x_init_gtp_teid_match(uint32_t value, uint32_t mask){
 }
 //CAPWAP
 of1x_match_t* of1x_init_capwap_wbid_match(uint8_t value, uint8_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_CAPWAP_WBID;
-	match->__tern = __init_utern8(value, mask);
+	__set_utern8(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1235,13 +1238,13 @@ of1x_match_t* of1x_init_capwap_wbid_match(uint8_t value, uint8_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_capwap_rid_match(uint8_t value, uint8_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_CAPWAP_RID;
-	match->__tern = __init_utern8(value, mask);
+	__set_utern8(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1257,7 +1260,7 @@ of1x_match_t* of1x_init_capwap_rid_match(uint8_t value, uint8_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_capwap_flags_match(uint16_t value, uint16_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1267,7 +1270,7 @@ of1x_match_t* of1x_init_capwap_flags_match(uint16_t value, uint16_t mask){
 	mask = HTONB16(mask);
 
 	match->type = OF1X_MATCH_CAPWAP_FLAGS;
-	match->__tern = __init_utern16(value, mask);
+	__set_utern16(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1284,7 +1287,7 @@ of1x_match_t* of1x_init_capwap_flags_match(uint16_t value, uint16_t mask){
 }
 //WLAN
 of1x_match_t* of1x_init_wlan_fc_match(uint16_t value, uint16_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1294,7 +1297,7 @@ of1x_match_t* of1x_init_wlan_fc_match(uint16_t value, uint16_t mask){
 	mask = HTONB16(mask);
 
 	match->type = OF1X_MATCH_WLAN_FC;
-	match->__tern = __init_utern16(value, mask);
+	__set_utern16(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1310,13 +1313,13 @@ of1x_match_t* of1x_init_wlan_fc_match(uint16_t value, uint16_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_wlan_type_match(uint8_t value, uint8_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_WLAN_TYPE;
-	match->__tern = __init_utern8(value, mask);
+	__set_utern8(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1332,13 +1335,13 @@ of1x_match_t* of1x_init_wlan_type_match(uint8_t value, uint8_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_wlan_subtype_match(uint8_t value, uint8_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_WLAN_SUBTYPE;
-	match->__tern = __init_utern8(value, mask);
+	__set_utern8(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1354,13 +1357,13 @@ of1x_match_t* of1x_init_wlan_subtype_match(uint8_t value, uint8_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_wlan_direction_match(uint8_t value, uint8_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
 
 	match->type = OF1X_MATCH_WLAN_DIRECTION;
-	match->__tern = __init_utern8(value, mask);
+	__set_utern8(&match->__tern, value, mask);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1376,7 +1379,7 @@ of1x_match_t* of1x_init_wlan_direction_match(uint8_t value, uint8_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_wlan_address_1_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1386,7 +1389,7 @@ of1x_match_t* of1x_init_wlan_address_1_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 
 	match->type = OF1X_MATCH_WLAN_ADDRESS_1;
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -1402,7 +1405,7 @@ of1x_match_t* of1x_init_wlan_address_1_match(uint64_t value, uint64_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_wlan_address_2_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1412,7 +1415,7 @@ of1x_match_t* of1x_init_wlan_address_2_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 
 	match->type = OF1X_MATCH_WLAN_ADDRESS_2;
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -1428,7 +1431,7 @@ of1x_match_t* of1x_init_wlan_address_2_match(uint64_t value, uint64_t mask){
 	return match;
 }
 of1x_match_t* of1x_init_wlan_address_3_match(uint64_t value, uint64_t mask){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1438,7 +1441,7 @@ of1x_match_t* of1x_init_wlan_address_3_match(uint64_t value, uint64_t mask){
 	mask = HTONB64(OF1X_MAC_ALIGN(mask));
 
 	match->type = OF1X_MATCH_WLAN_ADDRESS_3;
-	match->__tern = __init_utern64(value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
+	__set_utern64(&match->__tern, value&OF1X_48_BITS_MASK, mask&OF1X_48_BITS_MASK); //Enforce mask bits are always 00 for the first bits
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2
@@ -1455,7 +1458,7 @@ of1x_match_t* of1x_init_wlan_address_3_match(uint64_t value, uint64_t mask){
 }
 //GRE
 of1x_match_t* of1x_init_gre_version_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1463,7 +1466,7 @@ of1x_match_t* of1x_init_gre_version_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_GRE_VERSION;
-	match->__tern = __init_utern16(value&OF1X_3_BITS_MASK,OF1X_3_BITS_MASK); //no wildcard
+	__set_utern16(&match->__tern, value&OF1X_3_BITS_MASK,OF1X_3_BITS_MASK); //no wildcard
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1476,7 +1479,7 @@ of1x_match_t* of1x_init_gre_version_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_gre_prot_type_match(uint16_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1484,7 +1487,7 @@ of1x_match_t* of1x_init_gre_prot_type_match(uint16_t value){
 	value = HTONB16(value);
 
 	match->type = OF1X_MATCH_GRE_PROT_TYPE;
-	match->__tern = __init_utern16(value,OF1X_2_BYTE_MASK); //no wildcard
+	__set_utern16(&match->__tern, value,OF1X_2_BYTE_MASK); //no wildcard
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1497,7 +1500,7 @@ of1x_match_t* of1x_init_gre_prot_type_match(uint16_t value){
 	return match;
 }
 of1x_match_t* of1x_init_gre_key_match(uint32_t value){
-	of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(unlikely(match == NULL))
 		return NULL;
@@ -1506,7 +1509,7 @@ of1x_match_t* of1x_init_gre_key_match(uint32_t value){
 	value = HTONB32(value);
 
 	match->type = OF1X_MATCH_GRE_KEY;
-	match->__tern = __init_utern32(value, OF1X_4_BYTE_MASK);
+	__set_utern32(&match->__tern, value, OF1X_4_BYTE_MASK);
 
 	//Set fast validation flags
 	match->ver_req.min_ver = OF_VERSION_12;	//First supported in OF1.2 (extensions)
@@ -1605,7 +1608,7 @@ void __of1x_match_group_push_back(of1x_match_group_t* group, of1x_match_t* match
 */
 of1x_match_t* __of1x_copy_match(of1x_match_t* match){
 
-	of1x_match_t* tmp = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	of1x_match_t* tmp = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
 
 	if(!tmp)
 		return tmp;
@@ -1616,14 +1619,6 @@ of1x_match_t* __of1x_copy_match(of1x_match_t* match){
 	//Initialize linked-list to null
 	tmp->prev=tmp->next=NULL;
 
-	//Create a whatever type utern and copy from the orignal tern
-	tmp->__tern = __init_utern8(0x0, 0x0);
-
-	if(!tmp->__tern)
-		return NULL;
-
-	*tmp->__tern = *match->__tern;
-
 	return tmp;
 }
 
@@ -1666,15 +1661,15 @@ of1x_match_t* __of1x_copy_matches(of1x_match_t* matches){
 * Try to find the largest common value among match1 and match2, being ALWAYS match2 with a more strict mask 
 */
 of1x_match_t* __of1x_get_alike_match(of1x_match_t* match1, of1x_match_t* match2){
-	utern_t* common_tern = NULL;	
+	utern_t common_tern;	
 
 	if( match1->type != match2->type )
 		return NULL;	
 
-	common_tern = __utern_get_alike(*match1->__tern,*match2->__tern);
-
-	if(common_tern){
-		of1x_match_t* match = (of1x_match_t*)platform_malloc_shared(sizeof(of1x_match_t));
+	if(__utern_set_alike(&common_tern, &match1->__tern, &match2->__tern)){
+		of1x_match_t* match = (of1x_match_t*)__physical_switch_alloc(&of1x_match_slab_desc);
+		if(unlikely(match == NULL))
+			return NULL;
 		match->__tern = common_tern;
 		match->type = match1->type;
 		match->next = NULL;
@@ -1687,8 +1682,7 @@ of1x_match_t* __of1x_get_alike_match(of1x_match_t* match1, of1x_match_t* match2)
 * Common destructor
 */
 void of1x_destroy_match(of1x_match_t* match){
-	__destroy_utern(match->__tern);
-	platform_free_shared(match);
+	__slab_free(match);
 }
 
 /*
@@ -1703,7 +1697,7 @@ bool __of1x_equal_matches(of1x_match_t* match1, of1x_match_t* match2){
 	if( match1->type != match2->type )
 		return false; 
 
-	return __utern_equals(match1->__tern,match2->__tern);
+	return __utern_equals(&match1->__tern,&match2->__tern);
 }
 
 //Finds out if sub_match is a submatch of match
@@ -1712,7 +1706,63 @@ bool __of1x_is_submatch(of1x_match_t* sub_match, of1x_match_t* match){
 	if( match->type != sub_match->type )
 		return false; 
 	
-	return __utern_is_contained(sub_match->__tern,match->__tern);
+	return __utern_is_contained(&sub_match->__tern,&match->__tern);
+}
+
+//FNV-1a
+#define OF1X_MATCH_HASH_FNV_PRIME 0x01000193
+#define OF1X_MATCH_HASH_FNV_SEED 0x811C9DC5
+
+static inline uint32_t __of1x_match_hash_bytes(uint32_t hash, const uint8_t* data, unsigned int len){
+	unsigned int i;
+	for(i=0;i<len;i++)
+		hash = (data[i] ^ hash) * OF1X_MATCH_HASH_FNV_PRIME;
+	return hash;
+}
+
+//Hash over the type, value and mask of a single match
+static uint32_t __of1x_match_hash(const of1x_match_t* match){
+	unsigned int len;
+	uint8_t type = match->type;
+	const utern_t* tern = &match->__tern;
+	uint32_t hash;
+
+	switch(tern->type){
+		case UTERN8_T: len = sizeof(uint8_t);
+			break;
+		case UTERN16_T: len = sizeof(uint16_t);
+			break;
+		case UTERN32_T: len = sizeof(uint32_t);
+			break;
+		case UTERN64_T: len = sizeof(uint64_t);
+			break;
+		case UTERN128_T: len = sizeof(uint128__t);
+			break;
+		default:
+			assert(0);
+			len = 0;
+			break;
+	}
+
+	//Note that all the union members start at the same address
+	hash = __of1x_match_hash_bytes(OF1X_MATCH_HASH_FNV_SEED, &type, sizeof(type));
+	hash = __of1x_match_hash_bytes(hash, (const uint8_t*)&tern->value, len);
+	hash = __of1x_match_hash_bytes(hash, (const uint8_t*)&tern->mask, len);
+
+	return hash;
+}
+
+uint32_t __of1x_match_group_hash(const of1x_match_group_t* group){
+	of1x_match_t* it;
+	uint32_t hash = 0x0, h;
+
+	//Commutative combination, so that the order is irrelevant
+	for(it=group->head; it; it=it->next){
+		h = __of1x_match_hash(it);
+		hash += h ^ (h >> 16);
+	}
+
+	return hash;
 }
 
 //Matches with mask (including matches that do not support)
@@ -154,8 +154,8 @@ typedef struct of1x_match{
 	//Type
 	of1x_match_type_t type;
 
-	//Ternary value
-	utern_t* __tern;
+	//Ternary value (inline; no extra dereference on packet matching)
+	utern_t __tern;
 	
 	//Previous entry
 	struct of1x_match* prev;
@@ -653,12 +653,12 @@ void of1x_destroy_match(of1x_match_t* match);
 static inline 
 uint8_t __of1x_get_match_val8(const of1x_match_t* match, bool get_mask, bool raw_nbo){
 
-	wrap_uint_t* wrap;
+	const wrap_uint_t* wrap;
 	
 	if(get_mask)
-		wrap = &match->__tern->mask; 
+		wrap = &match->__tern.mask; 
 	else
-		wrap = &match->__tern->value; 
+		wrap = &match->__tern.value; 
 
 	if(raw_nbo)
 		return wrap->u8;
@@ -706,12 +706,12 @@ uint8_t of1x_get_match_value8(const of1x_match_t* match){
 static inline 
 uint16_t __of1x_get_match_val16(const of1x_match_t* match, bool get_mask, bool raw_nbo){
 
-	wrap_uint_t* wrap;
+	const wrap_uint_t* wrap;
 	
 	if(get_mask)
-		wrap = &match->__tern->mask; 
+		wrap = &match->__tern.mask; 
 	else
-		wrap = &match->__tern->value; 
+		wrap = &match->__tern.value; 
 
 
 	if(raw_nbo)
@@ -757,12 +757,12 @@ uint16_t of1x_get_match_value16(const of1x_match_t* match){
 static inline 
 uint32_t __of1x_get_match_val32(const of1x_match_t* match, bool get_mask, bool raw_nbo){
 	
-	wrap_uint_t* wrap;
+	const wrap_uint_t* wrap;
 	
 	if(get_mask)
-		wrap = &match->__tern->mask; 
+		wrap = &match->__tern.mask; 
 	else
-		wrap = &match->__tern->value; 
+		wrap = &match->__tern.value; 
 
 
 	if(raw_nbo)
@@ -811,12 +811,12 @@ uint32_t of1x_get_match_value32(const of1x_match_t* match){
 static inline 
 uint64_t __of1x_get_match_val64(const of1x_match_t* match, bool get_mask, bool raw_nbo){
 	
-	wrap_uint_t* wrap;
+	const wrap_uint_t* wrap;
 	
 	if(get_mask)
-		wrap = &match->__tern->mask; 
+		wrap = &match->__tern.mask; 
 	else
-		wrap = &match->__tern->value; 
+		wrap = &match->__tern.value; 
 
 
 	if(raw_nbo)
@@ -857,12 +857,12 @@ uint64_t of1x_get_match_value64(const of1x_match_t* match){
 static inline 
 uint128__t __of1x_get_match_val128(const of1x_match_t* match, bool get_mask, bool raw_nbo){
 	uint128__t tmp;
-	wrap_uint_t* wrap;
+	const wrap_uint_t* wrap;
 	
 	if(get_mask)
-		wrap = &match->__tern->mask; 
+		wrap = &match->__tern.mask; 
 	else
-		wrap = &match->__tern->value; 
+		wrap = &match->__tern.value; 
 
 	if(raw_nbo)
 		return wrap->u128;
@@ -981,6 +981,12 @@ of1x_match_t* __of1x_get_alike_match(of1x_match_t* match1, of1x_match_t* match2)
 bool __of1x_equal_matches(of1x_match_t* match1, of1x_match_t* match2);
 bool __of1x_is_submatch(of1x_match_t* sub_match, of1x_match_t* match);
 
+/*
+* Hash of the match set (type, value and mask of each match). The hash does
+* not depend on the order of the matches within the group.
+*/
+uint32_t __of1x_match_group_hash(const of1x_match_group_t* group);
+
 
 /*
 * OF1.0 specific behaviour for wildcard
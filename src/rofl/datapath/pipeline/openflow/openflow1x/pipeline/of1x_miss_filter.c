@@ -0,0 +1,227 @@
+#include "of1x_miss_filter.h"
+
+#include <assert.h>
+#include "../../../platform/likely.h"
+#include "../../../platform/lock.h"
+#include "../../../platform/memory.h"
+#include "../../../util/logging.h"
+
+#include "of1x_flow_entry.h"
+#include "of1x_flow_table.h"
+#include "of1x_pipeline.h"
+#include "of1x_utils.h"
+
+bool __of1x_miss_filter_is_valid_key(of1x_match_type_t key){
+	switch(key){
+		case OF1X_MATCH_IN_PORT:
+		case OF1X_MATCH_ETH_DST:
+		case OF1X_MATCH_ETH_SRC:
+		case OF1X_MATCH_IPV4_SRC:
+		case OF1X_MATCH_IPV4_DST:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+* Recovers the normalized key of the entry. Returns false if the entry does
+* not match the key field exactly (wildcarded or masked)
+*/
+static bool __of1x_miss_filter_get_entry_key(of1x_miss_filter_t* filter, of1x_flow_entry_t* entry, uint64_t* key){
+
+	of1x_match_t* match;
+	utern_t* tern;
+
+	if(!bitmap128_is_bit_set(&entry->matches.match_bm, filter->key))
+		return false;
+
+	for(match = entry->matches.head; match; match = match->next){
+		if(match->type != filter->key)
+			continue;
+
+		tern = &match->__tern;
+
+		switch(filter->key){
+			case OF1X_MATCH_IN_PORT:
+			case OF1X_MATCH_IPV4_SRC:
+			case OF1X_MATCH_IPV4_DST:
+				if(tern->mask.u32 != OF1X_4_BYTE_MASK)
+					return false;
+				*key = tern->value.u32;
+				return true;
+			case OF1X_MATCH_ETH_DST:
+			case OF1X_MATCH_ETH_SRC:
+				if(tern->mask.u64 != OF1X_48_BITS_MASK)
+					return false;
+				*key = tern->value.u64 & OF1X_48_BITS_MASK;
+				return true;
+			default:
+				assert(0);
+				return false;
+		}
+	}
+
+	return false;
+}
+
+void __of1x_init_miss_filter(of1x_miss_filter_t* filter){
+	filter->enabled = false;
+	filter->key = OF1X_MATCH_MAX;
+	filter->num_of_unkeyed = 0;
+	filter->counters = NULL;
+}
+
+void __of1x_destroy_miss_filter(of1x_miss_filter_t* filter){
+	filter->enabled = false;
+	if(filter->counters)
+		platform_free_shared(filter->counters);
+	filter->counters = NULL;
+}
+
+void __of1x_miss_filter_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	unsigned int i, slot;
+	uint32_t hash;
+	uint64_t key;
+	of1x_miss_filter_t* filter = &table->miss_filter;
+
+	if(likely(filter->counters == NULL))
+		return;
+
+	if(!__of1x_miss_filter_get_entry_key(filter, entry, &key)){
+		filter->num_of_unkeyed++;
+		return;
+	}
+
+	hash = __of1x_miss_filter_hash(key);
+	for(i=0;i<OF1X_MISS_FILTER_NUM_HASHES;i++){
+		slot = __of1x_miss_filter_slot(hash, i);
+		if(filter->counters[slot] != OF1X_MISS_FILTER_COUNTER_MAX)
+			filter->counters[slot]++;
+	}
+}
+
+void __of1x_miss_filter_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	unsigned int i, slot;
+	uint32_t hash;
+	uint64_t key;
+	of1x_miss_filter_t* filter = &table->miss_filter;
+
+	if(likely(filter->counters == NULL))
+		return;
+
+	if(!__of1x_miss_filter_get_entry_key(filter, entry, &key)){
+		assert(filter->num_of_unkeyed > 0);
+		filter->num_of_unkeyed--;
+		return;
+	}
+
+	hash = __of1x_miss_filter_hash(key);
+	for(i=0;i<OF1X_MISS_FILTER_NUM_HASHES;i++){
+		slot = __of1x_miss_filter_slot(hash, i);
+
+		//Saturated counters can no longer be decremented
+		if(filter->counters[slot] != OF1X_MISS_FILTER_COUNTER_MAX){
+			assert(filter->counters[slot] > 0);
+			filter->counters[slot]--;
+		}
+	}
+}
+
+rofl_result_t of1x_enable_table_miss_filter(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_match_type_t key){
+
+	of1x_flow_table_t* table;
+	of1x_miss_filter_t* filter;
+	of1x_flow_entry_t* entry;
+
+	//Verify table_id and key
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	if(unlikely(!__of1x_miss_filter_is_valid_key(key))){
+		ROFL_PIPELINE_ERR("%s: unsupported miss filter key %u\n", __func__, key);
+		return ROFL_FAILURE;
+	}
+
+	table = &pipeline->tables[table_id];
+	filter = &table->miss_filter;
+
+	//Serialize with flow_mods
+	platform_mutex_lock(table->mutex);
+
+	if(!filter->counters){
+		filter->counters = (uint8_t*)platform_malloc_shared(sizeof(uint8_t)*OF1X_MISS_FILTER_SLOTS);
+		if(unlikely(filter->counters == NULL)){
+			platform_mutex_unlock(table->mutex);
+			return ROFL_FAILURE;
+		}
+	}
+
+	//Stop packet processing from consulting it while rebuilding
+	filter->enabled = false;
+	tid_synchronize();
+
+	platform_memset(filter->counters, 0, sizeof(uint8_t)*OF1X_MISS_FILTER_SLOTS);
+	filter->key = key;
+	filter->num_of_unkeyed = 0;
+
+	//Rebuild (all matching algorithms keep the table->entries list)
+	for(entry = table->entries; entry; entry = entry->next)
+		__of1x_miss_filter_add_entry(table, entry);
+
+	//Counters and key before the flag (lock-free readers)
+	tid_memory_barrier();
+	filter->enabled = true;
+
+	platform_mutex_unlock(table->mutex);
+
+	return ROFL_SUCCESS;
+}
+
+static void __of1x_release_miss_filter_counters(void* counters){
+	platform_free_shared(counters);
+}
+
+rofl_result_t of1x_disable_table_miss_filter(of1x_pipeline_t *const pipeline, const unsigned int table_id){
+
+	of1x_flow_table_t* table;
+	uint8_t* counters;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	platform_mutex_lock(table->mutex);
+
+	//Entries are no longer accounted
+	table->miss_filter.enabled = false;
+	counters = table->miss_filter.counters;
+	table->miss_filter.counters = NULL;
+
+	platform_mutex_unlock(table->mutex);
+
+	//Packet processing may still be (lock-free) consulting them
+	if(counters)
+		tid_defer_release(counters, __of1x_release_miss_filter_counters);
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_dump_miss_filter(of1x_miss_filter_t* filter){
+
+	unsigned int i, used=0;
+
+	if(!filter->enabled)
+		return;
+
+	for(i=0;i<OF1X_MISS_FILTER_SLOTS;i++){
+		if(filter->counters[i])
+			used++;
+	}
+
+	ROFL_PIPELINE_INFO("\tMiss filter {key: %u, unkeyed entries: %u, counters in use: %u/%u}\n", filter->key, filter->num_of_unkeyed, used, OF1X_MISS_FILTER_SLOTS);
+}
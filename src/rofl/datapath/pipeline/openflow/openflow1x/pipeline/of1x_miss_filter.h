@@ -0,0 +1,135 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_MISS_FILTERH__
+#define __OF1X_MISS_FILTERH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "of1x_match.h"
+
+/**
+* @file of1x_miss_filter.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 per-table miss filter
+*
+* The miss filter is an (optional) counting Bloom filter over the exact-match
+* value of a single key field (e.g. ETH_DST) of the entries of a table. When
+* every entry of the table matches the key field exactly, a packet whose key
+* value is not in the filter cannot match any entry, and the lookup
+* can be skipped altogether (definite miss).
+*
+* Entries that wildcard (or mask) the key field are only accounted; while there
+* is at least one of them the filter is not consulted.
+*
+* The filter is maintained by the matching algorithms on entry addition and
+* removal (table->mutex held).
+*/
+
+//Number of counters (MUST be a power of 2) and hash functions
+#define OF1X_MISS_FILTER_SLOTS 16384
+#define OF1X_MISS_FILTER_SLOTS_MASK (OF1X_MISS_FILTER_SLOTS-1)
+#define OF1X_MISS_FILTER_NUM_HASHES 3
+
+//Counters stick once saturated
+#define OF1X_MISS_FILTER_COUNTER_MAX 0xFF
+
+//fwd decl
+struct of1x_flow_entry;
+struct of1x_flow_table;
+struct of1x_pipeline;
+
+/**
+* Per table miss filter state
+*/
+typedef struct of1x_miss_filter{
+	//Enabled flag (consulted by the packet processing)
+	bool enabled;
+
+	//Key field
+	of1x_match_type_t key;
+
+	//Number of entries not matching exactly the key field
+	unsigned int num_of_unkeyed;
+
+	//Counters (allocated on enable, released on disable -deferred- and on table destruction)
+	uint8_t* counters;
+}of1x_miss_filter_t;
+
+/*
+* FNV-1a over the 64 bit normalized key, folded to two independent
+* indexes which are combined (double hashing)
+*/
+#define OF1X_MISS_FILTER_FNV_PRIME 0x01000193 //16777619
+#define OF1X_MISS_FILTER_FNV_SEED 0x811C9DC5 //2166136261
+
+static inline uint32_t __of1x_miss_filter_hash(uint64_t key){
+	uint32_t hash = OF1X_MISS_FILTER_FNV_SEED;
+	unsigned int i;
+
+	for(i=0;i<sizeof(uint64_t);i++){
+		hash = ((key & 0xFF) ^ hash) * OF1X_MISS_FILTER_FNV_PRIME;
+		key >>= 8;
+	}
+	return hash;
+}
+
+static inline unsigned int __of1x_miss_filter_slot(uint32_t hash, unsigned int i){
+	uint32_t h1 = hash & 0xFFFF;
+	uint32_t h2 = (hash >> 16) | 0x1; //Odd, to visit different slots
+
+	return (h1 + i*h2) & OF1X_MISS_FILTER_SLOTS_MASK;
+}
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/**
+* @brief Checks if the field can be used as miss filter key
+* @ingroup core_of1x
+*/
+bool __of1x_miss_filter_is_valid_key(of1x_match_type_t key);
+
+/*
+* Init and destroy (table)
+*/
+void __of1x_init_miss_filter(of1x_miss_filter_t* filter);
+void __of1x_destroy_miss_filter(of1x_miss_filter_t* filter);
+
+/*
+* Accounting of entries. Shall be called by the matching algorithm on entry
+* addition/removal while holding table->mutex
+*/
+void __of1x_miss_filter_add_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+void __of1x_miss_filter_remove_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+
+/**
+* @brief Enables (or reconfigures) the miss filter of a table
+* @ingroup core_of1x
+*
+* The filter is (re)built from the existing entries of the table.
+*
+* @param pipeline Switch pipeline
+* @param table_id Table index
+* @param key Key field. Only OF1X_MATCH_IN_PORT, OF1X_MATCH_ETH_DST, OF1X_MATCH_ETH_SRC,
+* OF1X_MATCH_IPV4_SRC and OF1X_MATCH_IPV4_DST are supported.
+*/
+rofl_result_t of1x_enable_table_miss_filter(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_match_type_t key);
+
+/**
+* @brief Disables the miss filter of a table
+* @ingroup core_of1x
+*/
+rofl_result_t of1x_disable_table_miss_filter(struct of1x_pipeline *const pipeline, const unsigned int table_id);
+
+/*
+* Dump
+*/
+void __of1x_dump_miss_filter(of1x_miss_filter_t* filter);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_MISS_FILTER
@@ -0,0 +1,105 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_MISS_FILTER_PPH__
+#define __OF1X_MISS_FILTER_PPH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "../../../util/pp_guard.h" //Never forget to include the guard
+#include "../../../common/datapacket.h"
+#include "../../../platform/likely.h"
+#include "../../../platform/packet.h"
+#include "of1x_miss_filter.h"
+#include "of1x_flow_table.h"
+#include "of1x_utils.h"
+
+/**
+* @file of1x_miss_filter_pp.h
+* @brief Miss filter packet processing routines
+*/
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Recovers the normalized key from the packet. Returns false if the packet
+* does not have the field
+*/
+static inline bool __of1x_miss_filter_get_pkt_key(of1x_match_type_t type, datapacket_t *const pkt, uint64_t* key){
+
+	uint32_t* v32;
+	uint64_t* v64;
+
+	switch(type){
+		case OF1X_MATCH_IN_PORT:
+			v32 = platform_packet_get_port_in(pkt);
+			break;
+		case OF1X_MATCH_IPV4_SRC:
+			v32 = platform_packet_get_ipv4_src(pkt);
+			break;
+		case OF1X_MATCH_IPV4_DST:
+			v32 = platform_packet_get_ipv4_dst(pkt);
+			break;
+		case OF1X_MATCH_ETH_DST:
+			v64 = platform_packet_get_eth_dst(pkt);
+			if(unlikely(v64 == NULL))
+				return false;
+			*key = *v64 & OF1X_48_BITS_MASK;
+			return true;
+		case OF1X_MATCH_ETH_SRC:
+			v64 = platform_packet_get_eth_src(pkt);
+			if(unlikely(v64 == NULL))
+				return false;
+			*key = *v64 & OF1X_48_BITS_MASK;
+			return true;
+		default:
+			return false;
+	}
+
+	if(v32 == NULL)
+		return false;
+	*key = *v32;
+	return true;
+}
+
+/**
+* Returns true if the packet can NOT match any entry of the table (definite
+* miss). A false return value does not imply there is a match.
+*/
+static inline bool __of1x_miss_filter_is_definite_miss(of1x_flow_table_t *const table, datapacket_t *const pkt){
+
+	unsigned int i;
+	uint32_t hash;
+	uint64_t key;
+	uint8_t* counters;
+	of1x_miss_filter_t* filter = &table->miss_filter;
+
+	if(likely(!filter->enabled) || filter->num_of_unkeyed > 0)
+		return false;
+
+	//Released (deferred) on disable; may be NULL if the disable is in progress
+	counters = filter->counters;
+	if(unlikely(counters == NULL))
+		return false;
+
+	//All entries require the field
+	if(!__of1x_miss_filter_get_pkt_key(filter->key, pkt, &key))
+		return true;
+
+	hash = __of1x_miss_filter_hash(key);
+	for(i=0;i<OF1X_MISS_FILTER_NUM_HASHES;i++){
+		if(counters[__of1x_miss_filter_slot(hash, i)] == 0)
+			return true;
+	}
+
+	return false;
+}
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_MISS_FILTER_PP
@@ -0,0 +1,452 @@
+#include "of1x_overlap_index.h"
+
+#include <assert.h>
+#include "../../../platform/likely.h"
+#include "../../../platform/memory.h"
+#include "../../../util/logging.h"
+
+#include "of1x_flow_entry.h"
+#include "of1x_flow_table.h"
+
+/*
+* Field helpers
+*/
+static void __of1x_overlap_get_field(const utern_t* tern, of1x_overlap_field_t* value, of1x_overlap_field_t* mask){
+
+	value->hi = mask->hi = 0x0ULL;
+
+	switch(tern->type){
+		case UTERN8_T:
+			value->lo = tern->value.u8 & tern->mask.u8;
+			mask->lo = tern->mask.u8;
+			break;
+		case UTERN16_T:
+			value->lo = tern->value.u16 & tern->mask.u16;
+			mask->lo = tern->mask.u16;
+			break;
+		case UTERN32_T:
+			value->lo = tern->value.u32 & tern->mask.u32;
+			mask->lo = tern->mask.u32;
+			break;
+		case UTERN64_T:
+			value->lo = tern->value.u64 & tern->mask.u64;
+			mask->lo = tern->mask.u64;
+			break;
+		case UTERN128_T:
+			value->hi = UINT128__T_HI(tern->value.u128) & UINT128__T_HI(tern->mask.u128);
+			value->lo = UINT128__T_LO(tern->value.u128) & UINT128__T_LO(tern->mask.u128);
+			mask->hi = UINT128__T_HI(tern->mask.u128);
+			mask->lo = UINT128__T_LO(tern->mask.u128);
+			break;
+		default:
+			assert(0);
+			value->lo = mask->lo = 0x0ULL;
+			break;
+	}
+}
+
+static inline unsigned int __of1x_overlap_field_bits(const of1x_overlap_field_t* field){
+	return __builtin_popcountll(field->hi) + __builtin_popcountll(field->lo);
+}
+
+static inline bool __of1x_overlap_field_equals(const of1x_overlap_field_t* a, const of1x_overlap_field_t* b){
+	return a->hi == b->hi && a->lo == b->lo;
+}
+
+//Returns true if all the bits of sub are set in field
+static inline bool __of1x_overlap_field_covers(const of1x_overlap_field_t* field, const of1x_overlap_field_t* sub){
+	return (sub->hi & ~field->hi) == 0x0ULL && (sub->lo & ~field->lo) == 0x0ULL;
+}
+
+static inline uint32_t __of1x_overlap_hash(const of1x_overlap_class_t* cl, const of1x_overlap_field_t* value){
+	uint64_t h = (uint64_t)(uintptr_t)cl;
+
+	h ^= value->lo * 0x9E3779B97F4A7C15ULL;
+	h ^= value->hi * 0xC2B2AE3D27D4EB4FULL;
+	h ^= h >> 29;
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+//Key of an entry: the match with the widest mask (lowest type on ties)
+static of1x_match_t* __of1x_overlap_get_key(of1x_flow_entry_t *const entry){
+
+	unsigned int bits, best_bits = 0;
+	of1x_match_t *it, *best = NULL;
+	of1x_overlap_field_t value, mask;
+
+	for(it=entry->matches.head; it; it=it->next){
+		__of1x_overlap_get_field(&it->__tern, &value, &mask);
+		bits = __of1x_overlap_field_bits(&mask);
+		if(!best || bits > best_bits || (bits == best_bits && it->type < best->type)){
+			best = it;
+			best_bits = bits;
+		}
+	}
+	return best;
+}
+
+//Match of a certain type (or NULL)
+static of1x_match_t* __of1x_overlap_get_match(of1x_flow_entry_t *const entry, of1x_match_type_t type){
+	of1x_match_t* it;
+
+	for(it=entry->matches.head; it; it=it->next){
+		if(it->type == type)
+			return it;
+	}
+	return NULL;
+}
+
+/*
+* Init and destroy
+*/
+rofl_result_t __of1x_init_overlap_index(of1x_overlap_index_t* index){
+
+	index->prios = (of1x_overlap_prio_t**)platform_malloc_shared(sizeof(of1x_overlap_prio_t*)*OF1X_OVERLAP_INDEX_PRIO_BUCKETS);
+	if(unlikely(index->prios == NULL))
+		return ROFL_FAILURE;
+
+	index->buckets = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*OF1X_OVERLAP_INDEX_INITIAL_BUCKETS);
+	if(unlikely(index->buckets == NULL)){
+		platform_free_shared(index->prios);
+		index->prios = NULL;
+		return ROFL_FAILURE;
+	}
+
+	platform_memset(index->prios, 0, sizeof(of1x_overlap_prio_t*)*OF1X_OVERLAP_INDEX_PRIO_BUCKETS);
+	platform_memset(index->buckets, 0, sizeof(of1x_flow_entry_t*)*OF1X_OVERLAP_INDEX_INITIAL_BUCKETS);
+	index->num_of_buckets = OF1X_OVERLAP_INDEX_INITIAL_BUCKETS;
+	index->num_of_entries = 0;
+	index->enabled = true;
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_destroy_overlap_index(of1x_overlap_index_t* index){
+
+	unsigned int i;
+	of1x_overlap_prio_t *prio, *next_prio;
+	of1x_overlap_class_t *cl, *next_cl;
+
+	if(index->prios){
+		for(i=0;i<OF1X_OVERLAP_INDEX_PRIO_BUCKETS;i++){
+			for(prio=index->prios[i]; prio; prio=next_prio){
+				next_prio = prio->next;
+				for(cl=prio->classes; cl; cl=next_cl){
+					next_cl = cl->next;
+					platform_free_shared(cl);
+				}
+				platform_free_shared(prio);
+			}
+		}
+		platform_free_shared(index->prios);
+	}
+
+	if(index->buckets)
+		platform_free_shared(index->buckets);
+
+	index->enabled = false;
+	index->prios = NULL;
+	index->buckets = NULL;
+	index->num_of_buckets = index->num_of_entries = 0;
+}
+
+/*
+* Priorities and classes
+*/
+static inline unsigned int __of1x_overlap_prio_slot(uint16_t priority){
+	return priority & (OF1X_OVERLAP_INDEX_PRIO_BUCKETS-1);
+}
+
+static of1x_overlap_prio_t* __of1x_overlap_find_prio(of1x_overlap_index_t* index, uint16_t priority){
+	of1x_overlap_prio_t* it;
+
+	for(it=index->prios[__of1x_overlap_prio_slot(priority)]; it; it=it->next){
+		if(it->priority == priority)
+			return it;
+	}
+	return NULL;
+}
+
+static of1x_overlap_prio_t* __of1x_overlap_get_prio(of1x_overlap_index_t* index, uint16_t priority){
+
+	unsigned int slot;
+	of1x_overlap_prio_t* prio = __of1x_overlap_find_prio(index, priority);
+
+	if(prio)
+		return prio;
+
+	prio = (of1x_overlap_prio_t*)platform_malloc_shared(sizeof(of1x_overlap_prio_t));
+	if(unlikely(prio == NULL))
+		return NULL;
+
+	prio->priority = priority;
+	prio->classes = NULL;
+	prio->unkeyed = NULL;
+	prio->num_of_entries = 0;
+	slot = __of1x_overlap_prio_slot(priority);
+	prio->next = index->prios[slot];
+	index->prios[slot] = prio;
+
+	return prio;
+}
+
+static void __of1x_overlap_release_prio(of1x_overlap_index_t* index, of1x_overlap_prio_t* prio){
+
+	of1x_overlap_prio_t** it;
+
+	for(it=&index->prios[__of1x_overlap_prio_slot(prio->priority)]; *it; it=&(*it)->next){
+		if(*it == prio){
+			*it = prio->next;
+			break;
+		}
+	}
+	platform_free_shared(prio);
+}
+
+static of1x_overlap_class_t* __of1x_overlap_get_class(of1x_overlap_prio_t* prio, of1x_match_type_t type, const of1x_overlap_field_t* mask){
+
+	of1x_overlap_class_t* cl;
+
+	for(cl=prio->classes; cl; cl=cl->next){
+		if(cl->type == type && __of1x_overlap_field_equals(&cl->mask, mask))
+			return cl;
+	}
+
+	cl = (of1x_overlap_class_t*)platform_malloc_shared(sizeof(of1x_overlap_class_t));
+	if(unlikely(cl == NULL))
+		return NULL;
+
+	cl->type = type;
+	cl->mask = *mask;
+	cl->entries = NULL;
+	cl->num_of_entries = 0;
+	cl->next = prio->classes;
+	prio->classes = cl;
+
+	return cl;
+}
+
+static void __of1x_overlap_release_class(of1x_overlap_prio_t* prio, of1x_overlap_class_t* cl){
+
+	of1x_overlap_class_t** it;
+
+	for(it=&prio->classes; *it; it=&(*it)->next){
+		if(*it == cl){
+			*it = cl->next;
+			break;
+		}
+	}
+	platform_free_shared(cl);
+}
+
+//Doubles the number of buckets. On allocation failure chains just get longer
+static void __of1x_overlap_index_grow(of1x_overlap_index_t* index){
+
+	unsigned int i, slot, num_of_buckets = index->num_of_buckets*2;
+	of1x_flow_entry_t **buckets, *it, *next;
+
+	buckets = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*num_of_buckets);
+	if(unlikely(buckets == NULL))
+		return;
+	platform_memset(buckets, 0, sizeof(of1x_flow_entry_t*)*num_of_buckets);
+
+	for(i=0;i<index->num_of_buckets;i++){
+		for(it=index->buckets[i]; it; it=next){
+			next = it->cold->overlap_hash_next;
+			slot = it->cold->overlap_hash & (num_of_buckets-1);
+			it->cold->overlap_hash_next = buckets[slot];
+			buckets[slot] = it;
+		}
+	}
+
+	platform_free_shared(index->buckets);
+	index->buckets = buckets;
+	index->num_of_buckets = num_of_buckets;
+}
+
+/*
+* Entry accounting
+*/
+static inline void __of1x_overlap_list_add(of1x_flow_entry_t** head, of1x_flow_entry_t *const entry){
+	entry->cold->overlap_prev = NULL;
+	entry->cold->overlap_next = *head;
+	if(*head)
+		(*head)->cold->overlap_prev = entry;
+	*head = entry;
+}
+
+static inline void __of1x_overlap_list_remove(of1x_flow_entry_t** head, of1x_flow_entry_t *const entry){
+	if(entry->cold->overlap_prev)
+		entry->cold->overlap_prev->cold->overlap_next = entry->cold->overlap_next;
+	else
+		*head = entry->cold->overlap_next;
+	if(entry->cold->overlap_next)
+		entry->cold->overlap_next->cold->overlap_prev = entry->cold->overlap_prev;
+}
+
+void __of1x_overlap_index_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	unsigned int slot;
+	of1x_overlap_index_t* index = &table->overlap_index;
+	of1x_overlap_prio_t* prio;
+	of1x_overlap_class_t* cl;
+	of1x_overlap_field_t value, mask;
+
+	entry->cold->overlap_class = NULL;
+
+	if(unlikely(!index->enabled))
+		return;
+
+	prio = __of1x_overlap_get_prio(index, entry->priority & OF1X_2_BYTE_MASK);
+	if(unlikely(prio == NULL))
+		goto ENOMEM;
+
+	entry->cold->overlap_match = __of1x_overlap_get_key(entry);
+	if(!entry->cold->overlap_match){
+		__of1x_overlap_list_add(&prio->unkeyed, entry);
+		prio->num_of_entries++;
+		return;
+	}
+
+	__of1x_overlap_get_field(&entry->cold->overlap_match->__tern, &value, &mask);
+	cl = __of1x_overlap_get_class(prio, entry->cold->overlap_match->type, &mask);
+	if(unlikely(cl == NULL)){
+		if(prio->num_of_entries == 0)
+			__of1x_overlap_release_prio(index, prio);
+		goto ENOMEM;
+	}
+
+	if(index->num_of_entries >= index->num_of_buckets*OF1X_OVERLAP_INDEX_MAX_LOAD)
+		__of1x_overlap_index_grow(index);
+
+	entry->cold->overlap_class = cl;
+	__of1x_overlap_list_add(&cl->entries, entry);
+	cl->num_of_entries++;
+	prio->num_of_entries++;
+
+	entry->cold->overlap_hash = __of1x_overlap_hash(cl, &value);
+	slot = entry->cold->overlap_hash & (index->num_of_buckets-1);
+	entry->cold->overlap_hash_next = index->buckets[slot];
+	index->buckets[slot] = entry;
+	index->num_of_entries++;
+
+	return;
+
+ENOMEM:
+	//The index would no longer be complete
+	ROFL_PIPELINE_ERR("%s: unable to allocate memory. Disabling overlap index of table %u\n", __func__, table->number);
+	__of1x_destroy_overlap_index(index);
+}
+
+void __of1x_overlap_index_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_overlap_index_t* index = &table->overlap_index;
+	of1x_overlap_prio_t* prio;
+	of1x_overlap_class_t* cl = entry->cold->overlap_class;
+	of1x_flow_entry_t** it;
+
+	if(unlikely(!index->enabled))
+		return;
+
+	prio = __of1x_overlap_find_prio(index, entry->priority & OF1X_2_BYTE_MASK);
+	if(unlikely(prio == NULL)){
+		assert(0);
+		return;
+	}
+
+	if(!cl){
+		__of1x_overlap_list_remove(&prio->unkeyed, entry);
+	}else{
+		for(it=&index->buckets[entry->cold->overlap_hash & (index->num_of_buckets-1)]; *it; it=&(*it)->cold->overlap_hash_next){
+			if(*it == entry){
+				*it = entry->cold->overlap_hash_next;
+				break;
+			}
+		}
+		index->num_of_entries--;
+
+		__of1x_overlap_list_remove(&cl->entries, entry);
+		if(--cl->num_of_entries == 0)
+			__of1x_overlap_release_class(prio, cl);
+	}
+
+	if(--prio->num_of_entries == 0)
+		__of1x_overlap_release_prio(index, prio);
+
+	entry->cold->overlap_class = NULL;
+}
+
+/*
+* Query
+*/
+of1x_flow_entry_t* __of1x_overlap_index_find(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry, bool check_cookie, uint32_t out_port, uint32_t out_group){
+
+	uint32_t hash;
+	of1x_overlap_index_t* index = &table->overlap_index;
+	of1x_overlap_prio_t* prio;
+	of1x_overlap_class_t* cl;
+	of1x_flow_entry_t* it;
+	of1x_match_t* match;
+	of1x_overlap_field_t value, mask;
+
+	assert(index->enabled);
+
+	prio = __of1x_overlap_find_prio(index, entry->priority & OF1X_2_BYTE_MASK);
+	if(!prio)
+		return NULL;
+
+	//Entries without matches
+	for(it=prio->unkeyed; it; it=it->cold->overlap_next){
+		if(__of1x_flow_entry_check_overlap(it, entry, true, check_cookie, out_port, out_group))
+			return it;
+	}
+
+	for(cl=prio->classes; cl; cl=cl->next){
+		match = __of1x_overlap_get_match(entry, cl->type);
+
+		if(match){
+			__of1x_overlap_get_field(&match->__tern, &value, &mask);
+			if(__of1x_overlap_field_covers(&mask, &cl->mask)){
+				//Only the entries of the class with the same value (under the class mask) can overlap
+				value.hi &= cl->mask.hi;
+				value.lo &= cl->mask.lo;
+				hash = __of1x_overlap_hash(cl, &value);
+				for(it=index->buckets[hash & (index->num_of_buckets-1)]; it; it=it->cold->overlap_hash_next){
+					if(it->cold->overlap_hash != hash || it->cold->overlap_class != cl)
+						continue;
+					if(__of1x_flow_entry_check_overlap(it, entry, true, check_cookie, out_port, out_group))
+						return it;
+				}
+				continue;
+			}
+		}
+
+		//Wildcarded (or wider) on the key field; check the whole class
+		for(it=cl->entries; it; it=it->cold->overlap_next){
+			if(__of1x_flow_entry_check_overlap(it, entry, true, check_cookie, out_port, out_group))
+				return it;
+		}
+	}
+
+	return NULL;
+}
+
+void __of1x_dump_overlap_index(of1x_overlap_index_t* index){
+
+	unsigned int i, num_of_prios = 0, num_of_classes = 0;
+	of1x_overlap_prio_t* prio;
+	of1x_overlap_class_t* cl;
+
+	if(!index->enabled)
+		return;
+
+	for(i=0;i<OF1X_OVERLAP_INDEX_PRIO_BUCKETS;i++){
+		for(prio=index->prios[i]; prio; prio=prio->next){
+			num_of_prios++;
+			for(cl=prio->classes; cl; cl=cl->next)
+				num_of_classes++;
+		}
+	}
+
+	ROFL_PIPELINE_INFO("\tOverlap index {priorities: %u, classes: %u, keyed entries: %u, buckets: %u}\n", num_of_prios, num_of_classes, index->num_of_entries, index->num_of_buckets);
+}
@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_OVERLAP_INDEXH__
+#define __OF1X_OVERLAP_INDEXH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include "rofl_datapath.h"
+#include "of1x_match.h"
+
+/**
+* @file of1x_overlap_index.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 per-table overlap-check index
+*
+* The overlap index speeds up the OFPFF_CHECK_OVERLAP check of flow-mod adds,
+* which otherwise compares the new entry pairwise against all the entries of
+* the same priority.
+*
+* Within a priority, each entry is keyed by one of its matches (the one with
+* the widest mask). Entries keyed by the same field and mask form a class, and
+* are hashed by their (masked) value. Two entries can only overlap if they
+* agree on the bits of the key mask, so for each class of the priority the
+* check is a single hash lookup whenever the new entry matches the key field
+* with a mask that covers the key mask (e.g. exact matches), and a scan of the
+* class otherwise. Entries without matches are always checked. Candidates are
+* verified with __of1x_flow_entry_check_overlap().
+*
+* The index is maintained by the matching algorithms on entry addition and
+* removal and it is only used with table->mutex held.
+*/
+
+//Initial number of buckets (MUST be a power of 2)
+#define OF1X_OVERLAP_INDEX_INITIAL_BUCKETS 64
+//Number of priority buckets (MUST be a power of 2)
+#define OF1X_OVERLAP_INDEX_PRIO_BUCKETS 256
+//Grow when num_of_entries > num_of_buckets*OF1X_OVERLAP_INDEX_MAX_LOAD
+#define OF1X_OVERLAP_INDEX_MAX_LOAD 2
+
+//fwd decl
+struct of1x_flow_entry;
+struct of1x_flow_table;
+
+/**
+* Normalized (up to 128 bit) value or mask of a field
+*/
+typedef struct of1x_overlap_field{
+	uint64_t hi;
+	uint64_t lo;
+}of1x_overlap_field_t;
+
+/**
+* Entries of a priority keyed by the same field and mask
+*/
+typedef struct of1x_overlap_class{
+	of1x_match_type_t type;
+	of1x_overlap_field_t mask;
+
+	//Entries (of1x_flow_entry_t::overlap_prev/overlap_next)
+	struct of1x_flow_entry* entries;
+	unsigned int num_of_entries;
+
+	//Classes of the same priority
+	struct of1x_overlap_class* next;
+}of1x_overlap_class_t;
+
+/**
+* Per priority state
+*/
+typedef struct of1x_overlap_prio{
+	uint16_t priority;
+
+	of1x_overlap_class_t* classes;
+
+	//Entries without matches
+	struct of1x_flow_entry* unkeyed;
+
+	unsigned int num_of_entries;
+
+	//Hash chaining
+	struct of1x_overlap_prio* next;
+}of1x_overlap_prio_t;
+
+/**
+* Per table overlap index state
+*/
+typedef struct of1x_overlap_index{
+	//Set to false if the index could not be maintained (no memory)
+	bool enabled;
+
+	//Priorities
+	of1x_overlap_prio_t** prios;
+
+	//Keyed entries by (class, value) (of1x_flow_entry_t::overlap_hash_next)
+	struct of1x_flow_entry** buckets;
+	unsigned int num_of_buckets;
+	unsigned int num_of_entries;
+}of1x_overlap_index_t;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Init and destroy (table)
+*/
+rofl_result_t __of1x_init_overlap_index(of1x_overlap_index_t* index);
+void __of1x_destroy_overlap_index(of1x_overlap_index_t* index);
+
+/*
+* Accounting of entries. Shall be called by the matching algorithm on entry
+* addition/removal while holding table->mutex
+*/
+void __of1x_overlap_index_add_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+void __of1x_overlap_index_remove_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+
+/**
+* Looks for an entry of the table overlapping with entry (same semantics as
+* __of1x_flow_entry_check_overlap() with check_priority). Requires table->mutex
+* and an enabled index.
+*/
+struct of1x_flow_entry* __of1x_overlap_index_find(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry, bool check_cookie, uint32_t out_port, uint32_t out_group);
+
+/*
+* Dump
+*/
+void __of1x_dump_overlap_index(of1x_overlap_index_t* index);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_OVERLAP_INDEX
@@ -35,6 +35,8 @@ rofl_result_t __of1x_init_pipeline(struct of1x_switch* sw, const unsigned int nu
 	pipeline->sw = sw;
 	pipeline->num_of_tables = num_of_tables;
 	pipeline->num_of_buffers = 0; //Should be filled in the post_init hook
+	pipeline->latency = NULL;
+	pipeline->timeout_budget = 0;
 
 
 	//Allocate tables and initialize	
@@ -89,6 +91,9 @@ rofl_result_t __of1x_destroy_pipeline(of1x_pipeline_t* pipeline){
 
 	int i;
 	
+	//Latency histograms (no packets in the pipeline)
+	__of1x_destroy_latency(pipeline);
+
 	//destrouy groups
 	of1x_destroy_group_table(pipeline->groups);
 	
@@ -187,6 +192,7 @@ rofl_result_t __of1x_pipeline_get_snapshot(of1x_pipeline_t* pipeline, of1x_pipel
 
 	//Cleanup stuff coming from the cloning process
 	sn->sw = NULL;		
+	sn->latency = NULL;
 
 	//Allocate tables and initialize	
 	sn->tables = (of1x_flow_table_t*)platform_malloc_shared(sizeof(of1x_flow_table_t)*pipeline->num_of_tables);
@@ -209,15 +215,22 @@ rofl_result_t __of1x_pipeline_get_snapshot(of1x_pipeline_t* pipeline, of1x_pipel
 		//Memset to 0
 		memset(&t->stats,0,sizeof(of1x_stats_table_t));
 	
-		//Assign consolidated
-		t->stats.s.counters = c;	
+		//Assign consolidated (own counters)
+		if(unlikely(__of1x_stats_slab_alloc(&__of1x_stats_table_slab, &t->stats.__id) != ROFL_SUCCESS)){
+			while(i-- > 0)
+				__of1x_stats_slab_free(&__of1x_stats_table_slab, sn->tables[i].stats.__id);
+			platform_free_shared(sn->tables);
+			return ROFL_FAILURE;
+		}
+		*__of1x_stats_table_counters(&t->stats, 0) = c;	
 		
 		t->pipeline = t->rwlock = t->mutex = t->matching_aux[0] = t->matching_aux[1] = NULL;
-		
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS	
-#else
-		t->timers = NULL;
-#endif
+		__of1x_init_miss_filter(&t->miss_filter);
+		memset(&t->strict_index, 0, sizeof(of1x_strict_index_t));
+		__of1x_init_cookie_index(&t->cookie_index);
+		memset(&t->reverse_index, 0, sizeof(of1x_reverse_index_t));
+		memset(&t->overlap_index, 0, sizeof(of1x_overlap_index_t));
+		memset(&t->timers, 0, sizeof(of1x_timer_wheel_t));
 	}
 	
 	//TODO: deep entry copy?
@@ -244,7 +257,11 @@ rofl_result_t __of1x_pipeline_get_snapshot(of1x_pipeline_t* pipeline, of1x_pipel
 
 //Destroy a previously getd snapshot
 void __of1x_pipeline_destroy_snapshot(of1x_pipeline_snapshot_t* sn){
+	unsigned int i;
+
 	//Release tables memory
+	for(i=0;i<sn->num_of_tables;i++)
+		__of1x_stats_slab_free(&__of1x_stats_table_slab, sn->tables[i].stats.__id);
 	platform_free_shared(sn->tables);
 	platform_free_shared(sn->groups);
 }
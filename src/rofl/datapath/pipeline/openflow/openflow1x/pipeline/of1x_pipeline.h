@@ -9,6 +9,7 @@
 #include "rofl_datapath.h" 
 #include "of1x_flow_table.h"
 #include "of1x_group_table.h"
+#include "of1x_latency.h"
 #include "../../../common/bitmap.h"
 #include "../../../common/datapacket.h"
 #include "../../of_switch.h"
@@ -67,6 +68,12 @@ typedef struct of1x_pipeline{
 	//Group table
 	of1x_group_table_t* groups;
 
+	//Latency histograms (NULL if disabled)
+	of1x_latency_t* latency;
+
+	//Max. timers expired per table per timeout processing call (0: unlimited)
+	unsigned int timeout_budget;
+
 	//Reference back
 	struct of1x_switch* sw;	
 }of1x_pipeline_t;
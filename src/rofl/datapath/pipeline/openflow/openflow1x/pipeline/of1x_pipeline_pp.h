@@ -10,6 +10,9 @@
 #include "../of1x_switch.h"
 #include "of1x_pipeline.h"
 #include "of1x_flow_table_pp.h"
+#include "of1x_miss_filter_pp.h"
+#include "of1x_heavy_hitters_pp.h"
+#include "of1x_latency_pp.h"
 #include "of1x_instruction_pp.h"
 #include "of1x_statistics_pp.h"
 
@@ -49,12 +52,17 @@ ROFL_BEGIN_DECLS
 * Packet processing through pipeline
 *
 */
-static inline void __of1x_process_packet_pipeline(const unsigned int tid, const of_switch_t *sw, datapacket_t *const pkt){
+static inline void __of1x_process_packet_pipeline_tables(const unsigned int tid, const of_switch_t *sw, datapacket_t *const pkt){
 
 	//Loop over tables
 	unsigned int i, table_to_go, num_of_outputs;
+	uint32_t weight;
+	uint64_t start;
 	of1x_flow_table_t* table;
 	of1x_flow_entry_t* match;
+	of1x_instruction_group_t* inst_grp;
+	bool filtered;
+	of1x_latency_t* lat = __of1x_latency_get(((of1x_switch_t*)sw)->pipeline.latency);
 	
 	//Initialize packet for OF1.X pipeline processing 
 	__init_packet_metadata(pkt);
@@ -69,17 +77,21 @@ static inline void __of1x_process_packet_pipeline(const unsigned int tid, const
 
 		table = &((of1x_switch_t*)sw)->pipeline.tables[i];
 
-#ifdef ROFL_PIPELINE_LOCKLESS
-		//Mark core presence 
-		tid_mark_as_present(tid, &table->tid_presence_mask);
-#endif
-
 #ifdef DEBUG
 		dump_packet_matches(pkt, false);
 #endif
 	
-		//Perform lookup	
-		match = __of1x_find_best_match_table(tid, (of1x_flow_table_t* const)table, pkt);
+		//Heavy hitter detection (if enabled)
+		__of1x_hh_update(tid, table, pkt);
+
+		//Perform lookup, unless the miss filter guarantees there is no match
+		start = __of1x_latency_start(lat);
+		filtered = __of1x_miss_filter_is_definite_miss(table, pkt);
+		if(filtered)
+			match = NULL;
+		else
+			match = __of1x_find_best_match_table(tid, (of1x_flow_table_t* const)table, pkt);
+		__of1x_latency_end(tid, lat, OF1X_LATENCY_STAGE_LOOKUP+i, start);
 
 		if(likely(match != NULL)){
 
@@ -88,43 +100,33 @@ static inline void __of1x_process_packet_pipeline(const unsigned int tid, const
 
 			ROFL_PIPELINE_INFO("Packet[%p] matched at table: %u, entry: %p\n", pkt, i,match);
 
-			//Update table and entry statistics
-			__of1x_stats_table_update_match(tid, &table->stats);
+			//Update table and entry statistics (weight: table statistics mode)
+			weight = __of1x_stats_table_update_match(tid, &table->stats);
 			
 			//Update flow statistics
-			__of1x_stats_flow_update_match(tid, &match->stats, platform_packet_get_size_bytes(pkt));
+			__of1x_stats_flow_update_match(tid, &match->stats, weight, platform_packet_get_size_bytes(pkt));
+
+			//Current version of the instructions (single load; modifications publish a new one)
+			inst_grp = match->pp_inst_grp;
 
 			//Process instructions
-			table_to_go = __of1x_process_instructions(tid, (of1x_switch_t*)sw, i, pkt, &match->inst_grp);
+			start = __of1x_latency_start(lat);
+			table_to_go = __of1x_process_instructions(tid, (of1x_switch_t*)sw, i, pkt, inst_grp);
+			__of1x_latency_end(tid, lat, OF1X_LATENCY_STAGE_INSTRUCTIONS, start);
 
 			if(table_to_go > i && likely(table_to_go < OF1X_MAX_FLOWTABLES)){
 
 				ROFL_PIPELINE_INFO("Packet[%p] Going to table %u->%u\n",pkt, i,table_to_go);
 				i = table_to_go-1;
-
-#ifdef ROFL_PIPELINE_LOCKLESS
-				//Unmark core presence in the table
-				tid_mark_as_not_present(tid, &table->tid_presence_mask);
-#else
-				//Unlock the entry so that it can eventually be modified/deleted
-				platform_rwlock_rdunlock(match->rwlock);
-#endif
 				continue;
 			}
 
 			//Process WRITE actions
-			__of1x_process_write_actions(tid, (of1x_switch_t*)sw, i, pkt, __of1x_process_instructions_must_replicate(&match->inst_grp));
+			start = __of1x_latency_start(lat);
+			__of1x_process_write_actions(tid, (of1x_switch_t*)sw, i, pkt, __of1x_process_instructions_must_replicate(inst_grp));
+			__of1x_latency_end(tid, lat, OF1X_LATENCY_STAGE_WRITE_ACTIONS, start);
 
-			//Recover the num_of_outputs to release the lock asap
-			num_of_outputs = match->inst_grp.num_of_outputs;
-
-#ifdef ROFL_PIPELINE_LOCKLESS
-			//Unmark core presence in the table
-			tid_mark_as_not_present(tid, &table->tid_presence_mask);
-#else
-			//Unlock the entry so that it can eventually be modified/deleted
-			platform_rwlock_rdunlock(match->rwlock);
-#endif
+			num_of_outputs = inst_grp->num_of_outputs;
 
 			//Drop packet Only if there has been copy(cloning of the packet) due to 
 			//multiple output actions
@@ -133,13 +135,11 @@ static inline void __of1x_process_packet_pipeline(const unsigned int tid, const
 							
 			return;	
 		}else{
-#ifdef ROFL_PIPELINE_LOCKLESS
-			//Unmark core presence in the table
-			tid_mark_as_not_present(tid, &table->tid_presence_mask);
-#endif
-
 			//Update table statistics
-			__of1x_stats_table_update_no_match(tid, &table->stats);
+			if(filtered)
+				__of1x_stats_table_update_filtered_miss(tid, &table->stats);
+			else
+				__of1x_stats_table_update_no_match(tid, &table->stats);
 
 			//Not matched, look for table_miss behaviour 
 			if(table->default_action == OF1X_TABLE_MISS_DROP){
@@ -164,6 +164,31 @@ static inline void __of1x_process_packet_pipeline(const unsigned int tid, const
 
 }
 
+/*
+* Entries, instructions and matching algorithm state are read without locks
+* (RCU); writers unlink or publish new versions and release the old ones once
+* the threads in the pipeline have gone through a quiescent state.
+*/
+static inline void __of1x_process_packet_pipeline(const unsigned int tid, const of_switch_t *sw, datapacket_t *const pkt){
+
+	uint64_t start;
+	of1x_latency_t* lat;
+
+	//Mark core presence (once per pipeline pass; no-op if the platform already did it for the burst)
+	tid_epoch_enter(tid);
+
+	//Latency histograms are read under the epoch (RCU)
+	lat = __of1x_latency_get(((of1x_switch_t*)sw)->pipeline.latency);
+	start = __of1x_latency_start(lat);
+
+	__of1x_process_packet_pipeline_tables(tid, sw, pkt);
+
+	__of1x_latency_end(tid, lat, OF1X_LATENCY_STAGE_PIPELINE, start);
+
+	//Quiescent
+	tid_epoch_exit(tid);
+}
+
 /**
 * @brief Processes a packet-out through the OpenFlow pipeline.  
 * @ingroup core_pp 
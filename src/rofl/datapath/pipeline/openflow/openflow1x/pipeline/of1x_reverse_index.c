@@ -0,0 +1,312 @@
+#include "of1x_reverse_index.h"
+
+#include <assert.h>
+#include "../../../platform/likely.h"
+#include "../../../platform/memory.h"
+#include "../../../util/logging.h"
+
+#include "of1x_flow_entry.h"
+#include "of1x_flow_table.h"
+#include "of1x_group_table.h"
+
+static inline uint32_t __of1x_reverse_index_hash(of1x_packet_action_type_t type, uint32_t id){
+	return (id * 0x9E3779B1) ^ (uint32_t)type;
+}
+
+rofl_result_t __of1x_init_reverse_index(of1x_reverse_index_t* index){
+	index->buckets = (of1x_reverse_key_t**)platform_malloc_shared(sizeof(of1x_reverse_key_t*)*OF1X_REVERSE_INDEX_INITIAL_BUCKETS);
+	if(unlikely(index->buckets == NULL))
+		return ROFL_FAILURE;
+
+	platform_memset(index->buckets, 0, sizeof(of1x_reverse_key_t*)*OF1X_REVERSE_INDEX_INITIAL_BUCKETS);
+	index->num_of_buckets = OF1X_REVERSE_INDEX_INITIAL_BUCKETS;
+	index->num_of_keys = 0;
+	index->enabled = true;
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_destroy_reverse_index(of1x_reverse_index_t* index){
+
+	unsigned int i;
+	of1x_reverse_key_t *key, *next_key;
+	of1x_reverse_ref_t *ref, *next_ref;
+
+	if(index->buckets){
+		for(i=0;i<index->num_of_buckets;i++){
+			for(key=index->buckets[i]; key; key=next_key){
+				next_key = key->next;
+				for(ref=key->refs; ref; ref=next_ref){
+					next_ref = ref->next;
+					platform_free_shared(ref);
+				}
+				platform_free_shared(key);
+			}
+		}
+		platform_free_shared(index->buckets);
+	}
+
+	index->enabled = false;
+	index->buckets = NULL;
+	index->num_of_buckets = index->num_of_keys = 0;
+}
+
+/*
+* Keys
+*/
+static of1x_reverse_key_t* __of1x_reverse_index_find_key(of1x_reverse_index_t* index, of1x_packet_action_type_t type, uint32_t id){
+	of1x_reverse_key_t* it;
+
+	for(it=index->buckets[__of1x_reverse_index_hash(type, id) & (index->num_of_buckets-1)]; it; it=it->next){
+		if(it->id == id && it->type == type)
+			return it;
+	}
+	return NULL;
+}
+
+//Doubles the number of buckets. On allocation failure chains just get longer
+static void __of1x_reverse_index_grow(of1x_reverse_index_t* index){
+
+	unsigned int i, slot, num_of_buckets = index->num_of_buckets*2;
+	of1x_reverse_key_t **buckets, *it, *next;
+
+	buckets = (of1x_reverse_key_t**)platform_malloc_shared(sizeof(of1x_reverse_key_t*)*num_of_buckets);
+	if(unlikely(buckets == NULL))
+		return;
+	platform_memset(buckets, 0, sizeof(of1x_reverse_key_t*)*num_of_buckets);
+
+	for(i=0;i<index->num_of_buckets;i++){
+		for(it=index->buckets[i]; it; it=next){
+			next = it->next;
+			slot = __of1x_reverse_index_hash(it->type, it->id) & (num_of_buckets-1);
+			it->next = buckets[slot];
+			buckets[slot] = it;
+		}
+	}
+
+	platform_free_shared(index->buckets);
+	index->buckets = buckets;
+	index->num_of_buckets = num_of_buckets;
+}
+
+static of1x_reverse_key_t* __of1x_reverse_index_get_key(of1x_reverse_index_t* index, of1x_packet_action_type_t type, uint32_t id){
+
+	unsigned int slot;
+	of1x_reverse_key_t* key = __of1x_reverse_index_find_key(index, type, id);
+
+	if(key)
+		return key;
+
+	key = (of1x_reverse_key_t*)platform_malloc_shared(sizeof(of1x_reverse_key_t));
+	if(unlikely(key == NULL))
+		return NULL;
+
+	if(index->num_of_keys >= index->num_of_buckets)
+		__of1x_reverse_index_grow(index);
+
+	key->type = type;
+	key->id = id;
+	key->refs = NULL;
+	key->num_of_refs = 0;
+	slot = __of1x_reverse_index_hash(type, id) & (index->num_of_buckets-1);
+	key->next = index->buckets[slot];
+	index->buckets[slot] = key;
+	index->num_of_keys++;
+
+	return key;
+}
+
+static void __of1x_reverse_index_release_key(of1x_reverse_index_t* index, of1x_reverse_key_t* key){
+
+	of1x_reverse_key_t** it;
+
+	for(it=&index->buckets[__of1x_reverse_index_hash(key->type, key->id) & (index->num_of_buckets-1)]; *it; it=&(*it)->next){
+		if(*it == key){
+			*it = key->next;
+			break;
+		}
+	}
+	index->num_of_keys--;
+	platform_free_shared(key);
+}
+
+/*
+* Tears down the index of a table at runtime (e.g. on allocation failure).
+* Entries must no longer refer to the released index nodes
+*/
+static void __of1x_reverse_index_disable(of1x_flow_table_t *const table){
+
+	of1x_flow_entry_t* entry;
+
+	//All matching algorithms keep the table->entries list
+	for(entry=table->entries; entry; entry=entry->next)
+		entry->cold->out_refs = NULL;
+
+	__of1x_destroy_reverse_index(&table->reverse_index);
+}
+
+/*
+* Entry accounting
+*/
+static rofl_result_t __of1x_reverse_index_add_ref(of1x_reverse_index_t* index, of1x_flow_entry_t *const entry, of1x_packet_action_type_t type, uint32_t id){
+
+	of1x_reverse_key_t* key;
+	of1x_reverse_ref_t* ref;
+
+	//Skip duplicates (e.g. apply and write actions outputting to the same port)
+	for(ref=entry->cold->out_refs; ref; ref=ref->entry_next){
+		if(ref->key->id == id && ref->key->type == type)
+			return ROFL_SUCCESS;
+	}
+
+	key = __of1x_reverse_index_get_key(index, type, id);
+	if(unlikely(key == NULL))
+		return ROFL_FAILURE;
+
+	ref = (of1x_reverse_ref_t*)platform_malloc_shared(sizeof(of1x_reverse_ref_t));
+	if(unlikely(ref == NULL)){
+		if(key->num_of_refs == 0)
+			__of1x_reverse_index_release_key(index, key);
+		return ROFL_FAILURE;
+	}
+
+	ref->entry = entry;
+	ref->key = key;
+	ref->prev = NULL;
+	ref->next = key->refs;
+	if(key->refs)
+		key->refs->prev = ref;
+	key->refs = ref;
+	key->num_of_refs++;
+
+	ref->entry_next = entry->cold->out_refs;
+	entry->cold->out_refs = ref;
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_reverse_index_add_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_reverse_index_t* index = &table->reverse_index;
+	of1x_action_group_t* apply_actions;
+	of1x_write_actions_t* write_actions;
+	of1x_packet_action_t* action;
+	rofl_result_t res = ROFL_SUCCESS;
+
+	entry->cold->out_refs = NULL;
+
+	if(unlikely(!index->enabled))
+		return;
+
+	//Apply actions
+	apply_actions = entry->inst_grp.instructions[OF1X_IT_APPLY_ACTIONS].apply_actions;
+	if(apply_actions){
+		for(action=apply_actions->head; action && res == ROFL_SUCCESS; action=action->next){
+			if(action->type == OF1X_AT_OUTPUT || action->type == OF1X_AT_GROUP)
+				res = __of1x_reverse_index_add_ref(index, entry, action->type, action->__field.u32);
+		}
+	}
+
+	//Write actions
+	write_actions = entry->inst_grp.instructions[OF1X_IT_WRITE_ACTIONS].write_actions;
+	if(write_actions && res == ROFL_SUCCESS){
+		if(bitmap128_is_bit_set(&write_actions->bitmap, OF1X_AT_OUTPUT))
+			res = __of1x_reverse_index_add_ref(index, entry, OF1X_AT_OUTPUT, write_actions->actions[OF1X_AT_OUTPUT].__field.u32);
+		if(res == ROFL_SUCCESS && bitmap128_is_bit_set(&write_actions->bitmap, OF1X_AT_GROUP))
+			res = __of1x_reverse_index_add_ref(index, entry, OF1X_AT_GROUP, write_actions->actions[OF1X_AT_GROUP].__field.u32);
+	}
+
+	if(unlikely(res != ROFL_SUCCESS)){
+		//The index would no longer be complete
+		ROFL_PIPELINE_ERR("%s: unable to allocate memory. Disabling reverse index of table %u\n", __func__, table->number);
+		__of1x_reverse_index_disable(table);
+	}
+}
+
+void __of1x_reverse_index_remove_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+
+	of1x_reverse_index_t* index = &table->reverse_index;
+	of1x_reverse_ref_t *ref, *next;
+	of1x_reverse_key_t* key;
+
+	if(unlikely(!index->enabled))
+		return;
+
+	for(ref=entry->cold->out_refs; ref; ref=next){
+		next = ref->entry_next;
+		key = ref->key;
+
+		if(ref->prev)
+			ref->prev->next = ref->next;
+		else
+			key->refs = ref->next;
+		if(ref->next)
+			ref->next->prev = ref->prev;
+
+		if(--key->num_of_refs == 0)
+			__of1x_reverse_index_release_key(index, key);
+
+		platform_free_shared(ref);
+	}
+
+	entry->cold->out_refs = NULL;
+}
+
+void __of1x_reverse_index_update_entry(of1x_flow_table_t *const table, of1x_flow_entry_t *const entry){
+	__of1x_reverse_index_remove_entry(table, entry);
+	__of1x_reverse_index_add_entry(table, entry);
+}
+
+/*
+* Queries
+*/
+bool __of1x_reverse_index_usable(of1x_flow_table_t *const table, uint32_t out_port, uint32_t out_group){
+	return table->reverse_index.enabled && (out_port != OF1X_PORT_ANY || out_group != OF1X_GROUP_ANY);
+}
+
+of1x_flow_entry_t* __of1x_reverse_index_find_first(of1x_flow_table_t *const table, of1x_packet_action_type_t type, uint32_t id){
+
+	of1x_reverse_key_t* key;
+
+	assert(table->reverse_index.enabled);
+
+	key = __of1x_reverse_index_find_key(&table->reverse_index, type, id);
+
+	return (key)? key->refs->entry : NULL;
+}
+
+rofl_result_t __of1x_reverse_index_get_entries(of1x_flow_table_t *const table, uint32_t out_port, uint32_t out_group, of1x_flow_entry_t*** entries, unsigned int* num_of_entries){
+
+	unsigned int i;
+	of1x_reverse_key_t* key;
+	of1x_reverse_ref_t* ref;
+
+	assert(__of1x_reverse_index_usable(table, out_port, out_group));
+
+	if(out_port != OF1X_PORT_ANY)
+		key = __of1x_reverse_index_find_key(&table->reverse_index, OF1X_AT_OUTPUT, out_port);
+	else
+		key = __of1x_reverse_index_find_key(&table->reverse_index, OF1X_AT_GROUP, out_group);
+
+	//Always return a valid array
+	*entries = (of1x_flow_entry_t**)platform_malloc_shared(sizeof(of1x_flow_entry_t*)*((key)? key->num_of_refs : 1));
+	if(unlikely(*entries == NULL))
+		return ROFL_FAILURE;
+
+	i = 0;
+	if(key){
+		for(ref=key->refs; ref; ref=ref->next)
+			(*entries)[i++] = ref->entry;
+	}
+	*num_of_entries = i;
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_dump_reverse_index(of1x_reverse_index_t* index){
+
+	if(!index->enabled)
+		return;
+
+	ROFL_PIPELINE_INFO("\tReverse index {ports and groups referred: %u, buckets: %u}\n", index->num_of_keys, index->num_of_buckets);
+}
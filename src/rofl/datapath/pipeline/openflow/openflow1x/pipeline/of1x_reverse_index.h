@@ -0,0 +1,122 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __OF1X_REVERSE_INDEXH__
+#define __OF1X_REVERSE_INDEXH__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "of1x_action.h"
+
+/**
+* @file of1x_reverse_index.h
+* @brief OpenFlow v1.0, 1.2 and 1.3.2 per-table output port and group reverse index
+*
+* The reverse index maps output ports (OF1X_AT_OUTPUT) and groups (OF1X_AT_GROUP)
+* to the entries of the table whose instructions (apply or write actions) refer to
+* them. It allows group deletion, port flushing and out_port/out_group filtered
+* flow-mods and stats to only visit the relevant entries.
+*
+* The index is maintained by the matching algorithms on entry addition and
+* removal, and on instruction update (__of1x_update_flow_entry()). It is only
+* used with table->mutex held.
+*/
+
+//Initial number of buckets (MUST be a power of 2)
+#define OF1X_REVERSE_INDEX_INITIAL_BUCKETS 64
+
+//fwd decl
+struct of1x_flow_entry;
+struct of1x_flow_table;
+struct of1x_reverse_key;
+
+/**
+* Reference from a key (port or group) to an entry
+*/
+typedef struct of1x_reverse_ref{
+	struct of1x_flow_entry* entry;
+	struct of1x_reverse_key* key;
+
+	//Refs of the same key
+	struct of1x_reverse_ref* prev;
+	struct of1x_reverse_ref* next;
+
+	//Refs of the same entry
+	struct of1x_reverse_ref* entry_next;
+}of1x_reverse_ref_t;
+
+/**
+* Output port or group
+*/
+typedef struct of1x_reverse_key{
+	of1x_packet_action_type_t type; //OF1X_AT_OUTPUT or OF1X_AT_GROUP
+	uint32_t id;
+
+	of1x_reverse_ref_t* refs;
+	unsigned int num_of_refs;
+
+	//Hash chaining
+	struct of1x_reverse_key* next;
+}of1x_reverse_key_t;
+
+/**
+* Per table reverse index state
+*/
+typedef struct of1x_reverse_index{
+	//Set to false if the index could not be maintained (no memory)
+	bool enabled;
+
+	of1x_reverse_key_t** buckets;
+	unsigned int num_of_buckets;
+	unsigned int num_of_keys;
+}of1x_reverse_index_t;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/*
+* Init and destroy (table)
+*/
+rofl_result_t __of1x_init_reverse_index(of1x_reverse_index_t* index);
+void __of1x_destroy_reverse_index(of1x_reverse_index_t* index);
+
+/*
+* Accounting of entries. Shall be called while holding table->mutex
+*/
+void __of1x_reverse_index_add_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+void __of1x_reverse_index_remove_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+void __of1x_reverse_index_update_entry(struct of1x_flow_table *const table, struct of1x_flow_entry *const entry);
+
+/**
+* Checks if the index can be used to enumerate the candidates of an
+* out_port/out_group filter
+*/
+bool __of1x_reverse_index_usable(struct of1x_flow_table *const table, uint32_t out_port, uint32_t out_group);
+
+/**
+* Retrieves the first entry referring to the port (OF1X_AT_OUTPUT) or group (OF1X_AT_GROUP). Requires table->mutex
+*/
+struct of1x_flow_entry* __of1x_reverse_index_find_first(struct of1x_flow_table *const table, of1x_packet_action_type_t type, uint32_t id);
+
+/**
+* Retrieves the entries referring to out_port or out_group (if both are set, to
+* out_port; the other filter must be checked by the caller). Requires table->mutex.
+* The array shall be released by the caller via platform_free_shared()
+*
+* @param num_of_entries Number of entries in the array (may be 0)
+* @retval ROFL_FAILURE on memory allocation failure
+*/
+rofl_result_t __of1x_reverse_index_get_entries(struct of1x_flow_table *const table, uint32_t out_port, uint32_t out_group, struct of1x_flow_entry*** entries, unsigned int* num_of_entries);
+
+/*
+* Dump
+*/
+void __of1x_dump_reverse_index(of1x_reverse_index_t* index);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //OF1X_REVERSE_INDEX
@@ -1,13 +1,17 @@
 #include "of1x_statistics.h"
 
 #include <assert.h> 
+#include <limits.h>
 #include "of1x_pipeline.h"
 #include "of1x_flow_table.h"
 #include "of1x_flow_entry.h"
 #include "of1x_instruction.h"
 #include "of1x_timers.h"
 #include "of1x_group_table.h"
+#include "of1x_flow_iterator.h"
+#include "../of1x_async_events_hooks.h"
 #include "../../../platform/memory.h"
+#include "../../../platform/lock.h"
 #include "../../../platform/likely.h"
 #include "../../../platform/timing.h"
 #include "../../../platform/atomic_operations.h"
@@ -21,6 +25,233 @@
  * make it easyer and logic
  */
 
+/*
+* Per thread counter slabs
+*/
+__of1x_stats_slab_t __of1x_stats_flow_slab;
+__of1x_stats_slab_t __of1x_stats_table_slab;
+__of1x_stats_slab_t __of1x_stats_group_slab;
+__of1x_stats_slab_t __of1x_stats_bucket_slab;
+
+//Serializes the management of all the slabs
+static platform_mutex_t* __of1x_stats_slabs_mutex = NULL;
+
+static void __of1x_init_stats_slab(__of1x_stats_slab_t* slab, size_t size){
+	memset(slab, 0, sizeof(__of1x_stats_slab_t));
+	slab->size = size;
+	slab->next_id = OF1X_STATS_SLAB_NO_ID+1;
+}
+
+static void __of1x_destroy_stats_slab(__of1x_stats_slab_t* slab){
+
+	unsigned int i, tid, capacity;
+	size_t size = slab->size;
+	uint8_t ***dir, ***retired;
+
+	for(i=0;i<slab->num_of_chunks;i++){
+		for(tid=0;tid<slab->num_of_tids;tid++)
+			platform_free_shared(slab->dir[i][ROFL_PIPELINE_MAX_TIDS+tid]);
+		platform_free_shared(slab->dir[i]);
+	}
+
+	for(dir=slab->dir, capacity=slab->dir_capacity; dir; dir=retired, capacity/=2){
+		retired = (uint8_t***)dir[capacity];
+		platform_free_shared(dir);
+	}
+
+	if(slab->free_ids)
+		platform_free_shared(slab->free_ids);
+
+	__of1x_init_stats_slab(slab, size);
+}
+
+//Allocates the chunks of row for TIDs [from, to)
+static rofl_result_t __of1x_stats_slab_fill_row(__of1x_stats_slab_t* slab, uint8_t** row, unsigned int from, unsigned int to){
+
+	unsigned int tid;
+	size_t chunk_size = slab->size*OF1X_STATS_SLAB_CHUNK_SLOTS;
+	uint8_t* chunk;
+
+	for(tid=from;tid<to;tid++){
+		chunk = (uint8_t*)platform_malloc_shared(chunk_size+TID_CACHE_LINE_SIZE);
+		if(unlikely(chunk == NULL)){
+			while(tid > from)
+				platform_free_shared(row[ROFL_PIPELINE_MAX_TIDS+(--tid)]);
+			return ROFL_FAILURE;
+		}
+		row[ROFL_PIPELINE_MAX_TIDS+tid] = chunk;
+		row[tid] = (uint8_t*)(((uintptr_t)chunk + TID_CACHE_LINE_SIZE-1) & ~((uintptr_t)TID_CACHE_LINE_SIZE-1));
+		platform_memset(row[tid], 0, chunk_size);
+	}
+
+	return ROFL_SUCCESS;
+}
+
+//Makes sure all the TIDs in use have chunks
+static rofl_result_t __of1x_stats_slab_set_num_of_tids(__of1x_stats_slab_t* slab){
+
+	unsigned int i;
+
+	if(slab->num_of_tids >= tid_get_num_of_tids())
+		return ROFL_SUCCESS;
+
+	for(i=0;i<slab->num_of_chunks;i++){
+		if(__of1x_stats_slab_fill_row(slab, slab->dir[i], slab->num_of_tids, tid_get_num_of_tids()) != ROFL_SUCCESS)
+			return ROFL_FAILURE;
+	}
+	slab->num_of_tids = tid_get_num_of_tids();
+
+	return ROFL_SUCCESS;
+}
+
+rofl_result_t __of1x_init_stats_slabs(void){
+
+	if(!__of1x_stats_slabs_mutex){
+		__of1x_stats_slabs_mutex = platform_mutex_init(NULL);
+		if(unlikely(__of1x_stats_slabs_mutex == NULL))
+			return ROFL_FAILURE;
+
+		__of1x_init_stats_slab(&__of1x_stats_flow_slab, sizeof(__of1x_stats_flow_tid_t));
+		__of1x_init_stats_slab(&__of1x_stats_table_slab, sizeof(__of1x_stats_table_tid_t));
+		__of1x_init_stats_slab(&__of1x_stats_group_slab, sizeof(__of1x_stats_group_tid_t));
+		__of1x_init_stats_slab(&__of1x_stats_bucket_slab, sizeof(__of1x_stats_bucket_tid_t));
+	}
+
+	if(__of1x_stats_slab_set_num_of_tids(&__of1x_stats_flow_slab) != ROFL_SUCCESS ||
+		__of1x_stats_slab_set_num_of_tids(&__of1x_stats_table_slab) != ROFL_SUCCESS ||
+		__of1x_stats_slab_set_num_of_tids(&__of1x_stats_group_slab) != ROFL_SUCCESS ||
+		__of1x_stats_slab_set_num_of_tids(&__of1x_stats_bucket_slab) != ROFL_SUCCESS)
+		return ROFL_FAILURE;
+
+	return ROFL_SUCCESS;
+}
+
+void __of1x_destroy_stats_slabs(void){
+
+	unsigned int i;
+	bool in_use = false;
+	__of1x_stats_slab_t* slabs[] = { &__of1x_stats_flow_slab, &__of1x_stats_table_slab, &__of1x_stats_group_slab, &__of1x_stats_bucket_slab };
+
+	if(!__of1x_stats_slabs_mutex)
+		return;
+
+	for(i=0;i<sizeof(slabs)/sizeof(slabs[0]);i++){
+		if(slabs[i]->num_of_ids_in_use > 0)
+			in_use = true;
+		else
+			__of1x_destroy_stats_slab(slabs[i]);
+	}
+
+	//Ids still in use can be released later on
+	if(!in_use){
+		platform_mutex_destroy(__of1x_stats_slabs_mutex);
+		__of1x_stats_slabs_mutex = NULL;
+	}
+}
+
+//Adds a chunk per TID. Requires the slabs mutex
+static rofl_result_t __of1x_stats_slab_grow(__of1x_stats_slab_t* slab){
+
+	unsigned int dir_capacity;
+	uint8_t **row, ***dir;
+
+	//Directory. Readers (including management threads consolidating
+	//counters) may be using the current one; it is retired, not released
+	if(slab->num_of_chunks == slab->dir_capacity){
+		dir_capacity = (slab->dir_capacity)? slab->dir_capacity*2 : 16;
+		dir = (uint8_t***)platform_malloc_shared(sizeof(uint8_t**)*(dir_capacity+1));
+		if(unlikely(dir == NULL))
+			return ROFL_FAILURE;
+		if(slab->dir)
+			memcpy(dir, slab->dir, sizeof(uint8_t**)*slab->num_of_chunks);
+
+		//Retired directories chain (last slot)
+		dir[dir_capacity] = (uint8_t**)slab->dir;
+
+		tid_memory_barrier();
+		slab->dir = dir;
+		slab->dir_capacity = dir_capacity;
+	}
+
+	//Row; aligned chunks first, then the allocated pointers
+	row = (uint8_t**)platform_malloc_shared(sizeof(uint8_t*)*ROFL_PIPELINE_MAX_TIDS*2);
+	if(unlikely(row == NULL))
+		return ROFL_FAILURE;
+	platform_memset(row, 0, sizeof(uint8_t*)*ROFL_PIPELINE_MAX_TIDS*2);
+
+	if(__of1x_stats_slab_fill_row(slab, row, 0, slab->num_of_tids) != ROFL_SUCCESS){
+		platform_free_shared(row);
+		return ROFL_FAILURE;
+	}
+
+	tid_memory_barrier();
+	slab->dir[slab->num_of_chunks++] = row;
+
+	return ROFL_SUCCESS;
+}
+
+rofl_result_t __of1x_stats_slab_alloc(__of1x_stats_slab_t* slab, uint32_t* id){
+
+	uint32_t* free_ids;
+	rofl_result_t res = ROFL_SUCCESS;
+
+	platform_mutex_lock(__of1x_stats_slabs_mutex);
+
+	if(slab->num_of_free_ids > 0){
+		*id = slab->free_ids[--slab->num_of_free_ids];
+	}else{
+		if( (slab->next_id >> OF1X_STATS_SLAB_CHUNK_SHIFT) >= slab->num_of_chunks )
+			res = __of1x_stats_slab_grow(slab);
+
+		//Make sure the id can always be released
+		if(res == ROFL_SUCCESS && slab->free_ids_capacity < slab->num_of_chunks*OF1X_STATS_SLAB_CHUNK_SLOTS){
+			free_ids = (uint32_t*)platform_malloc_shared(sizeof(uint32_t)*slab->num_of_chunks*OF1X_STATS_SLAB_CHUNK_SLOTS);
+			if(likely(free_ids != NULL)){
+				if(slab->free_ids){
+					memcpy(free_ids, slab->free_ids, sizeof(uint32_t)*slab->num_of_free_ids);
+					platform_free_shared(slab->free_ids);
+				}
+				slab->free_ids = free_ids;
+				slab->free_ids_capacity = slab->num_of_chunks*OF1X_STATS_SLAB_CHUNK_SLOTS;
+			}else{
+				res = ROFL_FAILURE;
+			}
+		}
+
+		if(res == ROFL_SUCCESS)
+			*id = slab->next_id++;
+	}
+
+	if(res == ROFL_SUCCESS){
+		slab->num_of_ids_in_use++;
+		__of1x_stats_slab_reset(slab, *id);
+	}
+
+	platform_mutex_unlock(__of1x_stats_slabs_mutex);
+
+	return res;
+}
+
+void __of1x_stats_slab_free(__of1x_stats_slab_t* slab, uint32_t id){
+
+	if(id == OF1X_STATS_SLAB_NO_ID)
+		return;
+
+	platform_mutex_lock(__of1x_stats_slabs_mutex);
+	assert(slab->num_of_free_ids < slab->free_ids_capacity);
+	slab->free_ids[slab->num_of_free_ids++] = id;
+	slab->num_of_ids_in_use--;
+	platform_mutex_unlock(__of1x_stats_slabs_mutex);
+}
+
+void __of1x_stats_slab_reset(__of1x_stats_slab_t* slab, uint32_t id){
+
+	unsigned int tid;
+
+	for(tid=0;tid<slab->num_of_tids;tid++)
+		platform_memset(__of1x_stats_slab_slot(slab, id, tid, slab->size), 0, slab->size);
+}
+
 //Flow Statistics functions
 /**
  * of1x_stats_flow_init
@@ -28,24 +259,30 @@
  */
 void __of1x_init_flow_stats(of1x_flow_entry_t * entry)
 {
+	struct timeval now;
+	//The mutex and the counters are owned by the entry (object pool)
+	platform_mutex_t* mutex = entry->stats.mutex;
+	uint32_t id = entry->stats.__id;
+
 	memset(&entry->stats, 0, sizeof(of1x_stats_flow_t));
+	entry->stats.mutex = mutex;
+	entry->stats.__id = id;
+	entry->stats.pp_mode = OF1X_STATS_FLOW_FULL;
+	__of1x_stats_flow_reset_counts(entry);
 
-	struct timeval now;
 	platform_gettimeofday(&now);
 	entry->stats.initial_time = now;
-	
-	entry->stats.mutex = platform_mutex_init(NULL);
 
 	return;
 }
 
 /**
  * of1x_stats_flow_destroy
- * basically destroys the mutex
+ * the mutex and the counters are kept with the entry in the object pool
  */
 void __of1x_destroy_flow_stats(of1x_flow_entry_t* entry)
 {
-	platform_mutex_destroy(entry->stats.mutex);
+	(void)entry;
 }
 
 
@@ -96,8 +333,8 @@ of1x_stats_single_flow_msg_t* __of1x_init_stats_single_flow_msg(of1x_flow_entry_
 		msg->table_id = entry->table->number;
 	msg->priority = entry->priority;
 	msg->cookie = entry->cookie;
-	msg->idle_timeout = entry->timer_info.idle_timeout;
-	msg->hard_timeout = entry->timer_info.hard_timeout;
+	msg->idle_timeout = entry->cold->timer_info.idle_timeout;
+	msg->hard_timeout = entry->cold->timer_info.hard_timeout;
 	msg->flags = entry->flags;
 	
 	//Aggregate stats
@@ -185,7 +422,55 @@ void __of1x_push_single_flow_stats_to_msg(of1x_stats_flow_msg_t* msg, of1x_stats
  * of1x_stats_flow_reset_counts
  */
 void __of1x_stats_flow_reset_counts(of1x_flow_entry_t * entry){
-	memset(&entry->stats.s,0,sizeof(union __of1x_stats_flow_tids));
+	__of1x_stats_slab_reset(&__of1x_stats_flow_slab, entry->stats.__id);
+}
+
+void __of1x_stats_flow_set_mode(of1x_flow_entry_t* entry, of1x_flow_table_t* table){
+
+	uint8_t pp_mode;
+
+	switch(table->stats.mode){
+		case OF1X_STATS_MODE_PACKETS_ONLY:
+			pp_mode = OF1X_STATS_FLOW_PKTS;
+			break;
+		case OF1X_STATS_MODE_OFF:
+			pp_mode = 0x0;
+			break;
+		default:
+			pp_mode = OF1X_STATS_FLOW_FULL;
+			break;
+	}
+
+	if(entry->flags & OF1X_FLOW_FLAG_NO_PKT_COUNTS)
+		pp_mode &= ~OF1X_STATS_FLOW_PKTS;
+	if(entry->flags & OF1X_FLOW_FLAG_NO_BYT_COUNTS)
+		pp_mode &= ~OF1X_STATS_FLOW_BYTES;
+
+	//Idle timeouts rely on the last used timestamps (if enabled) or on the
+	//packet counts, unless they are not (exactly) kept
+	if(entry->cold->timer_info.idle_timeout){
+		if(table->timers.idle_timestamps)
+			pp_mode |= OF1X_STATS_FLOW_LAST_USED;
+		else if( !(pp_mode & OF1X_STATS_FLOW_PKTS) || table->stats.mode == OF1X_STATS_MODE_SAMPLED )
+			pp_mode |= OF1X_STATS_FLOW_IDLE_HIT;
+	}
+
+	entry->stats.pp_mode = pp_mode;
+}
+
+bool __of1x_stats_flow_test_and_clear_idle_hit(of1x_stats_flow_t* stats){
+
+	unsigned int tid;
+	bool hit = false;
+	__of1x_stats_flow_tid_t* s;
+
+	for(tid=0;tid<tid_get_num_of_tids();tid++){
+		s = __of1x_stats_flow_counters(stats, tid);
+		if(s->idle_hit && __sync_lock_test_and_set(&s->idle_hit, 0) != 0)
+			hit = true;
+	}
+
+	return hit;
 }
 
 /**
@@ -207,12 +492,20 @@ void of1x_stats_flow_get_duration(struct of1x_flow_entry * entry, uint32_t* sec,
 /**
  * Initializes table statistics state
  */
-void __of1x_stats_table_init(of1x_flow_table_t * table){
+rofl_result_t __of1x_stats_table_init(of1x_flow_table_t * table){
 	
 	memset(&table->stats, 0, sizeof(of1x_stats_table_t));
 
+	if(unlikely(__of1x_stats_slab_alloc(&__of1x_stats_table_slab, &table->stats.__id) != ROFL_SUCCESS))
+		return ROFL_FAILURE;
+
+	table->stats.mode = OF1X_STATS_MODE_FULL;
+	table->stats.sampling_rate = 1;
+
 	//Stats mutex	
 	table->stats.mutex = platform_mutex_init(NULL);
+
+	return ROFL_SUCCESS;
 }
 
 /**
@@ -221,20 +514,214 @@ void __of1x_stats_table_init(of1x_flow_table_t * table){
 void __of1x_stats_table_destroy(of1x_flow_table_t * table){
 
 	platform_mutex_destroy(table->stats.mutex);
+	__of1x_stats_slab_free(&__of1x_stats_table_slab, table->stats.__id);
+}
+
+rofl_result_t of1x_set_table_stats_mode(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_stats_mode_t mode, uint32_t sampling_rate){
+
+	of1x_flow_table_t* table;
+	of1x_flow_entry_t* entry;
+
+	//Verify arguments
+	if(unlikely(table_id >= pipeline->num_of_tables) || mode > OF1X_STATS_MODE_OFF)
+		return ROFL_FAILURE;
+	if(mode == OF1X_STATS_MODE_SAMPLED && sampling_rate == 0)
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	//Serialize with flow_mods
+	platform_mutex_lock(table->mutex);
+
+	table->stats.sampling_rate = (mode == OF1X_STATS_MODE_SAMPLED)? sampling_rate : 1;
+	tid_memory_barrier();
+	table->stats.mode = mode;
+
+	//Entries (all matching algorithms keep the table->entries list)
+	for(entry = table->entries; entry; entry = entry->next)
+		__of1x_stats_flow_set_mode(entry, table);
+
+	platform_mutex_unlock(table->mutex);
+
+	return ROFL_SUCCESS;
+}
+
+/*
+* Flow rates
+*/
+
+//Sweep of a table (of1x_sample_flow_rates())
+typedef struct __of1x_stats_rate_sweep{
+	uint64_t now;
+	of1x_stats_flow_rate_top_t top[OF1X_STATS_RATE_TOP_K];
+	unsigned int num_of_top;
+}__of1x_stats_rate_sweep_t;
+
+//Rate (per second, fixed point) of delta in ms
+static inline uint64_t __of1x_stats_rate(uint64_t delta, uint64_t ms){
+	uint64_t d = delta*1000;
+	return ((d/ms) << OF1X_STATS_RATE_FRAC_BITS) + (((d%ms) << OF1X_STATS_RATE_FRAC_BITS)/ms);
+}
+
+static inline uint64_t __of1x_stats_rate_ewma(uint64_t rate, uint64_t sample){
+
+	uint64_t step;
+
+	if(sample >= rate){
+		step = (sample-rate) >> OF1X_STATS_RATE_EWMA_SHIFT;
+		return rate + ((step || sample == rate)? step : 1);
+	}
+	step = (rate-sample) >> OF1X_STATS_RATE_EWMA_SHIFT;
+	return rate - ((step)? step : 1);
+}
+
+//Keeps the flows with the highest packet rates (decreasing order)
+static void __of1x_stats_rate_top_push(__of1x_stats_rate_sweep_t* sweep, of1x_flow_entry_t* entry){
+
+	unsigned int i;
+	of1x_stats_flow_rate_top_t flow;
+
+	flow.packet_rate = entry->cold->rate.packet_rate >> OF1X_STATS_RATE_FRAC_BITS;
+	flow.byte_rate = entry->cold->rate.byte_rate >> OF1X_STATS_RATE_FRAC_BITS;
+	if(flow.packet_rate == 0)
+		return;
+
+	if(sweep->num_of_top == OF1X_STATS_RATE_TOP_K){
+		if(flow.packet_rate <= sweep->top[OF1X_STATS_RATE_TOP_K-1].packet_rate)
+			return;
+		sweep->num_of_top--;
+	}
+
+	flow.flow_id = entry->cold->generation;
+	flow.priority = entry->priority & 0xFFFF;
+	flow.cookie = entry->cookie;
+
+	for(i=sweep->num_of_top; i>0 && sweep->top[i-1].packet_rate < flow.packet_rate; i--)
+		sweep->top[i] = sweep->top[i-1];
+	sweep->top[i] = flow;
+	sweep->num_of_top++;
+}
+
+//Iterator callback (table->mutex)
+static bool __of1x_stats_sample_flow_rate(of1x_flow_entry_t* entry, void* opaque){
+
+	__of1x_stats_rate_sweep_t* sweep = (__of1x_stats_rate_sweep_t*)opaque;
+	__of1x_stats_flow_rate_t* rate = &entry->cold->rate;
+	__of1x_stats_flow_tid_t c;
+	uint64_t ms, packet_rate, byte_rate;
+
+	//Same ms as the last sample
+	if(rate->last_sample_ms && sweep->now <= rate->last_sample_ms){
+		__of1x_stats_rate_top_push(sweep, entry);
+		return true;
+	}
+
+	// update statistics from platform
+	platform_of1x_update_stats_hook(entry);
+	__of1x_stats_flow_consolidate(&entry->stats, &c);
+
+	//Rates since the last sample (if none, or the counters were reset, these are the base)
+	if(rate->last_sample_ms && c.packet_count >= rate->last_packet_count && c.byte_count >= rate->last_byte_count){
+		ms = sweep->now - rate->last_sample_ms;
+		packet_rate = __of1x_stats_rate(c.packet_count - rate->last_packet_count, ms);
+		byte_rate = __of1x_stats_rate(c.byte_count - rate->last_byte_count, ms);
+
+		if(rate->valid){
+			rate->packet_rate = __of1x_stats_rate_ewma(rate->packet_rate, packet_rate);
+			rate->byte_rate = __of1x_stats_rate_ewma(rate->byte_rate, byte_rate);
+		}else{
+			rate->packet_rate = packet_rate;
+			rate->byte_rate = byte_rate;
+			rate->valid = true;
+		}
+	}
+
+	rate->last_packet_count = c.packet_count;
+	rate->last_byte_count = c.byte_count;
+	rate->last_sample_ms = sweep->now;
+
+	__of1x_stats_rate_top_push(sweep, entry);
+
+	return true;
+}
+
+void __of1x_sample_flow_rates(of1x_pipeline_t *const pipeline, uint64_t now){
+
+	unsigned int i, num_of_entries;
+	of1x_flow_table_t* table;
+	of1x_flow_iterator_t it;
+	__of1x_stats_rate_sweep_t sweep;
+
+	sweep.now = now;
+
+	for(i=0;i<pipeline->num_of_tables;i++){
+		table = &pipeline->tables[i];
+		sweep.num_of_top = 0;
+
+		if(of1x_init_flow_iterator(&it, pipeline, i, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, NULL) != ROFL_SUCCESS)
+			return;
+		while(!it.done)
+			of1x_flow_iterator_next_chunk(&it, UINT_MAX, __of1x_stats_sample_flow_rate, &sweep, &num_of_entries);
+		of1x_release_flow_iterator(&it);
+
+		//Publish the top
+		platform_mutex_lock(table->mutex);
+		memcpy(table->stats.top, sweep.top, sizeof(of1x_stats_flow_rate_top_t)*sweep.num_of_top);
+		table->stats.num_of_top = sweep.num_of_top;
+		platform_mutex_unlock(table->mutex);
+	}
 }
+
+void of1x_sample_flow_rates(of1x_pipeline_t *const pipeline){
+
+	struct timeval now;
+
+	platform_gettimeofday(&now);
+	__of1x_sample_flow_rates(pipeline, __of1x_get_time_ms(&now));
+}
+
+void of1x_stats_flow_get_rates(struct of1x_flow_entry * entry, uint64_t* packet_rate, uint64_t* byte_rate){
+	*packet_rate = entry->cold->rate.packet_rate >> OF1X_STATS_RATE_FRAC_BITS;
+	*byte_rate = entry->cold->rate.byte_rate >> OF1X_STATS_RATE_FRAC_BITS;
+}
+
+rofl_result_t of1x_get_table_top_flows(of1x_pipeline_t *const pipeline, const unsigned int table_id, of1x_stats_flow_rate_top_t* top, unsigned int* num_of_flows){
+
+	of1x_flow_table_t* table;
+
+	//Verify table_id
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	platform_mutex_lock(table->mutex);
+	memcpy(top, table->stats.top, sizeof(of1x_stats_flow_rate_top_t)*table->stats.num_of_top);
+	*num_of_flows = table->stats.num_of_top;
+	platform_mutex_unlock(table->mutex);
+
+	return ROFL_SUCCESS;
+}
+
 //NOTE this functions add too much overhead!
 
 
-void __of1x_init_group_stats(of1x_stats_group_t *group_stats){
+rofl_result_t __of1x_init_group_stats(of1x_stats_group_t *group_stats){
 	
 	memset(group_stats, 0, sizeof(of1x_stats_group_t));
+
+	if(unlikely(__of1x_stats_slab_alloc(&__of1x_stats_group_slab, &group_stats->__id) != ROFL_SUCCESS))
+		return ROFL_FAILURE;
 	
 	//NOTE bucket stats are initialized when the group is created, before being attached to the list
 	group_stats->mutex = platform_mutex_init(NULL);
+
+	return ROFL_SUCCESS;
 }
 
 void __of1x_destroy_group_stats(of1x_stats_group_t* group_stats){
 	platform_mutex_destroy(group_stats->mutex);
+	__of1x_stats_slab_free(&__of1x_stats_group_slab, group_stats->__id);
 }
 
 
@@ -425,15 +912,21 @@ of1x_stats_group_desc_msg_t *of1x_get_group_desc_stats(of1x_pipeline_t* pipeline
 	return head;
 }
 
-void __of1x_init_bucket_stats(__of1x_stats_bucket_t *bc_stats){
+rofl_result_t __of1x_init_bucket_stats(__of1x_stats_bucket_t *bc_stats){
 	
 	memset(bc_stats, 0, sizeof(__of1x_stats_bucket_t));
+
+	if(unlikely(__of1x_stats_slab_alloc(&__of1x_stats_bucket_slab, &bc_stats->__id) != ROFL_SUCCESS))
+		return ROFL_FAILURE;
 	
 	bc_stats->mutex = platform_mutex_init(NULL);
+
+	return ROFL_SUCCESS;
 }
 
 void __of1x_destroy_buckets_stats(__of1x_stats_bucket_t *bc_stats){
 	platform_mutex_destroy(bc_stats->mutex);
+	__of1x_stats_slab_free(&__of1x_stats_bucket_slab, bc_stats->__id);
 }
 
 
@@ -441,7 +934,7 @@ void __of1x_destroy_buckets_stats(__of1x_stats_bucket_t *bc_stats){
 * External interfaces
 */
 
-of1x_stats_flow_msg_t* of1x_get_flow_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint32_t cookie, uint32_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group *const matches){
+of1x_stats_flow_msg_t* of1x_get_flow_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group *const matches){
 
 	uint32_t i,tid_start, tid_end;	
 	of1x_stats_flow_msg_t* msg;
@@ -473,7 +966,7 @@ of1x_stats_flow_msg_t* of1x_get_flow_stats(struct of1x_pipeline* pipeline, uint8
 	
 	return msg;
 }
-of1x_stats_flow_aggregate_msg_t* of1x_get_flow_aggregate_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint32_t cookie, uint32_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group *const matches){
+of1x_stats_flow_aggregate_msg_t* of1x_get_flow_aggregate_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group *const matches){
 	
 	uint32_t i, tid_start, tid_end;	
 	of1x_stats_flow_aggregate_msg_t* msg;
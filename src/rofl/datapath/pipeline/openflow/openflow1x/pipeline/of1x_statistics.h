@@ -11,6 +11,7 @@
 #include "rofl_datapath.h"
 #include "of1x_group_types.h"
 #include "../../../platform/lock.h"
+#include "../../../threading.h"
 
 #define OF1X_STATS_NS_IN_A_SEC 1000000000
 
@@ -38,6 +39,93 @@ struct of1x_match;
 struct of1x_match_group;
 struct of1x_pipeline;
 
+//
+// Per thread counter slabs
+//
+
+/*
+* Per thread counters are not stored in the stats objects but in per TID
+* slabs: each TID only writes into its own chunks (cache line aligned), so that
+* updates from different cores never share cache lines. Stats objects hold a
+* counter id (__id), which is the slot of the object in the chunks of every TID.
+*
+* Chunks are never moved; the chunk directory is grown by pointer swap. Old
+* directories are only released with the slab, since management threads read
+* the counters outside of any epoch.
+*/
+#define OF1X_STATS_SLAB_CHUNK_SHIFT 7
+#define OF1X_STATS_SLAB_CHUNK_SLOTS (1U << OF1X_STATS_SLAB_CHUNK_SHIFT)
+
+//Never allocated; stats objects that own no counters
+#define OF1X_STATS_SLAB_NO_ID 0
+
+typedef struct __of1x_stats_slab{
+	//Slot size
+	size_t size;
+
+	//Chunk directory; dir[chunk][tid]. Rows also keep the (unaligned)
+	//allocated pointers, at dir[chunk][ROFL_PIPELINE_MAX_TIDS+tid]
+	uint8_t*** volatile dir;
+	unsigned int dir_capacity;
+	unsigned int num_of_chunks;
+
+	//TIDs with chunks
+	unsigned int num_of_tids;
+
+	//Ids never used (>= next_id) and released ones
+	uint32_t next_id;
+	uint32_t num_of_ids_in_use;
+	uint32_t* free_ids;
+	unsigned int num_of_free_ids;
+	unsigned int free_ids_capacity;
+}__of1x_stats_slab_t;
+
+//Slabs (of1x_statistics.c)
+extern __of1x_stats_slab_t __of1x_stats_flow_slab;
+extern __of1x_stats_slab_t __of1x_stats_table_slab;
+extern __of1x_stats_slab_t __of1x_stats_group_slab;
+extern __of1x_stats_slab_t __of1x_stats_bucket_slab;
+
+static inline void* __of1x_stats_slab_slot(const __of1x_stats_slab_t* slab, uint32_t id, unsigned int tid, size_t size){
+	return slab->dir[id >> OF1X_STATS_SLAB_CHUNK_SHIFT][tid] + (id & (OF1X_STATS_SLAB_CHUNK_SLOTS-1))*size;
+}
+
+//
+// Statistics modes
+//
+
+/**
+* @ingroup core_of1x
+* Statistics mode of a table (of1x_set_table_stats_mode()). Applies to the
+* table counters and to the counters of its flow entries
+*/
+typedef enum of1x_stats_mode{
+	OF1X_STATS_MODE_FULL = 0,		/* Packet and byte counters (default) */
+	OF1X_STATS_MODE_PACKETS_ONLY,		/* Flow byte counters are not kept */
+	OF1X_STATS_MODE_SAMPLED,		/* 1 in N packets is counted, with weight N */
+	OF1X_STATS_MODE_OFF,			/* No counters */
+}of1x_stats_mode_t;
+
+/**
+* @ingroup core_of1x
+* Flow entry flags (of1x_flow_entry_t::flags) disabling entry counters (OF1.3
+* OFPFF_NO_PKT_COUNTS and OFPFF_NO_BYT_COUNTS)
+*/
+#define OF1X_FLOW_FLAG_NO_PKT_COUNTS (1 << 3)
+#define OF1X_FLOW_FLAG_NO_BYT_COUNTS (1 << 4)
+
+/*
+* Flow counters updated in the packet processing path (of1x_stats_flow_t::pp_mode),
+* from the table mode and the entry flags (__of1x_stats_flow_set_mode()).
+* IDLE_HIT marks the entry as used (idle timeout) when packet counts are not exact.
+* LAST_USED keeps the coarse time of the last use (of1x_set_table_idle_timestamps())
+*/
+#define OF1X_STATS_FLOW_PKTS 0x1
+#define OF1X_STATS_FLOW_BYTES 0x2
+#define OF1X_STATS_FLOW_IDLE_HIT 0x4
+#define OF1X_STATS_FLOW_LAST_USED 0x8
+#define OF1X_STATS_FLOW_FULL (OF1X_STATS_FLOW_PKTS | OF1X_STATS_FLOW_BYTES)
+
 //
 // Inner pipeline stats
 //
@@ -47,17 +135,23 @@ struct of1x_pipeline;
 typedef struct __of1x_stats_flow_tid{
 	uint64_t packet_count;
 	uint64_t byte_count;
+
+	//Used since the last idle timeout check (OF1X_STATS_FLOW_IDLE_HIT)
+	uint32_t idle_hit;
 }__of1x_stats_flow_tid_t;
 
 //Flow entry stats (internal entry state)
 typedef struct of1x_stats_flow{
 
-	union __of1x_stats_flow_tids{	
-		__of1x_stats_flow_tid_t counters;
-		
-		//array of counters per thread to be used internally
-		__of1x_stats_flow_tid_t __internal[ROFL_PIPELINE_MAX_TIDS];
-	}s;
+	//Per thread counters id (__of1x_stats_flow_counters()). The ones of
+	//the first TID also hold the counts consolidated on a reset
+	uint32_t __id;
+
+	//Counters updated by packet processing (OF1X_STATS_FLOW_XXX)
+	uint8_t pp_mode;
+
+	//Coarse time (tid_get_clock()) of the last use (OF1X_STATS_FLOW_LAST_USED)
+	volatile uint32_t last_used;
 
 	//And more not so interesting
 	struct timeval initial_time;
@@ -65,24 +159,69 @@ typedef struct of1x_stats_flow{
 	platform_mutex_t* mutex; //Mutual exclusion stats
 }of1x_stats_flow_t;
 
+/* Rates */
+
+//Fractional bits of the rate estimations (fixed point)
+#define OF1X_STATS_RATE_FRAC_BITS 8
+
+//EWMA weight of the last sample (1/2^OF1X_STATS_RATE_EWMA_SHIFT)
+#define OF1X_STATS_RATE_EWMA_SHIFT 2
+
+//Flows kept in the per table top (highest packet rates)
+#define OF1X_STATS_RATE_TOP_K 16
+
+//Flow rate estimation (cold entry state), maintained by of1x_sample_flow_rates()
+typedef struct __of1x_stats_flow_rate{
+	//Counters and time (ms) of the last sample (0 if none)
+	uint64_t last_packet_count;
+	uint64_t last_byte_count;
+	uint64_t last_sample_ms;
+
+	//EWMA rates (per second, OF1X_STATS_RATE_FRAC_BITS fixed point)
+	bool valid;
+	uint64_t packet_rate;
+	uint64_t byte_rate;
+}__of1x_stats_flow_rate_t;
+
+/**
+* @ingroup core_of1x
+* Flow of the per table top (of1x_get_table_top_flows())
+*/
+typedef struct of1x_stats_flow_rate_top{
+	//Entry generation (unique within the table, see of1x_flow_iterator.h)
+	uint64_t flow_id;
+	uint16_t priority;
+	uint64_t cookie;
+
+	uint64_t packet_rate; /* Packets per second (EWMA) */
+	uint64_t byte_rate; /* Bytes per second (EWMA) */
+}of1x_stats_flow_rate_top_t;
+
 /* Table */
 
 //Per thread table stats
 typedef struct __of1x_stats_table_tid{
 	uint64_t lookup_count; /* Number of packets looked up in table. */
 	uint64_t matched_count; /* Number of packets that hit table. */
+	uint64_t filtered_miss_count; /* Number of packets that missed the table without lookup (miss filter). */
+
+	uint32_t sample_countdown; /* Packets until the next sampled one (OF1X_STATS_MODE_SAMPLED). */
 }__of1x_stats_table_tid_t;
 
 //Table stats (table state)
 typedef struct of1x_stats_table{
 
-	union __of1x_stats_table_tids{ 
-		/* Flow table counters */
-		__of1x_stats_table_tid_t counters;
-	
-		//array of counters per thread to be used internally
-		__of1x_stats_table_tid_t __internal[ROFL_PIPELINE_MAX_TIDS];	
-	}s;
+	//Per thread counters id (__of1x_stats_table_counters()). The ones of
+	//the first TID also hold the counts consolidated on a snapshot
+	uint32_t __id;
+
+	//Mode and sampling rate (1 in sampling_rate packets)
+	of1x_stats_mode_t mode;
+	uint32_t sampling_rate;
+
+	//Highest packet rate flows, as of the last of1x_sample_flow_rates() (table->mutex)
+	of1x_stats_flow_rate_top_t top[OF1X_STATS_RATE_TOP_K];
+	unsigned int num_of_top;
 
 	platform_mutex_t* mutex; //Mutual exclusion only for stats
 }of1x_stats_table_t;
@@ -98,13 +237,8 @@ typedef struct __of1x_stats_bucket_tid{
 typedef __of1x_stats_bucket_tid_t of1x_stats_bucket_t; //Used only for msgs
 
 typedef struct __of1x_stats_bucket{
-	union __of1x_stats_bucket_tids{ 
-		/* Bucket counters */
-		__of1x_stats_bucket_tid_t counters;
-	
-		//array of counters per thread to be used internally
-		__of1x_stats_bucket_tid_t __internal[ROFL_PIPELINE_MAX_TIDS];	
-	}s;
+	//Per thread counters id (__of1x_stats_bucket_counters())
+	uint32_t __id;
 
 	platform_mutex_t* mutex;
 }__of1x_stats_bucket_t;
@@ -120,13 +254,8 @@ typedef struct of1x_stats_group{
 	
 	uint32_t ref_count;
 	
-	union __of1x_stats_group_tids{ 
-		/* Group counters */
-		__of1x_stats_group_tid_t counters;
-	
-		//array of counters per thread to be used internally
-		__of1x_stats_group_tid_t __internal[ROFL_PIPELINE_MAX_TIDS];	
-	}s;
+	//Per thread counters id (__of1x_stats_group_counters())
+	uint32_t __id;
 
 	platform_mutex_t* mutex;
 }of1x_stats_group_t;
@@ -213,6 +342,31 @@ typedef struct of1x_stats_group_desc_msg{
 
 ROFL_BEGIN_DECLS
 
+//Per thread counter slabs (physical switch). Slabs with counters in use (e.g.
+//orphan objects of the pools) are kept, and extended to the TIDs in use on init
+rofl_result_t __of1x_init_stats_slabs(void);
+void __of1x_destroy_stats_slabs(void);
+
+//Allocates a (zeroed) slot for every TID in use
+rofl_result_t __of1x_stats_slab_alloc(__of1x_stats_slab_t* slab, uint32_t* id);
+void __of1x_stats_slab_free(__of1x_stats_slab_t* slab, uint32_t id);
+
+//Zeroes the slots of all TIDs
+void __of1x_stats_slab_reset(__of1x_stats_slab_t* slab, uint32_t id);
+
+static inline __of1x_stats_flow_tid_t* __of1x_stats_flow_counters(const of1x_stats_flow_t* stats, unsigned int tid){
+	return (__of1x_stats_flow_tid_t*)__of1x_stats_slab_slot(&__of1x_stats_flow_slab, stats->__id, tid, sizeof(__of1x_stats_flow_tid_t));
+}
+static inline __of1x_stats_table_tid_t* __of1x_stats_table_counters(const of1x_stats_table_t* stats, unsigned int tid){
+	return (__of1x_stats_table_tid_t*)__of1x_stats_slab_slot(&__of1x_stats_table_slab, stats->__id, tid, sizeof(__of1x_stats_table_tid_t));
+}
+static inline __of1x_stats_group_tid_t* __of1x_stats_group_counters(const of1x_stats_group_t* stats, unsigned int tid){
+	return (__of1x_stats_group_tid_t*)__of1x_stats_slab_slot(&__of1x_stats_group_slab, stats->__id, tid, sizeof(__of1x_stats_group_tid_t));
+}
+static inline __of1x_stats_bucket_tid_t* __of1x_stats_bucket_counters(const __of1x_stats_bucket_t* stats, unsigned int tid){
+	return (__of1x_stats_bucket_tid_t*)__of1x_stats_slab_slot(&__of1x_stats_bucket_slab, stats->__id, tid, sizeof(__of1x_stats_bucket_tid_t));
+}
+
 void __of1x_init_flow_stats(struct of1x_flow_entry * entry);
 void __of1x_destroy_flow_stats(struct of1x_flow_entry * entry);
 
@@ -246,53 +400,124 @@ void of1x_stats_flow_get_duration(struct of1x_flow_entry * entry, uint32_t* sec,
 
 void __of1x_stats_flow_reset_counts(struct of1x_flow_entry * entry);
 
+//Computes the counters updated by packet processing (pp_mode). Requires table->mutex
+void __of1x_stats_flow_set_mode(struct of1x_flow_entry* entry, struct of1x_flow_table* table);
+
+//Returns true if the entry has been used since the last call (OF1X_STATS_FLOW_IDLE_HIT)
+bool __of1x_stats_flow_test_and_clear_idle_hit(of1x_stats_flow_t* stats);
+
 static inline void __of1x_stats_flow_consolidate(of1x_stats_flow_t* stats, __of1x_stats_flow_tid_t* c){
 	int i;
+	__of1x_stats_flow_tid_t* s;
 	c->byte_count = c->packet_count = 0x0ULL;
+	c->idle_hit = 0;
 	
-	for(i=0;i<ROFL_PIPELINE_MAX_TIDS;i++){
-		c->packet_count += stats->s.__internal[i].packet_count;
-		c->byte_count += stats->s.__internal[i].byte_count;
+	for(i=0;i<(int)tid_get_num_of_tids();i++){
+		s = __of1x_stats_flow_counters(stats, i);
+		c->packet_count += s->packet_count;
+		c->byte_count += s->byte_count;
 	}
 }
 static inline void __of1x_stats_copy_flow_stats(of1x_stats_flow_t* origin, of1x_stats_flow_t* copy){
-	memcpy(&copy->s.__internal,&origin->s.__internal, sizeof(__of1x_stats_flow_tid_t)*ROFL_PIPELINE_MAX_TIDS); 
+	int i;
+
+	for(i=0;i<(int)tid_get_num_of_tids();i++)
+		*__of1x_stats_flow_counters(copy, i) = *__of1x_stats_flow_counters(origin, i);
 	copy->initial_time = origin->initial_time;
 }
 
-void __of1x_stats_table_init(struct of1x_flow_table * table);
+rofl_result_t __of1x_stats_table_init(struct of1x_flow_table * table);
 void __of1x_stats_table_destroy(struct of1x_flow_table * table);
 
+/**
+* @brief Sets the statistics mode of a table
+* @ingroup core_of1x
+*
+* Counters not kept in the mode are no longer updated by packet processing; they
+* keep their values. Flow entries with an idle timeout keep expiring correctly in
+* all modes.
+*
+* @param pipeline Switch pipeline
+* @param table_id Table index
+* @param mode Statistics mode
+* @param sampling_rate Count 1 in sampling_rate packets (OF1X_STATS_MODE_SAMPLED only, >= 1)
+*/
+rofl_result_t of1x_set_table_stats_mode(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_stats_mode_t mode, uint32_t sampling_rate);
+
 static inline void __of1x_stats_table_consolidate(of1x_stats_table_t* stats, __of1x_stats_table_tid_t* c){
 	int i;
-	c->lookup_count = c->matched_count = 0x0ULL;
+	__of1x_stats_table_tid_t* s;
+	c->lookup_count = c->matched_count = c->filtered_miss_count = 0x0ULL;
+	c->sample_countdown = 0;
 	
-	for(i=0;i<ROFL_PIPELINE_MAX_TIDS;i++){
-		c->lookup_count += stats->s.__internal[i].lookup_count;
-		c->matched_count += stats->s.__internal[i].matched_count;
+	for(i=0;i<(int)tid_get_num_of_tids();i++){
+		s = __of1x_stats_table_counters(stats, i);
+		c->lookup_count += s->lookup_count;
+		c->matched_count += s->matched_count;
+		c->filtered_miss_count += s->filtered_miss_count;
 	}
 }
 
-void __of1x_init_group_stats(of1x_stats_group_t *group_stats);
+/**
+* @brief Samples the flow counters of all the tables, and updates the rate estimations
+* @ingroup core_of1x
+*
+* Consolidates the counters of every flow entry (outside of the packet
+* processing path), and updates its EWMA packet and byte rates and the per table
+* top of flows (of1x_get_table_top_flows()). Tables are walked in chunks
+* (of1x_flow_iterator.h), so flow_mods are not delayed.
+*
+* The platform has to periodically call of1x_sample_flow_rates(), from a single
+* thread (usually a background one). The estimations are more accurate with
+* regular periods, of around 1s.
+*/
+void of1x_sample_flow_rates(struct of1x_pipeline *const pipeline);
+
+//Same, with the current time (ms) (public for testing)
+void __of1x_sample_flow_rates(struct of1x_pipeline *const pipeline, uint64_t now);
+
+/**
+* @brief Retrieves the estimated rates of a flow entry (per second)
+* @ingroup core_of1x
+*/
+void of1x_stats_flow_get_rates(struct of1x_flow_entry * entry, uint64_t* packet_rate, uint64_t* byte_rate);
+
+/**
+* @brief Retrieves the flows with the highest packet rates of a table, in decreasing order
+* @ingroup core_of1x
+*
+* Flows are the ones of the last of1x_sample_flow_rates(); they may have been
+* removed since then. Flows with a rate below 1 packet per second are not listed.
+*
+* @param top Array of (at least) OF1X_STATS_RATE_TOP_K flows
+* @param num_of_flows Number of flows filled
+*/
+rofl_result_t of1x_get_table_top_flows(struct of1x_pipeline *const pipeline, const unsigned int table_id, of1x_stats_flow_rate_top_t* top, unsigned int* num_of_flows);
+
+rofl_result_t __of1x_init_group_stats(of1x_stats_group_t *group_stats);
 void __of1x_destroy_group_stats(of1x_stats_group_t* group_stats);
 
 static inline void __of1x_stats_group_consolidate(of1x_stats_group_t* stats, __of1x_stats_group_tid_t* c){
 	int i;
+	__of1x_stats_group_tid_t* s;
 	c->byte_count = c->packet_count = 0x0ULL;
 	
-	for(i=0;i<ROFL_PIPELINE_MAX_TIDS;i++){
-		c->packet_count += stats->s.__internal[i].packet_count;
-		c->byte_count += stats->s.__internal[i].byte_count;
+	for(i=0;i<(int)tid_get_num_of_tids();i++){
+		s = __of1x_stats_group_counters(stats, i);
+		c->packet_count += s->packet_count;
+		c->byte_count += s->byte_count;
 	}
 }
 
 static inline void __of1x_stats_bucket_consolidate(__of1x_stats_bucket_t* stats, __of1x_stats_bucket_tid_t* c){
 	int i;
+	__of1x_stats_bucket_tid_t* s;
 	c->byte_count = c->packet_count = 0x0ULL;
 	
-	for(i=0;i<ROFL_PIPELINE_MAX_TIDS;i++){
-		c->packet_count += stats->s.__internal[i].packet_count;
-		c->byte_count += stats->s.__internal[i].byte_count;
+	for(i=0;i<(int)tid_get_num_of_tids();i++){
+		s = __of1x_stats_bucket_counters(stats, i);
+		c->packet_count += s->packet_count;
+		c->byte_count += s->byte_count;
 	}
 }
 
@@ -315,7 +540,7 @@ of1x_stats_group_msg_t* of1x_get_group_stats(struct of1x_pipeline* pipeline,uint
  */
 void of1x_destroy_stats_group_msg(of1x_stats_group_msg_t *msg);
 
-void __of1x_init_bucket_stats(__of1x_stats_bucket_t *bc_stats);
+rofl_result_t __of1x_init_bucket_stats(__of1x_stats_bucket_t *bc_stats);
 void __of1x_destroy_buckets_stats(__of1x_stats_bucket_t *bc_stats);
 
 /*
@@ -326,14 +551,14 @@ void __of1x_destroy_buckets_stats(__of1x_stats_bucket_t *bc_stats);
 * Retrieves individual flow stats 
 * @return of1x_stats_flow_msg_t instance that must be destroyed using of1x_destroy_stats_flow_msg() 
 */
-of1x_stats_flow_msg_t* of1x_get_flow_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint32_t cookie, uint32_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group* matchs);
+of1x_stats_flow_msg_t* of1x_get_flow_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group* matchs);
 
 /**
 * @ingroup core_of1x 
 * Retrieves aggregated flow stats 
 * @return of1x_stats_flow_aggregate_msg_t instance that must be destroyed using of1x_destroy_stats_flow_aggregate_msg() 
 */
-of1x_stats_flow_aggregate_msg_t* of1x_get_flow_aggregate_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint32_t cookie, uint32_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group* matchs);
+of1x_stats_flow_aggregate_msg_t* of1x_get_flow_aggregate_stats(struct of1x_pipeline* pipeline, uint8_t table_id, uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, uint32_t out_group, struct of1x_match_group* matchs);
 
 /**
  * @ingroup core_of1x
@@ -28,11 +28,60 @@
 */
 
 //Flow
-static inline void __of1x_stats_flow_update_match(unsigned int tid, of1x_stats_flow_t* stats, uint64_t bytes_rx){
+static inline void __of1x_stats_flow_update_match_mode(unsigned int tid, of1x_stats_flow_t* stats, uint32_t weight, uint64_t bytes_rx){
 
-	__of1x_stats_flow_tid_t* s = &stats->s.__internal[tid];
+	__of1x_stats_flow_tid_t* s;
+	uint32_t now;
+	uint8_t pp_mode = stats->pp_mode;
 
-	assert(tid < ROFL_PIPELINE_MAX_TIDS);
+	if(pp_mode == 0x0)
+		return;
+
+	//Relaxed store; only once per clock tick
+	if(pp_mode & OF1X_STATS_FLOW_LAST_USED){
+		now = tid_get_clock(tid);
+		if(stats->last_used != now)
+			stats->last_used = now;
+	}
+
+	s = __of1x_stats_flow_counters(stats, tid);
+
+	//Only written once per idle timeout check
+	if( (pp_mode & OF1X_STATS_FLOW_IDLE_HIT) && s->idle_hit == 0 )
+		s->idle_hit = 1;
+
+	if(weight == 0)
+		return;
+
+	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
+		if(pp_mode & OF1X_STATS_FLOW_PKTS)
+			platform_atomic_add64(&s->packet_count, weight, stats->mutex);
+		if(pp_mode & OF1X_STATS_FLOW_BYTES)
+			platform_atomic_add64(&s->byte_count, bytes_rx*weight, stats->mutex);
+	}else{
+		if(pp_mode & OF1X_STATS_FLOW_PKTS)
+			s->packet_count += weight;
+		if(pp_mode & OF1X_STATS_FLOW_BYTES)
+			s->byte_count += bytes_rx*weight;
+	}
+}
+
+/*
+* weight is the value returned by the table update (0: packet not counted by
+* the table mode)
+*/
+static inline void __of1x_stats_flow_update_match(unsigned int tid, of1x_stats_flow_t* stats, uint32_t weight, uint64_t bytes_rx){
+
+	__of1x_stats_flow_tid_t* s;
+
+	assert(tid < tid_get_num_of_tids());
+
+	if(unlikely(stats->pp_mode != OF1X_STATS_FLOW_FULL || weight != 1)){
+		__of1x_stats_flow_update_match_mode(tid, stats, weight, bytes_rx);
+		return;
+	}
+
+	s = __of1x_stats_flow_counters(stats, tid);
 
 	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
 		platform_atomic_inc64(&s->packet_count, stats->mutex);
@@ -44,38 +93,104 @@ static inline void __of1x_stats_flow_update_match(unsigned int tid, of1x_stats_f
 }
 
 //Flow table
-static inline void __of1x_stats_table_update_match(unsigned int tid, of1x_stats_table_t* stats){
+
+/*
+* Weight of the packet in the table counters and in the ones of the matched entry,
+* for tables not in OF1X_STATS_MODE_FULL; 0 if the packet is not counted. Sampling
+* is approximate for ROFL_PIPELINE_LOCKED_TID (the countdown is not atomic)
+*/
+static inline uint32_t __of1x_stats_table_weight(of1x_stats_table_t* stats, __of1x_stats_table_tid_t* s){
+
+	uint32_t rate;
+
+	switch(stats->mode){
+		case OF1X_STATS_MODE_SAMPLED:
+			rate = stats->sampling_rate;
+			if(s->sample_countdown > 1 && s->sample_countdown <= rate){
+				s->sample_countdown--;
+				return 0;
+			}
+			s->sample_countdown = rate;
+			return rate;
+		case OF1X_STATS_MODE_OFF:
+			return 0;
+		default:
+			return 1;
+	}
+}
+
+static inline uint32_t __of1x_stats_table_update_match(unsigned int tid, of1x_stats_table_t* stats){
 	
-	__of1x_stats_table_tid_t* s = &stats->s.__internal[tid];
+	__of1x_stats_table_tid_t* s = __of1x_stats_table_counters(stats, tid);
+	uint32_t weight = 1;
 	
-	assert(tid < ROFL_PIPELINE_MAX_TIDS);
+	assert(tid < tid_get_num_of_tids());
+
+	if(unlikely(stats->mode != OF1X_STATS_MODE_FULL)){
+		weight = __of1x_stats_table_weight(stats, s);
+		if(weight == 0)
+			return 0;
+	}
 	
 	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
-		platform_atomic_inc64(&s->lookup_count,stats->mutex);
-		platform_atomic_inc64(&s->matched_count,stats->mutex);
+		platform_atomic_add64(&s->lookup_count, weight, stats->mutex);
+		platform_atomic_add64(&s->matched_count, weight, stats->mutex);
 	}else{
-		s->lookup_count++;
-		s->matched_count++;
+		s->lookup_count += weight;
+		s->matched_count += weight;
 	}
+
+	return weight;
 }
 
 static inline void __of1x_stats_table_update_no_match(unsigned int tid, of1x_stats_table_t* stats){
 	
-	assert(tid < ROFL_PIPELINE_MAX_TIDS);
+	__of1x_stats_table_tid_t* s = __of1x_stats_table_counters(stats, tid);
+	uint32_t weight = 1;
+	
+	assert(tid < tid_get_num_of_tids());
+
+	if(unlikely(stats->mode != OF1X_STATS_MODE_FULL)){
+		weight = __of1x_stats_table_weight(stats, s);
+		if(weight == 0)
+			return;
+	}
+
+	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
+		platform_atomic_add64(&s->lookup_count, weight, stats->mutex);
+	}else{
+		s->lookup_count += weight;
+	}
+}
+
+static inline void __of1x_stats_table_update_filtered_miss(unsigned int tid, of1x_stats_table_t* stats){
+	
+	__of1x_stats_table_tid_t* s = __of1x_stats_table_counters(stats, tid);
+	uint32_t weight = 1;
+	
+	assert(tid < tid_get_num_of_tids());
+
+	if(unlikely(stats->mode != OF1X_STATS_MODE_FULL)){
+		weight = __of1x_stats_table_weight(stats, s);
+		if(weight == 0)
+			return;
+	}
 
 	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
-		platform_atomic_inc64(&stats->s.__internal[tid].lookup_count,stats->mutex);
+		platform_atomic_add64(&s->lookup_count, weight, stats->mutex);
+		platform_atomic_add64(&s->filtered_miss_count, weight, stats->mutex);
 	}else{
-		stats->s.__internal[tid].lookup_count++;
+		s->lookup_count += weight;
+		s->filtered_miss_count += weight;
 	}
 }
 
 //Group
 static void __of1x_stats_group_update(unsigned int tid, of1x_stats_group_t *gr_stats, uint64_t bytes){
 	
-	__of1x_stats_group_tid_t* s = &gr_stats->s.__internal[tid];
+	__of1x_stats_group_tid_t* s = __of1x_stats_group_counters(gr_stats, tid);
 	
-	assert(tid < ROFL_PIPELINE_MAX_TIDS);
+	assert(tid < tid_get_num_of_tids());
 
 	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
 		platform_atomic_inc64(&s->packet_count, gr_stats->mutex);
@@ -90,9 +205,9 @@ static void __of1x_stats_group_update(unsigned int tid, of1x_stats_group_t *gr_s
 //Bucket
 static void __of1x_stats_bucket_update(unsigned int tid, __of1x_stats_bucket_t* bc_stats, uint64_t bytes){
 	
-	__of1x_stats_bucket_tid_t* s = &bc_stats->s.__internal[tid];
+	__of1x_stats_bucket_tid_t* s = __of1x_stats_bucket_counters(bc_stats, tid);
 	
-	assert(tid < ROFL_PIPELINE_MAX_TIDS);
+	assert(tid < tid_get_num_of_tids());
 	
 	if(unlikely(tid == ROFL_PIPELINE_LOCKED_TID)){
 		platform_atomic_inc64(&s->packet_count, bc_stats->mutex);
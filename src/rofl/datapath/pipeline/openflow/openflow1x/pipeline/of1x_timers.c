@@ -1,3 +1,4 @@
+#include <limits.h>
 #include "of1x_timers.h"
 #include "of1x_pipeline.h"
 #include "of1x_flow_table.h"
@@ -8,11 +9,32 @@
 #include "../../../platform/likely.h"
 #include "../../../platform/timing.h"
 #include "../../../util/logging.h"
+#include "../../../threading.h"
 
-static rofl_result_t __of1x_destroy_all_entries_from_timer_group(of1x_timer_group_t* tg, of1x_pipeline_t *const pipeline, unsigned int id);
-#if ! OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-static of1x_timer_group_t* __of1x_dynamic_slot_search(of1x_flow_table_t* const table, uint64_t expiration_time);
-#endif
+#define OF1X_TIMER_WHEEL_L0_MASK (OF1X_TIMER_WHEEL_L0_SLOTS-1)
+#define OF1X_TIMER_WHEEL_LN_MASK (OF1X_TIMER_WHEEL_LN_SLOTS-1)
+
+//Expired entries removed at once (single table lock hold, grace period and notification)
+#define OF1X_TIMER_EXPIRATION_BATCH 256
+
+//State of the expiration processing of a table
+typedef struct of1x_timer_expiration{
+	of1x_pipeline_t* pipeline;
+	unsigned int id_table;
+
+	//Timers that can still be processed in this call
+	unsigned int budget;
+
+	//Clock (tid_get_clock()) before this call; last used timestamps are
+	//measured against it, since a packet stamped with it may have been
+	//processed right before the call
+	uint32_t clock;
+
+	//Expired entries pending removal
+	unsigned int num_of_entries;
+	of1x_flow_entry_t* entries[OF1X_TIMER_EXPIRATION_BATCH];
+	of1x_flow_remove_reason_t reasons[OF1X_TIMER_EXPIRATION_BATCH];
+}of1x_timer_expiration_t;
 
 /**
  * of1x_fill_new_timer_entry_info
@@ -20,11 +42,16 @@ static of1x_timer_group_t* __of1x_dynamic_slot_search(of1x_flow_table_t* const t
  */
 void __of1x_fill_new_timer_entry_info(of1x_flow_entry_t * entry, uint32_t hard_timeout, uint32_t idle_timeout){
 
-	entry->timer_info.hard_timeout = hard_timeout;
-	entry->timer_info.idle_timeout = idle_timeout;
-	entry->timer_info.hard_timer_entry = NULL;
-	entry->timer_info.idle_timer_entry = NULL;
+	entry->cold->timer_info.hard_timeout = hard_timeout;
+	entry->cold->timer_info.idle_timeout = idle_timeout;
 
+	platform_memset(&entry->cold->timer_info.hard_timer, 0, sizeof(of1x_entry_timer_t));
+	entry->cold->timer_info.hard_timer.entry = entry;
+	entry->cold->timer_info.hard_timer.type = HARD_TO;
+
+	platform_memset(&entry->cold->timer_info.idle_timer, 0, sizeof(of1x_entry_timer_t));
+	entry->cold->timer_info.idle_timer.entry = entry;
+	entry->cold->timer_info.idle_timer.type = IDLE_TO;
 }
 
 /**
@@ -34,53 +61,14 @@ bool __of1x_time_is_later(struct timeval *a, struct timeval *b){
 	if(a->tv_sec > b->tv_sec){
 		return true;
 	}
-	
+
 	if (a->tv_sec == b->tv_sec){
 		if(a->tv_usec > b->tv_usec){
 			return true;
 		}
 	}
-	
-	return false;
-}
 
-/**
- * of1x_dump_timers_structure
- * this function is ment to show the timer groups existing
- * and the entries related
- */
-void __of1x_dump_timers_structure(of1x_timer_group_t * timer_group){
-
-	of1x_timer_group_t * tg = timer_group;
-	of1x_entry_timer_t * et;
-	if(!tg)
-	{
-		ROFL_PIPELINE_DEBUG("Timer group list is empty\n");
-		return;
-	}
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	int i;
-	for(i=0;i<OF1X_TIMER_GROUPS_MAX;i++)
-	{
-		ROFL_PIPELINE_DEBUG("timer group on position %p\n", &(tg[i]));
-		ROFL_PIPELINE_DEBUG("	[%p] TO:%"PRIu64" Nent:%d h:%p t:%p\n",&(tg[i]), tg[i].timeout,
-			tg[i].list.num_of_timers, tg[i].list.head, tg[i].list.tail);
-		for(et=tg[i].list.head; et; et=et->next)
-			ROFL_PIPELINE_DEBUG("	[%p] fe:%p prev:%p next:%p tg:%p\n", et,et->entry, et->prev, et->next, et->group);
-	}
-	
-#else
-	if(tg->prev)
-		ROFL_PIPELINE_DEBUG("NOT the first group!!\n");
-	for(;tg!=NULL;tg=tg->next)
-	{
-		ROFL_PIPELINE_DEBUG("timer group on position %p\n", tg);
-		ROFL_PIPELINE_DEBUG("	[%p] TO:%"PRIu64" next:%p prev:%p Nent:%d h:%p t:%p\n",tg, tg->timeout, tg->next, tg->prev,
-			tg->list.num_of_timers, tg->list.head, tg->list.tail);
-		for(et=tg->list.head; et; et=et->next)
-			ROFL_PIPELINE_DEBUG("	[%p] fe:%p prev:%p next:%p tg:%p\n", et,et->entry, et->prev, et->next, et->group);
-	}
-#endif
+	return false;
 }
 
 /**
@@ -95,233 +83,146 @@ inline uint64_t __of1x_get_time_ms(struct timeval *time){
 }
 
 /**
- * of1x_get_expiration_time_slotted
+ * of1x_get_expiration_time
+ * expiration time in ms of a timeout (s) starting now
  */
-uint64_t __of1x_get_expiration_time_slotted (uint32_t timeout,struct timeval *now){
-
-	uint64_t expiration_time_ms;
-	// exact expiration time calculation
-	//WARNING it could happen that the calculated value does not fit in a uint64_t
-	// then we might have to use floats.
-	expiration_time_ms = (now->tv_sec+timeout)*1000+now->tv_usec/1000;
-	// now it must be set in one of the slots
-	//NOTE we are selecting the next slot so we round up the expiration time
-	if(expiration_time_ms%OF1X_TIMER_SLOT_MS)
-		return (expiration_time_ms/OF1X_TIMER_SLOT_MS + 1)*OF1X_TIMER_SLOT_MS;
-	else
-		return expiration_time_ms;
+uint64_t __of1x_get_expiration_time(uint32_t timeout, struct timeval *now){
+	return __of1x_get_time_ms(now) + (uint64_t)timeout*1000;
 }
 
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-/**
- * of1x_timer_group_static_init
- * initializes the timeout values
- * initializes the values for the entry lists
- */
-rofl_result_t __of1x_timer_group_static_init(of1x_flow_table_t* table){
-
-	int i;
+//Current time (ms)
+static inline uint64_t __of1x_timer_get_ms(void){
 	struct timeval now;
-	uint64_t time_next_slot;
 	platform_gettimeofday(&now);
-	time_next_slot = __of1x_get_expiration_time_slotted(0,&now);
+	return __of1x_get_time_ms(&now);
+}
 
-	//First allocate the memory
-	table->timers = (struct of1x_timer_group*) platform_malloc_shared(sizeof(struct of1x_timer_group)*OF1X_TIMER_GROUPS_MAX);
+/**
+ * of1x_dump_timers_structure
+ * this function is ment to show the timers scheduled in the wheel
+ */
+void __of1x_dump_timers_structure(of1x_timer_wheel_t* wheel){
 
-	if(unlikely(table->timers == NULL))
-		return ROFL_FAILURE;
+	unsigned int i;
+	of1x_entry_timer_t * et;
 
-	for(i=0; i<OF1X_TIMER_GROUPS_MAX;i++)
-	{
-		table->timers[i].timeout=time_next_slot+OF1X_TIMER_SLOT_MS*i;
-		table->timers[i].list.num_of_timers = 0;
-		table->timers[i].list.head = table->timers[i].list.tail = NULL;
+	ROFL_PIPELINE_DEBUG("Timer wheel [%p] now:%"PRIu64" Ntimers:%u\n", wheel, wheel->now, wheel->num_of_timers);
+
+	for(i=0;i<OF1X_TIMER_WHEEL_NUM_OF_SLOTS;i++){
+		if(!wheel->slots[i].num_of_timers)
+			continue;
+		ROFL_PIPELINE_DEBUG("	slot %u Nent:%u h:%p t:%p\n", i, wheel->slots[i].num_of_timers, wheel->slots[i].head, wheel->slots[i].tail);
+		for(et=wheel->slots[i].head; et; et=et->next)
+			ROFL_PIPELINE_DEBUG("	[%p] fe:%p type:%u exp:%"PRIu64" prev:%p next:%p\n", et, et->entry, et->type, et->expiration, et->prev, et->next);
 	}
-	table->current_timer_group=0;
-	
-	return ROFL_SUCCESS;
 }
 
-/**
- * of1x_timer_group_static_destroy
- * Destroys the timers table
- * initializes the values for the entry lists
- */
-void __of1x_timer_group_static_destroy(of1x_flow_table_t* table){
-	platform_free_shared(table->timers);
-}
+/*
+* Wheel
+*/
+void __of1x_init_timer_wheel(of1x_flow_table_t* table){
+	uint64_t now = __of1x_timer_get_ms();
 
-/**
- * if we are using static slots, we need to rotate the memory every time that a slot passes. steps:
- * - if there are entries we must erase them
- * - we must set the new timeout
- * - we must update the pointer to the next timer group
- */
-static void __of1x_timer_group_rotate(of1x_pipeline_t *const pipeline, of1x_timer_group_t *tg , unsigned int id_table)
-{
-	if(tg->list.head)
-	{
-		//erase_all_entries;
-		if(__of1x_destroy_all_entries_from_timer_group(tg, pipeline, id_table)!=ROFL_SUCCESS)
-			ROFL_PIPELINE_DEBUG("ERROR in destroying timer group\n");
-	}
-	tg->timeout += OF1X_TIMER_SLOT_MS*OF1X_TIMER_GROUPS_MAX;
-	tg->list.num_of_timers=0;
-	tg->list.head = tg->list.tail = NULL;
+	platform_memset(&table->timers, 0, sizeof(of1x_timer_wheel_t));
+	table->timers.now = now / OF1X_TIMER_TICK_MS;
 
-	pipeline->tables[id_table].current_timer_group++;
-	if(pipeline->tables[id_table].current_timer_group>=OF1X_TIMER_GROUPS_MAX)
-		pipeline->tables[id_table].current_timer_group=0;
+	//Entries may be added before the first expiration processing
+	tid_set_clock((uint32_t)now);
 }
 
-#else
-/**
- * of1x_timer_group_init creates a new timer group and places it in
- * between tg_next and tg_prev, ordered by timeout values.
- * This function is NOT thread safe, you must lock the timer before.
- */
-static of1x_timer_group_t* __of1x_timer_group_init(uint64_t timeout, of1x_timer_group_t* tg_next, of1x_timer_group_t* tg_prev, of1x_flow_table_t* table)
-{
-	// create the new timer_group
-	of1x_timer_group_t* new_group;
-	new_group = platform_malloc_shared(sizeof(of1x_timer_group_t));
-	if(unlikely(new_group == NULL))
-	{
-		ROFL_PIPELINE_DEBUG("<%s:%d> Error allocating memory\n",__func__,__LINE__);
-		return NULL;
+//Slot of a timer, relative to the current tick
+static inline unsigned int __of1x_timer_wheel_slot(of1x_timer_wheel_t* wheel, uint64_t expiration){
+
+	unsigned int level, shift;
+	uint64_t delta;
+
+	if(expiration < wheel->now)
+		expiration = wheel->now; //Overdue; next tick
+	delta = expiration - wheel->now;
+
+	if(delta < OF1X_TIMER_WHEEL_L0_SLOTS)
+		return expiration & OF1X_TIMER_WHEEL_L0_MASK;
+
+	//Beyond the range; re-evaluated when cascaded
+	if(delta >= OF1X_TIMER_WHEEL_RANGE)
+		expiration = wheel->now + OF1X_TIMER_WHEEL_RANGE - 1;
+
+	for(level=1, shift=OF1X_TIMER_WHEEL_L0_BITS; level<OF1X_TIMER_WHEEL_LEVELS-1; level++, shift+=OF1X_TIMER_WHEEL_LN_BITS){
+		if(delta < (1ULL << (shift+OF1X_TIMER_WHEEL_LN_BITS)))
+			break;
 	}
-	new_group->timeout = timeout;
-	new_group->list.num_of_timers=0;
-	new_group->list.head=NULL;
-	new_group->list.tail=NULL;
-	
-	// place the timer group
-	new_group->prev=tg_prev;
-	new_group->next=tg_next;
-	
-	//if there is a node afterwards we place the new one before
-	if (tg_next) tg_next->prev=new_group;
-	//if there is a node forewards we place the new one before
-	if (tg_prev) tg_prev->next=new_group;
-	
-	if(table->timers == tg_next)
-		table->timers = new_group;
-	
-	return new_group;
+
+	return OF1X_TIMER_WHEEL_L0_SLOTS + (level-1)*OF1X_TIMER_WHEEL_LN_SLOTS + ((expiration >> shift) & OF1X_TIMER_WHEEL_LN_MASK);
 }
 
-/**
- * of1x_destroy_timer_group removes a timer_group and frees the memory
- * This function is NOT thread safe, you must lock the timer before.
- */
-static void of1x_destroy_timer_group(of1x_timer_group_t* tg, of1x_flow_table_t* table)
-{
-	if(tg->prev)
-		(tg->prev)->next=tg->next;
+static inline void __of1x_timer_wheel_link(of1x_timer_wheel_t* wheel, of1x_entry_timer_t* timer){
+
+	unsigned int slot = __of1x_timer_wheel_slot(wheel, timer->expiration);
+	of1x_timer_list_t* list = &wheel->slots[slot];
+
+	// we add the new entries at the end
+	timer->list = list;
+	timer->next = NULL;
+	timer->prev = list->tail;
+	if(list->tail)
+		list->tail->next = timer;
 	else
-		if(table->timers == tg)
-			table->timers = tg->next;
-	if(tg->next)
-		(tg->next)->prev=tg->prev;
-	platform_free_shared(tg);
-	tg = NULL;
+		list->head = timer;
+	list->tail = timer;
+	list->num_of_timers++;
+
+	wheel->bitmap[slot/64] |= 1ULL << (slot%64);
+	wheel->num_of_timers++;
 }
-#endif
 
-/**
- * of1x_entry_timer_init
- * adds a new entry in the list
- */
-static of1x_entry_timer_t* __of1x_entry_timer_init(of1x_timer_group_t* tg, of1x_flow_entry_t* entry, of1x_timer_timeout_type_t is_idle)
-{
-	of1x_entry_timer_t* new_entry;
-	new_entry = platform_malloc_shared(sizeof(of1x_entry_timer_t));
-	if(unlikely(new_entry==NULL))
-	{
-		ROFL_PIPELINE_DEBUG("<%s:%d> Error allocating memory\n",__func__,__LINE__);
-		return NULL;
-	}
-	new_entry->entry = entry;
-	new_entry->group = tg;
-	
-	// we add the new entries at the end
-	new_entry->next=NULL;
-	
-	// we check if it is the first entry.
-	if(tg->list.tail) //if it is not
-	{
-		new_entry->prev=tg->list.tail;
-		//update the pointer OF the last entry on the list
-		tg->list.tail->next=new_entry;
+static inline void __of1x_timer_wheel_unlink(of1x_timer_wheel_t* wheel, of1x_entry_timer_t* timer){
+
+	unsigned int slot;
+	of1x_timer_list_t* list = timer->list;
+
+	if(timer->prev)
+		timer->prev->next = timer->next;
+	else
+		list->head = timer->next;
+	if(timer->next)
+		timer->next->prev = timer->prev;
+	else
+		list->tail = timer->prev;
+
+	if(--list->num_of_timers == 0){
+		slot = list - wheel->slots;
+		wheel->bitmap[slot/64] &= ~(1ULL << (slot%64));
 	}
-	else //if it is the first one
-	{
-		new_entry->prev=NULL;
-		//normally this should also apply:
-		if(!tg->list.head)
-			tg->list.head = new_entry;
+	wheel->num_of_timers--;
+
+	timer->list = NULL;
+	timer->prev = timer->next = NULL;
+}
+
+//Next non-empty level 0 slot of the current round, from slot (or -1)
+static inline int __of1x_timer_wheel_next_l0_slot(of1x_timer_wheel_t* wheel, unsigned int slot){
+
+	unsigned int w = slot/64;
+	uint64_t bits = wheel->bitmap[w] & (~0ULL << (slot%64));
+
+	for(;;){
+		if(bits)
+			return w*64 + __builtin_ctzll(bits);
+		if(++w == OF1X_TIMER_WHEEL_L0_SLOTS/64)
+			return -1;
+		bits = wheel->bitmap[w];
 	}
-	
-	// update the pointer TO the last entry of the list
-	tg->list.tail = new_entry;
-	// update the entries counter
-	tg->list.num_of_timers++;
-	
-	new_entry->type=is_idle;
-	
-	if(is_idle)
-		entry->timer_info.idle_timer_entry=new_entry;
-	else
-		entry->timer_info.hard_timer_entry=new_entry;
-	
-	return new_entry;
 }
 
-/**
- * of1x_destroy_single_timer_entry_clean
- * when the time comes the list of entries must be erased from the list
- * This is ment to be used when a single entry is deleted.
- */
-static rofl_result_t __of1x_destroy_single_timer_entry_clean(of1x_entry_timer_t* entry, of1x_flow_table_t * table)
-{	
-	if(likely(entry!=NULL))
-	{
-		if(!entry->next && !entry->prev) // this is the only entry
-		{
-			entry->group->list.head=NULL;
-			entry->group->list.tail=NULL;
-		}
-		else if(!entry->prev) //is the first entry
-		{
-			entry->group->list.head=entry->next;
-			entry->next->prev = NULL;
-		}
-		else if(!entry->next) //last entry
-		{
-			entry->group->list.tail=entry->prev;
-			entry->prev->next = NULL;
-		}
-		else
-		{
-			entry->next->prev = entry->prev;
-			entry->prev->next = entry->next;
-		}
-		
-		entry->group->list.num_of_timers--;
-#if ! OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-		//we need to check if this entry was the last one and delete the timer group
-		if(entry->group->list.num_of_timers == 0)
-			__of1x_destroy_timer_group(entry->group,table);
-#endif
-		platform_free_shared(entry);
-		entry = NULL;
+//Moves the timers of a slot of an upper level to the lower levels
+static void __of1x_timer_wheel_cascade(of1x_timer_wheel_t* wheel, unsigned int level, unsigned int index){
 
-		return ROFL_SUCCESS;
+	of1x_entry_timer_t* timer;
+	of1x_timer_list_t* list = &wheel->slots[OF1X_TIMER_WHEEL_L0_SLOTS + (level-1)*OF1X_TIMER_WHEEL_LN_SLOTS + index];
 
-	}else{
-		ROFL_PIPELINE_DEBUG("<%s:%d> Not a valid timer entry %p\n",__func__,__LINE__,entry);
-		return ROFL_FAILURE;
+	while( (timer = list->head) != NULL){
+		__of1x_timer_wheel_unlink(wheel, timer);
+		__of1x_timer_wheel_link(wheel, timer);
 	}
 }
 
@@ -333,268 +234,313 @@ static rofl_result_t __of1x_destroy_single_timer_entry_clean(of1x_entry_timer_t*
  * and assumes that the mutex is already locked.)
  */
 rofl_result_t __of1x_destroy_timer_entries(of1x_flow_entry_t * entry){
-	// We need to erase both hard and idle timer_entries
+	// We need to erase both hard and idle timers
 
 	if(unlikely(entry->table==NULL))
 		return ROFL_FAILURE;
 
-	if(entry->timer_info.hard_timeout){
-		if(__of1x_destroy_single_timer_entry_clean(entry->timer_info.hard_timer_entry, entry->table)!=ROFL_SUCCESS)
-			return ROFL_FAILURE;
-		entry->timer_info.hard_timer_entry = NULL;
-	}
-		
-	if(entry->timer_info.idle_timeout){
-		if(__of1x_destroy_single_timer_entry_clean(entry->timer_info.idle_timer_entry, entry->table)!=ROFL_SUCCESS)
-			return ROFL_FAILURE;
-		entry->timer_info.idle_timer_entry = NULL;
-	}
-		
+	if(__of1x_timer_is_scheduled(&entry->cold->timer_info.hard_timer))
+		__of1x_timer_wheel_unlink(&entry->table->timers, &entry->cold->timer_info.hard_timer);
+
+	if(__of1x_timer_is_scheduled(&entry->cold->timer_info.idle_timer))
+		__of1x_timer_wheel_unlink(&entry->table->timers, &entry->cold->timer_info.idle_timer);
+
 #if DEBUG_NO_REAL_PIPE
 	__of1x_fill_new_timer_entry_info(entry,0,0);
 #endif
-		
+
 	return ROFL_SUCCESS;
 }
 
+//Removes the expired entries of the batch (table->mutex is held)
+static void __of1x_flush_expired_entries(of1x_timer_expiration_t* exp){
+
+	if(exp->num_of_entries == 0)
+		return;
+
+	__of1x_remove_specific_flow_entries_table(exp->pipeline, exp->id_table, exp->entries, exp->reasons, exp->num_of_entries);
+	exp->num_of_entries = 0;
+}
+
+//Queues an expired entry for removal
+static void __of1x_expire_entry(of1x_timer_expiration_t* exp, of1x_flow_entry_t* entry, of1x_flow_remove_reason_t reason){
+
+#ifdef DEBUG_NO_REAL_PIPE
+	ROFL_PIPELINE_DEBUG("NOT erasing real entries of table \n");
+	__of1x_fill_new_timer_entry_info(entry,0,0);
+	//we need to destroy the entries
+	__of1x_destroy_timer_entries(entry);
+	(void)exp;
+	(void)reason;
+#else
+	//Unlink the other timer, so that the entry is queued only once
+	__of1x_destroy_timer_entries(entry);
+
+	exp->entries[exp->num_of_entries] = entry;
+	exp->reasons[exp->num_of_entries] = reason;
+	if(++exp->num_of_entries == OF1X_TIMER_EXPIRATION_BATCH)
+		__of1x_flush_expired_entries(exp);
+#endif
+}
+
+static void __of1x_schedule_timer(of1x_flow_table_t* const table, of1x_entry_timer_t* timer, uint64_t expiration_ms){
+
+	//NOTE we round up to the next tick: the actual expiration will be in [timeout, timeout+OF1X_TIMER_TICK_MS)
+	timer->expiration = (expiration_ms + OF1X_TIMER_TICK_MS-1) / OF1X_TIMER_TICK_MS;
+
+	__of1x_timer_wheel_link(&table->timers, timer);
+}
+
+/**
+ * of1x_check_idle_timestamp
+ * O(1) idle timeout check from the last used timestamp (OF1X_STATS_FLOW_LAST_USED)
+ */
+static void __of1x_check_idle_timestamp(of1x_entry_timer_t * entry_timer, of1x_timer_expiration_t* exp)
+{
+	uint64_t now = __of1x_timer_get_ms();
+	uint64_t idle_ms = (uint64_t)entry_timer->entry->cold->timer_info.idle_timeout*1000;
+	int32_t elapsed = (int32_t)(exp->clock - entry_timer->entry->stats.last_used);
+
+	//Timestamps are coarse (one processing period); idle time is at least
+	//the time elapsed up to the previous clock value
+	if(elapsed < 0)
+		elapsed = 0;
+
+	if((uint64_t)elapsed >= idle_ms){
+		__of1x_expire_entry(exp, entry_timer->entry, OF1X_FLOW_REMOVE_IDLE_TIMEOUT);
+		return;
+	}
+
+	//Expires at last used + idle timeout, plus at most one processing period
+	__of1x_schedule_timer(&exp->pipeline->tables[exp->id_table], entry_timer, now + idle_ms - elapsed);
+}
+
 /**
  * of1x_reschedule_idle_timer
- * check if there is the need of re-scheduling an idle timer
+ * check if there is the need of re-scheduling an idle timer (already unlinked)
  */
-static rofl_result_t __of1x_reschedule_idle_timer(of1x_entry_timer_t * entry_timer, of1x_pipeline_t *const pipeline, unsigned int id_table)
+static void __of1x_reschedule_idle_timer(of1x_entry_timer_t * entry_timer, of1x_timer_expiration_t* exp)
 {
-	struct timeval system_time;
-	uint64_t expiration_time;
 	__of1x_stats_flow_tid_t consolidated_stats;
+	bool hit;
+	struct timeval now;
+
+	if(entry_timer->entry->stats.pp_mode & OF1X_STATS_FLOW_LAST_USED){
+		__of1x_check_idle_timestamp(entry_timer, exp);
+		return;
+	}
 
 	//Consolidate entry
 	__of1x_stats_flow_consolidate(&entry_timer->entry->stats, &consolidated_stats);
-	
-	if(consolidated_stats.packet_count == entry_timer->entry->timer_info.last_packet_count)
+
+	//Used while packet counts are not (exactly) kept
+	hit = __of1x_stats_flow_test_and_clear_idle_hit(&entry_timer->entry->stats);
+
+	if(consolidated_stats.packet_count == entry_timer->entry->cold->timer_info.last_packet_count && !hit)
 	{
 	// timeout expired so no need to reschedule !!! we have to delete the entry
-#ifdef DEBUG_NO_REAL_PIPE
-		ROFL_PIPELINE_DEBUG("NOT erasing real entries of table \n");
-		__of1x_fill_new_timer_entry_info(entry_timer->entry,0,0);
-		//we need to destroy the entries
-		__of1x_destroy_timer_entries(entry_timer->entry);
-#else
-		__of1x_remove_specific_flow_entry_table(pipeline, id_table, entry_timer->entry, OF1X_FLOW_REMOVE_IDLE_TIMEOUT, MUTEX_ALREADY_ACQUIRED_BY_TIMER_EXPIRATION);
-#endif
-		return ROFL_SUCCESS;
+		__of1x_expire_entry(exp, entry_timer->entry, OF1X_FLOW_REMOVE_IDLE_TIMEOUT);
+		return;
 	}
-	
-	entry_timer->entry->timer_info.last_packet_count = consolidated_stats.packet_count;
+
+	entry_timer->entry->cold->timer_info.last_packet_count = consolidated_stats.packet_count;
 
 	//NOTE we calculate the new time of expiration from the checking time and not from the last time it was used (less accurate and more efficient)
-	platform_gettimeofday(&system_time);
-	expiration_time = __of1x_get_expiration_time_slotted(entry_timer->entry->timer_info.idle_timeout, &system_time);
-	
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	
-	int slot_delta = expiration_time - pipeline->tables[id_table].timers[pipeline->tables[id_table].current_timer_group].timeout; //ms
-	int slot_position = (pipeline->tables[id_table].current_timer_group + slot_delta/OF1X_TIMER_SLOT_MS) % OF1X_TIMER_GROUPS_MAX;
-	if(__of1x_entry_timer_init(&(pipeline->tables[id_table].timers[slot_position]), entry_timer->entry, IDLE_TO)==NULL)
-		return ROFL_FAILURE;
-#else
-		
-	of1x_timer_group_t * tg_iterator = __of1x_dynamic_slot_search(pipeline->tables[id_table], expiration_time);
-	if(tg_iterator==NULL)
-		return ROFL_FAILURE;
-	// add entry to this group. new_group.list->num_of_timers++; ...
-	if(__of1x_entry_timer_init(tg_iterator, entry_timer->entry, IDLE_TO) == NULL)
-		return ROFL_FAILURE;
-#endif
-		
-	//TODO delete timer_entry that has been rescheduled:
-	__of1x_destroy_single_timer_entry_clean(entry_timer, &pipeline->tables[id_table]);
-	
-	return ROFL_SUCCESS;
+	platform_gettimeofday(&now);
+	__of1x_schedule_timer(&exp->pipeline->tables[exp->id_table], entry_timer, __of1x_get_expiration_time(entry_timer->entry->cold->timer_info.idle_timeout, &now));
 }
 
 /**
- * of1x_destroy_all_entries_from_timer_group()
- * implements for loop that destroys the complete list of entries
- * This is ment to be used when a timer expires and we want to delete
- * all the entries of the group and the group itself
+ * of1x_expire_timers
+ * expires the timers of a level 0 slot, up to the budget. Returns false if
+ * the budget was exhausted before the slot was emptied
  */
-static rofl_result_t __of1x_destroy_all_entries_from_timer_group(of1x_timer_group_t* tg, of1x_pipeline_t *const pipeline, unsigned int id_table)
+static bool __of1x_expire_timers(of1x_timer_list_t* list, of1x_timer_expiration_t* exp)
 {
 	of1x_entry_timer_t* entry_iterator;
+	of1x_timer_wheel_t* wheel = &exp->pipeline->tables[exp->id_table].timers;
 
-	if(tg->list.num_of_timers>0 && tg->list.head){
-		while( (entry_iterator = tg->list.head) != NULL){
-			//NOTE actual removal of timer_entries is done in the destruction of the entry
-			
-			if(entry_iterator->type == IDLE_TO){
-				if(__of1x_reschedule_idle_timer(entry_iterator, pipeline, id_table)!=ROFL_SUCCESS)
-					return ROFL_FAILURE;
-			}else{
-#ifdef DEBUG_NO_REAL_PIPE
-				ROFL_PIPELINE_DEBUG("NOT erasing real entries of table \n");
-				__of1x_fill_new_timer_entry_info(entry_iterator->entry,0,0);
-				//we delete the enrty_timer form outside
-				__of1x_destroy_timer_entries(entry_iterator->entry);
-#else
-				//ROFL_PIPELINE_DEBUG("Erasing real entries of table \n"); //NOTE DELETE
-				__of1x_remove_specific_flow_entry_table(pipeline, id_table,entry_iterator->entry, OF1X_FLOW_REMOVE_HARD_TIMEOUT, MUTEX_ALREADY_ACQUIRED_BY_TIMER_EXPIRATION);
-#endif
-			}
-		}
+	//NOTE expiring the entry also unlinks its other timer (which may be in this slot)
+	while( (entry_iterator = list->head) != NULL){
+		if(exp->budget == 0)
+			return false;
+		exp->budget--;
+
+		__of1x_timer_wheel_unlink(wheel, entry_iterator);
+
+		if(entry_iterator->type == IDLE_TO)
+			__of1x_reschedule_idle_timer(entry_iterator, exp);
+		else
+			__of1x_expire_entry(exp, entry_iterator->entry, OF1X_FLOW_REMOVE_HARD_TIMEOUT);
 	}
-	return ROFL_SUCCESS;
+
+	return true;
 }
 
-#if ! OF1X_TIMER_STATIC_ALLOCATION_SLOTS
 /**
- * of1x_dynamic_slot_search
- * extraction of a function used to search a timer group with a specific timeout
- * and if it does not exist create it.
+ * of1x_advance_timer_wheel
+ * processes all the ticks of the table up to now (included), or until the
+ * budget is exhausted (returns true then). Requires table->mutex
  */
-static of1x_timer_group_t * of1x_dynamic_slot_search(of1x_flow_table_t* const table, uint64_t expiration_time)
+static bool __of1x_advance_timer_wheel(of1x_timer_expiration_t* exp, uint64_t now)
 {
-	of1x_timer_group_t* tg_iterator;
-	//Determine the slot, check if is already defined, if not allocate
-	//We search the timer group with the timeout corresponding to the expiration_time calculated
-	for(tg_iterator = table->timers; tg_iterator && tg_iterator->timeout<expiration_time && tg_iterator->next; tg_iterator=tg_iterator->next);
-	// After that we expect 3 different situations:
-	
-	if(!tg_iterator)
-	{
-		//the list is empty, we sould create the first group
-		table->timers = __of1x_timer_group_init(expiration_time,NULL,NULL, table);
-		if(table->timers == NULL)
-			return NULL;
+	int next;
+	unsigned int slot, level, index, shift;
+	uint64_t round;
+	of1x_timer_wheel_t* wheel = &exp->pipeline->tables[exp->id_table].timers;
 
-		tg_iterator = table->timers;
-	}
-	else if(tg_iterator->timeout>expiration_time)
-	{
-		// Create new group and allocate it before the current group
-		tg_iterator = __of1x_timer_group_init(expiration_time,tg_iterator,tg_iterator->prev, table);
-		if(tg_iterator == NULL)
-			return NULL;
-	}
-	else if(tg_iterator->timeout < expiration_time && !tg_iterator->next)
-	{
-		// Create new group and allocate it after the current group
-		tg_iterator = __of1x_timer_group_init(expiration_time,NULL, tg_iterator, table);
-		if(tg_iterator == NULL)
-			return NULL;
-	}
-	else
-	{
-		if (!(tg_iterator->timeout==expiration_time))
-		{
-			// Unexpected outcome ...
-			ROFL_PIPELINE_DEBUG("<%s:%d> No proper position for this entry found\n",__func__, __LINE__);
-			return NULL;
+	while(wheel->now <= now){
+
+		//Nothing scheduled; jump
+		if(wheel->num_of_timers == 0){
+			wheel->now = now+1;
+			break;
+		}
+
+		slot = wheel->now & OF1X_TIMER_WHEEL_L0_MASK;
+
+		//Level 0 wraps around; cascade the upper levels (as they wrap around too)
+		if(slot == 0){
+			for(level=1, shift=OF1X_TIMER_WHEEL_L0_BITS; level<OF1X_TIMER_WHEEL_LEVELS; level++, shift+=OF1X_TIMER_WHEEL_LN_BITS){
+				index = (wheel->now >> shift) & OF1X_TIMER_WHEEL_LN_MASK;
+				__of1x_timer_wheel_cascade(wheel, level, index);
+				if(index)
+					break;
+			}
+		}
+
+		//Skip empty slots up to the next timer or the end of the round
+		next = __of1x_timer_wheel_next_l0_slot(wheel, slot);
+		round = wheel->now - slot;
+		if(next < 0){
+			wheel->now = round + OF1X_TIMER_WHEEL_L0_SLOTS;
+			continue;
 		}
+		if(round + next > now){
+			wheel->now = now+1;
+			break;
+		}
+		wheel->now = round + next;
+
+		//NOTE the tick is not consumed; the next call resumes from it (cascading again is harmless)
+		if(!__of1x_expire_timers(&wheel->slots[next], exp))
+			return true;
+		wheel->now++;
 	}
-	
-	return tg_iterator;
+
+	return false;
 }
-#endif
 
 static rofl_result_t __of1x_add_single_timer(of1x_flow_table_t* const table, const uint32_t timeout, of1x_flow_entry_t* entry, of1x_timer_timeout_type_t is_idle)
 {
-	uint64_t expiration_time;
+	of1x_entry_timer_t* timer;
 	struct timeval now;
-	platform_gettimeofday(&now);
-	expiration_time = __of1x_get_expiration_time_slotted(timeout, &now);
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	// add entries to the position tc + hard_timeout_s
-	if(timeout > OF1X_TIMER_GROUPS_MAX)
+
+	if(timeout > OF1X_TIMER_MAX_TIMEOUT)
 	{
-		ROFL_PIPELINE_DEBUG("Timeout value excedded maximum value (hto=%d, MAX=%d)\n", timeout,OF1X_TIMER_GROUPS_MAX);
+		ROFL_PIPELINE_DEBUG("Timeout value excedded maximum value (to=%d, MAX=%d)\n", timeout, OF1X_TIMER_MAX_TIMEOUT);
 		return ROFL_FAILURE;
 	}
-	
-	
-	int slot_delta = expiration_time - table->timers[table->current_timer_group].timeout; //ms
-	
-	//NOTE we allocate the timer in the next slot rounding up:
-	//so the actual expiration time will be a value in [hard_timeout,hard_timeout+OF1X_TIMER_SLOT_MS)
-	int slot_position = (table->current_timer_group+(slot_delta/OF1X_TIMER_SLOT_MS))%(OF1X_TIMER_GROUPS_MAX);
-	if(__of1x_entry_timer_init(&(table->timers[slot_position]), entry, is_idle)==NULL)
-		return ROFL_FAILURE;
 
-#else
-	
-	of1x_timer_group_t* tg_iterator = __of1x_dynamic_slot_search(table, expiration_time);
-	if (tg_iterator==NULL)
-		return ROFL_FAILURE;
-	
-	// add entry to this group. new_group.list->num_of_timers++; ...
-	if(__of1x_entry_timer_init(tg_iterator, entry, is_idle, NULL) == NULL)
-		return ROFL_FAILURE;
-	
-#endif
+	timer = (is_idle)? &entry->cold->timer_info.idle_timer : &entry->cold->timer_info.hard_timer;
+	timer->entry = entry;
+	timer->type = is_idle;
+
+	//Already scheduled (should never happen)
+	if(unlikely(__of1x_timer_is_scheduled(timer)))
+		__of1x_timer_wheel_unlink(&table->timers, timer);
+
+	platform_gettimeofday(&now);
+
+	//Not used yet
+	if(is_idle)
+		entry->stats.last_used = (uint32_t)__of1x_get_time_ms(&now);
+
+	__of1x_schedule_timer(table, timer, __of1x_get_expiration_time(timeout, &now));
+
 	return ROFL_SUCCESS;
 }
 
 //Add timer to a table
 rofl_result_t __of1x_add_timer(of1x_flow_table_t* const table, of1x_flow_entry_t* const entry){
-	rofl_result_t res;
-	//NOTE we don't use that lock because this is only called from of1x_add_flow_entry...()
-	
-	if(entry->timer_info.idle_timeout)
-	{
-		res = __of1x_add_single_timer(table, entry->timer_info.idle_timeout, entry, IDLE_TO); //is_idle = 1
-		if(res == ROFL_FAILURE)
-		{
-			return ROFL_FAILURE;
-		}
-	}
-	if(entry->timer_info.hard_timeout)
-	{
-		res = __of1x_add_single_timer(table, entry->timer_info.hard_timeout, entry, HARD_TO); //is_idle = 0
-		if(res == ROFL_FAILURE)
-		{
-			return ROFL_FAILURE;
-		}
-	}
-	
-	return ROFL_SUCCESS;
+	rofl_result_t res = ROFL_SUCCESS;
+
+	//Serialize with the expiration processing
+	platform_mutex_lock(table->mutex);
+
+	if(entry->cold->timer_info.idle_timeout)
+		res = __of1x_add_single_timer(table, entry->cold->timer_info.idle_timeout, entry, IDLE_TO); //is_idle = 1
+
+	if(res == ROFL_SUCCESS && entry->cold->timer_info.hard_timeout)
+		res = __of1x_add_single_timer(table, entry->cold->timer_info.hard_timeout, entry, HARD_TO); //is_idle = 0
+
+	platform_mutex_unlock(table->mutex);
+
+	return res;
 }
 
-void __of1x_process_pipeline_tables_timeout_expirations(of1x_pipeline_t *const pipeline){
+bool __of1x_process_pipeline_tables_timeout_expirations(of1x_pipeline_t *const pipeline){
 
 	unsigned int i;
-	
-	struct timeval system_time;
-	platform_gettimeofday(&system_time);
-	uint64_t now = __of1x_get_time_ms(&system_time);
+	bool pending = false;
+	uint64_t now = __of1x_timer_get_ms();
+	of1x_timer_expiration_t exp;
+
+	//Coarse clock of packet processing (last used timestamps)
+	exp.clock = tid_get_clock(ROFL_PIPELINE_LOCKED_TID);
+	tid_set_clock((uint32_t)now);
+
+	exp.pipeline = pipeline;
 
 	for(i=0;i<pipeline->num_of_tables;i++)
 	{
 		of1x_flow_table_t* table = &pipeline->tables[i];
+
+		exp.id_table = i;
+		exp.budget = (pipeline->timeout_budget)? pipeline->timeout_budget : UINT_MAX;
+		exp.num_of_entries = 0;
+
 		platform_mutex_lock(table->mutex);
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-		while(table->timers[table->current_timer_group].timeout<=now)
-		{
-			//rotate the timers
-			__of1x_timer_group_rotate(pipeline,&(table->timers[table->current_timer_group]),i);
-		}
-#else	
-		of1x_timer_group_t* slot_it, *next;
-		for(slot_it=table->timers; slot_it; slot_it=next)
-		{
-			if(now<slot_it->timeout) //Current slot time > time_now. We are done
-				break;
-			//remove all entries and the timer group.
-			if(__of1x_destroy_all_entries_from_timer_group(slot_it, table)!=ROFL_SUCCESS)
-			{
-				ROFL_PIPELINE_DEBUG("Error while destroying timer group\n");
-				platform_mutex_unlock(table->mutex);
-				return;
-			}
-			next = slot_it->next;
-			if(slot_it)
-				__of1x_destroy_timer_group(slot_it, table);
-		}		
-#endif
+		if(__of1x_advance_timer_wheel(&exp, now / OF1X_TIMER_TICK_MS))
+			pending = true;
+		__of1x_flush_expired_entries(&exp);
 		platform_mutex_unlock(table->mutex);
+
+		//Release (if possible) the entries removed
+		tid_reclaim(false);
+	}
+
+	return pending;
+}
+
+void of1x_set_timeout_expiration_budget(of1x_pipeline_t *const pipeline, unsigned int budget){
+	pipeline->timeout_budget = budget;
+}
+
+rofl_result_t of1x_set_table_idle_timestamps(of1x_pipeline_t *const pipeline, const unsigned int table_id, bool enabled){
+
+	of1x_flow_table_t* table;
+	of1x_flow_entry_t* entry;
+	uint32_t now = (uint32_t)__of1x_timer_get_ms();
+
+	if(unlikely(table_id >= pipeline->num_of_tables))
+		return ROFL_FAILURE;
+
+	table = &pipeline->tables[table_id];
+
+	//Serialize with flow_mods and expirations
+	platform_mutex_lock(table->mutex);
+
+	table->timers.idle_timestamps = enabled;
+
+	//Entries (all matching algorithms keep the table->entries list); when
+	//enabled, they are considered used now
+	for(entry = table->entries; entry; entry = entry->next){
+		entry->stats.last_used = now;
+		__of1x_stats_flow_set_mode(entry, table);
 	}
-	return;
+
+	platform_mutex_unlock(table->mutex);
+
+	return ROFL_SUCCESS;
 }
@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <sys/time.h>
 #include "rofl_datapath.h" 
 
@@ -20,34 +21,53 @@
 */
 
 /*
-* OF1X Timers. Implementation assumes (and enforces) that ALL timers will expire in a multiple of OF1X_TIMER_SLOT_MS ms
+* OF1X Timers. Flow timeouts are kept, per table, in a hierarchical timing
+* wheel of OF1X_TIMER_TICK_MS ticks:
+*
+* - Level 0: OF1X_TIMER_WHEEL_L0_SLOTS slots of 1 tick
+* - Level n (1..3): OF1X_TIMER_WHEEL_LN_SLOTS slots of L0_SLOTS*LN_SLOTS^(n-1) ticks
+*
+* Timers are placed in the lowest level whose range covers them, and are
+* moved down (cascaded) when level 0 wraps around. Timer nodes are embedded in
+* the flow entry (no allocations); adding and cancelling a timer is O(1).
 */
-#define OF1X_TIMER_SLOT_MS 1000 //1s
+#define OF1X_TIMER_TICK_MS 1
 
-//Flag to define the usage of static allocation of slots for the timers
-#ifdef OF1X_TIMER_DYNAMIC_ALLOCATION_SLOTS
-	#error "Dynamic timers are not yet supported."
-	#define OF1X_TIMER_STATIC_ALLOCATION_SLOTS 0
-#else
-	#define OF1X_TIMER_STATIC_ALLOCATION_SLOTS 1
-#endif
+#define OF1X_TIMER_WHEEL_L0_BITS 8
+#define OF1X_TIMER_WHEEL_LN_BITS 6
+#define OF1X_TIMER_WHEEL_L0_SLOTS (1<<OF1X_TIMER_WHEEL_L0_BITS) //256
+#define OF1X_TIMER_WHEEL_LN_SLOTS (1<<OF1X_TIMER_WHEEL_LN_BITS) //64
+#define OF1X_TIMER_WHEEL_LEVELS 4
+#define OF1X_TIMER_WHEEL_NUM_OF_SLOTS (OF1X_TIMER_WHEEL_L0_SLOTS + (OF1X_TIMER_WHEEL_LEVELS-1)*OF1X_TIMER_WHEEL_LN_SLOTS)
 
-#define OF1X_TIMER_GROUPS_MAX 65536 //timeouts are given in a uint16_t=> 2^16
+//Ticks covered by the wheel (2^26 ms, ~18.6h)
+#define OF1X_TIMER_WHEEL_RANGE (1ULL << (OF1X_TIMER_WHEEL_L0_BITS + (OF1X_TIMER_WHEEL_LEVELS-1)*OF1X_TIMER_WHEEL_LN_BITS))
+
+//Maximum timeout (s); timeouts are given in a uint16_t => 2^16
+#define OF1X_TIMER_MAX_TIMEOUT 65536
 
 //fwd declarations
 struct of1x_pipeline;
 struct of1x_flow_entry;
 struct of1x_flow_table;
-struct of1x_timer_group;
+struct of1x_timer_list;
 
 typedef enum{
 	HARD_TO=0,
 	IDLE_TO=1,
 }of1x_timer_timeout_type_t;
 
+/**
+* Timer node (embedded in of1x_timers_info_t)
+*/
 typedef struct of1x_entry_timer{
 	struct of1x_flow_entry* entry;
-	struct of1x_timer_group* group;
+
+	//Slot (NULL if not scheduled)
+	struct of1x_timer_list* list;
+
+	//Expiration (tick)
+	uint64_t expiration;
 
 	//linked list	
 	struct of1x_entry_timer* prev;
@@ -65,29 +85,37 @@ typedef struct of1x_timers_info{
 	// less accurate but more eficient
 	uint64_t last_packet_count;
 	
-	of1x_entry_timer_t * idle_timer_entry;
-	of1x_entry_timer_t * hard_timer_entry;
+	of1x_entry_timer_t idle_timer;
+	of1x_entry_timer_t hard_timer;
 
 }of1x_timers_info_t;
 
+//Wheel slot
 typedef struct of1x_timer_list{
 	unsigned int num_of_timers;
 	of1x_entry_timer_t* head;
 	of1x_entry_timer_t* tail;	
 }of1x_timer_list_t;
 
+/**
+* Per table timing wheel
+*/
+typedef struct of1x_timer_wheel{
+	//Next tick to be processed
+	uint64_t now;
 
+	//Timers scheduled
+	unsigned int num_of_timers;
 
-typedef struct of1x_timer_group{
-	uint64_t timeout; //Expiration time in ms (slot)	
-	of1x_timer_list_t list; //List of entries that expire at this timeout
-	
-#if ! OF1X_TIMER_STATIC_ALLOCATION_SLOTS	
-	struct of1x_timer_group* prev; //linked list
-	struct of1x_timer_group* next;
-#endif
-	
-}of1x_timer_group_t;
+	//Idle timeouts from the last used timestamps (of1x_set_table_idle_timestamps())
+	bool idle_timestamps;
+
+	//Non-empty slots
+	uint64_t bitmap[OF1X_TIMER_WHEEL_NUM_OF_SLOTS/64];
+
+	//Level 0 slots, followed by the slots of levels 1..3
+	of1x_timer_list_t slots[OF1X_TIMER_WHEEL_NUM_OF_SLOTS];
+}of1x_timer_wheel_t;
 
 //C++ extern C
 ROFL_BEGIN_DECLS
@@ -96,17 +124,59 @@ ROFL_BEGIN_DECLS
 rofl_result_t __of1x_add_timer(struct of1x_flow_table* const table, struct of1x_flow_entry* const entry);
 rofl_result_t __of1x_destroy_timer_entries(struct of1x_flow_entry * entry);
 
-void __of1x_process_pipeline_tables_timeout_expirations(struct of1x_pipeline *const pipeline);
+//Returns true if there are expirations pending (budget exhausted)
+bool __of1x_process_pipeline_tables_timeout_expirations(struct of1x_pipeline *const pipeline);
 
-void __of1x_dump_timers_structure(of1x_timer_group_t * timer_group);
-rofl_result_t __of1x_timer_group_static_init(struct of1x_flow_table* table);
-void __of1x_timer_group_static_destroy(struct of1x_flow_table* table);
-//void __of1x_timer_update_entry(struct of1x_flow_entry * flow_entry, struct timeval ts);
+/**
+* @brief Sets the maximum number of timers expired per table on every timeout
+* processing call
+* @ingroup core_of1x
+*
+* Bounds the time table->mutex is held (and flow_mods are delayed) on a mass
+* expiration. The expirations beyond the budget are processed in the next
+* calls; of_process_pipeline_tables_timeout_expirations() returns true while
+* there are pending ones, so that the platform can call it again earlier.
+*
+* @param budget Timers per table and call; 0 (default) is unlimited
+*/
+void of1x_set_timeout_expiration_budget(struct of1x_pipeline *const pipeline, unsigned int budget);
+
+/**
+* @brief Evaluates the idle timeouts of a table from the last used timestamps of the entries
+* @ingroup core_of1x
+*
+* When enabled, packet processing keeps the coarse time of the last use of
+* the entries with an idle timeout (tid_get_clock(); relaxed stores, once per
+* tick), and they expire after last used + idle timeout, in O(1), regardless
+* of the statistics mode. Otherwise, the idle timeout is checked (lazily)
+* against the packet counts of the entry when it elapses, and rescheduled from
+* the time of the check if the entry was used.
+*
+* The clock is advanced by the timeout processing, so its resolution is the
+* period at which timeouts are processed, which must be regular. A timestamp
+* only bounds the last use to one period, so entries expire between idle
+* timeout and idle timeout + one period after their last use; an entry used
+* in every period never expires, even if the idle timeout is shorter than it.
+*/
+rofl_result_t of1x_set_table_idle_timestamps(struct of1x_pipeline *const pipeline, const unsigned int table_id, bool enabled);
+
+void __of1x_dump_timers_structure(of1x_timer_wheel_t* wheel);
+void __of1x_init_timer_wheel(struct of1x_flow_table* table);
 void __of1x_fill_new_timer_entry_info(struct of1x_flow_entry * entry, uint32_t hard_timeout, uint32_t idle_timeout);
 // public for testing
-uint64_t __of1x_get_expiration_time_slotted (uint32_t timeout,struct timeval *now);
+uint64_t __of1x_get_expiration_time(uint32_t timeout,struct timeval *now);
 inline uint64_t __of1x_get_time_ms(struct timeval *time);
 
+//Timers pending in the wheel (testing)
+static inline unsigned int __of1x_timer_wheel_num_of_timers(const of1x_timer_wheel_t* wheel){
+	return wheel->num_of_timers;
+}
+
+//True if the timer is scheduled
+static inline bool __of1x_timer_is_scheduled(const of1x_entry_timer_t* timer){
+	return timer->list != NULL;
+}
+
 static inline
 void __of1x_reset_last_packet_count_idle_timeout(of1x_timers_info_t *timer_info){
 	timer_info->last_packet_count=0;
@@ -5,7 +5,9 @@
 #include "platform/memory.h"
 #include "platform/likely.h"
 #include "util/logging.h"
+#include "threading.h"
 #include "openflow/of_switch.h"
+#include "openflow/openflow1x/pipeline/of1x_statistics.h"
 #include "openflow/openflow1x/pipeline/matching_algorithms/matching_algorithms.h"
 
 static physical_switch_t* psw=NULL;
@@ -40,10 +42,21 @@ rofl_result_t physical_switch_init(){
 	
 	if( unlikely(psw==NULL) )
 		return ROFL_FAILURE;	
+
+	//Per thread state is allocated from now on
+	__tid_freeze_num_of_tids(true);
+
+	//Per thread statistics counters
+	if(__of1x_init_stats_slabs() != ROFL_SUCCESS)
+		return ROFL_FAILURE;
 	
 	psw->mutex = platform_mutex_init(NULL);
 	if(!psw->mutex)
 		return ROFL_FAILURE;
+
+	psw->pools_mutex = platform_mutex_init(NULL);
+	if(!psw->pools_mutex)
+		return ROFL_FAILURE;
 	
 	platform_memset(psw->logical_switches, 0, sizeof(psw->logical_switches));
 	psw->num_of_logical_switches = 0;	
@@ -52,6 +65,7 @@ rofl_result_t physical_switch_init(){
 	platform_memset(psw->tunnel_ports, 0, sizeof(psw->tunnel_ports));
 	platform_memset(psw->virtual_ports, 0, sizeof(psw->virtual_ports));
 	platform_memset(psw->meta_ports, 0, sizeof(psw->meta_ports));
+	platform_memset((void*)psw->pools, 0, sizeof(psw->pools));
 	
 	//Generate metaports
 	//Flood
@@ -128,12 +142,74 @@ void physical_switch_destroy(){
 
 	//Destroy monitoring
 	__monitoring_destroy(&psw->monitoring);		
+
+	//Release the objects whose release was deferred (e.g. flow entries)
+	tid_reclaim(true);
+
+	//Number of TIDs can be changed again
+	__tid_freeze_num_of_tids(false);
+
+	//Destroy object pools (objects still in use are released later on)
+	for(i=0;i<SLAB_MAX_POOLS;i++){
+		if(psw->pools[i])
+			__slab_pool_destroy(psw->pools[i]);
+	}
+	platform_mutex_destroy(psw->pools_mutex);
+
+	//Destroy statistics slabs (unless counters are still in use)
+	__of1x_destroy_stats_slabs();
 	
 	//Destroy mutex
 	platform_mutex_destroy(psw->mutex);
 	
 	//destroy physical switch
 	platform_free_shared(psw);
+	psw = NULL;
+}
+
+//
+// Object pools
+//
+
+static slab_pool_t* __physical_switch_get_pool(const slab_desc_t* desc){
+
+	slab_pool_t* pool;
+#ifdef ROFL_PIPELINE_HUGEPAGES
+	bool hugepages = true;
+#else
+	bool hugepages = false;
+#endif
+
+	platform_mutex_lock(psw->pools_mutex);
+
+	pool = psw->pools[desc->id];
+	if(!pool){
+		pool = __slab_pool_init(desc, hugepages);
+
+		//Pool initialized before it is visible to the lock-free readers
+		tid_memory_barrier();
+		psw->pools[desc->id] = pool;
+	}
+
+	platform_mutex_unlock(psw->pools_mutex);
+
+	return pool;
+}
+
+void* __physical_switch_alloc(const slab_desc_t* desc){
+
+	slab_pool_t* pool = NULL;
+
+	if(likely(psw != NULL)){
+		//Single (volatile) load; the pool is only dereferenced through it
+		//(address dependency), so it is seen initialized
+		pool = psw->pools[desc->id];
+		if(unlikely(pool == NULL))
+			pool = __physical_switch_get_pool(desc);
+	}
+
+	//Falls back to platform_malloc_shared() if pool is NULL
+	return __slab_alloc(pool, desc);
 }
 
 //
@@ -12,6 +12,7 @@
 #include "switch_port.h"
 #include "monitoring.h"
 #include "platform/lock.h"
+#include "util/slab.h"
 
 /**
 * @file physical_switch.h
@@ -176,6 +177,11 @@ typedef struct physical_switch{
 	//Monitoring data
 	monitoring_state_t monitoring;
 
+	//Object pools (flow entries, matches...), created (under pools_mutex) and
+	//published on first use; read without locks
+	slab_pool_t* volatile pools[SLAB_MAX_POOLS];
+	platform_mutex_t* pools_mutex;
+
 	/* 
 	* Other state 
 	*/
@@ -234,6 +240,18 @@ void __set_physical_switch(physical_switch_t* sw);
 */
 void physical_switch_destroy(void);
 
+/**
+* Allocates a pipeline object from the physical switch pools (slab). If the physical
+* switch is not initialized, it falls back to platform_malloc_shared(). Objects
+* shall be released via __slab_free().
+*
+* Pipeline objects are only allocated in the control path (flow_mods, group_mods,
+* entry updates); packet processing never allocates from the pools. Every
+* allocation takes the (per type) pool mutex for a few instructions, which only
+* serializes concurrent control path operations.
+*/
+void* __physical_switch_alloc(const slab_desc_t* desc);
+
 
 //
 //
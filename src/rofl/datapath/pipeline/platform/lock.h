@@ -5,6 +5,7 @@
 #ifndef __PLATFORM_LOCK_H__
 #define __PLATFORM_LOCK_H__
 
+#include <stdint.h>
 #include "rofl_datapath.h"
 
 /**
@@ -138,6 +139,33 @@ void platform_rwlock_wrlock(platform_rwlock_t* rwlock);
 */
 void platform_rwlock_wrunlock(platform_rwlock_t* rwlock);
 
+/* WAIT (futex-like) */
+
+/**
+* @brief Blocks the calling thread while *addr == val, for at most timeout_us
+* microseconds (0: no timeout).
+* @ingroup platform_lock
+*
+* This has the same semantic as Linux's FUTEX_WAIT; the comparison and the
+* blocking must be atomic with respect to platform_wake_all(), and spurious
+* wake ups are allowed (callers always re-check their condition). On Linux it
+* maps straight forward to the futex() syscall; other platforms can implement
+* it with a condition variable.
+*
+* The library uses it to block writers (e.g. flow_mods waiting for a grace
+* period, see threading.h), after a bounded spinning, until the packet
+* processing threads leave the pipeline.
+*/
+void platform_wait_on(volatile uint32_t* addr, uint32_t val, uint32_t timeout_us);
+
+/**
+* @brief Wakes up all the threads blocked in platform_wait_on() over addr.
+* @ingroup platform_lock
+*
+* This has the same semantic as Linux's FUTEX_WAKE (INT_MAX waiters).
+*/
+void platform_wake_all(volatile uint32_t* addr);
+
 //C++ extern C
 ROFL_END_DECLS
 
@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include "rofl_datapath.h"
 
 /**
@@ -74,6 +75,34 @@ void platform_free( void* data );
 */
 void platform_free_shared( void* data );
 
+/**
+* @brief Allocates a large chunk of memory (R/W) shared among all the
+* threads, hardware threads, cores... that may interact with the same logical switch.
+* @ingroup platform_memory
+*
+* Chunks are used to back the pipeline object pools (slabs) of flow entries,
+* matches, actions... They are only released (platform_free_shared_chunk())
+* when the pool is destroyed.
+*
+* If hugepages is true (pipeline compiled with --with-pipeline-hugepages),
+* the platform should back the chunk with hugepages (e.g. mmap() MAP_HUGETLB),
+* falling back to regular pages if not available. In LIBC compatible platforms,
+* without hugepage support, this is equivalent to malloc().
+*
+* @param length Length of the chunk in bytes
+* @param hugepages Hint to back the chunk with hugepages
+*/
+void* platform_malloc_shared_chunk( size_t length, bool hugepages );
+
+/**
+* @brief Frees a chunk of memory previously allocated with
+* platform_malloc_shared_chunk().
+* @ingroup platform_memory
+*
+* @param length Length of the chunk in bytes, as passed to platform_malloc_shared_chunk()
+*/
+void platform_free_shared_chunk( void* data, size_t length );
+
 /**
 * @brief Copies a chunk of memory. Equivalent to LIBC memcpy() 
 * @ingroup platform_memory
@@ -0,0 +1,237 @@
+#include "threading.h"
+
+#include "platform/memory.h"
+
+/*
+* Epoch records (one cache line per TID) and global epoch
+*/
+tid_epoch_t tid_epochs[ROFL_PIPELINE_MAX_TIDS] __attribute__((aligned(TID_CACHE_LINE_SIZE)));
+volatile uint64_t tid_global_epoch = 1;
+volatile uint32_t tid_num_of_waiters = 0;
+
+//Coarse clock (tid_set_clock())
+volatile uint32_t tid_global_clock = 0;
+
+/*
+* ROFL_PIPELINE_LOCKED_TID (shared) grace periods. The threads counted in
+* shared_readers[i] entered after the global epoch reached
+* tid_shared_flip_epoch[i]
+*/
+volatile uint32_t tid_shared_parity = 0;
+static volatile uint64_t tid_shared_flip_epoch[2] = { 1, 1 };
+__thread unsigned int tid_shared_nesting = 0;
+__thread uint32_t tid_shared_idx = 0;
+
+//Serializes parity flips (tid_synchronize())
+static volatile uint32_t tid_shared_lock = 0;
+
+/*
+* TIDs in use
+*/
+unsigned int tid_num_of_tids = ROFL_PIPELINE_MAX_TIDS;
+static bool tid_num_of_tids_frozen = false;
+
+rofl_result_t tid_set_num_of_tids(unsigned int num_of_tids){
+
+	if( num_of_tids == 0 || num_of_tids > ROFL_PIPELINE_MAX_TIDS || ROFL_PIPELINE_LOCKED_TID >= num_of_tids )
+		return ROFL_FAILURE;
+
+	//Per thread state has already been allocated
+	if(tid_num_of_tids_frozen)
+		return ROFL_FAILURE;
+
+	tid_num_of_tids = num_of_tids;
+
+	return ROFL_SUCCESS;
+}
+
+void __tid_freeze_num_of_tids(bool freeze){
+	tid_num_of_tids_frozen = freeze;
+}
+
+/*
+* Deferred release list
+*/
+typedef struct tid_deferred{
+	void* obj;
+	void (*release)(void* obj);
+
+	//Global epoch when deferred
+	uint64_t epoch;
+
+	struct tid_deferred* next;
+}tid_deferred_t;
+
+static tid_deferred_t* volatile tid_deferred = NULL;
+static volatile uint32_t tid_deferred_lock = 0;
+
+/*
+* Writer locks; 0: unlocked, 1: locked, 2: locked with (possibly) blocked threads
+*/
+static inline void tid_lock(volatile uint32_t* lock){
+
+	unsigned int i;
+
+	for(i=0;i<TID_WAIT_SPIN_ITERATIONS;i++){
+		if( likely(CAS(lock, 0, 1) == true) )
+			return;
+		tid_cpu_relax();
+	}
+
+	while( __sync_lock_test_and_set(lock, 2) != 0 )
+		platform_wait_on(lock, 2, 0);
+}
+
+static inline void tid_unlock(volatile uint32_t* lock){
+
+	if( unlikely(__sync_fetch_and_sub(lock, 1) != 1) ){
+		*lock = 0;
+		platform_wake_all(lock);
+	}
+}
+
+/*
+* Writer waits
+*/
+static inline bool tid_blocks(tid_epoch_t* e, uint64_t epoch){
+	uint64_t state = e->s.state;
+	return (state & 0x1ULL) > 0 && (state >> 1) < epoch;
+}
+
+static inline bool tid_shared_blocks(tid_epoch_t* e, uint64_t parity){
+	return e->s.shared_readers[parity] > 0;
+}
+
+static void tid_wait(tid_epoch_t* e, bool (*blocks)(tid_epoch_t* e, uint64_t arg), uint64_t arg){
+
+	unsigned int i;
+	uint32_t seq;
+
+	//Spin first; threads are usually only a few packets away from leaving
+	for(i=0;i<TID_WAIT_SPIN_ITERATIONS;i++){
+		if( likely(!(*blocks)(e, arg)) )
+			return;
+		tid_cpu_relax();
+	}
+
+	//Block (full barrier)
+	__sync_add_and_fetch(&tid_num_of_waiters, 1);
+
+	do{
+		seq = e->s.wake_seq;
+		tid_memory_barrier();
+		if(!(*blocks)(e, arg))
+			break;
+		platform_wait_on(&e->s.wake_seq, seq, TID_WAIT_TIMEOUT_US);
+	}while(1);
+
+	__sync_sub_and_fetch(&tid_num_of_waiters, 1);
+}
+
+void __tid_wake(unsigned int tid){
+	tid_epoch_t* e = &tid_epochs[tid];
+
+	__sync_add_and_fetch(&e->s.wake_seq, 1);
+	platform_wake_all(&e->s.wake_seq);
+}
+
+void tid_synchronize(void){
+
+	unsigned int i;
+	uint32_t parity;
+	uint64_t epoch;
+
+	//Readers entering from now on cannot see what was unlinked before (full barrier)
+	epoch = __sync_add_and_fetch(&tid_global_epoch, 1);
+
+	for(i=0;i<tid_num_of_tids;i++){
+		if(i != ROFL_PIPELINE_LOCKED_TID)
+			tid_wait(&tid_epochs[i], tid_blocks, epoch);
+	}
+
+	//Shared TID; new readers are counted in the other parity, drain this one
+	tid_lock(&tid_shared_lock);
+
+	parity = tid_shared_parity;
+	tid_shared_flip_epoch[parity^0x1] = __sync_add_and_fetch(&tid_global_epoch, 1);
+	tid_shared_parity = parity^0x1;
+	tid_memory_barrier();
+
+	tid_wait(&tid_epochs[ROFL_PIPELINE_LOCKED_TID], tid_shared_blocks, parity);
+
+	tid_unlock(&tid_shared_lock);
+}
+
+void tid_defer_release(void* obj, void (*release)(void* obj)){
+
+	tid_deferred_t* item = (tid_deferred_t*)platform_malloc_shared(sizeof(tid_deferred_t));
+
+	if( unlikely(item == NULL) ){
+		//Wait instead
+		tid_synchronize();
+		(*release)(obj);
+		return;
+	}
+
+	item->obj = obj;
+	item->release = release;
+	item->epoch = __sync_add_and_fetch(&tid_global_epoch, 1);
+
+	tid_lock(&tid_deferred_lock);
+	item->next = tid_deferred;
+	tid_deferred = item;
+	tid_unlock(&tid_deferred_lock);
+}
+
+void tid_reclaim(bool wait){
+
+	unsigned int i;
+	uint64_t state, min_epoch;
+	tid_deferred_t **it, *item, *expired = NULL;
+
+	if( likely(tid_deferred == NULL) )
+		return;
+
+	tid_lock(&tid_deferred_lock);
+
+	if(wait){
+		//All of them
+		expired = tid_deferred;
+		tid_deferred = NULL;
+		tid_unlock(&tid_deferred_lock);
+
+		tid_synchronize();
+	}else{
+		//Oldest epoch observed by the active threads
+		tid_memory_barrier();
+		min_epoch = UINT64_MAX;
+		for(i=0;i<tid_num_of_tids;i++){
+			state = tid_epochs[i].s.state;
+			if( (state & 0x1ULL) > 0 && (state >> 1) < min_epoch )
+				min_epoch = state >> 1;
+		}
+		for(i=0;i<2;i++){
+			if( tid_shared_blocks(&tid_epochs[ROFL_PIPELINE_LOCKED_TID], i) && tid_shared_flip_epoch[i] < min_epoch )
+				min_epoch = tid_shared_flip_epoch[i];
+		}
+
+		for(it=(tid_deferred_t**)&tid_deferred; *it;){
+			item = *it;
+			if(item->epoch <= min_epoch){
+				*it = item->next;
+				item->next = expired;
+				expired = item;
+			}else{
+				it = &item->next;
+			}
+		}
+		tid_unlock(&tid_deferred_lock);
+	}
+
+	//Release
+	for(item=expired; item; item=expired){
+		expired = item->next;
+		(*item->release)(item->obj);
+		platform_free_shared(item);
+	}
+}
@@ -15,8 +15,10 @@
 #include <assert.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "rofl_datapath.h"
 #include "platform/likely.h" 
+#include "platform/lock.h" 
 
 #if !defined(__GNUC__) && !defined(__INTEL_COMPILER)
 	#error Unknown compiler; could not guess which compare-and-swap instructions to use
@@ -25,86 +27,235 @@
 	#define tid_memory_barrier __sync_synchronize
 #endif
 
-//Basic type
-typedef uint64_t tid_presence_t;
+/**
+* Size of the per-TID records (cache line), to prevent false sharing
+*/
+#define TID_CACHE_LINE_SIZE 64
 
-static inline void tid_init_presence_mask(tid_presence_t* presence_mask){
-	*presence_mask = 0x0ULL;
-}
+/**
+* Writers waiting for packet processing threads first spin (bounded) and then
+* block (platform_wait_on()). A blocked writer re-checks at least every
+* TID_WAIT_TIMEOUT_US, in case a reader missed it while leaving the pipeline
+*/
+#define TID_WAIT_SPIN_ITERATIONS 2048
+#define TID_WAIT_TIMEOUT_US 1000
+
+#if defined(__i386__) || defined(__x86_64__)
+	#define tid_cpu_relax() __asm__ __volatile__("pause" ::: "memory")
+#else
+	#define tid_cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
 
 /**
-* Set thread presence  
+* Per-TID epoch record (QSBR/EBR).
+*
+* Packet processing threads publish, with plain stores on their own cache
+* line, the global epoch they observed when entering the pipeline (active) and
+* clear it when leaving (quiescent). Writers advance the global epoch and wait
+* (tid_synchronize()) or defer the release of the unlinked objects
+* (tid_defer_release()) until all the threads that could still see them have
+* gone through a quiescent state.
 */
-static inline void tid_mark_as_present(unsigned int tid, volatile tid_presence_t* presence_mask){
-	tid_presence_t old_val, new_val;
-	
-	do{
-
-TID_MARK_AS_PRESENT_RETRY:
-		old_val = *presence_mask;
-	
-		//Check for other threads within  
-		if( unlikely(tid == ROFL_PIPELINE_LOCKED_TID ) && unlikely( ( old_val & ( 1<<tid ) ) > 0)){
-			//There some other thread in ROFL_PIPELINE_LOCKED_TID
-			usleep(0);
-			goto TID_MARK_AS_PRESENT_RETRY;
-		}
-
-		//Set our
-		new_val = old_val | ( 1<<tid );
-
-	}while( CAS(presence_mask, old_val, new_val) == false);
-
-	//Double check
-	assert( ( *presence_mask & (1<<tid) ) > 0);	
+typedef union tid_epoch{
+	struct{
+		//(epoch << 1) | 1 when active, 0 when quiescent
+		volatile uint64_t state;
+
+		//Nesting depth (e.g. burst and packet)
+		unsigned int nesting;
+
+		//Bumped on exit when there are blocked writers (platform_wait_on())
+		volatile uint32_t wake_seq;
+
+		//ROFL_PIPELINE_LOCKED_TID only; threads in the pipeline per grace
+		//period parity (tid_shared_parity)
+		volatile uint32_t shared_readers[2];
+
+		//Coarse clock (tid_global_clock) cached on enter
+		uint32_t clock;
+	}s;
+
+	uint8_t __pad[TID_CACHE_LINE_SIZE];
+}tid_epoch_t;
+
+//Records and global epoch (threading.c)
+extern tid_epoch_t tid_epochs[ROFL_PIPELINE_MAX_TIDS];
+extern volatile uint64_t tid_global_epoch;
+
+//Coarse clock (ms, wraps around), set by tid_set_clock() (threading.c)
+extern volatile uint32_t tid_global_clock;
+
+//Number of TIDs in use (threading.c)
+extern unsigned int tid_num_of_tids;
+
+//Number of writers blocked (threading.c)
+extern volatile uint32_t tid_num_of_waiters;
+
+//Grace period parity of ROFL_PIPELINE_LOCKED_TID, flipped by tid_synchronize() (threading.c)
+extern volatile uint32_t tid_shared_parity;
+
+//Per thread ROFL_PIPELINE_LOCKED_TID nesting depth and parity (threading.c)
+extern __thread unsigned int tid_shared_nesting;
+extern __thread uint32_t tid_shared_idx;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+//Wakes up the writers blocked on tid. Internal use only
+void __tid_wake(unsigned int tid);
+
+//C++ extern C
+ROFL_END_DECLS
+
+/**
+* Number of TIDs in use; valid TIDs are [0, tid_get_num_of_tids())
+*/
+static inline unsigned int tid_get_num_of_tids(void){
+	return tid_num_of_tids;
 }
-	
+
+//Release store (all previous accesses are performed before the store)
+#if defined(__i386__) || defined(__x86_64__)
+	#define tid_release_barrier() __asm__ __volatile__("" ::: "memory")
+#else
+	#define tid_release_barrier tid_memory_barrier
+#endif
+
 /**
-* Unset thread presence  
+* Marks the thread as active in the pipeline(s). It can be nested; e.g. the
+* platform can wrap a burst of packets so that the record is only written
+* once per burst.
+*
+* ROFL_PIPELINE_LOCKED_TID is shared by several threads. They do not exclude
+* each other; they are counted (atomically) in the grace period they enter
+* (tid_shared_parity), and writers wait for the count of the previous grace
+* period to drain (SRCU-like).
 */
-static inline void tid_mark_as_not_present(unsigned int tid, volatile tid_presence_t* presence_mask){
-	tid_presence_t old_val, new_val;
-	
-	do{
-		old_val = *presence_mask;
+static inline void tid_epoch_enter(unsigned int tid){
+	tid_epoch_t* e = &tid_epochs[tid];
+	uint32_t idx;
 
-		//Double check
-		assert( ( old_val & (1<<tid) ) > 0);	
+	if( unlikely(tid == ROFL_PIPELINE_LOCKED_TID) ){
+		if(tid_shared_nesting++ > 0)
+			return;
 
-		//Set our
-		new_val = old_val & ~(1 << tid);
+		do{
+			idx = tid_shared_parity;
+
+			//Full barrier
+			__sync_add_and_fetch(&e->s.shared_readers[idx], 1);
+			if( likely(tid_shared_parity == idx) )
+				break;
+
+			//A writer flipped the parity meanwhile; it may not wait for us
+			if( __sync_sub_and_fetch(&e->s.shared_readers[idx], 1) == 0 && tid_num_of_waiters > 0 )
+				__tid_wake(tid);
+		}while(1);
+
+		tid_shared_idx = idx;
+		return;
+	}
 
-	}while( CAS(presence_mask, old_val, new_val) == false);
+	if(e->s.nesting++ > 0)
+		return;
+
+	e->s.clock = tid_global_clock;
+	e->s.state = (tid_global_epoch << 1) | 0x1ULL;
+
+	//The record must be visible before any access to the pipeline state
+	tid_memory_barrier();
 }
 
 /**
-*
+* Marks the thread as quiescent (matches tid_epoch_enter())
 */
-static inline void tid_wait_all_not_present(volatile tid_presence_t* presence_mask){
-	int i;
-	uint64_t tid;
-	tid_presence_t present;
-	tid_presence_t tmp; 
-
-	//Memory barrier first
-	tid_memory_barrier();	
-
-	//Recover current present
-	present = *presence_mask;
-	
-	for(i=0;i<ROFL_PIPELINE_MAX_TIDS;i++){	
-		tid = 1 << i;
-
-		if( unlikely( ( present & tid) > 0 ) ){
-			//Wait until the core is out of the pipeline
-			do{
-				tmp = *presence_mask;
-				if( likely( ( tmp&tid ) == 0) )
-					break;
-				usleep(0);
-			}while(1);
-		}
+static inline void tid_epoch_exit(unsigned int tid){
+	tid_epoch_t* e = &tid_epochs[tid];
+
+	if( unlikely(tid == ROFL_PIPELINE_LOCKED_TID) ){
+		assert(tid_shared_nesting > 0);
+		if(--tid_shared_nesting > 0)
+			return;
+
+		//Full barrier
+		if( __sync_sub_and_fetch(&e->s.shared_readers[tid_shared_idx], 1) == 0 && unlikely(tid_num_of_waiters > 0) )
+			__tid_wake(tid);
+		return;
 	}
+
+	assert(e->s.nesting > 0);
+	if(--e->s.nesting > 0)
+		return;
+
+	assert( (e->s.state & 0x1ULL) > 0);
+
+	tid_release_barrier();
+	e->s.state = 0x0ULL;
+
+	if( unlikely(tid_num_of_waiters > 0) )
+		__tid_wake(tid);
+}
+
+/**
+* Coarse clock (ms, wraps around every ~49 days) as seen by the thread. It is
+* cached on (the outermost) tid_epoch_enter(), so reading it costs no
+* syscall nor access to shared state. Differences must be computed as
+* (uint32_t)(a-b).
+*/
+static inline uint32_t tid_get_clock(unsigned int tid){
+	if( unlikely(tid == ROFL_PIPELINE_LOCKED_TID) )
+		return tid_global_clock;
+	return tid_epochs[tid].s.clock;
+}
+
+/**
+* Sets the coarse clock (ms). Its resolution is the period at which it is
+* set; the pipeline sets it when processing the timeouts.
+*/
+static inline void tid_set_clock(uint32_t ms){
+	tid_global_clock = ms;
 }
 
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/**
+* Sets the number of packet processing threads (TIDs) the platform uses,
+* 1 <= num_of_tids <= ROFL_PIPELINE_MAX_TIDS. Per thread state (e.g. the
+* statistics counters of flow entries, tables and groups) is only allocated for
+* the TIDs in use, so that memory scales with them rather than with the compile
+* time maximum.
+*
+* It must be called before physical_switch_init(). By default all the
+* ROFL_PIPELINE_MAX_TIDS TIDs are in use.
+*/
+rofl_result_t tid_set_num_of_tids(unsigned int num_of_tids);
+
+//Prevents (allows) changes in the number of TIDs. Internal use only (physical switch)
+void __tid_freeze_num_of_tids(bool freeze);
+
+/**
+* Waits for a grace period; all the threads that were active in the pipeline
+* when called have gone through a quiescent state on return.
+*/
+void tid_synchronize(void);
+
+/**
+* Defers release(obj) until all the threads that could still be referencing
+* obj (active when called) have gone through a quiescent state. obj must
+* already be unreachable for new readers.
+*
+* Objects are released by tid_reclaim().
+*/
+void tid_defer_release(void* obj, void (*release)(void* obj));
+
+/**
+* Releases the deferred objects whose grace period has elapsed. If wait is
+* true, it waits for a grace period and releases all of them.
+*/
+void tid_reclaim(bool wait);
+
+//C++ extern C
+ROFL_END_DECLS
+
 #endif //THREADING_PP
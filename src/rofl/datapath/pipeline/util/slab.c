@@ -0,0 +1,195 @@
+#include "slab.h"
+
+#include <assert.h>
+#include "../platform/likely.h"
+#include "../platform/memory.h"
+#include "logging.h"
+
+#define SLAB_ALIGN 16
+#define SLAB_ROUND_UP(x) ( ((x) + (SLAB_ALIGN-1)) & ~((size_t)SLAB_ALIGN-1) )
+
+#define SLAB_HDR_SIZE SLAB_ROUND_UP(sizeof(slab_hdr_t))
+#define SLAB_CHUNK_HDR_SIZE SLAB_ROUND_UP(sizeof(slab_chunk_t))
+
+static inline void* __slab_obj(slab_hdr_t* hdr){
+	return ((uint8_t*)hdr) + SLAB_HDR_SIZE;
+}
+
+static inline slab_hdr_t* __slab_hdr(void* obj){
+	return (slab_hdr_t*)(((uint8_t*)obj) - SLAB_HDR_SIZE);
+}
+
+static inline slab_hdr_t* __slab_chunk_slot(slab_pool_t* pool, slab_chunk_t* chunk, unsigned int i){
+	return (slab_hdr_t*)(((uint8_t*)chunk) + SLAB_CHUNK_HDR_SIZE + i*pool->slot_size);
+}
+
+slab_pool_t* __slab_pool_init(const slab_desc_t* desc, bool hugepages){
+
+	slab_pool_t* pool = (slab_pool_t*)platform_malloc_shared(sizeof(slab_pool_t));
+
+	if(unlikely(pool == NULL))
+		return NULL;
+
+	platform_memset(pool, 0, sizeof(slab_pool_t));
+
+	pool->mutex = platform_mutex_init(NULL);
+	if(unlikely(pool->mutex == NULL)){
+		platform_free_shared(pool);
+		return NULL;
+	}
+
+	pool->desc = desc;
+	pool->hugepages = hugepages;
+	pool->slot_size = SLAB_HDR_SIZE + SLAB_ROUND_UP(desc->size);
+	pool->chunk_size = (hugepages)? SLAB_HUGE_CHUNK_SIZE : SLAB_CHUNK_SIZE;
+
+	//At least one object per chunk
+	if(pool->chunk_size < SLAB_CHUNK_HDR_SIZE + pool->slot_size)
+		pool->chunk_size = SLAB_CHUNK_HDR_SIZE + pool->slot_size;
+	pool->objs_per_chunk = (pool->chunk_size - SLAB_CHUNK_HDR_SIZE) / pool->slot_size;
+
+	return pool;
+}
+
+//Destructs the objects and releases the chunks and the pool
+static void __slab_pool_release(slab_pool_t* pool){
+
+	unsigned int i;
+	slab_chunk_t *chunk, *next;
+
+	for(chunk=pool->chunks; chunk; chunk=next){
+		next = chunk->next;
+		if(pool->desc->dtor){
+			for(i=0;i<chunk->num_of_objs;i++)
+				pool->desc->dtor(__slab_obj(__slab_chunk_slot(pool, chunk, i)));
+		}
+		platform_free_shared_chunk(chunk, pool->chunk_size);
+	}
+
+	platform_mutex_destroy(pool->mutex);
+	platform_free_shared(pool);
+}
+
+void __slab_pool_destroy(slab_pool_t* pool){
+
+	bool release;
+
+	platform_mutex_lock(pool->mutex);
+	release = (pool->in_use == 0);
+	if(!release){
+		ROFL_PIPELINE_DEBUG("%s: pool %s destroyed with %u objects in use. Deferring release\n", __func__, pool->desc->name, pool->in_use);
+		pool->orphan = true;
+	}
+	platform_mutex_unlock(pool->mutex);
+
+	if(release)
+		__slab_pool_release(pool);
+}
+
+//Carves a new chunk. Shall be called with pool->mutex held
+static rofl_result_t __slab_pool_grow(slab_pool_t* pool){
+
+	unsigned int i;
+	slab_chunk_t* chunk;
+	slab_hdr_t* hdr;
+
+	chunk = (slab_chunk_t*)platform_malloc_shared_chunk(pool->chunk_size, pool->hugepages);
+	if(unlikely(chunk == NULL))
+		return ROFL_FAILURE;
+
+	//Construct the objects; stop at the first failure
+	for(i=0;i<pool->objs_per_chunk;i++){
+		hdr = __slab_chunk_slot(pool, chunk, i);
+		if(pool->desc->ctor && pool->desc->ctor(__slab_obj(hdr)) != ROFL_SUCCESS)
+			break;
+		hdr->pool = pool;
+		hdr->u.next = pool->free;
+		pool->free = hdr;
+	}
+
+	if(unlikely(i == 0)){
+		platform_free_shared_chunk(chunk, pool->chunk_size);
+		return ROFL_FAILURE;
+	}
+
+	chunk->num_of_objs = i;
+	chunk->next = pool->chunks;
+	pool->chunks = chunk;
+	pool->num_of_chunks++;
+	pool->num_of_objs += i;
+
+	return ROFL_SUCCESS;
+}
+
+void* __slab_alloc(slab_pool_t* pool, const slab_desc_t* desc){
+
+	slab_hdr_t* hdr;
+
+	//No pool; plain platform_malloc_shared()
+	if(unlikely(pool == NULL)){
+		hdr = (slab_hdr_t*)platform_malloc_shared(SLAB_HDR_SIZE + desc->size);
+		if(unlikely(hdr == NULL))
+			return NULL;
+		if(desc->ctor && desc->ctor(__slab_obj(hdr)) != ROFL_SUCCESS){
+			platform_free_shared(hdr);
+			return NULL;
+		}
+		hdr->pool = NULL;
+		hdr->u.desc = desc;
+		return __slab_obj(hdr);
+	}
+
+	assert(pool->desc == desc);
+
+	platform_mutex_lock(pool->mutex);
+
+	if(unlikely(pool->free == NULL) && __slab_pool_grow(pool) != ROFL_SUCCESS){
+		platform_mutex_unlock(pool->mutex);
+		return NULL;
+	}
+
+	hdr = pool->free;
+	pool->free = hdr->u.next;
+	pool->in_use++;
+
+	platform_mutex_unlock(pool->mutex);
+
+	return __slab_obj(hdr);
+}
+
+void __slab_free(void* obj){
+
+	bool release;
+	slab_hdr_t* hdr;
+	slab_pool_t* pool;
+
+	//As free()
+	if(unlikely(obj == NULL))
+		return;
+
+	hdr = __slab_hdr(obj);
+	pool = hdr->pool;
+
+	if(unlikely(pool == NULL)){
+		if(hdr->u.desc->dtor)
+			hdr->u.desc->dtor(obj);
+		platform_free_shared(hdr);
+		return;
+	}
+
+	platform_mutex_lock(pool->mutex);
+
+	hdr->u.next = pool->free;
+	pool->free = hdr;
+	pool->in_use--;
+	release = pool->orphan && (pool->in_use == 0);
+
+	platform_mutex_unlock(pool->mutex);
+
+	if(release)
+		__slab_pool_release(pool);
+}
+
+void __slab_pool_dump(slab_pool_t* pool){
+	ROFL_PIPELINE_INFO("\tPool %s {object size: %u, chunks: %u, objects: %u, in use: %u%s}\n", pool->desc->name, (unsigned int)pool->desc->size, pool->num_of_chunks, pool->num_of_objs, pool->in_use, (pool->hugepages)? ", hugepages" : "");
+}
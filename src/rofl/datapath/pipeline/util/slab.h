@@ -0,0 +1,156 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include "rofl_datapath.h"
+#include "../platform/lock.h"
+
+/**
+* @file slab.h
+* @brief Fixed-size object pools (slabs) for the pipeline objects
+*
+* Flow entries, matches, ternary values, actions... are allocated from per
+* object type pools, backed by large chunks (platform_malloc_shared_chunk()),
+* instead of one platform_malloc_shared() call per object. Freed objects are kept
+* in the pool (LIFO) and reused.
+*
+* Pools keep objects constructed: the (optional) constructor of the type is
+* called once when the object is carved from a chunk and the destructor when
+* the chunk is released. This is used, for instance, to keep the locks of the
+* flow entries across allocations.
+*
+* The pools are owned by the physical switch (see physical_switch_init()).
+* Objects allocated when there are no pools (e.g. before physical_switch_init())
+* fall back to platform_malloc_shared(). Any object can be released with
+* __slab_free(), regardless of its origin.
+*/
+
+//Size of the chunks
+#define SLAB_CHUNK_SIZE (64*1024)
+//Size of the chunks, when backed by hugepages
+#define SLAB_HUGE_CHUNK_SIZE (2*1024*1024)
+
+/**
+* Pipeline object pools
+*/
+typedef enum slab_pool_id{
+	SLAB_POOL_FLOW_ENTRY = 0,
+	SLAB_POOL_MATCH,
+	SLAB_POOL_UTERN,
+	SLAB_POOL_ACTION,
+	SLAB_POOL_ACTION_GROUP,
+	SLAB_POOL_WRITE_ACTIONS,
+
+	SLAB_MAX_POOLS //Keep it last
+}slab_pool_id_t;
+
+/**
+* Object type descriptor
+*/
+typedef struct slab_desc{
+	//Name (dumping)
+	const char* name;
+
+	//Pool in the pool set
+	slab_pool_id_t id;
+
+	//Object size
+	size_t size;
+
+	//Constructor and destructor (optional)
+	rofl_result_t (*ctor)(void* obj);
+	void (*dtor)(void* obj);
+}slab_desc_t;
+
+/**
+* Chunk
+*/
+typedef struct slab_chunk{
+	struct slab_chunk* next;
+
+	//Number of slots carved (and constructed)
+	unsigned int num_of_objs;
+}slab_chunk_t;
+
+/**
+* Object header. Keep it a multiple of 16 bytes
+*/
+typedef struct slab_hdr{
+	//Owner pool or NULL (platform_malloc_shared())
+	struct slab_pool* pool;
+
+	union{
+		//Pool objects: next free object
+		struct slab_hdr* next;
+
+		//platform_malloc_shared() objects
+		const slab_desc_t* desc;
+	}u;
+}slab_hdr_t;
+
+/**
+* Pool
+*/
+typedef struct slab_pool{
+	const slab_desc_t* desc;
+
+	platform_mutex_t* mutex;
+
+	//Chunks and free objects
+	slab_chunk_t* chunks;
+	slab_hdr_t* free;
+
+	size_t slot_size;
+	size_t chunk_size;
+	unsigned int objs_per_chunk;
+	bool hugepages;
+
+	//Counters
+	unsigned int num_of_chunks;
+	unsigned int num_of_objs;
+	unsigned int in_use;
+
+	//Destroyed with objects in use; released on the last __slab_free()
+	bool orphan;
+}slab_pool_t;
+
+//C++ extern C
+ROFL_BEGIN_DECLS
+
+/**
+* Creates a pool for the object type desc
+*/
+slab_pool_t* __slab_pool_init(const slab_desc_t* desc, bool hugepages);
+
+/**
+* Destroys the pool. If there are objects in use, the pool is only
+* released once the last one is freed.
+*/
+void __slab_pool_destroy(slab_pool_t* pool);
+
+/**
+* Allocates an object of type desc from pool. If pool is NULL,
+* platform_malloc_shared() is used.
+*/
+void* __slab_alloc(slab_pool_t* pool, const slab_desc_t* desc);
+
+/**
+* Releases an object allocated via __slab_alloc(). obj may be NULL
+*/
+void __slab_free(void* obj);
+
+/*
+* Dump
+*/
+void __slab_pool_dump(slab_pool_t* pool);
+
+//C++ extern C
+ROFL_END_DECLS
+
+#endif //SLAB
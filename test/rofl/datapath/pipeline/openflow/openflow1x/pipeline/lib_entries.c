@@ -0,0 +1,39 @@
+#include "lib_entries.h"
+
+#include <CUnit/Basic.h>
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_match.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_instruction.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_table.h"
+
+/* Flow entry factories */
+of1x_flow_entry_t* port_in_entry(uint32_t port, of1x_packet_action_type_t type, uint32_t id){
+
+	wrap_uint_t field;
+	of1x_action_group_t* apply_actions;
+	of1x_flow_entry_t* entry = of1x_init_flow_entry(false);
+	CU_ASSERT_FATAL(entry != NULL);
+
+	if(port)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(port)) == ROFL_SUCCESS);
+
+	if(type == OF1X_AT_NO_ACTION)
+		return entry;
+
+	field.u64 = 0x0;
+	field.u32 = id;
+	apply_actions = of1x_init_action_group(NULL);
+	CU_ASSERT_FATAL(apply_actions != NULL);
+	of1x_push_packet_action_to_group(apply_actions, of1x_init_packet_action(type, field, 0x0));
+	of1x_add_instruction_to_group(&entry->inst_grp, OF1X_IT_APPLY_ACTIONS, apply_actions, NULL, NULL, 0);
+
+	return entry;
+}
+
+of1x_flow_entry_t* install_entry(of1x_switch_t* sw, unsigned int table_id, of1x_flow_entry_t* entry){
+
+	of1x_flow_entry_t* installed = entry;
+
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, table_id, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+
+	return installed;
+}
@@ -0,0 +1,18 @@
+#ifndef LIB_ENTRIES
+#define LIB_ENTRIES
+
+#include <inttypes.h>
+#include "rofl/datapath/pipeline/openflow/openflow1x/of1x_switch.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_entry.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_action.h"
+
+/* Flow entry factories */
+
+//Entry matching port_in (no matches if port is 0), with an APPLY action of
+//type with id (no instructions if type is OF1X_AT_NO_ACTION)
+of1x_flow_entry_t* port_in_entry(uint32_t port, of1x_packet_action_type_t type, uint32_t id);
+
+//Installs entry in table_id; returns the installed entry
+of1x_flow_entry_t* install_entry(of1x_switch_t* sw, unsigned int table_id, of1x_flow_entry_t* entry);
+
+#endif
@@ -117,7 +117,7 @@ void* io_thread(void* id){
 	}
 
 	//Check our stats
-	CU_ASSERT(sw->pipeline.tables[0].stats.s.__internal[tid].lookup_count == cnt);
+	CU_ASSERT(__of1x_stats_table_counters(&sw->pipeline.tables[0].stats,tid)->lookup_count == cnt);
 
 	return NULL;
 }
@@ -1,4 +1,6 @@
 #include "matching_test.h"
+#include "rofl/datapath/pipeline/openflow/of_switch_pp.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/matching_algorithms/loop/of1x_loop_ma.h"
 
 static of1x_switch_t* sw=NULL;
 	
@@ -462,3 +464,756 @@ void test_flow_modify(){
 	//Reupdate with NO-Strict
 
 }
+
+//Packet values are taken from the empty packet mockup
+extern uint128__t tmp_val;
+
+void test_miss_filter(){
+
+	unsigned int i;
+	of1x_flow_entry_t* entry;
+	datapacket_t pkt;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+	__of1x_stats_table_tid_t c;
+
+	clean_pipeline(sw);
+	memset(&pkt, 0, sizeof(pkt));
+	memset(&tmp_val, 0, sizeof(tmp_val));
+
+	//Unsupported key
+	CU_ASSERT(of1x_enable_table_miss_filter(&sw->pipeline, 0, OF1X_MATCH_VLAN_PCP) == ROFL_FAILURE);
+
+	//Install some exact entries before enabling it (rebuild)
+	for(i=1;i<10;i++){
+		entry = of1x_init_flow_entry(false);
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+	}
+
+	CU_ASSERT(of1x_enable_table_miss_filter(&sw->pipeline, 0, OF1X_MATCH_IN_PORT) == ROFL_SUCCESS);
+	CU_ASSERT(table->miss_filter.num_of_unkeyed == 0);
+
+	//Installed after enabling it
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(10)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+
+	for(i=1;i<=10;i++){
+		*((uint32_t*)&tmp_val) = i;
+		CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == false);
+	}
+	*((uint32_t*)&tmp_val) = 0xCAFE;
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == true);
+
+	//Filtered misses are accounted separately 
+	of_process_packet_pipeline(1, (const struct of_switch *)sw, &pkt);
+	__of1x_stats_table_consolidate(&table->stats, &c);
+	CU_ASSERT(c.filtered_miss_count == 1);
+	CU_ASSERT(c.lookup_count == 1);
+	CU_ASSERT(c.matched_count == 0);
+
+	//Wildcarded entry => filter can no longer tell
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(0x012345678901, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+	CU_ASSERT(table->miss_filter.num_of_unkeyed == 1);
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == false);
+
+	//Remove it
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(0x012345678901, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	CU_ASSERT(table->miss_filter.num_of_unkeyed == 0);
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == true);
+
+	//Removed entries are no longer in the filter
+	*((uint32_t*)&tmp_val) = 10;
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(10)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == true);
+
+	//Disable (counters are released once packet processing cannot use them)
+	CU_ASSERT(of1x_disable_table_miss_filter(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(table->miss_filter.counters == NULL);
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == false);
+	tid_reclaim(true);
+
+	//Enabled again; rebuilt from the entries
+	CU_ASSERT(of1x_enable_table_miss_filter(&sw->pipeline, 0, OF1X_MATCH_IN_PORT) == ROFL_SUCCESS);
+	*((uint32_t*)&tmp_val) = 9;
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == false);
+	*((uint32_t*)&tmp_val) = 10;
+	CU_ASSERT(__of1x_miss_filter_is_definite_miss(table, &pkt) == true);
+	CU_ASSERT(of1x_disable_table_miss_filter(&sw->pipeline, 0) == ROFL_SUCCESS);
+
+	clean_pipeline(sw);
+	memset(&tmp_val, 0, sizeof(tmp_val));
+}
+
+//Runs must delimit the entries of each number of matches within the priority range
+static void check_priority_runs(loop_state_t* state){
+
+	unsigned int i, count;
+	of1x_flow_entry_t* entry;
+	loop_prio_bucket_t* bucket;
+
+	for(bucket=state->head.next[0]; bucket; bucket=bucket->next[0]){
+		CU_ASSERT(bucket->num_of_runs > 0);
+		CU_ASSERT(bucket->runs[bucket->num_of_runs-1].last == bucket->last);
+		for(i=0, count=0, entry=bucket->first; ; entry=entry->next){
+			count++;
+			CU_ASSERT(entry->matches.num_elements == bucket->runs[i].num_of_matches);
+			if(entry == bucket->runs[i].last){
+				CU_ASSERT(i == 0 || bucket->runs[i-1].num_of_matches > bucket->runs[i].num_of_matches);
+				if(++i == bucket->num_of_runs)
+					break;
+			}
+		}
+		CU_ASSERT(i == bucket->num_of_runs);
+		CU_ASSERT(count == bucket->num_of_entries);
+	}
+}
+
+void test_priority_index(){
+
+	unsigned int i, j, num_of_matches, count;
+	of1x_flow_entry_t *entry, *prev;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+	loop_prio_bucket_t* bucket;
+
+	clean_pipeline(sw);
+	CU_ASSERT(state != NULL);
+	CU_ASSERT(state->num_of_buckets == 0);
+
+	//Install entries with random priorities and number of matches
+	for(i=0;i<500;i++){
+		entry = of1x_init_flow_entry(false);
+		entry->priority = rand()%50;
+		num_of_matches = rand()%3;
+
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		for(j=0;j<num_of_matches;j++){
+			if(j == 0)
+				CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(i, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+			if(j == 1)
+				CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_src_match(i, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+		}
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, true, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+	CU_ASSERT(table->num_of_entries == 500);
+
+	//List order (PRIORITY|HITS)
+	for(prev=table->entries, entry=prev->next; entry; prev=entry, entry=entry->next){
+		CU_ASSERT(prev->priority >= entry->priority);
+		if(prev->priority == entry->priority)
+			CU_ASSERT(prev->matches.num_elements >= entry->matches.num_elements);
+	}
+
+	//Buckets must delimit the priority ranges
+	count = 0;
+	for(bucket=state->head.next[0]; bucket; bucket=bucket->next[0]){
+		CU_ASSERT(bucket->first->priority == bucket->priority);
+		CU_ASSERT(bucket->last->priority == bucket->priority);
+		CU_ASSERT(bucket->first->prev == NULL || bucket->first->prev->priority > bucket->priority);
+		CU_ASSERT(bucket->last->next == NULL || bucket->last->next->priority < bucket->priority);
+		for(i=1, entry=bucket->first; entry != bucket->last; entry=entry->next)
+			i++;
+		CU_ASSERT(i == bucket->num_of_entries);
+		count += bucket->num_of_entries;
+	}
+	CU_ASSERT(count == 500);
+	check_priority_runs(state);
+
+	//Remove some of them (any position of the runs)
+	for(i=0;i<500;i+=3){
+		entry = of1x_init_flow_entry(false);
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, NOT_STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+		of1x_destroy_flow_entry(entry);
+	}
+	CU_ASSERT(table->num_of_entries == 500-167);
+	check_priority_runs(state);
+
+	//Overlap is still detected within the priority range
+	entry = of1x_init_flow_entry(false);
+	entry->priority = table->entries->priority;
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(table->entries->matches.head->__tern.value.u32)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, true, false) == ROFL_OF1X_FM_OVERLAP);
+	of1x_destroy_flow_entry(entry);
+
+	clean_pipeline(sw);
+	CU_ASSERT(state->num_of_buckets == 0);
+	CU_ASSERT(state->head.next[0] == NULL);
+}
+
+static of1x_flow_entry_t* strict_index_entry(unsigned int i, bool reversed){
+	of1x_flow_entry_t* entry = of1x_init_flow_entry(false);
+
+	entry->priority = i%10;
+	if(reversed){
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(i, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+	}else{
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(i, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+	}
+	return entry;
+}
+
+void test_strict_index(){
+
+	unsigned int i;
+	of1x_flow_entry_t *entry, *found;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->strict_index.num_of_entries == 0);
+
+	for(i=0;i<500;i++){
+		entry = strict_index_entry(i, false);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+	CU_ASSERT(table->num_of_entries == 500);
+	CU_ASSERT(table->strict_index.num_of_entries == 500);
+	CU_ASSERT(table->strict_index.num_of_buckets > OF1X_STRICT_INDEX_INITIAL_BUCKETS);
+
+	//Lookup
+	entry = strict_index_entry(123, false);
+	found = __of1x_strict_index_find(table, entry, OF1X_PORT_ANY, OF1X_GROUP_ANY, false);
+	CU_ASSERT(found != NULL);
+	CU_ASSERT(found->priority == 3);
+
+	//Same bucket regardless of the match order, but (as per __of1x_flow_entry_check_equal()) not equal
+	found = strict_index_entry(123, true);
+	CU_ASSERT(__of1x_match_group_hash(&found->matches) == __of1x_match_group_hash(&entry->matches));
+	CU_ASSERT(__of1x_strict_index_find(table, found, OF1X_PORT_ANY, OF1X_GROUP_ANY, false) == NULL);
+	of1x_destroy_flow_entry(found);
+
+	//Different priority
+	entry->priority++;
+	CU_ASSERT(__of1x_strict_index_find(table, entry, OF1X_PORT_ANY, OF1X_GROUP_ANY, false) == NULL);
+	of1x_destroy_flow_entry(entry);
+
+	//Re-adding an identical entry replaces it
+	entry = strict_index_entry(123, false);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 500);
+	CU_ASSERT(table->strict_index.num_of_entries == 500);
+
+	//Strict modify
+	entry = strict_index_entry(200, false);
+	CU_ASSERT(of1x_modify_flow_entry_table(&sw->pipeline, 0, &entry, STRICT, false) == ROFL_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 500);
+
+	//Strict delete (priority mismatch does not remove)
+	entry = strict_index_entry(200, false);
+	entry->priority = 9;
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 500);
+	of1x_destroy_flow_entry(entry);
+
+	for(i=0;i<500;i+=2){
+		entry = strict_index_entry(i, false);
+		CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+		of1x_destroy_flow_entry(entry);
+	}
+	CU_ASSERT(table->num_of_entries == 250);
+	CU_ASSERT(table->strict_index.num_of_entries == 250);
+
+	for(found=table->entries; found; found=found->next)
+		CU_ASSERT(found->matches.head->__tern.value.u32 % 2 == 1);
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->strict_index.num_of_entries == 0);
+}
+
+static unsigned int cookie_index_count(uint64_t cookie, uint64_t cookie_mask){
+	unsigned int count;
+	of1x_match_group_t matches;
+	of1x_stats_flow_aggregate_msg_t* msg;
+
+	__of1x_init_match_group(&matches);
+	msg = of1x_get_flow_aggregate_stats(&sw->pipeline, 0, cookie, cookie_mask, OF1X_PORT_ANY, OF1X_GROUP_ANY, &matches);
+	CU_ASSERT(msg != NULL);
+	if(!msg)
+		return 0;
+	count = msg->flow_count;
+	of1x_destroy_stats_flow_aggregate_msg(msg);
+	return count;
+}
+
+void test_cookie_index(){
+
+	unsigned int i;
+	of1x_flow_entry_t* entry;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+	uint64_t app_mask = 0xFFFFFFFF00000000ULL;
+
+	clean_pipeline(sw);
+	CU_ASSERT(of1x_enable_table_cookie_index(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(table->cookie_index.enabled == true);
+
+	//Three applications (cookie high bits), unique low bits
+	for(i=0;i<300;i++){
+		entry = of1x_init_flow_entry(false);
+		entry->priority = i%7;
+		entry->cookie = ((uint64_t)(i%3) << 32) | i;
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+	CU_ASSERT(table->cookie_index.num_of_cookies == 300);
+
+	//Exact and masked queries
+	CU_ASSERT(cookie_index_count((1ULL << 32) | 4, 0xFFFFFFFFFFFFFFFFULL) == 1);
+	CU_ASSERT(cookie_index_count((1ULL << 32) | 5, 0xFFFFFFFFFFFFFFFFULL) == 0);
+	CU_ASSERT(cookie_index_count(1ULL << 32, app_mask) == 100);
+	CU_ASSERT(cookie_index_count(0x1, 0x1) == 150);
+	CU_ASSERT(cookie_index_count(0x0, 0x0) == 300);
+
+	//Bulk removal of an application
+	entry = of1x_init_flow_entry(false);
+	entry->cookie = 2ULL << 32;
+	entry->cookie_mask = app_mask;
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, NOT_STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	CU_ASSERT(table->num_of_entries == 200);
+	CU_ASSERT(table->cookie_index.num_of_cookies == 200);
+	CU_ASSERT(cookie_index_count(2ULL << 32, app_mask) == 0);
+	CU_ASSERT(cookie_index_count(1ULL << 32, app_mask) == 100);
+
+	//Same results without the index
+	CU_ASSERT(of1x_disable_table_cookie_index(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(table->cookie_index.enabled == false);
+	CU_ASSERT(cookie_index_count(1ULL << 32, app_mask) == 100);
+	CU_ASSERT(cookie_index_count(0x1, 0x1) == 100);
+
+	//Rebuilt from the existing entries
+	CU_ASSERT(of1x_enable_table_cookie_index(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(table->cookie_index.num_of_cookies == 200);
+	CU_ASSERT(cookie_index_count(0x0, app_mask) == 100);
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->cookie_index.num_of_cookies == 0);
+	CU_ASSERT(table->cookie_index.root == 0x0);
+	CU_ASSERT(of1x_disable_table_cookie_index(&sw->pipeline, 0) == ROFL_SUCCESS);
+}
+
+static unsigned int reverse_index_count(uint32_t out_port, uint32_t out_group){
+	unsigned int count;
+	of1x_match_group_t matches;
+	of1x_stats_flow_aggregate_msg_t* msg;
+
+	__of1x_init_match_group(&matches);
+	msg = of1x_get_flow_aggregate_stats(&sw->pipeline, 0, 0x0, 0x0, out_port, out_group, &matches);
+	CU_ASSERT(msg != NULL);
+	if(!msg)
+		return 0;
+	count = msg->flow_count;
+	of1x_destroy_stats_flow_aggregate_msg(msg);
+	return count;
+}
+
+void test_reverse_index(){
+
+	unsigned int i;
+	of1x_flow_entry_t* entry;
+	of1x_bucket_list_t* buckets;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->reverse_index.enabled == true);
+
+	//Group 7 (no buckets)
+	buckets = of1x_init_bucket_list();
+	CU_ASSERT(of1x_group_add(sw->pipeline.groups, OF1X_GROUP_TYPE_ALL, 7, &buckets) == ROFL_OF1X_GM_OK);
+
+	//Entries outputting to ports 1..4
+	for(i=1;i<=200;i++){
+		entry = port_in_entry(i, OF1X_AT_OUTPUT, (i%4)+1);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+	//Entries pointing to the group (one without matches)
+	for(i=0;i<10;i++){
+		entry = port_in_entry((i)? 1000+i : 0, OF1X_AT_GROUP, 7);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+	CU_ASSERT(table->num_of_entries == 210);
+	CU_ASSERT(table->reverse_index.num_of_keys == 5);
+
+	//Filtered stats
+	CU_ASSERT(reverse_index_count(1, OF1X_GROUP_ANY) == 50);
+	CU_ASSERT(reverse_index_count(5, OF1X_GROUP_ANY) == 0);
+	CU_ASSERT(reverse_index_count(OF1X_PORT_ANY, 7) == 10);
+	CU_ASSERT(reverse_index_count(OF1X_PORT_ANY, OF1X_GROUP_ANY) == 210);
+
+	//Filtered delete
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, NOT_STRICT, 2, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	CU_ASSERT(table->num_of_entries == 160);
+	CU_ASSERT(reverse_index_count(2, OF1X_GROUP_ANY) == 0);
+	CU_ASSERT(table->reverse_index.num_of_keys == 4);
+
+	//Modify (instructions are re-indexed)
+	entry = port_in_entry(4, OF1X_AT_OUTPUT, 3);
+	CU_ASSERT(of1x_modify_flow_entry_table(&sw->pipeline, 0, &entry, STRICT, false) == ROFL_SUCCESS);
+	CU_ASSERT(reverse_index_count(3, OF1X_GROUP_ANY) == 51);
+	CU_ASSERT(reverse_index_count(1, OF1X_GROUP_ANY) == 49);
+
+	//Port down flushing
+	CU_ASSERT(of1x_remove_flow_entries_using_port(&sw->pipeline, 3) == ROFL_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 109);
+	CU_ASSERT(reverse_index_count(3, OF1X_GROUP_ANY) == 0);
+
+	//Group lookup and deletion
+	entry = of1x_matching_algorithms[table->matching_algorithm].find_entry_using_group_hook(table, 7);
+	CU_ASSERT(entry != NULL);
+	CU_ASSERT(of1x_group_delete(&sw->pipeline, sw->pipeline.groups, 7) == ROFL_OF1X_GM_OK);
+	CU_ASSERT(of1x_matching_algorithms[table->matching_algorithm].find_entry_using_group_hook(table, 7) == NULL);
+	CU_ASSERT(table->num_of_entries == 99);
+	CU_ASSERT(reverse_index_count(OF1X_PORT_ANY, 7) == 0);
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->reverse_index.num_of_keys == 0);
+}
+
+//Entry shapes (one per priority): exact MAC, IPv4 prefix + port, port, no matches
+static of1x_flow_entry_t* overlap_index_entry(unsigned int i, unsigned int j){
+	of1x_flow_entry_t* entry = of1x_init_flow_entry(false);
+	uint32_t v = (i*2)%64;
+
+	entry->priority = j%4;
+	switch(j%4){
+		case 0:
+			CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(0x000102030400ULL | v, 0xFFFFFFFFFFFFULL)) == ROFL_SUCCESS);
+			break;
+		case 1:
+			CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_ip4_dst_match(0x0A000000 | (v << 16) | (i%7 << 8), (i%2)? 0xFFFFFF00 : 0xFFFF0000)) == ROFL_SUCCESS);
+			CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i%5)) == ROFL_SUCCESS);
+			break;
+		case 2:
+			CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(v)) == ROFL_SUCCESS);
+			break;
+		default:
+			break;
+	}
+	return entry;
+}
+
+static of1x_flow_entry_t* overlap_brute_force(of1x_flow_table_t* table, of1x_flow_entry_t* entry){
+	of1x_flow_entry_t* it;
+
+	for(it=table->entries; it; it=it->next){
+		if(__of1x_flow_entry_check_overlap(it, entry, true, false, OF1X_PORT_ANY, OF1X_GROUP_ANY))
+			return it;
+	}
+	return NULL;
+}
+
+void test_overlap_index(){
+
+	unsigned int i, j, num_of_overlaps = 0;
+	of1x_flow_entry_t *entry, *found;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->overlap_index.enabled == true);
+
+	//Populate (no overlap check) with even values and a single entry without matches
+	for(i=0;i<16;i++){
+		for(j=0;j<3;j++){
+			entry = overlap_index_entry(i, j);
+			CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+		}
+	}
+	entry = overlap_index_entry(0, 3);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+
+	//Index and brute force must agree
+	for(i=0;i<200;i++){
+		for(j=0;j<4;j++){
+			entry = overlap_index_entry(i*7+1, j);
+			platform_mutex_lock(table->mutex);
+			found = __of1x_overlap_index_find(table, entry, false, OF1X_PORT_ANY, OF1X_GROUP_ANY);
+			CU_ASSERT( (found == NULL) == (overlap_brute_force(table, entry) == NULL) );
+			platform_mutex_unlock(table->mutex);
+			if(found)
+				num_of_overlaps++;
+			of1x_destroy_flow_entry(entry);
+		}
+	}
+	CU_ASSERT(num_of_overlaps > 0);
+	CU_ASSERT(num_of_overlaps < 800);
+
+	//Through the flow-mod API
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(0x000102030400ULL | 4, 0xFFFFFFFFFFFFULL)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, true, false) == ROFL_OF1X_FM_OVERLAP);
+	entry->priority = 7;
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, true, false) == ROFL_OF1X_FM_SUCCESS);
+
+	//The entry without matches (priority 3) overlaps anything
+	entry = of1x_init_flow_entry(false);
+	entry->priority = 3;
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(77)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, true, false) == ROFL_OF1X_FM_OVERLAP);
+	of1x_destroy_flow_entry(entry);
+
+	clean_pipeline(sw);
+	CU_ASSERT(table->overlap_index.num_of_entries == 0);
+}
+
+//Reference lookup (list of entries)
+static of1x_flow_entry_t* loop_array_reference(of1x_flow_table_t* table, datapacket_t* pkt){
+
+	of1x_flow_entry_t* entry;
+	of1x_match_t* it;
+
+	for(entry=table->entries; entry; entry=entry->next){
+		for(it=entry->matches.head; it; it=it->next){
+			if(!__of1x_check_match(pkt, it))
+				break;
+		}
+		if(!it)
+			return entry;
+	}
+	return NULL;
+}
+
+static of1x_flow_entry_t* loop_array_entry(unsigned int port, uint32_t priority, bool eth_dst){
+
+	of1x_flow_entry_t* entry = of1x_init_flow_entry(false);
+
+	entry->priority = priority;
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(port)) == ROFL_SUCCESS);
+	if(eth_dst)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(port, 0xFFFFFFFFFFFF)) == ROFL_SUCCESS);
+	return entry;
+}
+
+void test_loop_array(){
+
+	unsigned int i, port, slot;
+	bool eth_dst;
+	uint32_t priority;
+	of1x_flow_entry_t *entry, *found;
+	datapacket_t pkt;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+
+	clean_pipeline(sw);
+	memset(&pkt, 0, sizeof(pkt));
+	memset(&tmp_val, 0, sizeof(tmp_val));
+	srand(35);
+
+	//Entries installed before enabling it (build)
+	for(i=0;i<100;i++){
+		entry = loop_array_entry(i%20, rand()%10, (i%3) == 0);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+
+	CU_ASSERT(of1x_enable_table_loop_array(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(state->array != NULL);
+	CU_ASSERT(state->array->num_of_gaps > 0);
+
+	//Random adds (gap filling, appends and rebuilds) and removals
+	for(i=0;i<2000;i++){
+		port = rand()%20;
+		priority = rand()%10;
+		eth_dst = (rand()%3) == 0;
+		entry = loop_array_entry(port, priority, eth_dst);
+
+		if(rand()%2){
+			CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false, false) == ROFL_OF1X_FM_SUCCESS);
+		}else{
+			CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+			of1x_destroy_flow_entry(entry);
+		}
+
+		//Array mirrors the list
+		CU_ASSERT_FATAL(state->array != NULL);
+		for(slot=0, entry=table->entries; entry; entry=entry->next){
+			CU_ASSERT(entry->cold->ma_slot >= slot);
+			CU_ASSERT(state->array->slots[entry->cold->ma_slot].entry == entry);
+			slot = entry->cold->ma_slot+1;
+		}
+		CU_ASSERT(slot <= state->array->num_of_slots);
+		CU_ASSERT(state->array->num_of_slots - state->array->num_of_gaps == table->num_of_entries);
+
+		//Same results as the list
+		*((uint32_t*)&tmp_val) = rand()%22;
+		found = of1x_find_best_match_loop_ma(table, &pkt);
+		CU_ASSERT(found == loop_array_reference(table, &pkt));
+	}
+	CU_ASSERT(state->num_of_array_builds > 1);
+
+	of1x_dump_table(table, false);
+
+	//Disable (back to the list)
+	CU_ASSERT(of1x_disable_table_loop_array(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(state->array == NULL);
+
+	//Invalid table
+	CU_ASSERT(of1x_enable_table_loop_array(&sw->pipeline, sw->pipeline.num_of_tables) == ROFL_FAILURE);
+
+	clean_pipeline(sw);
+	memset(&tmp_val, 0, sizeof(tmp_val));
+}
+
+//Entry of priority 2000 with num_of_matches matches (1-6), so that every entry opens its own run
+static of1x_flow_entry_t* bundle_run_entry(unsigned int num_of_matches){
+
+	of1x_flow_entry_t* entry = of1x_init_flow_entry(false);
+
+	entry->priority = 2000;
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(2000)) == ROFL_SUCCESS);
+	if(num_of_matches > 1)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_dst_match(0x012345678901ULL, 0xFFFFFFFFFFFFULL)) == ROFL_SUCCESS);
+	if(num_of_matches > 2)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_src_match(0x012345678902ULL, 0xFFFFFFFFFFFFULL)) == ROFL_SUCCESS);
+	if(num_of_matches > 3)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_eth_type_match(0x0800)) == ROFL_SUCCESS);
+	if(num_of_matches > 4)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_metadata_match(1, 0xFFFFFFFFFFFFFFFFULL)) == ROFL_SUCCESS);
+	if(num_of_matches > 5)
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_vlan_vid_match(10, 0xFFF, true)) == ROFL_SUCCESS);
+
+	return entry;
+}
+
+void test_flow_mod_bundle(){
+
+	unsigned int i;
+	of1x_flow_entry_t* entries[100];
+	of1x_flow_entry_t *entry, *head;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+	loop_state_t* state = (loop_state_t*)table->matching_aux[1];
+
+	clean_pipeline(sw);
+
+	//Some entries before the bundle
+	for(i=0;i<10;i++){
+		entry = of1x_init_flow_entry(false);
+		entry->priority = i;
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, true, false) == ROFL_OF1X_FM_SUCCESS);
+	}
+	head = table->entries;
+
+	//Bundle whose last entry overlaps with a previous entry of the bundle => rollback
+	for(i=0;i<100;i++){
+		entries[i] = of1x_init_flow_entry(false);
+		entries[i]->priority = 1000+i%3;
+		CU_ASSERT(of1x_add_match_to_entry(entries[i],of1x_init_port_in_match(100+i)) == ROFL_SUCCESS);
+	}
+	of1x_destroy_flow_entry(entries[99]);
+	entries[99] = of1x_init_flow_entry(false);
+	entries[99]->priority = 1000;
+	CU_ASSERT(of1x_add_match_to_entry(entries[99],of1x_init_port_in_match(100)) == ROFL_SUCCESS);
+
+	CU_ASSERT(of1x_add_flow_entries_table(&sw->pipeline, 0, entries, 100, true, false) == ROFL_OF1X_FM_OVERLAP);
+	CU_ASSERT(table->num_of_entries == 10);
+	CU_ASSERT(table->entries == head);
+	CU_ASSERT(state->num_of_buckets == 10);
+	for(i=0;i<100;i++){
+		CU_ASSERT_FATAL(entries[i] != NULL);
+		CU_ASSERT(entries[i]->cold->bundle_ref == NULL);
+	}
+
+	//Same bundle without the overlap check: the duplicate replaces its twin
+	CU_ASSERT(of1x_add_flow_entries_table(&sw->pipeline, 0, entries, 100, false, false) == ROFL_OF1X_FM_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 10+99);
+	CU_ASSERT(state->num_of_buckets == 13);
+	for(i=0;i<100;i++)
+		CU_ASSERT(entries[i] == NULL);
+
+	//Replacing the installed entries
+	for(i=0;i<10;i++){
+		entries[i] = of1x_init_flow_entry(false);
+		entries[i]->priority = i;
+		CU_ASSERT(of1x_add_match_to_entry(entries[i],of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+	}
+	CU_ASSERT(of1x_add_flow_entries_table(&sw->pipeline, 0, entries, 10, false, false) == ROFL_OF1X_FM_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 10+99);
+	CU_ASSERT(table->entries != head);
+
+	//New priority whose runs outgrow the initial capacity within the bundle,
+	//along with a replacement; the room is reserved upfront
+	for(i=0;i<6;i++)
+		entries[i] = bundle_run_entry(i+1);
+	entries[6] = of1x_init_flow_entry(false);
+	entries[6]->priority = 3;
+	CU_ASSERT(of1x_add_match_to_entry(entries[6],of1x_init_port_in_match(3)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entries_table(&sw->pipeline, 0, entries, 7, false, false) == ROFL_OF1X_FM_SUCCESS);
+	CU_ASSERT(table->num_of_entries == 10+99+6);
+	CU_ASSERT_FATAL(state->head.next[0] != NULL);
+	CU_ASSERT(state->head.next[0]->priority == 2000);
+	CU_ASSERT(state->head.next[0]->num_of_runs == 6);
+	CU_ASSERT(state->head.next[0]->runs_capacity >= 6);
+	CU_ASSERT(state->head.next[0]->runs_reserved == 0);
+	CU_ASSERT(table->entries->matches.num_elements == 6);
+
+	//Entries failing validation (OF1.3 match in an OF1.2 switch); nothing installed
+	entries[0] = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entries[0],of1x_init_port_in_match(5000)) == ROFL_SUCCESS);
+	entries[1] = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entries[1],of1x_init_tunnel_id_match(1, 0xFFFFFFFFFFFFFFFFULL)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entries_table(&sw->pipeline, 0, entries, 2, false, false) == ROFL_OF1X_FM_FAILURE);
+	CU_ASSERT(table->num_of_entries == 10+99+6);
+	of1x_destroy_flow_entry(entries[0]);
+	of1x_destroy_flow_entry(entries[1]);
+
+	clean_pipeline(sw);
+}
+
+void test_rcu_modify(){
+
+	unsigned int tid = ROFL_PIPELINE_LOCKED_TID+1;
+	of1x_flow_entry_t *entry, *installed;
+	of1x_instruction_group_t* version;
+	of1x_action_group_t* apply_actions;
+
+	entry = port_in_entry(1, OF1X_AT_OUTPUT, 1);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+	installed = sw->pipeline.tables[0].entries;
+	CU_ASSERT_FATAL(installed != NULL);
+
+	//Packet processing reads the version published on insertion
+	version = installed->pp_inst_grp;
+	CU_ASSERT_FATAL(version != &installed->inst_grp);
+	CU_ASSERT(version->instructions[OF1X_IT_APPLY_ACTIONS].apply_actions == installed->inst_grp.instructions[OF1X_IT_APPLY_ACTIONS].apply_actions);
+
+	//A reader holds the current version while it is replaced; the first
+	//modification does not wait for it either
+	tid_epoch_enter(tid);
+	apply_actions = version->instructions[OF1X_IT_APPLY_ACTIONS].apply_actions;
+
+	entry = port_in_entry(1, OF1X_AT_OUTPUT, 2);
+	CU_ASSERT(of1x_modify_flow_entry_table(&sw->pipeline, 0, &entry, STRICT, false) == ROFL_SUCCESS);
+	CU_ASSERT(installed->pp_inst_grp != version);
+	CU_ASSERT(installed->pp_inst_grp->instructions[OF1X_IT_APPLY_ACTIONS].apply_actions->head->__field.u32 == 2);
+
+	//Still readable
+	tid_reclaim(false);
+	CU_ASSERT(version->instructions[OF1X_IT_APPLY_ACTIONS].apply_actions == apply_actions);
+	CU_ASSERT(apply_actions->head->__field.u32 == 1);
+	tid_epoch_exit(tid);
+
+	tid_reclaim(false);
+	CU_ASSERT(installed->inst_grp.instructions[OF1X_IT_APPLY_ACTIONS].apply_actions->head->__field.u32 == 2);
+
+	//Subsequent modifications
+	version = installed->pp_inst_grp;
+	entry = port_in_entry(1, OF1X_AT_OUTPUT, 3);
+	CU_ASSERT(of1x_modify_flow_entry_table(&sw->pipeline, 0, &entry, STRICT, false) == ROFL_SUCCESS);
+	CU_ASSERT(installed->pp_inst_grp != version);
+	CU_ASSERT(installed->pp_inst_grp->instructions[OF1X_IT_APPLY_ACTIONS].apply_actions == installed->inst_grp.instructions[OF1X_IT_APPLY_ACTIONS].apply_actions);
+	tid_reclaim(false);
+	CU_ASSERT(installed->inst_grp.instructions[OF1X_IT_APPLY_ACTIONS].apply_actions->head->__field.u32 == 3);
+
+	clean_pipeline(sw);
+}
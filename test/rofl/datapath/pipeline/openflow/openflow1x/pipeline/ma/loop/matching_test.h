@@ -14,6 +14,8 @@
 #include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_entry.h"
 #include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_table.h"
 
+#include "../../lib_entries.h"
+
 /* Setup/teardown */
 int set_up(void);
 int tear_down(void);
@@ -25,6 +27,15 @@ void test_uninstall_wildcard(void);
 void test_overlap(void);
 void test_overlap2(void);
 void test_flow_modify(void);
+void test_miss_filter(void);
+void test_priority_index(void);
+void test_strict_index(void);
+void test_cookie_index(void);
+void test_reverse_index(void);
+void test_overlap_index(void);
+void test_loop_array(void);
+void test_flow_mod_bundle(void);
+void test_rcu_modify(void);
 
 
 #endif
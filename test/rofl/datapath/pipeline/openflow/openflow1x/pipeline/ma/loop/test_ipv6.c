@@ -158,6 +158,39 @@ void ipv6_alike_test_wrong(void){
 	
 }
 
+void ipv6_alike_match_test(void){
+	of1x_match_t *match1, *match2, *copy, *res;
+	uint128__t mask; UINT128__T_HI(mask) =  0xffffffffffffffff; UINT128__T_LO(mask) = 0xffffffffffffffff;
+	uint128__t value1; UINT128__T_HI(value1) = 0xaaaabbbbccccdddd; UINT128__T_LO(value1) =0x1111222233334444;
+	uint128__t value2; UINT128__T_HI(value2) = 0xaaaabbbbccccdddd; UINT128__T_LO(value2) =0x1111222233335444;
+	uint128__t tmp;
+
+	//The ternary value is stored inline in the match
+	match1 = of1x_init_ip6_src_match(value1,mask);
+	match2 = of1x_init_ip6_src_match(value2,mask);
+	CU_ASSERT(match1 != NULL && match2 != NULL);
+	CU_ASSERT(match1->__tern.type == UTERN128_T);
+
+	//Copies do not share it
+	copy = __of1x_copy_matches(match1);
+	CU_ASSERT(copy != NULL);
+	CU_ASSERT(__of1x_equal_matches(match1, copy));
+	of1x_destroy_match(match1);
+	tmp = of1x_get_match_value128(copy);
+	CU_ASSERT(UINT128__T_HI(tmp) == UINT128__T_HI(value1) && UINT128__T_LO(tmp) == UINT128__T_LO(value1));
+
+	res = __of1x_get_alike_match(copy, match2);
+	CU_ASSERT(res != NULL);
+	if(res){
+		CU_ASSERT(res->type == OF1X_MATCH_IPV6_SRC);
+		CU_ASSERT(res->__tern.type == UTERN128_T);
+		of1x_destroy_match(res);
+	}
+
+	of1x_destroy_match(copy);
+	of1x_destroy_match(match2);
+}
+
 /*TODO do tests using masks that doesn't make sense (not continuous ones) to check for failure*/
 
 void ipv6_install_flow_mod(void){
@@ -31,7 +31,16 @@ int main(int args, char** argv){
 	(NULL == CU_add_test(pSuite, "test uninstall wildcard", test_uninstall_wildcard)) || 
 	(NULL == CU_add_test(pSuite, "test check overlap addition", test_overlap)) || 
 	(NULL == CU_add_test(pSuite, "test check overlap addition2", test_overlap2)) || 
-	(NULL == CU_add_test(pSuite, "test flow modify", test_flow_modify)) 
+	(NULL == CU_add_test(pSuite, "test flow modify", test_flow_modify)) ||
+	(NULL == CU_add_test(pSuite, "test miss filter", test_miss_filter)) ||
+	(NULL == CU_add_test(pSuite, "test priority index", test_priority_index)) ||
+	(NULL == CU_add_test(pSuite, "test strict index", test_strict_index)) ||
+	(NULL == CU_add_test(pSuite, "test cookie index", test_cookie_index)) ||
+	(NULL == CU_add_test(pSuite, "test reverse index", test_reverse_index)) ||
+	(NULL == CU_add_test(pSuite, "test overlap index", test_overlap_index)) ||
+	(NULL == CU_add_test(pSuite, "test loop array", test_loop_array)) ||
+	(NULL == CU_add_test(pSuite, "test flow_mod bundle", test_flow_mod_bundle)) ||
+	(NULL == CU_add_test(pSuite, "test RCU modify", test_rcu_modify))
 	
 		)
 	{
@@ -53,7 +62,8 @@ int main(int args, char** argv){
 		(CU_add_test(ipv6_suite,"utern 128 bits",ipv6_utern_test)==NULL)	||
 		(CU_add_test(ipv6_suite,"get_alike_low",ipv6_alike_test_low)==NULL)	||
 		(CU_add_test(ipv6_suite,"get_alike_high",ipv6_alike_test_high)==NULL) ||
-		(CU_add_test(ipv6_suite,"get_alike_wrong",ipv6_alike_test_wrong)==NULL)
+		(CU_add_test(ipv6_suite,"get_alike_wrong",ipv6_alike_test_wrong)==NULL) ||
+		(CU_add_test(ipv6_suite,"get_alike_match",ipv6_alike_match_test)==NULL)
 	){
 		fprintf(stderr,"ERROR WHILE ADDING TEST\n");
 		CU_cleanup_registry();
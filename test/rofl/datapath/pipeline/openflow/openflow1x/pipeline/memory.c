@@ -9,6 +9,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
 
 /*
@@ -36,3 +37,14 @@ inline void platform_free_shared( void *data ){
 	free( data );
 }
 
+
+//Chunks (object pools)
+void* platform_malloc_shared_chunk( size_t length, bool hugepages ){
+	(void)hugepages;
+	return malloc( length );
+}
+
+void platform_free_shared_chunk( void *data, size_t length ){
+	(void)length;
+	free( data );
+}
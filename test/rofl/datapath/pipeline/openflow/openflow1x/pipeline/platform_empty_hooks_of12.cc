@@ -42,6 +42,13 @@ void platform_of1x_notify_flow_removed(const of1x_switch_t* sw, of1x_flow_remove
 
 }
 
+#ifdef ROFL_PIPELINE_BATCH_FLOW_REMOVED
+void platform_of1x_notify_flows_removed(const of1x_switch_t* sw, of1x_flow_entry_t** entries, of1x_flow_remove_reason_t* reasons, unsigned int num_of_entries)
+{
+
+}
+#endif
+
 void
 plaftorm_of1x_add_entry_hook(of1x_flow_entry_t* new_entry)
 {
@@ -2,6 +2,16 @@
 #include <rofl/datapath/pipeline/platform/memory.h>
 
 #include <pthread.h>
+#include <limits.h>
+
+#ifdef __linux__
+	#include <time.h>
+	#include <unistd.h>
+	#include <sys/syscall.h>
+	#include <linux/futex.h>
+#else
+	#include <sys/time.h>
+#endif
 
 /*
 *
@@ -81,3 +91,54 @@ void platform_rwlock_wrlock(platform_rwlock_t* rwlock){
 void platform_rwlock_wrunlock(platform_rwlock_t* rwlock){
 	pthread_rwlock_unlock(rwlock);
 }
+
+
+/* WAIT */
+#ifdef __linux__
+
+//Futexes
+void platform_wait_on(volatile uint32_t* addr, uint32_t val, uint32_t timeout_us){
+	struct timespec ts;
+
+	ts.tv_sec = timeout_us/1000000;
+	ts.tv_nsec = (timeout_us%1000000)*1000;
+
+	syscall(SYS_futex, addr, FUTEX_WAIT, val, (timeout_us)? &ts : NULL, NULL, 0);
+}
+
+void platform_wake_all(volatile uint32_t* addr){
+	syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+#else
+
+//Single condition variable for all the addresses
+static pthread_mutex_t wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wait_cond = PTHREAD_COND_INITIALIZER;
+
+void platform_wait_on(volatile uint32_t* addr, uint32_t val, uint32_t timeout_us){
+	struct timeval now;
+	struct timespec ts;
+
+	pthread_mutex_lock(&wait_mutex);
+	if(*addr == val){
+		if(timeout_us){
+			gettimeofday(&now, NULL);
+			ts.tv_sec = now.tv_sec + (now.tv_usec + timeout_us)/1000000;
+			ts.tv_nsec = ((now.tv_usec + timeout_us)%1000000)*1000;
+			pthread_cond_timedwait(&wait_cond, &wait_mutex, &ts);
+		}else{
+			pthread_cond_wait(&wait_cond, &wait_mutex);
+		}
+	}
+	pthread_mutex_unlock(&wait_mutex);
+}
+
+void platform_wake_all(volatile uint32_t* addr){
+	(void)addr;
+	pthread_mutex_lock(&wait_mutex);
+	pthread_cond_broadcast(&wait_cond);
+	pthread_mutex_unlock(&wait_mutex);
+}
+
+#endif
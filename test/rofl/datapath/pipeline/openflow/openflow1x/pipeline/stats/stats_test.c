@@ -0,0 +1,810 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include "CUnit/Basic.h"
+
+#include "rofl/datapath/pipeline/physical_switch.h"
+#include "rofl/datapath/pipeline/threading.h"
+#include "rofl/datapath/pipeline/openflow/of_switch_pp.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/of1x_switch.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_entry.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_table.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_statistics.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_stats_export.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_heavy_hitters.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_latency.h"
+
+#include "../lib_entries.h"
+
+//Value of all the packet fields (empty_packet.c)
+extern uint128__t tmp_val;
+
+static of1x_switch_t* sw=NULL;
+
+int set_up(){
+
+	enum of1x_matching_algorithm_available ma_list[4]={of1x_loop_matching_algorithm, of1x_loop_matching_algorithm,
+	of1x_loop_matching_algorithm, of1x_loop_matching_algorithm};
+
+	physical_switch_init();
+
+	//Create instance	
+	sw = of1x_init_switch("Test switch", OF_VERSION_12, 0x0101,4,ma_list);
+	
+	if(!sw)
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
+
+int tear_down(){
+	//Destroy the switch
+	if(__of1x_destroy_switch(sw) != ROFL_SUCCESS)
+		return EXIT_FAILURE;
+
+	physical_switch_destroy();
+	
+	return EXIT_SUCCESS;
+}
+
+//Removes all the entries of table_id
+static void clean_table(unsigned int table_id){
+
+	of1x_flow_entry_t* deleting_entry = of1x_init_flow_entry(false); 
+
+	CU_ASSERT_FATAL(deleting_entry != NULL);
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, table_id, deleting_entry, NOT_STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(deleting_entry);
+	CU_ASSERT(sw->pipeline.tables[table_id].num_of_entries == 0);
+}
+
+//Processes num_of_pkts packets in tid; all the (32 bit) fields of the packets are value
+static void process_packets(unsigned int tid, uint32_t value, unsigned int num_of_pkts){
+
+	unsigned int i;
+	datapacket_t pkt;
+
+	memset(&pkt, 0, sizeof(pkt));
+	memset(&tmp_val, 0, sizeof(tmp_val));
+	*((uint32_t*)&tmp_val) = value;
+
+	for(i=0;i<num_of_pkts;i++)
+		of_process_packet_pipeline(tid, (const struct of_switch *)sw, &pkt);
+
+	memset(&tmp_val, 0, sizeof(tmp_val));
+}
+
+void test_stats_slabs(){
+
+	unsigned int i, tid;
+	uint32_t id, other, ids[OF1X_STATS_SLAB_CHUNK_SLOTS*3];
+	uintptr_t slot, prev;
+	__of1x_stats_slab_t* slab = &__of1x_stats_flow_slab;
+
+	CU_ASSERT_FATAL(__of1x_stats_slab_alloc(slab, &id) == ROFL_SUCCESS);
+	CU_ASSERT(id != OF1X_STATS_SLAB_NO_ID);
+
+	//Each TID has its own cache lines
+	prev = 0;
+	for(tid=0;tid<tid_get_num_of_tids();tid++){
+		slot = (uintptr_t)__of1x_stats_slab_slot(slab, id, tid, slab->size);
+		CU_ASSERT(slot/TID_CACHE_LINE_SIZE != prev/TID_CACHE_LINE_SIZE);
+		prev = slot;
+	}
+	CU_ASSERT(((uintptr_t)__of1x_stats_slab_slot(slab, id&~(OF1X_STATS_SLAB_CHUNK_SLOTS-1), 1, slab->size) % TID_CACHE_LINE_SIZE) == 0);
+
+	//Released ids are reused (and zeroed)
+	((__of1x_stats_flow_tid_t*)__of1x_stats_slab_slot(slab, id, 1, slab->size))->packet_count = 10;
+	__of1x_stats_slab_free(slab, id);
+	CU_ASSERT_FATAL(__of1x_stats_slab_alloc(slab, &other) == ROFL_SUCCESS);
+	CU_ASSERT(other == id);
+	CU_ASSERT(((__of1x_stats_flow_tid_t*)__of1x_stats_slab_slot(slab, id, 1, slab->size))->packet_count == 0);
+
+	//Grow over several chunks; slots already handed out stay in place
+	slot = (uintptr_t)__of1x_stats_slab_slot(slab, id, 1, slab->size);
+	for(i=0;i<sizeof(ids)/sizeof(ids[0]);i++)
+		CU_ASSERT_FATAL(__of1x_stats_slab_alloc(slab, &ids[i]) == ROFL_SUCCESS);
+	CU_ASSERT(slab->num_of_chunks >= 3);
+	CU_ASSERT((uintptr_t)__of1x_stats_slab_slot(slab, id, 1, slab->size) == slot);
+
+	for(i=0;i<sizeof(ids)/sizeof(ids[0]);i++)
+		__of1x_stats_slab_free(slab, ids[i]);
+	__of1x_stats_slab_free(slab, id);
+}
+
+//Packets of a single source processed concurrently in the shared TID
+#define HH_SHARED_TID_THREADS 4
+#define HH_SHARED_TID_PKTS 20000
+
+static void* process_packets_shared_tid(void* arg){
+
+	unsigned int i;
+	datapacket_t pkt;
+
+	(void)arg;
+	memset(&pkt, 0, sizeof(pkt));
+	for(i=0;i<HH_SHARED_TID_PKTS;i++)
+		of_process_packet_pipeline(ROFL_PIPELINE_LOCKED_TID, (const struct of_switch *)sw, &pkt);
+
+	return NULL;
+}
+
+void test_heavy_hitters(){
+
+	unsigned int i, num;
+	uint64_t packet_count;
+	of1x_heavy_hitter_t hh[OF1X_HH_TOP_K];
+	pthread_t threads[HH_SHARED_TID_THREADS];
+
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 0, hh, &num, &packet_count) == ROFL_FAILURE);
+	CU_ASSERT(of1x_enable_table_heavy_hitters(&sw->pipeline, 0, __OF1X_HH_KEY_MAX) == ROFL_FAILURE);
+	CU_ASSERT(of1x_enable_table_heavy_hitters(&sw->pipeline, sw->pipeline.num_of_tables, OF1X_HH_KEY_IPV4_SRC) == ROFL_FAILURE);
+	CU_ASSERT(of1x_enable_table_heavy_hitters(&sw->pipeline, 0, OF1X_HH_KEY_IPV4_SRC) == ROFL_SUCCESS);
+
+	//Two heavy sources (in several TIDs) among many light ones
+	process_packets(1, 0x0A000001, 300);
+	process_packets(2, 0x0A000001, 200);
+	process_packets(2, 0x0A000002, 100);
+	for(i=0;i<500;i++)
+		process_packets(1+(i%2), 0x0B000000+i, 1);
+
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 0, hh, &num, &packet_count) == ROFL_SUCCESS);
+	CU_ASSERT(packet_count == 1100);
+	CU_ASSERT_FATAL(num >= 2);
+	CU_ASSERT(num <= OF1X_HH_TOP_K);
+	CU_ASSERT(hh[0].key.ipv4_src == 0x0A000001);
+	CU_ASSERT(hh[0].key.ipv4_dst == 0x0);
+	CU_ASSERT(hh[0].packet_count >= 500 && hh[0].packet_count < 510);
+	CU_ASSERT(hh[1].key.ipv4_src == 0x0A000002);
+	CU_ASSERT(hh[1].packet_count >= 100 && hh[1].packet_count < 110);
+	for(i=1;i<num;i++)
+		CU_ASSERT(hh[i].packet_count <= hh[i-1].packet_count);
+
+	//Reset
+	CU_ASSERT(of1x_enable_table_heavy_hitters(&sw->pipeline, 0, OF1X_HH_KEY_IPV4_SRC_DST) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 0, hh, &num, &packet_count) == ROFL_SUCCESS);
+	CU_ASSERT(num == 0);
+	CU_ASSERT(packet_count == 0);
+	process_packets(1, 0x0A000003, 10);
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 0, hh, &num, &packet_count) == ROFL_SUCCESS);
+	CU_ASSERT_FATAL(num == 1);
+	CU_ASSERT(hh[0].key.ipv4_src == 0x0A000003);
+	CU_ASSERT(hh[0].key.ipv4_dst == 0x0A000003);
+	CU_ASSERT(hh[0].packet_count == 10);
+
+	//The shared TID is updated by several threads at once; no update is lost
+	CU_ASSERT(of1x_enable_table_heavy_hitters(&sw->pipeline, 0, OF1X_HH_KEY_IPV4_SRC) == ROFL_SUCCESS);
+	memset(&tmp_val, 0, sizeof(tmp_val));
+	*((uint32_t*)&tmp_val) = 0x0A000004;
+	for(i=0;i<HH_SHARED_TID_THREADS;i++)
+		CU_ASSERT_FATAL(pthread_create(&threads[i], NULL, process_packets_shared_tid, NULL) == 0);
+	for(i=0;i<HH_SHARED_TID_THREADS;i++)
+		pthread_join(threads[i], NULL);
+	memset(&tmp_val, 0, sizeof(tmp_val));
+
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 0, hh, &num, &packet_count) == ROFL_SUCCESS);
+	CU_ASSERT(packet_count == HH_SHARED_TID_THREADS*HH_SHARED_TID_PKTS);
+	CU_ASSERT_FATAL(num == 1);
+	CU_ASSERT(hh[0].key.ipv4_src == 0x0A000004);
+	CU_ASSERT(hh[0].packet_count == HH_SHARED_TID_THREADS*HH_SHARED_TID_PKTS);
+
+	//Other tables are not affected
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 1, hh, &num, &packet_count) == ROFL_FAILURE);
+
+	CU_ASSERT(of1x_disable_table_heavy_hitters(&sw->pipeline, 0) == ROFL_SUCCESS);
+	CU_ASSERT(sw->pipeline.tables[0].heavy_hitters == NULL);
+	CU_ASSERT(of1x_get_table_heavy_hitters(&sw->pipeline, 0, hh, &num, &packet_count) == ROFL_FAILURE);
+	process_packets(1, 0x0A000003, 10);
+
+	tid_reclaim(true);
+}
+
+void test_latency_histograms(){
+
+	uint64_t v, max;
+	unsigned int b, prev = 0;
+	of1x_latency_stats_t stats;
+	of1x_latency_histogram_t* hist;
+
+	//Buckets: monotonic, and within 1/OF1X_LATENCY_SUB_BUCKETS of the value
+	for(v=0;v<(1ULL<<OF1X_LATENCY_MAX_BITS);v=(v<4096)? v+1 : v+(v>>5)+7){
+		b = __of1x_latency_bucket(v);
+		CU_ASSERT_FATAL(b < OF1X_LATENCY_NUM_OF_BUCKETS);
+		CU_ASSERT(b >= prev);
+		max = __of1x_latency_bucket_max(b);
+		CU_ASSERT(max >= v);
+		CU_ASSERT(max - v <= v/OF1X_LATENCY_SUB_BUCKETS);
+		if(b > 0)
+			CU_ASSERT(__of1x_latency_bucket_max(b-1) < v);
+		prev = b;
+	}
+	CU_ASSERT(__of1x_latency_bucket(UINT64_MAX) == OF1X_LATENCY_NUM_OF_BUCKETS-1);
+
+	//Percentiles
+	hist = (of1x_latency_histogram_t*)malloc(sizeof(of1x_latency_histogram_t));
+	CU_ASSERT_FATAL(hist != NULL);
+	memset(hist, 0, sizeof(*hist));
+	CU_ASSERT(of1x_latency_histogram_percentile(hist, 50000) == 0);
+	for(v=1;v<=10000;v++)
+		__of1x_latency_histogram_record(hist, v);
+	CU_ASSERT(hist->count == 10000);
+	CU_ASSERT(hist->max == 10000);
+	v = of1x_latency_histogram_percentile(hist, 50000);
+	CU_ASSERT(v >= 5000 && v <= 5000+5000/OF1X_LATENCY_SUB_BUCKETS);
+	v = of1x_latency_histogram_percentile(hist, 99000);
+	CU_ASSERT(v >= 9900 && v <= 10000);
+	CU_ASSERT(of1x_latency_histogram_percentile(hist, 100000) == 10000);
+	free(hist);
+
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_PIPELINE, 0, &stats) == ROFL_FAILURE);
+
+#ifdef ROFL_PIPELINE_LATENCY_HISTOGRAMS
+	CU_ASSERT(of1x_enable_latency_histograms(&sw->pipeline) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, __OF1X_LATENCY_STAGE_MAX, 0, &stats) == ROFL_FAILURE);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_LOOKUP, sw->pipeline.num_of_tables, &stats) == ROFL_FAILURE);
+
+	//Matched in table 0 (no actions)
+	install_entry(sw, 0, port_in_entry(1, OF1X_AT_NO_ACTION, 0));
+	process_packets(1, 1, 100);
+
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_PIPELINE, 0, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 100);
+	CU_ASSERT(stats.p50 <= stats.p99 && stats.p99 <= stats.p999 && stats.p999 <= stats.max);
+	CU_ASSERT(stats.mean <= stats.max);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_LOOKUP, 0, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 100);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_LOOKUP, 1, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 0);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_INSTRUCTIONS, 0, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 100);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_WRITE_ACTIONS, 0, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 100);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_OUTPUT, 0, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 0);
+	of1x_dump_switch(sw, false);
+
+	//Reset
+	CU_ASSERT(of1x_enable_latency_histograms(&sw->pipeline) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_PIPELINE, 0, &stats) == ROFL_SUCCESS);
+	CU_ASSERT(stats.count == 0);
+
+	CU_ASSERT(of1x_disable_latency_histograms(&sw->pipeline) == ROFL_SUCCESS);
+	CU_ASSERT(sw->pipeline.latency == NULL);
+	process_packets(1, 1, 10);
+#else
+	//Instrumentation compiled out
+	CU_ASSERT(of1x_enable_latency_histograms(&sw->pipeline) == ROFL_FAILURE);
+	CU_ASSERT(sw->pipeline.latency == NULL);
+#endif
+	CU_ASSERT(of1x_get_latency_stats(&sw->pipeline, OF1X_LATENCY_STAGE_PIPELINE, 0, &stats) == ROFL_FAILURE);
+
+	tid_reclaim(true);
+	clean_table(0);
+}
+
+static of1x_flow_entry_t* stats_mode_entry(uint32_t port, uint32_t flags, uint32_t idle_timeout){
+
+	of1x_flow_entry_t* entry = port_in_entry(port, OF1X_AT_NO_ACTION, 0);
+
+	entry->flags = flags;
+	__of1x_fill_new_timer_entry_info(entry, 0, idle_timeout);
+
+	return install_entry(sw, 0, entry);
+}
+
+//Last used timestamps (idle timeouts); the expiration side is in the timers test
+static void stats_modes_last_used(){
+
+	of1x_flow_entry_t *idle, *plain;
+	__of1x_stats_flow_tid_t c;
+
+	clean_table(0);
+
+	//Wrong arguments
+	CU_ASSERT(of1x_set_table_idle_timestamps(&sw->pipeline, sw->pipeline.num_of_tables, true) == ROFL_FAILURE);
+
+	CU_ASSERT(of1x_set_table_idle_timestamps(&sw->pipeline, 0, true) == ROFL_SUCCESS);
+	idle = stats_mode_entry(2, 0x0, 10);
+	plain = stats_mode_entry(1, 0x0, 0);
+
+	//Only entries with an idle timeout
+	CU_ASSERT(idle->stats.pp_mode == (OF1X_STATS_FLOW_FULL | OF1X_STATS_FLOW_LAST_USED));
+	CU_ASSERT(plain->stats.pp_mode == OF1X_STATS_FLOW_FULL);
+
+	//The datapath stores the clock cached by the TID
+	tid_set_clock(12345);
+	process_packets(1, 2, 1);
+	CU_ASSERT(idle->stats.last_used == 12345);
+	__of1x_stats_flow_consolidate(&idle->stats, &c);
+	CU_ASSERT(c.packet_count == 1);
+
+	tid_set_clock(12346);
+	process_packets(1, 2, 3);
+	process_packets(1, 1, 1);
+	CU_ASSERT(idle->stats.last_used == 12346);
+
+	//Regardless of the stats mode (no IDLE_HIT)
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_OFF, 0) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_LAST_USED);
+	tid_set_clock(12347);
+	process_packets(1, 2, 1);
+	CU_ASSERT(idle->stats.last_used == 12347);
+	__of1x_stats_flow_consolidate(&idle->stats, &c);
+	CU_ASSERT(c.packet_count == 4);
+
+	//Wraps around
+	tid_set_clock(0);
+	process_packets(1, 2, 1);
+	CU_ASSERT(idle->stats.last_used == 0);
+
+	//Disabled; back to the packet counts (and IDLE_HIT)
+	CU_ASSERT(of1x_set_table_idle_timestamps(&sw->pipeline, 0, false) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_IDLE_HIT);
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_FULL, 0) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_FULL);
+	tid_set_clock(20000);
+	process_packets(1, 2, 1);
+	CU_ASSERT(idle->stats.last_used != 20000);
+
+	clean_table(0);
+}
+
+void test_stats_modes(){
+
+	of1x_flow_entry_t *no_bytes, *idle;
+	of1x_flow_table_t* table = &sw->pipeline.tables[0];
+	__of1x_stats_table_tid_t tc, base;
+	__of1x_stats_flow_tid_t c;
+
+	clean_table(0);
+	__of1x_stats_table_consolidate(&table->stats, &base);
+
+	//Per entry flags
+	no_bytes = stats_mode_entry(1, OF1X_FLOW_FLAG_NO_BYT_COUNTS, 0);
+	idle = stats_mode_entry(2, 0x0, 10);
+	CU_ASSERT(no_bytes->stats.pp_mode == OF1X_STATS_FLOW_PKTS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_FULL);
+
+	__of1x_stats_flow_update_match(1, &no_bytes->stats, 1, 100);
+	__of1x_stats_flow_consolidate(&no_bytes->stats, &c);
+	CU_ASSERT(c.packet_count == 1);
+	CU_ASSERT(c.byte_count == 0);
+
+	//Wrong arguments
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_SAMPLED, 0) == ROFL_FAILURE);
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, sw->pipeline.num_of_tables, OF1X_STATS_MODE_OFF, 0) == ROFL_FAILURE);
+
+	//Sampled; 1 in 4 packets with weight 4 (out of 6, the 1st and the 5th)
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_SAMPLED, 4) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == (OF1X_STATS_FLOW_FULL | OF1X_STATS_FLOW_IDLE_HIT));
+	CU_ASSERT(no_bytes->stats.pp_mode == OF1X_STATS_FLOW_PKTS);
+
+	process_packets(1, 2, 6);
+	__of1x_stats_table_consolidate(&table->stats, &tc);
+	CU_ASSERT(tc.lookup_count == base.lookup_count+8);
+	CU_ASSERT(tc.matched_count == base.matched_count+8);
+	__of1x_stats_flow_consolidate(&idle->stats, &c);
+	CU_ASSERT(c.packet_count == 8);
+	CU_ASSERT(__of1x_stats_flow_test_and_clear_idle_hit(&idle->stats) == true);
+	CU_ASSERT(__of1x_stats_flow_test_and_clear_idle_hit(&idle->stats) == false);
+
+	//Off; entries with idle timeouts are still marked as used
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_OFF, 0) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_IDLE_HIT);
+	CU_ASSERT(no_bytes->stats.pp_mode == 0x0);
+
+	process_packets(1, 2, 3);
+	process_packets(1, 3, 1);
+	__of1x_stats_table_consolidate(&table->stats, &tc);
+	CU_ASSERT(tc.lookup_count == base.lookup_count+8);
+	__of1x_stats_flow_consolidate(&idle->stats, &c);
+	CU_ASSERT(c.packet_count == 8);
+	CU_ASSERT(__of1x_stats_flow_test_and_clear_idle_hit(&idle->stats) == true);
+
+	//Packets only
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_PACKETS_ONLY, 0) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_PKTS);
+
+	//Back to full
+	CU_ASSERT(of1x_set_table_stats_mode(&sw->pipeline, 0, OF1X_STATS_MODE_FULL, 0) == ROFL_SUCCESS);
+	CU_ASSERT(idle->stats.pp_mode == OF1X_STATS_FLOW_FULL);
+	process_packets(1, 3, 1);
+	__of1x_stats_table_consolidate(&table->stats, &tc);
+	CU_ASSERT(tc.lookup_count == base.lookup_count+9);
+	CU_ASSERT(tc.matched_count == base.matched_count+8);
+
+	clean_table(0);
+
+	stats_modes_last_used();
+}
+
+#define EXPORT_TEST_ENTRIES 10
+
+void test_flow_stats_export(){
+
+	unsigned int i, num, total, seen[EXPORT_TEST_ENTRIES+1];
+	size_t size;
+	uint64_t buffer[512];
+	wrap_uint_t field;
+	of1x_flow_entry_t* entry;
+	of1x_action_group_t* apply_actions;
+	of1x_match_group_t matches;
+	of1x_flow_stats_cursor_t cursor;
+	of1x_flow_stats_record_t* records = (of1x_flow_stats_record_t*)buffer;
+	of1x_flow_stats_match_t* match;
+	of1x_flow_stats_instruction_t* inst;
+	of1x_flow_stats_action_t* action;
+
+	clean_table(0);
+	__of1x_init_match_group(&matches);
+	memset(seen, 0, sizeof(seen));
+
+	for(i=1;i<=EXPORT_TEST_ENTRIES;i++){
+		entry = of1x_init_flow_entry(false);
+		CU_ASSERT_FATAL(entry != NULL);
+		CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+		field.u32 = i;
+		apply_actions = of1x_init_action_group(NULL);
+		of1x_push_packet_action_to_group(apply_actions, of1x_init_packet_action(OF1X_AT_OUTPUT, field, 0x0));
+		of1x_add_instruction_to_group(&entry->inst_grp, OF1X_IT_APPLY_ACTIONS, apply_actions, NULL, NULL, 0);
+		CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+	}
+
+	//3 flows per chunk
+	size = 3*(sizeof(of1x_flow_stats_record_t) +
+		((sizeof(of1x_flow_stats_match_t)+OF1X_FLOW_STATS_EXPORT_ALIGN-1) & ~(OF1X_FLOW_STATS_EXPORT_ALIGN-1)) +
+		((sizeof(of1x_flow_stats_instruction_t)+sizeof(of1x_flow_stats_action_t)+OF1X_FLOW_STATS_EXPORT_ALIGN-1) & ~(OF1X_FLOW_STATS_EXPORT_ALIGN-1)));
+	size = (size + OF1X_FLOW_STATS_EXPORT_ALIGN-1) & ~(OF1X_FLOW_STATS_EXPORT_ALIGN-1);
+	CU_ASSERT_FATAL(size <= sizeof(buffer));
+
+	CU_ASSERT(of1x_init_flow_stats_cursor(&cursor, &sw->pipeline, sw->pipeline.num_of_tables, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, &matches) == ROFL_FAILURE);
+	CU_ASSERT(of1x_init_flow_stats_cursor(&cursor, &sw->pipeline, OF1X_FLOW_TABLE_ALL, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, &matches) == ROFL_SUCCESS);
+
+	//Too small
+	CU_ASSERT(of1x_export_flow_stats(&cursor, buffer, sizeof(of1x_flow_stats_record_t), &num) == ROFL_FAILURE);
+	CU_ASSERT(num == 0);
+
+	CU_ASSERT(of1x_export_flow_stats(&cursor, buffer, size, &num) == ROFL_SUCCESS);
+	CU_ASSERT_FATAL(num == 3);
+	CU_ASSERT(cursor.done == false);
+	for(total=0;total<num;total++){
+		CU_ASSERT(records[total].table_id == 0);
+		CU_ASSERT_FATAL(records[total].num_of_matches == 1);
+		CU_ASSERT_FATAL(records[total].num_of_instructions == 1);
+		match = of1x_flow_stats_record_matches(buffer, &records[total]);
+		CU_ASSERT(match->type == OF1X_MATCH_IN_PORT);
+		inst = of1x_flow_stats_record_instructions(buffer, &records[total]);
+		CU_ASSERT(inst->type == OF1X_IT_APPLY_ACTIONS);
+		CU_ASSERT_FATAL(inst->num_of_actions == 1);
+		action = of1x_flow_stats_instruction_actions(inst);
+		CU_ASSERT(action->type == OF1X_AT_OUTPUT);
+		CU_ASSERT(action->__field.u32 == match->__tern.value.u32);
+		CU_ASSERT_FATAL(action->__field.u32 <= EXPORT_TEST_ENTRIES);
+		seen[action->__field.u32]++;
+	}
+
+	//Remove the entry the cursor is positioned at; the export goes on
+	CU_ASSERT_FATAL(cursor.next != NULL);
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(cursor.next->matches.head->__tern.value.u32)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	tid_reclaim(true);
+
+	while(!cursor.done){
+		CU_ASSERT_FATAL(of1x_export_flow_stats(&cursor, buffer, size, &num) == ROFL_SUCCESS);
+		for(i=0;i<num;i++){
+			inst = of1x_flow_stats_record_instructions(buffer, &records[i]);
+			action = of1x_flow_stats_instruction_actions(inst);
+			CU_ASSERT_FATAL(action->__field.u32 <= EXPORT_TEST_ENTRIES);
+			seen[action->__field.u32]++;
+		}
+		total += num;
+	}
+	of1x_release_flow_stats_cursor(&cursor);
+
+	//Every remaining entry once
+	CU_ASSERT(total == EXPORT_TEST_ENTRIES-1);
+	for(i=1;i<=EXPORT_TEST_ENTRIES;i++)
+		CU_ASSERT(seen[i] <= 1);
+	CU_ASSERT(sw->pipeline.tables[0].iterators == NULL);
+
+	//Released before the end
+	CU_ASSERT(of1x_init_flow_stats_cursor(&cursor, &sw->pipeline, 0, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, &matches) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_export_flow_stats(&cursor, buffer, size, &num) == ROFL_SUCCESS);
+	CU_ASSERT(sw->pipeline.tables[0].iterators == &cursor);
+	of1x_release_flow_stats_cursor(&cursor);
+	CU_ASSERT(sw->pipeline.tables[0].iterators == NULL);
+
+	clean_table(0);
+}
+
+static of1x_flow_entry_t* iterator_entry(uint32_t port, uint32_t priority, uint64_t cookie){
+
+	of1x_flow_entry_t* entry = port_in_entry(port, OF1X_AT_OUTPUT, port);
+
+	entry->priority = priority;
+	entry->cookie = cookie;
+
+	return install_entry(sw, 0, entry);
+}
+
+//Collects the in_port of the visited entries (up to limit per chunk)
+typedef struct iterator_visited{
+	unsigned int count[32];
+	unsigned int total;
+	unsigned int limit;
+}iterator_visited_t;
+
+static bool iterator_visit(of1x_flow_entry_t* entry, void* opaque){
+
+	iterator_visited_t* visited = (iterator_visited_t*)opaque;
+
+	if(visited->limit == 0)
+		return false;
+	visited->limit--;
+
+	CU_ASSERT_FATAL(entry->matches.head->__tern.value.u32 < 32);
+	visited->count[entry->matches.head->__tern.value.u32]++;
+	visited->total++;
+	return true;
+}
+
+static unsigned int iterator_count(uint64_t cookie, uint64_t cookie_mask, uint32_t out_port, of1x_match_group_t* matches){
+
+	unsigned int num;
+	of1x_flow_iterator_t it;
+	iterator_visited_t visited;
+
+	memset(&visited, 0, sizeof(visited));
+	CU_ASSERT(of1x_init_flow_iterator(&it, &sw->pipeline, 0, cookie, cookie_mask, out_port, OF1X_GROUP_ANY, matches) == ROFL_SUCCESS);
+	while(!it.done){
+		visited.limit = UINT_MAX;
+		CU_ASSERT(of1x_flow_iterator_next_chunk(&it, 3, iterator_visit, &visited, &num) == ROFL_SUCCESS);
+		CU_ASSERT(num <= 3);
+	}
+	of1x_release_flow_iterator(&it);
+
+	return visited.total;
+}
+
+void test_flow_iterator(){
+
+	unsigned int i, num, removed;
+	of1x_flow_entry_t* entry;
+	of1x_match_group_t matches;
+	of1x_flow_iterator_t it;
+	iterator_visited_t visited;
+
+	clean_table(0);
+
+	//Ports 1..10, cookie = port
+	for(i=1;i<=10;i++)
+		iterator_entry(i, 100, i);
+
+	//Filters
+	CU_ASSERT(iterator_count(0x0, 0x0, OF1X_PORT_ANY, NULL) == 10);
+	CU_ASSERT(iterator_count(0x1, 0x1, OF1X_PORT_ANY, NULL) == 5);
+	CU_ASSERT(iterator_count(0x0, 0x0, 4, NULL) == 1);
+	CU_ASSERT(iterator_count(0x1, 0x1, 4, NULL) == 0);
+	__of1x_init_match_group(&matches);
+	__of1x_match_group_push_back(&matches, of1x_init_port_in_match(3));
+	CU_ASSERT(iterator_count(0x0, 0x0, OF1X_PORT_ANY, &matches) == 1);
+	__of1x_destroy_match_group(&matches);
+
+	//Chunks
+	memset(&visited, 0, sizeof(visited));
+	CU_ASSERT(of1x_init_flow_iterator(&it, &sw->pipeline, OF1X_FLOW_TABLE_ALL, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, NULL) == ROFL_SUCCESS);
+	visited.limit = UINT_MAX;
+	CU_ASSERT(of1x_flow_iterator_next_chunk(&it, 4, iterator_visit, &visited, &num) == ROFL_SUCCESS);
+	CU_ASSERT(num == 4);
+	CU_ASSERT(it.done == false);
+	CU_ASSERT(sw->pipeline.tables[0].iterators == &it);
+
+	//Stopped by the callback; the entry is not consumed
+	visited.limit = 1;
+	CU_ASSERT(of1x_flow_iterator_next_chunk(&it, 4, iterator_visit, &visited, &num) == ROFL_SUCCESS);
+	CU_ASSERT(num == 1);
+	CU_ASSERT(visited.total == 5);
+
+	//Modifications in between: entry at the position removed, entry inserted after it
+	CU_ASSERT_FATAL(it.next != NULL);
+	i = it.next->matches.head->__tern.value.u32;
+	CU_ASSERT(visited.count[i] == 0);
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT_FATAL(entry != NULL);
+	entry->priority = 100;
+	CU_ASSERT(of1x_add_match_to_entry(entry, of1x_init_port_in_match(i)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_remove_flow_entry_table(&sw->pipeline, 0, entry, STRICT, OF1X_PORT_ANY, OF1X_GROUP_ANY) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	iterator_entry(20, 10, 20);
+
+	while(!it.done){
+		visited.limit = UINT_MAX;
+		CU_ASSERT(of1x_flow_iterator_next_chunk(&it, 4, iterator_visit, &visited, &num) == ROFL_SUCCESS);
+	}
+	of1x_release_flow_iterator(&it);
+
+	//Removed and inserted entries not visited, the rest once
+	CU_ASSERT(visited.total == 9);
+	CU_ASSERT(visited.count[i] == 0);
+	CU_ASSERT(visited.count[20] == 0);
+	for(num=1;num<=10;num++){
+		if(num != i)
+			CU_ASSERT(visited.count[num] == 1);
+	}
+	CU_ASSERT(sw->pipeline.tables[0].iterators == NULL);
+
+	//New iterations see it
+	CU_ASSERT(iterator_count(0x0, 0x0, OF1X_PORT_ANY, NULL) == 10);
+
+	//Dump is chunked as well
+	of1x_dump_table(&sw->pipeline.tables[0], false);
+	CU_ASSERT(sw->pipeline.tables[0].iterators == NULL);
+
+	//Replacements (flow_mod add of identical entries); visited once, in their last version
+	removed = i;
+	memset(&visited, 0, sizeof(visited));
+	CU_ASSERT(of1x_init_flow_iterator(&it, &sw->pipeline, 0, 0x0, 0x0, OF1X_PORT_ANY, OF1X_GROUP_ANY, NULL) == ROFL_SUCCESS);
+	visited.limit = UINT_MAX;
+	CU_ASSERT(of1x_flow_iterator_next_chunk(&it, 4, iterator_visit, &visited, &num) == ROFL_SUCCESS);
+	CU_ASSERT(num == 4);
+	CU_ASSERT_FATAL(it.next != NULL);
+	i = it.next->matches.head->__tern.value.u32;
+	CU_ASSERT(visited.count[i] == 0);
+	entry = iterator_entry(i, 100, 0x100);
+	CU_ASSERT(it.next == entry);
+	for(num=1;num<=10;num++){
+		if(visited.count[num] != 0)
+			break;
+	}
+	CU_ASSERT_FATAL(num <= 10);
+	iterator_entry(num, 100, 0x100);
+	CU_ASSERT(sw->pipeline.tables[0].num_of_entries == 10);
+
+	while(!it.done){
+		visited.limit = UINT_MAX;
+		CU_ASSERT(of1x_flow_iterator_next_chunk(&it, 4, iterator_visit, &visited, &num) == ROFL_SUCCESS);
+	}
+	of1x_release_flow_iterator(&it);
+
+	CU_ASSERT(visited.total == 10);
+	for(num=1;num<=10;num++)
+		CU_ASSERT(visited.count[num] == ((num != removed)? 1 : 0));
+	CU_ASSERT(visited.count[20] == 1);
+
+	tid_reclaim(true);
+	clean_table(0);
+}
+
+static void flow_rates_count(of1x_flow_entry_t* entry, unsigned int tid, uint64_t pkts, uint64_t bytes){
+	__of1x_stats_flow_counters(&entry->stats, tid)->packet_count += pkts;
+	__of1x_stats_flow_counters(&entry->stats, tid)->byte_count += bytes;
+}
+
+void test_flow_rates(){
+
+	unsigned int num;
+	uint64_t pps, bps;
+	of1x_flow_entry_t *heavy, *light, *idle;
+	of1x_stats_flow_rate_top_t top[OF1X_STATS_RATE_TOP_K];
+
+	clean_table(0);
+
+	heavy = iterator_entry(1, 100, 0x1);
+	light = iterator_entry(2, 100, 0x2);
+	idle = iterator_entry(3, 100, 0x3);
+
+	//Base
+	__of1x_sample_flow_rates(&sw->pipeline, 1000);
+	CU_ASSERT(of1x_get_table_top_flows(&sw->pipeline, 0, top, &num) == ROFL_SUCCESS);
+	CU_ASSERT(num == 0);
+
+	//First rates; counters of all the TIDs
+	flow_rates_count(heavy, 0, 60, 6000);
+	flow_rates_count(heavy, 1, 40, 4000);
+	flow_rates_count(light, 0, 10, 640);
+	__of1x_sample_flow_rates(&sw->pipeline, 2000);
+
+	of1x_stats_flow_get_rates(heavy, &pps, &bps);
+	CU_ASSERT(pps == 100);
+	CU_ASSERT(bps == 10000);
+	of1x_stats_flow_get_rates(light, &pps, &bps);
+	CU_ASSERT(pps == 10);
+	CU_ASSERT(bps == 640);
+	of1x_stats_flow_get_rates(idle, &pps, &bps);
+	CU_ASSERT(pps == 0);
+
+	CU_ASSERT(of1x_get_table_top_flows(&sw->pipeline, 0, top, &num) == ROFL_SUCCESS);
+	CU_ASSERT_FATAL(num == 2);
+	CU_ASSERT(top[0].cookie == 0x1);
+	CU_ASSERT(top[0].flow_id == heavy->cold->generation);
+	CU_ASSERT(top[0].priority == 100);
+	CU_ASSERT(top[0].packet_rate == 100);
+	CU_ASSERT(top[1].cookie == 0x2);
+
+	//EWMA; 2s period, 300pps -> 100 + (300-100)/4
+	flow_rates_count(heavy, 0, 600, 60000);
+	__of1x_sample_flow_rates(&sw->pipeline, 4000);
+	of1x_stats_flow_get_rates(heavy, &pps, &bps);
+	CU_ASSERT(pps == 150);
+	CU_ASSERT(bps == 15000);
+
+	//Decays
+	for(num=5;num<100;num++)
+		__of1x_sample_flow_rates(&sw->pipeline, num*1000);
+	of1x_stats_flow_get_rates(heavy, &pps, &bps);
+	CU_ASSERT(pps == 0);
+	CU_ASSERT(bps == 0);
+	CU_ASSERT(of1x_get_table_top_flows(&sw->pipeline, 0, top, &num) == ROFL_SUCCESS);
+	CU_ASSERT(num == 0);
+
+	//Counters reset; new base, the rate is kept. 0 + 1000/4, then 250 + (1000-250)/4
+	flow_rates_count(idle, 0, 1000, 1000);
+	__of1x_sample_flow_rates(&sw->pipeline, 100000);
+	of1x_stats_flow_get_rates(idle, &pps, &bps);
+	CU_ASSERT(pps == 250);
+	__of1x_stats_flow_reset_counts(idle);
+	__of1x_sample_flow_rates(&sw->pipeline, 101000);
+	of1x_stats_flow_get_rates(idle, &pps, &bps);
+	CU_ASSERT(pps == 250);
+	flow_rates_count(idle, 0, 1000, 1000);
+	__of1x_sample_flow_rates(&sw->pipeline, 102000);
+	of1x_stats_flow_get_rates(idle, &pps, &bps);
+	CU_ASSERT(pps == 437);
+
+	//Same ms; ignored
+	flow_rates_count(idle, 0, 1000, 1000);
+	__of1x_sample_flow_rates(&sw->pipeline, 102000);
+	of1x_stats_flow_get_rates(idle, &pps, &bps);
+	CU_ASSERT(pps == 437);
+
+	CU_ASSERT(of1x_get_table_top_flows(&sw->pipeline, sw->pipeline.num_of_tables, top, &num) == ROFL_FAILURE);
+
+	clean_table(0);
+}
+
+int main(int args, char** argv){
+
+	int return_code;
+	//main to call all the other tests written in the oder files in this folder
+	CU_pSuite pSuite = NULL;
+
+	/* initialize the CUnit test registry */
+	if (CUE_SUCCESS != CU_initialize_registry())
+		return CU_get_error();
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("Suite_OF1X_statistics", set_up, tear_down);
+
+	if (NULL == pSuite){
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if ((NULL == CU_add_test(pSuite, "test statistics slabs", test_stats_slabs)) ||
+	(NULL == CU_add_test(pSuite, "test heavy hitters", test_heavy_hitters)) ||
+	(NULL == CU_add_test(pSuite, "test latency histograms", test_latency_histograms)) ||
+	(NULL == CU_add_test(pSuite, "test statistics modes", test_stats_modes)) ||
+	(NULL == CU_add_test(pSuite, "test flow stats export", test_flow_stats_export)) ||
+	(NULL == CU_add_test(pSuite, "test flow iterator", test_flow_iterator)) ||
+	(NULL == CU_add_test(pSuite, "test flow rates", test_flow_rates))
+		)
+	{
+		fprintf(stderr,"ERROR WHILE ADDING TEST\n");
+		return_code = CU_get_error();
+		CU_cleanup_registry();
+		return return_code;
+	}
+	
+	/* Run all tests using the CUnit Basic interface */
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	return_code = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return return_code;
+}
@@ -14,6 +14,7 @@
 #include <sys/mman.h>
 
 #define OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES 10000
+#define OF1X_TIMERS_TEST_BUDGET_ENTRIES 1000
 /*
  * Test for the insertion of entries to be deleted at
  * the corresponding timeout.
@@ -22,6 +23,9 @@
  * a) insert -> extract
  * b) insert -> expire
  * c) (IDLE) insert -> update -> reschedule -> expire
+ * d) (IDLE) last used timestamps -> expire at last used + timeout
+ * e) expiration at the exact ms, from any level of the wheel
+ * f) mass expiration processed in batches, within the budget of every call
  * ...
  */
 
@@ -44,112 +48,124 @@ void time_forward(uint64_t sec, uint64_t usec, struct timeval * time)
 }
 
 
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
+//Current (fake) time in ms
+static uint64_t now_ms(struct timeval* now){
+	time_forward(0,0,now);
+	return __of1x_get_time_ms(now);
+}
 
-void test_insert_and_expiration_static(of1x_pipeline_t * pipeline, uint32_t hard_timeout)
+void test_insert_and_expiration(of1x_pipeline_t * pipeline, uint32_t hard_timeout)
 {
 	of1x_flow_table_t* table = pipeline->tables;
 	struct timeval now;
-	time_forward(0,0,&now);
-	of1x_flow_entry_t *single_entry = of1x_init_flow_entry(false);
+	uint64_t expiration = now_ms(&now) + (uint64_t)hard_timeout*1000;
+	of1x_flow_entry_t *tmp, *single_entry = of1x_init_flow_entry(false);
 	CU_ASSERT(single_entry!=NULL);
 	__of1x_fill_new_timer_entry_info(single_entry,hard_timeout,0);
-	CU_ASSERT(single_entry->timer_info.hard_timeout==hard_timeout);
+	CU_ASSERT(single_entry->cold->timer_info.hard_timeout==hard_timeout);
+
+	//Cheat pipeline
+	tmp = single_entry;
 	CU_ASSERT(of1x_add_flow_entry_table(pipeline,0, &single_entry, false, false)==ROFL_OF1X_FM_SUCCESS);
-	
-	//ASSERT(of1x_add_timer(table, single_entry)==EXIT_SUCCESS,"add timer failed");
-
-	int slot = (now.tv_sec+hard_timeout)%OF1X_TIMER_GROUPS_MAX;
-	//of1x_dump_timers_structure(table->timers);
-	CU_ASSERT(table->timers[slot].list.num_of_timers==1);
-	CU_ASSERT(table->timers[slot].list.head != NULL);//this can improve with the actual addersses
-	CU_ASSERT(table->timers[slot].list.tail != NULL);
-	CU_ASSERT(table->timers[slot].list.head == table->timers[slot].list.tail);
-	
-	time_forward(hard_timeout+1,0,&now); //we need to go to hard_timeout +1 because of possible rounding up.
+	single_entry = tmp;
+
+	//__of1x_dump_timers_structure(&table->timers);
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers)==1);
+	CU_ASSERT(__of1x_timer_is_scheduled(&single_entry->cold->timer_info.hard_timer));
+	CU_ASSERT(!__of1x_timer_is_scheduled(&single_entry->cold->timer_info.idle_timer));
+	CU_ASSERT(single_entry->cold->timer_info.hard_timer.expiration == expiration);
+	CU_ASSERT(single_entry->cold->timer_info.hard_timer.list->head == &single_entry->cold->timer_info.hard_timer);
+	CU_ASSERT(single_entry->cold->timer_info.hard_timer.list->head == single_entry->cold->timer_info.hard_timer.list->tail);
+
+	time_forward(hard_timeout,0,&now);
 	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
-	
-	//of1x_dump_timers_structure(table->timers);
-	CU_ASSERT(table->timers[slot].list.num_of_timers==0);//this can improve with the actual addersses
-	CU_ASSERT(table->timers[slot].list.head == NULL);
-	CU_ASSERT(table->timers[slot].list.tail == NULL);
-	CU_ASSERT(table->timers[slot].list.head == table->timers[slot].list.tail);
+
+	//__of1x_dump_timers_structure(&table->timers);
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers)==0);
+	CU_ASSERT(table->num_of_entries == 0);
 	fprintf(stderr,"<%s> test passed\n",__func__);
 }
 
-void test_insert_and_extract_static(of1x_pipeline_t * pipeline, uint32_t hard_timeout, int num_of_entries)
+void test_insert_and_extract(of1x_pipeline_t * pipeline, uint32_t hard_timeout, int num_of_entries)
 {
 	int i;
 	of1x_flow_table_t* table = pipeline->tables;
-	struct timeval now;
-	time_forward(0,0,&now);
-	
-	of1x_flow_entry_t** entry_list = malloc(num_of_entries*sizeof(of1x_entry_timer_t*));
-	int slot = (now.tv_sec+hard_timeout)%OF1X_TIMER_GROUPS_MAX; //WARNING needs to be mora accurate when MS per SLOT != 1000
-	
+	of1x_timer_list_t* list = NULL;
+	of1x_entry_timer_t* entry_iterator;
+
+	of1x_flow_entry_t** entry_list = malloc(num_of_entries*sizeof(of1x_flow_entry_t*));
+
 	//adding the entries
 	for(i=0; i< num_of_entries; i++)
 	{
-		
+
 		of1x_flow_entry_t* tmp;
 		entry_list[i] = of1x_init_flow_entry(false);
 		__of1x_fill_new_timer_entry_info(entry_list[i],hard_timeout,0); 	//WARNING supposition: the entry is filled up alone
 		of1x_add_match_to_entry(entry_list[i],of1x_init_port_in_match(i));
-		
+
 		//Cheat pipeline
 		tmp = entry_list[i];
 		of1x_add_flow_entry_table(pipeline,0, &entry_list[i], false, false);
 		entry_list[i] = tmp;
-		
-		CU_ASSERT(table->timers[slot].list.num_of_timers==i+1);
-		CU_ASSERT(table->timers[slot].list.head != NULL); //this can improve with the actual addersses
-		CU_ASSERT(table->timers[slot].list.tail != NULL);
+
+		//Same expiration, same slot
+		if(i==0)
+			list = entry_list[i]->cold->timer_info.hard_timer.list;
+		CU_ASSERT(list != NULL);
+		CU_ASSERT(entry_list[i]->cold->timer_info.hard_timer.list == list);
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers)==(unsigned int)i+1);
+		CU_ASSERT(list->num_of_timers==(unsigned int)i+1);
+		CU_ASSERT(list->head != NULL);
+		CU_ASSERT(list->tail == &entry_list[i]->cold->timer_info.hard_timer);
 		if(i==0)
 		{
-			CU_ASSERT(table->timers[slot].list.head == table->timers[slot].list.tail);
+			CU_ASSERT(list->head == list->tail);
 		}
 		else
 		{
-			CU_ASSERT(table->timers[slot].list.head != table->timers[slot].list.tail);
+			CU_ASSERT(list->head != list->tail);
 		}
 	}
-	
+
 	//check pointers of entries
-	i=0;
-	of1x_entry_timer_t * entry_iterator=table->timers[slot].list.head;
-	for(;entry_iterator->next;entry_iterator=entry_iterator->next)
-	{
-		i++;
+	if(num_of_entries > 0){
+		i=0;
+		for(entry_iterator=list->head;entry_iterator->next;entry_iterator=entry_iterator->next)
+		{
+			CU_ASSERT(entry_iterator->next->prev == entry_iterator);
+			i++;
+		}
+		CU_ASSERT(i==num_of_entries-1);
 	}
-	CU_ASSERT(i==num_of_entries-1);
-	
+
 	//external extraction of the entries
 	for(i=0; i< num_of_entries; i++)
 	{
 		platform_mutex_lock(table->mutex);
 
+		CU_ASSERT(__of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
+		CU_ASSERT(!__of1x_timer_is_scheduled(&entry_list[i]->cold->timer_info.hard_timer));
 		if(i==num_of_entries-2)
 		{
-			CU_ASSERT(__of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
-			CU_ASSERT(table->timers[slot].list.head == table->timers[slot].list.tail);
+			CU_ASSERT(list->head == list->tail);
 		}
 		else if(i==num_of_entries-1)
 		{
-			CU_ASSERT(__of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
-			CU_ASSERT(table->timers[slot].list.head == NULL);
-			CU_ASSERT(table->timers[slot].list.tail == NULL);
+			CU_ASSERT(list->head == NULL);
+			CU_ASSERT(list->tail == NULL);
 		}
-		else
-		{
-			//fprintf(stderr,"i %d entry %p hto %d ne %d \n", i, entry_list[i], hard_timeout, num_of_entries);
-			CU_ASSERT(__of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
-		}
-		CU_ASSERT(table->timers[slot].list.num_of_timers==(num_of_entries-i-1));
+		CU_ASSERT(list->num_of_timers==(unsigned int)(num_of_entries-i-1));
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers)==(unsigned int)(num_of_entries-i-1));
+
+		//Idempotent
+		CU_ASSERT(__of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers)==(unsigned int)(num_of_entries-i-1));
 		platform_mutex_unlock(table->mutex);
-		
+
 		of1x_remove_flow_entry_table(pipeline,0, entry_list[i], NOT_STRICT,OF1X_PORT_ANY,OF1X_GROUP_ANY);
 	}
-		
+
 	free(entry_list);
 	fprintf(stderr,"<%s> test passed\n",__func__);
 }
@@ -157,375 +173,374 @@ void test_insert_and_extract_static(of1x_pipeline_t * pipeline, uint32_t hard_ti
 /**
  * Test for Idle timers
  */
-void test_simple_idle_static(of1x_pipeline_t * pipeline, uint32_t ito)
+void test_simple_idle(of1x_pipeline_t * pipeline, uint32_t ito)
 {
 	of1x_flow_table_t * table = pipeline->tables;
 	of1x_flow_entry_t *tmp;
-	of1x_flow_entry_t *entry=of1x_init_flow_entry(false); //NOTE entry is initiated but not inserted in the table. Therefore we must extract it.??
+	of1x_flow_entry_t *entry=of1x_init_flow_entry(false);
 	struct timeval now;
-	//WARNING not working for slots different than seconds (1000 ms)
-	int slot, i;
+	uint64_t t0;
 	__of1x_fill_new_timer_entry_info(entry,0,ito);
-	
-	//insert to table?
+
 	//Cheat pipeline
-	tmp = entry;	
+	tmp = entry;
+	t0 = now_ms(&now);
 	of1x_add_flow_entry_table(pipeline, 0, &entry,false, false);
 	entry = tmp;
-	
-	//insert a timer
-	//CU_ASSERT(of1x_add_timer(table, entry)==EXIT_SUCCESS);
-	time_forward(0,0,&now);
+
 	fprintf(stderr,"added idle TO (%p) at time %lu:%lu for %d seconds\n", entry, now.tv_sec, now.tv_usec, ito);
-	slot = (now.tv_sec+ito)%OF1X_TIMER_GROUPS_MAX;
-	CU_ASSERT(table->timers[slot].list.head->entry == entry);
-	
+	CU_ASSERT(__of1x_timer_is_scheduled(&entry->cold->timer_info.idle_timer));
+	CU_ASSERT(entry->cold->timer_info.idle_timer.expiration == t0 + (uint64_t)ito*1000);
+
 	//update the counter
 	time_forward(ito-1,0,&now);
-	entry->stats.s.__internal[1].packet_count++; //__of1x_timer_update_entry(entry,now);
+	__of1x_stats_flow_counters(&entry->stats,1)->packet_count++; //__of1x_timer_update_entry(entry,now);
 	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
 	fprintf(stderr,"updated last used. TO (%p) at time %lu:%lu for %d seconds\n", entry, now.tv_sec, now.tv_usec, ito);
-	slot = (now.tv_sec+1)%OF1X_TIMER_GROUPS_MAX;
-	CU_ASSERT(table->timers[slot].list.head->entry == entry);
-	
+	CU_ASSERT(__of1x_timer_is_scheduled(&entry->cold->timer_info.idle_timer));
+	CU_ASSERT(entry->cold->timer_info.idle_timer.expiration == __of1x_get_time_ms(&now) + 1000);
+
 	//check that it is not expired but rescheduled
 	time_forward(1,0,&now);
 	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
-	//slot = (now.tv_sec+ito-1)%OF1X_TIMER_GROUPS_MAX; NOTE with the lazy expiration we reschedule depending on the time of chek of the expiration
-	slot = (now.tv_sec+ito)%OF1X_TIMER_GROUPS_MAX;
-	CU_ASSERT(table->timers[slot].list.head->entry == entry);
-	
+	//NOTE with the lazy expiration we reschedule depending on the time of chek of the expiration
+	CU_ASSERT(table->num_of_entries == 1);
+	CU_ASSERT(__of1x_timer_is_scheduled(&entry->cold->timer_info.idle_timer));
+	CU_ASSERT(entry->cold->timer_info.idle_timer.expiration == __of1x_get_time_ms(&now) + (uint64_t)ito*1000);
+
 	//check final expiration
 	time_forward(ito,0,&now);
 	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
-	for(i=0; i<OF1X_TIMER_GROUPS_MAX; i++)
-		CU_ASSERT(table->timers[i].list.num_of_timers == 0);
-	
-	//of1x_destroy_flow_entry(entry);
-	fprintf(stderr,"<%s> test passed\n",__func__);
-}
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 0);
+	CU_ASSERT(table->num_of_entries == 0);
 
-void debug_how_many_entries_static(of1x_flow_table_t *table){
-	unsigned int num=0, i=0;
-	for(i=0; i<OF1X_TIMER_GROUPS_MAX;i++){
-		if(table->timers[i].list.num_of_timers>0)
-			fprintf(stderr,"<%s:%d> i=%d\n",__func__,__LINE__,i);
-		num+=table->timers[i].list.num_of_timers;
-	}
-	fprintf(stderr,"<%s:%d> Total num of entr = %d\n",__func__,__LINE__,num);
+	fprintf(stderr,"<%s> test passed\n",__func__);
 }
 
-void test_insert_both_expires_one_check_the_other_static(of1x_pipeline_t * pipeline, uint32_t hto, uint32_t ito)
+void test_insert_both_expires_one_check_the_other(of1x_pipeline_t * pipeline, uint32_t hto, uint32_t ito)
 {
 	of1x_flow_table_t * table = pipeline->tables;
 	struct timeval now;
-	time_forward(0,0,&now);
-	int slot, i;
-	
+	uint64_t t0 = now_ms(&now);
+
 	of1x_flow_entry_t *tmp;
 	of1x_flow_entry_t *single_entry = of1x_init_flow_entry(false);
 	__of1x_fill_new_timer_entry_info(single_entry,hto,ito);
-	
+
 	//Cheat pipeline
 	tmp = single_entry;
 	of1x_add_flow_entry_table(pipeline,0,&single_entry, false, false);
 	single_entry = tmp;
-	
-	//CU_ASSERT(of1x_add_timer(table, entry)==EXIT_SUCCESS,"error add timer");
-	
+
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 2);
+
 	if(hto==ito)
 	{
 		time_forward(ito,0,&now);
 		__of1x_process_pipeline_tables_timeout_expirations(pipeline);
-		for(i=0; i<OF1X_TIMER_GROUPS_MAX; i++)
-			CU_ASSERT(table->timers[i].list.num_of_timers == 0);
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 0);
 	}
 	else
 	{
 		uint32_t min = (hto<ito ? hto : ito);
 		uint32_t max = (hto>ito ? hto : ito);
 		fprintf(stderr,"<%s:%d>hto %u ito %u min %u max %u\n",__func__,__LINE__,hto,ito,min, max);
-		slot = (now.tv_sec+ito)%OF1X_TIMER_GROUPS_MAX;
-		CU_ASSERT(table->timers[slot].list.head->entry==single_entry);
-		slot = (now.tv_sec+hto)%OF1X_TIMER_GROUPS_MAX;
-		CU_ASSERT(table->timers[slot].list.head->entry==single_entry);
-		slot = (now.tv_sec+min)%OF1X_TIMER_GROUPS_MAX;
-		CU_ASSERT(table->timers[slot].timeout==(min+now.tv_sec)*1000+now.tv_usec/1000);
-		slot = (now.tv_sec+max)%OF1X_TIMER_GROUPS_MAX;
-		CU_ASSERT(table->timers[slot].timeout==(max+now.tv_sec)*1000+now.tv_usec/1000);
-		time_forward(min,0,&now);
+		CU_ASSERT(single_entry->cold->timer_info.idle_timer.entry==single_entry);
+		CU_ASSERT(single_entry->cold->timer_info.idle_timer.expiration==t0+(uint64_t)ito*1000);
+		CU_ASSERT(single_entry->cold->timer_info.hard_timer.entry==single_entry);
+		CU_ASSERT(single_entry->cold->timer_info.hard_timer.expiration==t0+(uint64_t)hto*1000);
+
+		//Nothing expires before the min
+		time_forward(min-1,0,&now);
 		__of1x_process_pipeline_tables_timeout_expirations(pipeline);
-		for(i=0; i<OF1X_TIMER_GROUPS_MAX; i++)
-			CU_ASSERT(table->timers[i].list.num_of_timers == 0);
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 2);
+		CU_ASSERT(table->num_of_entries == 1);
+
+		time_forward(1,0,&now);
+		__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 0);
 	}
+	CU_ASSERT(table->num_of_entries == 0);
 	fprintf(stderr,"<%s> test passed\n",__func__);
 }
 
-#else
 /**
- * testing insertion and extraction with dynamic timer groups
+ * Idle timers from the last used timestamps; expire exactly at last used + ito
  */
-void test_insert_and_extract_dynamic(of1x_pipeline_t * pipeline, uint32_t hard_timeout, int num_of_entries)
+void test_idle_timestamps(of1x_pipeline_t * pipeline, uint32_t ito)
 {
-	int i;
-	of1x_flow_table_t* table = pipeline->tables;
-	of1x_flow_entry_t** entry_list = malloc(num_of_entries*sizeof(of1x_flow_entry_t*));
-	
-	//adding the entries
-	for(i=0; i< num_of_entries; i++)
-	{
-		//WARNING supposition: the entry is filled up alone
-		entry_list[i] = of1x_init_flow_entry(false);
-		of1x_fill_new_timer_entry_info(entry_list[i],hard_timeout,0);
-		of1x_add_match_to_entry(entry_list[i],of1x_init_port_in_match(i));
-		of1x_add_flow_entry_table(pipeline,0, &entry_list[i], false, false);
-		//CU_ASSERT(of1x_add_timer(table, entry_list[i]));
-		
-		CU_ASSERT(table->timers->list.num_of_timers==i+1);
-		CU_ASSERT(table->timers->list.head != NULL);
-		CU_ASSERT(table->timers->list.tail != NULL);
-		if(i==0)
-		{
-			CU_ASSERT(table->timers->list.head == table->timers->list.tail);
-		}
-		else
-		{
-			CU_ASSERT(table->timers->list.head != table->timers->list.tail);
-		}
-	}
-	
-	//check pointers of entries
-	i=0;
-	of1x_entry_timer_t * entry_iterator=table->timers->list.head;
-	for(;entry_iterator->next;entry_iterator=entry_iterator->next)
-	{
-		i++;
-	}
-	CU_ASSERT(i==num_of_entries-1);
-	
-	for(i=0; i< num_of_entries; i++)
-	{
-		platform_mutex_lock(table->mutex);
+	of1x_flow_table_t * table = pipeline->tables;
+	of1x_flow_entry_t *tmp;
+	of1x_flow_entry_t *entry=of1x_init_flow_entry(false);
+	struct timeval now;
+	uint64_t t0, last_used;
+	unsigned int i;
 
-		if(i==num_of_entries-1)
-		{
-			CU_ASSERT(of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
-			CU_ASSERT(table->timers == NULL);
-		}
-		else if(i==num_of_entries-2)
-		{
-			assert(of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
-			assert(table->timers->list.head == table->timers->list.tail);
-			assert(table->timers->list.num_of_timers==(num_of_entries-i-1));
-		}
-		else
-		{
-			fprintf(stderr,"i %d entry %p hto %d ne %d \n", i, entry_list[i], hard_timeout, num_of_entries);
-			CU_ASSERT(of1x_destroy_timer_entries(entry_list[i])==EXIT_SUCCESS);
-			CU_ASSERT(table->timers->list.num_of_timers==(num_of_entries-i-1));
-		}
-		platform_mutex_unlock(table->mutex);
-		CU_ASSERT( of1x_destroy_flow_entry(entry_list[i])==ROFL_SUCCESS);
+	CU_ASSERT(of1x_set_table_idle_timestamps(pipeline, 0, true) == ROFL_SUCCESS);
+	__of1x_fill_new_timer_entry_info(entry,0,ito);
+
+	//Cheat pipeline
+	tmp = entry;
+	t0 = now_ms(&now);
+	of1x_add_flow_entry_table(pipeline, 0, &entry,false, false);
+	entry = tmp;
+
+	CU_ASSERT(entry->stats.pp_mode & OF1X_STATS_FLOW_LAST_USED);
+	CU_ASSERT(entry->stats.last_used == (uint32_t)t0);
+	CU_ASSERT(entry->cold->timer_info.idle_timer.expiration == t0 + (uint64_t)ito*1000);
+
+	//Used 1s before the idle timeout (datapath)
+	time_forward(ito-1,0,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	last_used = now_ms(&now);
+	CU_ASSERT(tid_get_clock(ROFL_PIPELINE_LOCKED_TID) == (uint32_t)last_used);
+	entry->stats.last_used = tid_get_clock(ROFL_PIPELINE_LOCKED_TID);
+
+	//Rescheduled from the last use, not from the time of the check; the
+	//timestamp only bounds the use to the period (1s) that followed it
+	time_forward(1,0,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	CU_ASSERT(table->num_of_entries == 1);
+	CU_ASSERT(__of1x_timer_is_scheduled(&entry->cold->timer_info.idle_timer));
+	CU_ASSERT(entry->cold->timer_info.idle_timer.expiration == last_used + 1000 + (uint64_t)ito*1000);
+
+	//1 ms before
+	time_forward(ito-1,999000,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	CU_ASSERT(table->num_of_entries == 1);
+
+	time_forward(0,1000,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 0);
+	CU_ASSERT(table->num_of_entries == 0);
+
+	//Idle timeout as long as the processing period; used in every period
+	entry = of1x_init_flow_entry(false);
+	__of1x_fill_new_timer_entry_info(entry,0,1);
+	tmp = entry;
+	of1x_add_flow_entry_table(pipeline, 0, &entry,false, false);
+	entry = tmp;
+	for(i=0;i<10;i++){
+		entry->stats.last_used = tid_get_clock(ROFL_PIPELINE_LOCKED_TID);
+		time_forward(1,0,&now);
+		__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+		CU_ASSERT(table->num_of_entries == 1);
 	}
-	
-	free(entry_list);
+
+	//Not used anymore; expires within a period after the idle timeout
+	time_forward(1,0,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	CU_ASSERT(table->num_of_entries == 0);
+
+	CU_ASSERT(of1x_set_table_idle_timestamps(pipeline, 0, false) == ROFL_SUCCESS);
 	fprintf(stderr,"<%s> test passed\n",__func__);
 }
 
 /**
- * Test for Idle timers
+ * Expiration at the exact ms (all the levels of the wheel)
  */
-void test_simple_idle_dynamic(of1x_pipeline_t * pipeline, uint32_t ito)
+void test_expiration_accuracy(of1x_pipeline_t * pipeline, uint32_t hard_timeout)
 {
-	of1x_flow_table_t * table = pipeline->tables;
-	struct timeval now;
-	
-	of1x_flow_entry_t *entry=of1x_init_flow_entry(false);
-	of1x_fill_new_timer_entry_info(entry,0,ito);
-	CU_ASSERT(of1x_add_flow_entry_table(pipeline,0, &entry, false, false)==ROFL_OF1X_FM_SUCCESS);
-	
-	//insert a timer
-	//CU_ASSERT(of1x_add_timer(table, entry)==EXIT_SUCCESS);
-	of1x_time_forward(0,0,&now);
-	fprintf(stderr,"added idle TO (%p) at time %lu:%lu for %d seconds\n", entry, now.tv_sec, now.tv_usec, ito);
-	CU_ASSERT(table->timers->list.head->entry == entry);
-	
-	//update the counter
-	of1x_time_forward(ito-1,0,&now);
-	of1x_timer_update_entry(entry);
-	of1x_process_pipeline_tables_timeout_expirations(pipeline);
-	fprintf(stderr,"updated last used. TO (%p) at time %lu:%lu for %d seconds\n", entry, now.tv_sec, now.tv_usec, ito);
-	CU_ASSERT(table->timers->list.head->entry == entry);
-	
-	//check that it is not expired but rescheduled
-	of1x_time_forward(1,0,&now);
-	of1x_process_pipeline_tables_timeout_expirations(pipeline);
-	CU_ASSERT(table->timers->list.head->entry == entry);
-	
-	//check final expiration
-	of1x_time_forward(ito-1,0,&now);
-	of1x_process_pipeline_tables_timeout_expirations(pipeline);
-	CU_ASSERT(table->timers == NULL);
-	
-	//of1x_destroy_flow_entry(entry);
-	fprintf(stderr,"<%s> test passed\n",__func__);
-}
-
-void test_insert_both_expires_one_check_the_other_dynamic(of1x_pipeline_t * pipeline, uint32_t hto, uint32_t ito)
-{
-	of1x_flow_table_t * table = pipeline->tables;
+	of1x_flow_table_t* table = pipeline->tables;
 	struct timeval now;
-	of1x_time_forward(0,0,&now);
-	
 	of1x_flow_entry_t *single_entry = of1x_init_flow_entry(false);
-	of1x_fill_new_timer_entry_info(single_entry,hto,ito);
-	of1x_add_flow_entry_table(pipeline,0, single_entry, false, false);
-	
-	if(hto==ito)
-	{
-		of1x_time_forward(ito,0,&now);
-		of1x_process_pipeline_tables_timeout_expirations(pipeline);
-		assert(table->timers == NULL);
-	}
-	else
-	{
-		uint32_t min = (hto<ito ? hto : ito);
-		uint32_t max = (hto>ito ? hto : ito);
-		fprintf(stderr,"<%s:%d>hto %u ito %u min %u max %u\n",__func__,__LINE__,hto,ito,min, max);
-		assert(table->timers->next!=NULL);
-		assert(table->timers->timeout==(min+now.tv_sec)*1000+now.tv_usec/1000);
-		assert(table->timers->next->timeout==(max+now.tv_sec)*1000+now.tv_usec/1000);
-		of1x_time_forward(min,0,&now);
-		of1x_process_pipeline_tables_timeout_expirations(pipeline);
-		assert(table->timers==NULL);
-	}
+	__of1x_fill_new_timer_entry_info(single_entry,hard_timeout,0);
+	CU_ASSERT(of1x_add_flow_entry_table(pipeline,0, &single_entry, false, false)==ROFL_OF1X_FM_SUCCESS);
+
+	//1 ms before
+	if(hard_timeout > 1)
+		time_forward(hard_timeout-1,0,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	time_forward(0,999000,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 1);
+	CU_ASSERT(table->num_of_entries == 1);
+
+	time_forward(0,1000,&now);
+	__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 0);
+	CU_ASSERT(table->num_of_entries == 0);
+
 	fprintf(stderr,"<%s> test passed\n",__func__);
 }
 
 /**
- * random insert and time expiration
+ * incremental insert and time expiration
  */
-void test_incremental_insert_and_expiration_dynamic(of1x_pipeline_t * pipeline)
+void test_incremental_insert_and_expiration(of1x_pipeline_t * pipeline)
 {
 	of1x_flow_table_t * table = pipeline->tables;
-	of1x_timer_group_t * tg_pointer;
 	struct timeval now;
 	int i;
-	of1x_flow_entry_t* entry_list[OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES];// = malloc(OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES*sizeof(of1x_flow_entry_t*));
-	
+	of1x_flow_entry_t* tmp;
+	of1x_flow_entry_t** entry_list = malloc(OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES*sizeof(of1x_flow_entry_t*));
+
 	for(i=0; i<OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES; i++)
 	{
 		uint32_t timeout = i+1;
 		entry_list[i] = of1x_init_flow_entry(false);
 		CU_ASSERT(entry_list[i]!=NULL);
-		of1x_fill_new_timer_entry_info(entry_list[i],timeout,0);
+		__of1x_fill_new_timer_entry_info(entry_list[i],timeout,0);
 		of1x_add_match_to_entry(entry_list[i],of1x_init_port_in_match(i));
+
+		//Cheat pipeline
+		tmp = entry_list[i];
 		CU_ASSERT(of1x_add_flow_entry_table(pipeline,0, &entry_list[i], false, false)==ROFL_OF1X_FM_SUCCESS);
-		
-		//if(i==0)
-		//{
-		//	CU_ASSERT(mprotect(entry_list[i]->rwlock, sizeof(pthread_rwlock_t), PROT_NONE)==0);
-		//}
-		
-		if(i==0)
-		{
-			tg_pointer = table->timers;
-		}
-		else
-		{
-			tg_pointer = tg_pointer->next;
-		}
-		
-		CU_ASSERT(tg_pointer->list.head->entry == entry_list[i]);
-		
-		//number of entries
+		entry_list[i] = tmp;
+
+		CU_ASSERT(__of1x_timer_is_scheduled(&entry_list[i]->cold->timer_info.hard_timer));
 	}
-	
-	//comprovar que els timers han sigut ben assignats
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES);
+
+	//One entry expires every second (timers are cascaded from the upper levels)
 	for(i=0; i<OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES; i++)
 	{
-		//vaig fent processes i passant el temps
-		of1x_time_forward(1,0,&now);
-		of1x_process_pipeline_tables_timeout_expirations(pipeline);
+		time_forward(1,0,&now);
+		__of1x_process_pipeline_tables_timeout_expirations(pipeline);
+		CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == (unsigned int)(OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES-i-1));
+		CU_ASSERT(table->num_of_entries == (unsigned int)(OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES-i-1));
 		if(i<OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES-1)
 		{
-			CU_ASSERT(table->timers->list.head->entry == entry_list[i+1]);
+			CU_ASSERT(__of1x_timer_is_scheduled(&entry_list[i+1]->cold->timer_info.hard_timer));
 		}
 	}
-	//free(entry_list);
+	free(entry_list);
 	fprintf(stderr,"<%s> test passed\n",__func__);
 }
 
+/**
+ * mass expiration with a budget: every call expires at most budget entries,
+ * and returns true while there are pending ones
+ */
+void test_budgeted_expiration(of1x_pipeline_t * pipeline, uint32_t hard_timeout, unsigned int budget)
+{
+	of1x_flow_table_t * table = pipeline->tables;
+	struct timeval now;
+	unsigned int i, num_of_calls;
+	bool pending;
+	of1x_flow_entry_t* entry;
+
+	of1x_set_timeout_expiration_budget(pipeline, budget);
+
+	//Notified (batch path) entries
+	for(i=0; i<OF1X_TIMERS_TEST_BUDGET_ENTRIES; i++)
+	{
+		entry = of1x_init_flow_entry(true);
+		CU_ASSERT(entry!=NULL);
+		__of1x_fill_new_timer_entry_info(entry,hard_timeout,0);
+		of1x_add_match_to_entry(entry,of1x_init_port_in_match(i));
+		CU_ASSERT(of1x_add_flow_entry_table(pipeline,0, &entry, false, false)==ROFL_OF1X_FM_SUCCESS);
+	}
+	CU_ASSERT(table->num_of_entries == OF1X_TIMERS_TEST_BUDGET_ENTRIES);
+
+	//Nothing expired yet
+	CU_ASSERT(__of1x_process_pipeline_tables_timeout_expirations(pipeline) == false);
+	CU_ASSERT(table->num_of_entries == OF1X_TIMERS_TEST_BUDGET_ENTRIES);
+
+	time_forward(hard_timeout,0,&now);
+
+	for(num_of_calls=1;;num_of_calls++)
+	{
+		pending = __of1x_process_pipeline_tables_timeout_expirations(pipeline);
+
+		if(num_of_calls*budget < OF1X_TIMERS_TEST_BUDGET_ENTRIES){
+			CU_ASSERT(pending == true);
+			CU_ASSERT(table->num_of_entries == OF1X_TIMERS_TEST_BUDGET_ENTRIES-num_of_calls*budget);
+			CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == table->num_of_entries);
+		}else{
+			CU_ASSERT(table->num_of_entries == 0);
+		}
+
+		if(!pending || num_of_calls > OF1X_TIMERS_TEST_BUDGET_ENTRIES)
+			break;
+	}
+
+	//The last call may only find out there is nothing left
+	CU_ASSERT(num_of_calls >= (OF1X_TIMERS_TEST_BUDGET_ENTRIES+budget-1)/budget);
+	CU_ASSERT(num_of_calls <= (OF1X_TIMERS_TEST_BUDGET_ENTRIES+budget-1)/budget+1);
+	CU_ASSERT(table->num_of_entries == 0);
+	CU_ASSERT(__of1x_timer_wheel_num_of_timers(&table->timers) == 0);
 
-#endif
+	//Unlimited
+	of1x_set_timeout_expiration_budget(pipeline, 0);
 
-static int setup_test(of1x_switch_t** sw)
+	fprintf(stderr,"<%s> test passed\n",__func__);
+}
+
+static of1x_switch_t* sw=NULL;
+
+int timers_set_up(void)
 {
 	physical_switch_init();	
 
 	enum of1x_matching_algorithm_available ma_list= of1x_loop_matching_algorithm;
-	(*sw) = of1x_init_switch("Test switch",OF_VERSION_12, 0x0101,1,&ma_list);
-	CU_ASSERT(sw!=NULL);
-/*	
-	table->mutex = platform_mutex_init(NULL);
-	if(table->mutex==NULL)
-	{
-		fprintf(stderr,"<%s:%d> Mutex init failed\n", __func__, __LINE__);
+	sw = of1x_init_switch("Test switch",OF_VERSION_12, 0x0101,1,&ma_list);
+	if(sw==NULL)
 		return EXIT_FAILURE;
-	}
-	pipeline->tables = table;
-	pipeline.num_of_tables=1;
-*/
+
 	return EXIT_SUCCESS;
 }
 
-static int clean_up(of1x_switch_t * sw)
+int timers_tear_down(void)
 {
-	//platform_mutex_destroy(table->mutex);
-	__of1x_destroy_switch(sw);
+	if(__of1x_destroy_switch(sw) != ROFL_SUCCESS)
+		return EXIT_FAILURE;
 	
 	return EXIT_SUCCESS;
 }
 
+//Random timeout (s), at least 2s
+static uint32_t random_timeout(void)
+{
+	uint32_t to = (random32()%OF1X_TIMER_MAX_TIMEOUT)+1;
+	return (to > 1)? to : 2;
+}
+
 //Tests
 void main_test(void)
 {	
 	/*
 	 * steps:
-	 * 1- create a table which needs to have the timer_group defined 
-	 * (table->timers)
+	 * 1- create a table (timer wheel in table->timers)
 	 * 2- create some entries: they dont need to be full, just to have a timeout or smthg
 	 * 3- add some enrteies with some timeouts and pretend the time has passed
 	 */
-	of1x_switch_t *sw=NULL;
-	CU_ASSERT(setup_test(&sw)==EXIT_SUCCESS);
-	
 	int i;
 	uint32_t rnd_to, rnd_toh,rnd_entries;
 	for(i=0;i<1;i++)
 	{
-		rnd_to = (random32()%OF1X_TIMER_GROUPS_MAX)+1;
-		rnd_toh = (random32()%OF1X_TIMER_GROUPS_MAX)+1;
+		rnd_to = (random32()%OF1X_TIMER_MAX_TIMEOUT)+1;
+		rnd_toh = (random32()%OF1X_TIMER_MAX_TIMEOUT)+1;
 		rnd_entries = random32()%OF1X_TIMERS_TEST_MAX_TIMER_ENTRIES;
 		fprintf(stderr,"<%s:%d> Rnd values: ito %d hto %d n_entries %d\n", __func__, __LINE__,
 				rnd_to, rnd_toh, rnd_entries);
-#if OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-		test_insert_and_expiration_static(&sw->pipeline, rnd_to);
-		test_insert_and_extract_static(&sw->pipeline, rnd_to, rnd_entries);
-		test_simple_idle_static(&sw->pipeline, rnd_to);
-		test_insert_both_expires_one_check_the_other_static(&sw->pipeline,rnd_toh, rnd_to);
-#else
-		test_insert_and_extract_dynamic(&sw->pipeline,rnd_to, 2/*rnd_entries*/);
-		test_simple_idle_dynamic(&sw->pipeline, rnd_to);
-		test_insert_both_expires_one_check_the_other_dynamic(&sw->pipeline, rnd_toh, rnd_to );
-#endif
+		test_insert_and_expiration(&sw->pipeline, rnd_to);
+		test_insert_and_extract(&sw->pipeline, rnd_to, rnd_entries);
+		test_simple_idle(&sw->pipeline, rnd_to);
+		test_insert_both_expires_one_check_the_other(&sw->pipeline,rnd_toh, rnd_to);
+		test_insert_both_expires_one_check_the_other(&sw->pipeline,rnd_to, rnd_to);
 	}
-	
+}
 
-#if ! OF1X_TIMER_STATIC_ALLOCATION_SLOTS
-	test_incremental_insert_and_expiration_dynamic(sw->pipeline);
-#endif
-	
-	CU_ASSERT(clean_up(sw)==EXIT_SUCCESS);
-	
+void wheel_accuracy_test(void)
+{
+	test_expiration_accuracy(&sw->pipeline, 1);
+	test_expiration_accuracy(&sw->pipeline, random_timeout());
+	test_expiration_accuracy(&sw->pipeline, OF1X_TIMER_MAX_TIMEOUT);
+}
+
+void wheel_cascade_test(void)
+{
+	test_incremental_insert_and_expiration(&sw->pipeline);
+}
+
+void idle_timestamps_test(void)
+{
+	test_idle_timestamps(&sw->pipeline, random_timeout());
+}
+
+void budgeted_expiration_test(void)
+{
+	test_budgeted_expiration(&sw->pipeline, random_timeout(), 100);
+	test_budgeted_expiration(&sw->pipeline, 1, 300);
 }
@@ -10,7 +10,14 @@
 #include "rofl/datapath/pipeline/platform/lock.h"
 #include "rofl/datapath/pipeline/platform/memory.h"
 
+int timers_set_up(void);
+int timers_tear_down(void);
+
 void main_test(void);
+void wheel_accuracy_test(void);
+void wheel_cascade_test(void);
+void idle_timestamps_test(void);
+void budgeted_expiration_test(void);
 
 void time_forward(uint64_t sec, uint64_t usec, struct timeval * time);
 /*
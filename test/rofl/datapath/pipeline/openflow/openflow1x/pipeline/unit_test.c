@@ -54,12 +54,16 @@ int main(int args, char** argv){
 		return CU_get_error();
 	}
 	
-	timers_hard_suite = CU_add_suite("Suite_timers_hard", NULL, NULL);
+	timers_hard_suite = CU_add_suite("Suite_timers_hard", timers_set_up, timers_tear_down);
 	if (NULL == timers_hard_suite) {
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
-	if ((NULL == CU_add_test(timers_hard_suite, "main test", main_test)) ){
+	if ((NULL == CU_add_test(timers_hard_suite, "main test", main_test)) ||
+		(NULL == CU_add_test(timers_hard_suite, "wheel accuracy", wheel_accuracy_test)) ||
+		(NULL == CU_add_test(timers_hard_suite, "wheel cascade", wheel_cascade_test)) ||
+		(NULL == CU_add_test(timers_hard_suite, "idle timestamps", idle_timestamps_test)) ||
+		(NULL == CU_add_test(timers_hard_suite, "budgeted expiration", budgeted_expiration_test)) ){
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "CUnit/Basic.h"
+
+#include "rofl/datapath/pipeline/physical_switch.h"
+#include "rofl/datapath/pipeline/threading.h"
+#include "rofl/datapath/pipeline/openflow/of_switch_pp.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/of1x_switch.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_match.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_entry.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_table.h"
+
+static of1x_switch_t* sw=NULL;
+
+int set_up(){
+
+	enum of1x_matching_algorithm_available ma_list[4]={of1x_loop_matching_algorithm, of1x_loop_matching_algorithm,
+	of1x_loop_matching_algorithm, of1x_loop_matching_algorithm};
+
+	physical_switch_init();
+
+	//Create instance	
+	sw = of1x_init_switch("Test switch", OF_VERSION_12, 0x0101,4,ma_list);
+	
+	if(!sw)
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
+
+int tear_down(){
+	//Destroy the switch
+	if(__of1x_destroy_switch(sw) != ROFL_SUCCESS)
+		return EXIT_FAILURE;
+
+	physical_switch_destroy();
+	
+	return EXIT_SUCCESS;
+}
+
+static unsigned int num_of_released = 0;
+static void count_release(void* obj){
+	(void)obj;
+	num_of_released++;
+}
+
+void test_epoch_reclamation(){
+
+	unsigned int tid = ROFL_PIPELINE_LOCKED_TID+1;
+	int obj1, obj2;
+
+	num_of_released = 0;
+
+	//Nobody in the pipeline; no grace period to wait for
+	tid_synchronize();
+	tid_defer_release(&obj1, count_release);
+	tid_reclaim(false);
+	CU_ASSERT(num_of_released == 1);
+
+	//A thread (burst and packet nesting) sees the object
+	tid_epoch_enter(tid);
+	tid_epoch_enter(tid);
+	CU_ASSERT((tid_epochs[tid].s.state & 0x1ULL) > 0);
+	tid_defer_release(&obj1, count_release);
+	tid_epoch_exit(tid);
+	tid_reclaim(false);
+	CU_ASSERT(num_of_released == 1);
+
+	//Deferred while tid (older epoch) is still active
+	tid_epoch_enter(ROFL_PIPELINE_LOCKED_TID);
+	tid_defer_release(&obj2, count_release);
+	tid_reclaim(false);
+	CU_ASSERT(num_of_released == 1);
+	tid_epoch_exit(ROFL_PIPELINE_LOCKED_TID);
+	CU_ASSERT(tid_epochs[ROFL_PIPELINE_LOCKED_TID].s.shared_readers[0] == 0);
+	CU_ASSERT(tid_epochs[ROFL_PIPELINE_LOCKED_TID].s.shared_readers[1] == 0);
+
+	//Quiescent
+	tid_epoch_exit(tid);
+	CU_ASSERT(tid_epochs[tid].s.state == 0x0ULL);
+	tid_reclaim(false);
+	CU_ASSERT(num_of_released == 3);
+
+	//Drain
+	tid_defer_release(&obj1, count_release);
+	tid_reclaim(true);
+	CU_ASSERT(num_of_released == 4);
+}
+
+static volatile bool reader_left = false;
+static void* epoch_reader(void* arg){
+	unsigned int tid = *(unsigned int*)arg;
+
+	//Stay long enough for the writer to block
+	tid_epoch_enter(tid);
+	usleep(50000);
+	reader_left = true;
+	tid_epoch_exit(tid);
+
+	return NULL;
+}
+
+void test_epoch_blocking_wait(){
+
+	pthread_t thread;
+	unsigned int tid = ROFL_PIPELINE_LOCKED_TID+1;
+
+	//Writer blocks until the reader leaves
+	reader_left = false;
+	CU_ASSERT_FATAL(pthread_create(&thread, NULL, epoch_reader, &tid) == 0);
+	usleep(10000);
+	tid_synchronize();
+	CU_ASSERT(reader_left == true);
+	pthread_join(thread, NULL);
+
+	//ROFL_PIPELINE_LOCKED_TID is shared, but writers still wait for all of them
+	tid = ROFL_PIPELINE_LOCKED_TID;
+	reader_left = false;
+	CU_ASSERT_FATAL(pthread_create(&thread, NULL, epoch_reader, &tid) == 0);
+	usleep(10000);
+	tid_epoch_enter(tid);
+	CU_ASSERT(reader_left == false);
+	tid_epoch_exit(tid);
+	tid_synchronize();
+	CU_ASSERT(reader_left == true);
+	pthread_join(thread, NULL);
+
+	CU_ASSERT(tid_num_of_waiters == 0);
+}
+
+//Restarts the physical switch and the test switch with num_of_tids TIDs
+static void restart_with_tids(unsigned int num_of_tids){
+
+	enum of1x_matching_algorithm_available ma_list[4]={of1x_loop_matching_algorithm, of1x_loop_matching_algorithm,
+	of1x_loop_matching_algorithm, of1x_loop_matching_algorithm};
+
+	CU_ASSERT_FATAL(__of1x_destroy_switch(sw) == ROFL_SUCCESS);
+	physical_switch_destroy();
+
+	CU_ASSERT(tid_set_num_of_tids(num_of_tids) == ROFL_SUCCESS);
+	CU_ASSERT_FATAL(physical_switch_init() == ROFL_SUCCESS);
+
+	sw = of1x_init_switch("Test switch", OF_VERSION_12, 0x0101,4,ma_list);
+	CU_ASSERT_FATAL(sw != NULL);
+}
+
+void test_num_of_tids(){
+
+	of1x_flow_entry_t* entry;
+	__of1x_stats_flow_tid_t c;
+	__of1x_stats_table_tid_t tc;
+
+	//Per thread state is already allocated
+	CU_ASSERT(tid_get_num_of_tids() == ROFL_PIPELINE_MAX_TIDS);
+	CU_ASSERT(tid_set_num_of_tids(2) == ROFL_FAILURE);
+
+	//Only 2 TIDs
+	restart_with_tids(2);
+	CU_ASSERT(tid_get_num_of_tids() == 2);
+	CU_ASSERT(tid_set_num_of_tids(0) == ROFL_FAILURE);
+	CU_ASSERT(tid_set_num_of_tids(ROFL_PIPELINE_MAX_TIDS+1) == ROFL_FAILURE);
+
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(1)) == ROFL_SUCCESS);
+	CU_ASSERT(of1x_add_flow_entry_table(&sw->pipeline, 0, &entry, false,false) == ROFL_OF1X_FM_SUCCESS);
+	entry = sw->pipeline.tables[0].entries;
+	CU_ASSERT_FATAL(entry != NULL);
+
+	__of1x_stats_flow_update_match(ROFL_PIPELINE_LOCKED_TID, &entry->stats, 1, 100);
+	__of1x_stats_flow_update_match(1, &entry->stats, 1, 50);
+	__of1x_stats_flow_consolidate(&entry->stats, &c);
+	CU_ASSERT(c.packet_count == 2);
+	CU_ASSERT(c.byte_count == 150);
+
+	__of1x_stats_table_update_no_match(1, &sw->pipeline.tables[0].stats);
+	__of1x_stats_table_consolidate(&sw->pipeline.tables[0].stats, &tc);
+	CU_ASSERT(tc.lookup_count == 1);
+
+	//Back to the defaults
+	restart_with_tids(ROFL_PIPELINE_MAX_TIDS);
+}
+
+int main(int args, char** argv){
+
+	int return_code;
+	//main to call all the other tests written in the oder files in this folder
+	CU_pSuite pSuite = NULL;
+
+	/* initialize the CUnit test registry */
+	if (CUE_SUCCESS != CU_initialize_registry())
+		return CU_get_error();
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("Suite_Threading", set_up, tear_down);
+
+	if (NULL == pSuite){
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if ((NULL == CU_add_test(pSuite, "test epoch reclamation", test_epoch_reclamation)) ||
+	(NULL == CU_add_test(pSuite, "test epoch blocking wait", test_epoch_blocking_wait)) ||
+	(NULL == CU_add_test(pSuite, "test number of TIDs", test_num_of_tids))
+		)
+	{
+		fprintf(stderr,"ERROR WHILE ADDING TEST\n");
+		return_code = CU_get_error();
+		CU_cleanup_registry();
+		return return_code;
+	}
+	
+	/* Run all tests using the CUnit Basic interface */
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	return_code = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return return_code;
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "rofl/datapath/pipeline/physical_switch.h"
+#include "rofl/datapath/pipeline/util/slab.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_match.h"
+#include "rofl/datapath/pipeline/openflow/openflow1x/pipeline/of1x_flow_entry.h"
+
+int set_up(){
+
+	if(physical_switch_init() != ROFL_SUCCESS)
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
+
+int tear_down(){
+	physical_switch_destroy();
+	return EXIT_SUCCESS;
+}
+
+void test_slab_pools(){
+
+	slab_pool_t* pool;
+	unsigned int in_use;
+	unsigned int i, n;
+	void* objs[2048];
+	of1x_match_t *match, *match2;
+	of1x_flow_entry_t *entry, *entry2;
+	platform_rwlock_t* rwlock;
+	static const slab_desc_t desc = { "test", SLAB_POOL_MATCH, 24, NULL, NULL };
+
+	//Matches are taken from the physical switch pool and reused (LIFO)
+	match = of1x_init_port_in_match(1);
+	CU_ASSERT(match != NULL);
+	pool = get_physical_switch()->pools[SLAB_POOL_MATCH];
+	CU_ASSERT(pool != NULL);
+	in_use = pool->in_use;
+	CU_ASSERT(in_use > 0);
+	of1x_destroy_match(match);
+	CU_ASSERT(pool->in_use == in_use-1);
+	match2 = of1x_init_port_in_match(2);
+	CU_ASSERT(match2 == match);
+	CU_ASSERT(pool->in_use == in_use);
+	of1x_destroy_match(match2);
+
+	//Entries keep their (constructed) locks across allocations
+	entry = of1x_init_flow_entry(false);
+	CU_ASSERT(entry != NULL);
+	CU_ASSERT(entry->rwlock != NULL);
+	CU_ASSERT(entry->stats.mutex != NULL);
+	rwlock = entry->rwlock;
+	CU_ASSERT(of1x_add_match_to_entry(entry,of1x_init_port_in_match(3)) == ROFL_SUCCESS);
+	of1x_destroy_flow_entry(entry);
+	entry2 = of1x_init_flow_entry(false);
+	CU_ASSERT(entry2 == entry);
+	CU_ASSERT(entry2->rwlock == rwlock);
+	CU_ASSERT(entry2->matches.head == NULL);
+	CU_ASSERT(__of1x_stats_flow_counters(&entry2->stats,0)->packet_count == 0);
+	of1x_destroy_flow_entry(entry2);
+
+	//Pool growth
+	pool = __slab_pool_init(&desc, false);
+	CU_ASSERT(pool != NULL);
+	n = pool->objs_per_chunk+1;
+	CU_ASSERT_FATAL(n <= 2048);
+	for(i=0;i<n;i++){
+		objs[i] = __slab_alloc(pool, &desc);
+		CU_ASSERT(objs[i] != NULL);
+	}
+	CU_ASSERT(pool->num_of_chunks == 2);
+	CU_ASSERT(pool->in_use == n);
+	for(i=0;i<n;i++)
+		__slab_free(objs[i]);
+	CU_ASSERT(pool->in_use == 0);
+	__slab_pool_destroy(pool);
+
+	//Without a pool objects fall back to platform_malloc_shared()
+	objs[0] = __slab_alloc(NULL, &desc);
+	CU_ASSERT(objs[0] != NULL);
+	__slab_free(objs[0]);
+}
+
+int main(int args, char** argv){
+
+	int return_code;
+	//main to call all the other tests written in the oder files in this folder
+	CU_pSuite pSuite = NULL;
+
+	/* initialize the CUnit test registry */
+	if (CUE_SUCCESS != CU_initialize_registry())
+		return CU_get_error();
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("Suite_Slab_pools", set_up, tear_down);
+
+	if (NULL == pSuite){
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if ((NULL == CU_add_test(pSuite, "test slab pools", test_slab_pools))
+		)
+	{
+		fprintf(stderr,"ERROR WHILE ADDING TEST\n");
+		return_code = CU_get_error();
+		CU_cleanup_registry();
+		return return_code;
+	}
+	
+	/* Run all tests using the CUnit Basic interface */
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	return_code = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return return_code;
+}